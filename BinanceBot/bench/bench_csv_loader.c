@@ -0,0 +1,131 @@
+// bench_csv_loader.c
+// Compares the fgets/sscanf CSV loader with the mmap and parallel loaders and reports MB/s.
+//
+// Usage: ./bin/bench_csv_loader [klines.csv] [rows] [max_threads]
+// Without a file a synthetic *_MinuteBars.csv style file is generated first.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "market_data_array.h"
+
+#define DEFAULT_ROWS 1000000
+#define SYNTHETIC_PATH "/tmp/bench_MinuteBars.csv"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Write rows in the layout produced by binanceBar.py (pandas to_csv of the kline frame)
+static int write_synthetic_csv(const char *path, size_t rows) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        return -1;
+    }
+
+    fprintf(file, "timestamp,open,high,low,close,volume,close_time,quote_av,trades,tb_base_av,tb_quote_av,ignore\n");
+
+    double price = 29000.0;
+    long long open_time = 1609459200000LL;
+    srand(42);
+    for (size_t i = 0; i < rows; i++) {
+        double open = price;
+        price += (rand() % 2001 - 1000) * 0.01;
+        double close = price;
+        double high = (open > close ? open : close) + (rand() % 500) * 0.01;
+        double low = (open < close ? open : close) - (rand() % 500) * 0.01;
+        double volume = (rand() % 100000) * 0.001;
+        time_t secs = (time_t)(open_time / 1000);
+        struct tm tm;
+        gmtime_r(&secs, &tm);
+        char stamp[20];
+        strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+
+        fprintf(file, "%s,%.8f,%.8f,%.8f,%.8f,%.8f,%lld,%.8f,%d,%.8f,%.8f,0\n",
+                stamp, open, high, low, close, volume, open_time + 59999,
+                volume * close, rand() % 5000, volume / 2, volume * close / 2);
+        open_time += 60000;
+    }
+
+    fclose(file);
+    return 0;
+}
+
+static int compare_arrays(const MarketDataArray *a, const MarketDataArray *b) {
+    if (a->length != b->length) {
+        printf("row count mismatch: %zu vs %zu\n", a->length, b->length);
+        return -1;
+    }
+    for (size_t i = 0; i < a->length; i++) {
+        const MarketData *x = &a->data[i];
+        const MarketData *y = &b->data[i];
+        if (x->open_time_ms != y->open_time_ms || x->close_time_ms != y->close_time_ms ||
+            x->open != y->open || x->high != y->high || x->low != y->low || x->close != y->close ||
+            x->volume != y->volume || x->quote_av != y->quote_av || x->trades != y->trades ||
+            x->tb_base_av != y->tb_base_av || x->tb_quote_av != y->tb_quote_av) {
+            printf("row %zu differs between loaders\n", i);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = argc > 1 ? argv[1] : SYNTHETIC_PATH;
+    size_t rows = argc > 2 ? (size_t)strtoull(argv[2], NULL, 10) : DEFAULT_ROWS;
+    int max_threads = argc > 3 ? atoi(argv[3]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (argc < 2 && write_synthetic_csv(path, rows) != 0) {
+        printf("Could not write synthetic file: %s\n", path);
+        return 1;
+    }
+
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        printf("Could not stat file: %s\n", path);
+        return 1;
+    }
+    double megabytes = st.st_size / (1024.0 * 1024.0);
+
+    MarketDataArray *sscanf_array = market_data_array_init(1024);
+    double start = now_seconds();
+    read_csv_file(path, sscanf_array);
+    double sscanf_seconds = now_seconds() - start;
+
+    MarketDataArray *mmap_array = market_data_array_init(1024);
+    start = now_seconds();
+    if (read_csv_file_mmap(path, mmap_array) != 0) {
+        return 1;
+    }
+    double mmap_seconds = now_seconds() - start;
+
+    int status = compare_arrays(sscanf_array, mmap_array);
+
+    printf("file: %s (%.1f MB, %zu rows)\n", path, megabytes, mmap_array->length);
+    printf("fgets+sscanf: %8.3f s  %8.1f MB/s\n", sscanf_seconds, megabytes / sscanf_seconds);
+    printf("mmap scanner: %8.3f s  %8.1f MB/s  (%.1fx)\n", mmap_seconds, megabytes / mmap_seconds,
+           sscanf_seconds / mmap_seconds);
+
+    // Parallel loader at doubling thread counts, to show how it scales
+    for (int threads = 2; threads <= max_threads && status == 0; threads *= 2) {
+        MarketDataArray *parallel_array = market_data_array_init(1024);
+        start = now_seconds();
+        if (read_csv_file_parallel(path, parallel_array, threads) != 0) {
+            return 1;
+        }
+        double parallel_seconds = now_seconds() - start;
+        status = compare_arrays(mmap_array, parallel_array);
+
+        printf("parallel x%-3d: %8.3f s  %8.1f MB/s  (%.1fx)\n", threads, parallel_seconds,
+               megabytes / parallel_seconds, sscanf_seconds / parallel_seconds);
+        market_data_array_free(parallel_array);
+    }
+
+    market_data_array_free(sscanf_array);
+    market_data_array_free(mmap_array);
+    return status == 0 ? 0 : 1;
+}
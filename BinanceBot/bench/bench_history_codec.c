@@ -0,0 +1,111 @@
+// bench_history_codec.c
+// Measures compression ratio and decode throughput of the block-compressed history
+// against the raw 88 bytes/row of the .kbin columns, and checks the round trip is exact.
+//
+// Usage: ./bin/bench_history_codec [klines.csv]
+// The compressed file is written next to the CSV (same name, .kgor extension).
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "market_data_array.h"
+#include "market_data_columns.h"
+#include "history_codec.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Bitwise comparison, so -0.0 and NaN payloads must survive too
+static int columns_equal(const MarketDataColumns *a, const MarketDataColumns *b, size_t offset) {
+    size_t bytes = b->length * sizeof(uint64_t);
+    return memcmp(a->open_time + offset, b->open_time, bytes) == 0 &&
+           memcmp(a->close_time + offset, b->close_time, bytes) == 0 &&
+           memcmp(a->open + offset, b->open, bytes) == 0 &&
+           memcmp(a->high + offset, b->high, bytes) == 0 &&
+           memcmp(a->low + offset, b->low, bytes) == 0 &&
+           memcmp(a->close + offset, b->close, bytes) == 0 &&
+           memcmp(a->volume + offset, b->volume, bytes) == 0 &&
+           memcmp(a->quote_av + offset, b->quote_av, bytes) == 0 &&
+           memcmp(a->trades + offset, b->trades, bytes) == 0 &&
+           memcmp(a->tb_base_av + offset, b->tb_base_av, bytes) == 0 &&
+           memcmp(a->tb_quote_av + offset, b->tb_quote_av, bytes) == 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *csv_path = argc > 1 ? argv[1] : "/tmp/bench_MinuteBars.csv";
+    char history_path[4096];
+    snprintf(history_path, sizeof(history_path), "%s.kgor", csv_path);
+
+    MarketDataArray *array = market_data_array_init(1024);
+    if (read_csv_file_mmap(csv_path, array) != 0) {
+        return 1;
+    }
+    MarketDataColumns *columns = market_data_columns_from_array(array);
+    market_data_array_free(array);
+    if (columns == NULL || columns->length == 0) {
+        printf("No rows in %s\n", csv_path);
+        return 1;
+    }
+
+    double start = now_seconds();
+    CompressedHistory *compressed = history_compress(columns);
+    double compress_seconds = now_seconds() - start;
+    if (compressed == NULL || history_write(history_path, compressed) != 0) {
+        return 1;
+    }
+    history_free(compressed);
+
+    CompressedHistory *history = history_open(history_path);
+    if (history == NULL) {
+        return 1;
+    }
+
+    // Full decode, best of a few runs
+    double decode_seconds = 1e9;
+    int status = 0;
+    for (int run = 0; run < 3; run++) {
+        MarketDataColumns *decoded = market_data_columns_init(columns->length);
+        start = now_seconds();
+        for (size_t block = 0; block < history->block_count; block++) {
+            history_decompress_block(history, block, decoded);
+        }
+        double elapsed = now_seconds() - start;
+        decode_seconds = elapsed < decode_seconds ? elapsed : decode_seconds;
+        if (decoded->length != columns->length || !columns_equal(columns, decoded, 0)) {
+            printf("full decode differs from the source columns\n");
+            status = 1;
+        }
+        market_data_columns_free(decoded);
+    }
+
+    // A one-day range from the middle touches only the blocks that overlap it
+    int64_t range_start = columns->open_time[columns->length / 2];
+    int64_t range_end = range_start + 24LL * 60 * 60 * 1000;
+    start = now_seconds();
+    MarketDataColumns *range = history_decompress_range(history, range_start, range_end);
+    double range_seconds = now_seconds() - start;
+    size_t first, last;
+    market_data_columns_seek(columns, range_start, range_end, &first, &last);
+    if (range == NULL || range->length != last - first || !columns_equal(columns, range, first)) {
+        printf("range decode differs from the source columns\n");
+        status = 1;
+    }
+
+    double raw_bytes = (double)columns->length * KLINE_COLUMN_COUNT * sizeof(uint64_t);
+    printf("rows: %zu in %zu blocks\n", columns->length, history->block_count);
+    printf("raw columns:     %10.1f MB (%d bytes/row)\n", raw_bytes / 1e6, (int)(KLINE_COLUMN_COUNT * sizeof(uint64_t)));
+    printf("compressed:      %10.1f MB (%.2f bytes/row, %.2fx)\n", history->size / 1e6,
+           (double)history->size / columns->length, raw_bytes / history->size);
+    printf("compress:        %10.3f ms\n", compress_seconds * 1e3);
+    printf("decode:          %10.3f ms (%.0f MB/s raw, %.1f M rows/s)\n", decode_seconds * 1e3,
+           raw_bytes / decode_seconds / 1e6, columns->length / decode_seconds / 1e6);
+    printf("1-day range:     %10.3f ms (%zu rows)\n", range_seconds * 1e3, range ? range->length : 0);
+
+    market_data_columns_free(range);
+    history_free(history);
+    market_data_columns_free(columns);
+    return status;
+}
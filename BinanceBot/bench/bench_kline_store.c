@@ -0,0 +1,70 @@
+// bench_kline_store.c
+// Measures time-to-first-scan for a .kbin store against loading the same CSV.
+//
+// Usage: ./bin/bench_kline_store klines.csv
+// The .kbin file is written next to the CSV (same name, .kbin extension).
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "market_data_array.h"
+#include "kline_store.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+    const char *csv_path = argc > 1 ? argv[1] : "/tmp/bench_MinuteBars.csv";
+    char kbin_path[4096];
+    snprintf(kbin_path, sizeof(kbin_path), "%s.kbin", csv_path);
+
+    double start = now_seconds();
+    MarketDataArray *array = market_data_array_init(1024);
+    if (read_csv_file_mmap(csv_path, array) != 0) {
+        return 1;
+    }
+    double csv_seconds = now_seconds() - start;
+
+    if (kline_store_write(kbin_path, array) != 0) {
+        return 1;
+    }
+
+    // Open the store and touch the whole close column, as an indicator scan would
+    start = now_seconds();
+    KlineStore *store = kline_store_open(kbin_path);
+    if (store == NULL) {
+        return 1;
+    }
+    double open_seconds = now_seconds() - start;
+    double sum = 0;
+    for (size_t i = 0; i < store->row_count; i++) {
+        sum += store->close[i];
+    }
+    double scan_seconds = now_seconds() - start;
+
+    // Spot check that columns round-trip
+    int status = 0;
+    for (size_t i = 0; i < store->row_count; i += store->row_count / 97 + 1) {
+        MarketData row;
+        kline_store_row(store, i, &row);
+        if (row.close != array->data[i].close || row.trades != array->data[i].trades ||
+            row.open_time_ms != array->data[i].open_time_ms ||
+            row.close_time_ms != array->data[i].close_time_ms) {
+            printf("row %zu differs after round trip\n", i);
+            status = 1;
+            break;
+        }
+    }
+
+    printf("rows: %zu (checksum %.2f)\n", store->row_count, sum);
+    printf("csv load:        %8.3f ms\n", csv_seconds * 1e3);
+    printf("kbin open:       %8.3f ms\n", open_seconds * 1e3);
+    printf("kbin open+scan:  %8.3f ms\n", scan_seconds * 1e3);
+
+    kline_store_close(store);
+    market_data_array_free(array);
+    return status;
+}
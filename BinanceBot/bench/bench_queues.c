@@ -0,0 +1,223 @@
+// bench_queues.c
+// Stress-tests the linked lock-free queues with several producers and consumers at once,
+// checking that every item comes out exactly once and in each producer's order, one at a time
+// and in bulk runs, then compares their throughput with the bounded SPSC ring.
+//
+// Usage: ./bin/bench_queues [THREADS_PER_SIDE]
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "lock_free_queue.h"
+#include "proces_queue.h"
+#include "spsc_ring.h"
+
+#define ITEMS_PER_RUN 2000000
+#define MAX_THREADS_PER_SIDE 16
+#define BULK_BATCH 32
+// Items carry their producer in the high bits and a per-producer sequence number below it.
+// They are never dereferenced, only passed through the queues.
+#define PRODUCER_SHIFT 32
+
+typedef enum { QUEUE_MARKET_DATA, QUEUE_PROCESSED, QUEUE_SPSC_RING } QueueKind;
+
+typedef struct {
+    QueueKind kind;
+    void *queue;
+    uintptr_t producer;
+    size_t items;
+    atomic_size_t *remaining;
+    size_t last_seen[MAX_THREADS_PER_SIDE];
+    size_t taken;
+    bool ordered;
+    bool bulk;
+} WorkerArgs;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void push(QueueKind kind, void *queue, void *item) {
+    if (kind == QUEUE_MARKET_DATA) {
+        lock_free_queue_enqueue((LockFreeQueue *)queue, (MarketData *)item);
+    } else if (kind == QUEUE_PROCESSED) {
+        proces_enqueue((ProcesLockFreeNode *)queue, (PreProcessedData *)item);
+    } else {
+        while (!spsc_ring_push((SpscRing *)queue, item)) {
+            sched_yield();
+        }
+    }
+}
+
+static void *pop(QueueKind kind, void *queue) {
+    if (kind == QUEUE_MARKET_DATA) {
+        return lock_free_queue_dequeue((LockFreeQueue *)queue);
+    } else if (kind == QUEUE_PROCESSED) {
+        return proces_dequeue((ProcesLockFreeNode *)queue);
+    }
+    return spsc_ring_pop((SpscRing *)queue);
+}
+
+static size_t push_bulk(QueueKind kind, void *queue, void **items, size_t count) {
+    if (kind == QUEUE_MARKET_DATA) {
+        return lock_free_queue_enqueue_bulk((LockFreeQueue *)queue, (MarketData *const *)items, count);
+    } else if (kind == QUEUE_PROCESSED) {
+        return proces_enqueue_bulk((ProcesLockFreeNode *)queue, (PreProcessedData *const *)items, count);
+    }
+    return spsc_ring_push_bulk((SpscRing *)queue, items, count);
+}
+
+static size_t pop_bulk(QueueKind kind, void *queue, void **items, size_t max) {
+    if (kind == QUEUE_MARKET_DATA) {
+        return lock_free_queue_dequeue_bulk((LockFreeQueue *)queue, (MarketData **)items, max);
+    } else if (kind == QUEUE_PROCESSED) {
+        return proces_dequeue_bulk((ProcesLockFreeNode *)queue, (PreProcessedData **)items, max);
+    }
+    return spsc_ring_pop_bulk((SpscRing *)queue, items, max);
+}
+
+static void *producer_thread(void *args) {
+    WorkerArgs *worker = (WorkerArgs *)args;
+    if (!worker->bulk) {
+        for (uintptr_t i = 1; i <= worker->items; i++) {
+            push(worker->kind, worker->queue, (void *)((worker->producer << PRODUCER_SHIFT) | i));
+        }
+        return NULL;
+    }
+    void *batch[BULK_BATCH];
+    for (uintptr_t i = 1; i <= worker->items;) {
+        size_t count = 0;
+        while (count < BULK_BATCH && i + count <= worker->items) {
+            batch[count] = (void *)((worker->producer << PRODUCER_SHIFT) | (i + count));
+            count++;
+        }
+        size_t pushed = 0;
+        while ((pushed += push_bulk(worker->kind, worker->queue, batch + pushed, count - pushed)) < count) {
+            sched_yield();
+        }
+        i += count;
+    }
+    return NULL;
+}
+
+static void *consumer_thread(void *args) {
+    WorkerArgs *worker = (WorkerArgs *)args;
+    void *batch[BULK_BATCH];
+    while (atomic_load(worker->remaining) > 0) {
+        size_t count;
+        if (worker->bulk) {
+            count = pop_bulk(worker->kind, worker->queue, batch, BULK_BATCH);
+        } else {
+            batch[0] = pop(worker->kind, worker->queue);
+            count = batch[0] != NULL;
+        }
+        if (count == 0) {
+            sched_yield();
+            continue;
+        }
+        atomic_fetch_sub(worker->remaining, count);
+        for (size_t i = 0; i < count; i++) {
+            uintptr_t item = (uintptr_t)batch[i];
+            size_t producer = item >> PRODUCER_SHIFT;
+            size_t sequence = item & 0xffffffffu;
+            // One producer's items may be split across consumers, but each consumer sees them in order
+            if (producer >= MAX_THREADS_PER_SIDE || sequence <= worker->last_seen[producer]) {
+                worker->ordered = false;
+            } else {
+                worker->last_seen[producer] = sequence;
+            }
+        }
+        worker->taken += count;
+    }
+    return NULL;
+}
+
+// Returns millions of items per second, or -1 if items were lost, duplicated or reordered
+static double run(QueueKind kind, size_t threads_per_side, bool bulk) {
+    void *queue = kind == QUEUE_MARKET_DATA ? (void *)lock_free_queue_init()
+                : kind == QUEUE_PROCESSED   ? (void *)proces_queue_init()
+                                            : (void *)spsc_ring_init(SPSC_RING_DEFAULT_CAPACITY);
+    size_t per_producer = ITEMS_PER_RUN / threads_per_side;
+    atomic_size_t remaining = per_producer * threads_per_side;
+    WorkerArgs producers[MAX_THREADS_PER_SIDE], consumers[MAX_THREADS_PER_SIDE];
+    pthread_t producer_ids[MAX_THREADS_PER_SIDE], consumer_ids[MAX_THREADS_PER_SIDE];
+
+    double start = now_seconds();
+    for (size_t i = 0; i < threads_per_side; i++) {
+        consumers[i] = (WorkerArgs){.kind = kind, .queue = queue, .remaining = &remaining, .ordered = true, .bulk = bulk};
+        producers[i] = (WorkerArgs){.kind = kind, .queue = queue, .producer = i, .items = per_producer, .bulk = bulk};
+        pthread_create(&consumer_ids[i], NULL, consumer_thread, &consumers[i]);
+        pthread_create(&producer_ids[i], NULL, producer_thread, &producers[i]);
+    }
+    for (size_t i = 0; i < threads_per_side; i++) {
+        pthread_join(producer_ids[i], NULL);
+        pthread_join(consumer_ids[i], NULL);
+    }
+    double seconds = now_seconds() - start;
+
+    size_t taken = 0;
+    bool ordered = true;
+    for (size_t i = 0; i < threads_per_side; i++) {
+        taken += consumers[i].taken;
+        ordered &= consumers[i].ordered;
+    }
+    for (size_t p = 0; p < threads_per_side; p++) {
+        size_t highest = 0;
+        for (size_t i = 0; i < threads_per_side; i++) {
+            highest = consumers[i].last_seen[p] > highest ? consumers[i].last_seen[p] : highest;
+        }
+        ordered &= highest == per_producer;
+    }
+    bool drained = pop(kind, queue) == NULL;
+
+    if (kind == QUEUE_MARKET_DATA) {
+        lock_free_queue_destroy((LockFreeQueue *)queue);
+    } else if (kind == QUEUE_PROCESSED) {
+        proces_queue_destroy((ProcesLockFreeNode *)queue);
+    } else {
+        spsc_ring_destroy((SpscRing *)queue);
+    }
+    if (!ordered || !drained || taken != per_producer * threads_per_side) {
+        printf("FAIL %zu items taken of %zu, %s, %s\n", taken, per_producer * threads_per_side,
+               ordered ? "in order" : "out of order", drained ? "drained" : "items left behind");
+        return -1;
+    }
+    return taken / seconds / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+    size_t threads = argc > 1 ? (size_t)atoi(argv[1]) : 4;
+    if (threads < 1 || threads > MAX_THREADS_PER_SIDE) {
+        printf("THREADS_PER_SIDE must be 1 to %d\n", MAX_THREADS_PER_SIDE);
+        return 1;
+    }
+
+    double market_many = run(QUEUE_MARKET_DATA, threads, false);
+    double processed_many = run(QUEUE_PROCESSED, threads, false);
+    double market_one = run(QUEUE_MARKET_DATA, 1, false);
+    double ring_one = run(QUEUE_SPSC_RING, 1, false);
+    double market_many_bulk = run(QUEUE_MARKET_DATA, threads, true);
+    double processed_many_bulk = run(QUEUE_PROCESSED, threads, true);
+    double market_one_bulk = run(QUEUE_MARKET_DATA, 1, true);
+    double ring_one_bulk = run(QUEUE_SPSC_RING, 1, true);
+    if (market_many < 0 || processed_many < 0 || market_one < 0 || ring_one < 0 || market_many_bulk < 0 ||
+        processed_many_bulk < 0 || market_one_bulk < 0 || ring_one_bulk < 0) {
+        return 1;
+    }
+
+    printf("%zu producers x %zu consumers: LockFreeQueue %.2f M items/s, ProcesLockFreeNode %.2f M items/s\n",
+           threads, threads, market_many, processed_many);
+    printf("1 producer x 1 consumer:     LockFreeQueue %.2f M items/s, SpscRing %.2f M items/s\n",
+           market_one, ring_one);
+    printf("in runs of %d:\n", BULK_BATCH);
+    printf("%zu producers x %zu consumers: LockFreeQueue %.2f M items/s, ProcesLockFreeNode %.2f M items/s\n",
+           threads, threads, market_many_bulk, processed_many_bulk);
+    printf("1 producer x 1 consumer:     LockFreeQueue %.2f M items/s, SpscRing %.2f M items/s\n",
+           market_one_bulk, ring_one_bulk);
+    return 0;
+}
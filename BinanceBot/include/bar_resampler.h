@@ -0,0 +1,35 @@
+#ifndef BAR_RESAMPLER_H
+#define BAR_RESAMPLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "market_data_array.h"
+#include "market_data_columns.h"
+
+// Aggregates finer bars into a multiple interval. Buckets are aligned to the epoch
+// (so 1d bars start at 00:00 UTC) and a coarse bar takes the open of its first row,
+// the close of its last, the high/low extremes and the sums of volume, quote volume,
+// trades and taker volumes. Missing rows inside a bucket are simply absent from the
+// aggregate; buckets with no rows at all are skipped, or emitted as flat zero-volume
+// bars at the previous close when fill_gaps is set.
+#define RESAMPLE_MAX_INTERVAL_MS (7LL * 24 * 60 * 60 * 1000)
+
+// Incremental state for resampling a live stream one row at a time; the stream path
+// never synthesizes bars for empty buckets
+typedef struct {
+    int64_t interval_ms;
+    bool has_bar;        // bar holds a partially aggregated bucket
+    MarketData bar;
+} BarResampler;
+
+int64_t resample_interval_ms(const char *interval);
+
+MarketDataColumns *resample_columns(const MarketDataColumns *columns, int64_t interval_ms, bool fill_gaps);
+int resample_market_data(const MarketDataArray *array, int64_t interval_ms, bool fill_gaps, MarketDataArray *out);
+
+void bar_resampler_init(BarResampler *resampler, int64_t interval_ms);
+size_t bar_resampler_push(BarResampler *resampler, const MarketData *row, MarketData *out, size_t out_capacity);
+bool bar_resampler_flush(BarResampler *resampler, MarketData *out);
+
+#endif // BAR_RESAMPLER_H
@@ -9,6 +9,16 @@ typedef struct {
     double ema_alpha;
     int rsi_period;
     double bollinger_multiplier;
+    int load_threads;
+    long long start_time_ms;  // 0 loads from the first row
+    long long end_time_ms;    // 0 loads to the last row
+    int stream_input;         // parse CSV rows straight into the queue instead of loading the file
+    int stream_queue_rows;    // rows in flight between reader and pre-processing when streaming
+    char symbol[32];          // symbol to load when the data path is a catalog directory
+    char interval[8];
+    int catalog_memory_mb;    // mapped-file budget for the data catalog
+    char resample_interval[8];  // aggregate input bars to this interval ("5m", "1h", "1d"), empty to keep them
+    int resample_fill_gaps;   // emit flat zero-volume bars for empty buckets when resampling a loaded span
 } ConfigParams;
 
 // Function to load config
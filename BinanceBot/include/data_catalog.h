@@ -0,0 +1,62 @@
+#ifndef DATA_CATALOG_H
+#define DATA_CATALOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "kline_store.h"
+#include "market_data_columns.h"
+#include "history_codec.h"
+
+// Catalog of per-symbol, per-interval .kbin files in one directory, named
+// SYMBOL_INTERVAL.kbin (BTCUSDT_1m.kbin). The older SYMBOL_MinuteBars.kbin name
+// is read as the 1m interval. Compressed histories (BTCUSDT_1m.kgor) are indexed
+// the same way and decoded into memory on first access. Files are loaded on first
+// access and the least recently used unpinned files are dropped while the loaded
+// total is over budget.
+#define DATA_CATALOG_SYMBOL_LENGTH 32
+#define DATA_CATALOG_INTERVAL_LENGTH 8
+
+typedef struct DataCatalogEntry {
+    char symbol[DATA_CATALOG_SYMBOL_LENGTH];
+    char interval[DATA_CATALOG_INTERVAL_LENGTH];
+    char *path;
+    size_t file_size;                // from the directory scan, refreshed each time the file is loaded
+    bool compressed;                 // .kgor: columns are decoded copies, store stays NULL
+    size_t resident_bytes;           // charged against the budget while loaded
+    KlineStore *store;               // NULL until first access or after eviction
+    MarketDataColumns *columns;      // view over store, or decoded history; NULL when not loaded
+    int pin_count;
+    struct DataCatalogEntry *lru_prev;  // mapped entries only, most recent first
+    struct DataCatalogEntry *lru_next;
+} DataCatalogEntry;
+
+typedef struct {
+    DataCatalogEntry *entries;
+    size_t entry_count;
+    size_t *slots;                   // open-addressed hash of entry index + 1, 0 when empty
+    size_t slot_mask;
+    DataCatalogEntry *lru_head;
+    DataCatalogEntry *lru_tail;
+    size_t mapped_bytes;
+    size_t memory_budget;
+    pthread_mutex_t lock;
+} DataCatalog;
+
+// Rows [first, last) of one file, pinned until data_catalog_release
+typedef struct {
+    const MarketDataColumns *columns;
+    size_t first;
+    size_t last;
+    DataCatalogEntry *entry;
+} DataCatalogSlice;
+
+DataCatalog *data_catalog_open(const char *directory, size_t memory_budget);
+DataCatalogEntry *data_catalog_find(DataCatalog *catalog, const char *symbol, const char *interval);
+int data_catalog_acquire(DataCatalog *catalog, const char *symbol, const char *interval,
+                         int64_t start_time_ms, int64_t end_time_ms, DataCatalogSlice *slice);
+void data_catalog_release(DataCatalog *catalog, DataCatalogSlice *slice);
+void data_catalog_close(DataCatalog *catalog);
+
+#endif // DATA_CATALOG_H
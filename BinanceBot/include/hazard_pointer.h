@@ -0,0 +1,53 @@
+#ifndef HAZARD_POINTER_H
+#define HAZARD_POINTER_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+// Threads that may hold hazard pointers at the same time
+#define HAZARD_MAX_THREADS 64
+// Hazard pointers each thread can publish
+#define HAZARD_SLOTS 2
+// Retired nodes a thread holds before it scans for ones it can free; twice the number of
+// hazard pointers, so every scan frees at least half of them
+#define HAZARD_RETIRE_THRESHOLD (2 * HAZARD_MAX_THREADS * HAZARD_SLOTS)
+
+// Tagged pointers: the low 48 bits are the address (all user-space addresses fit on x86-64
+// and AArch64) and the high 16 bits count the times the word has been swung, so a CAS that
+// saw A, then B, then A again fails instead of succeeding on a stale value.
+#define TAGGED_POINTER_BITS 48
+#define TAGGED_POINTER_MASK (((uintptr_t)1 << TAGGED_POINTER_BITS) - 1)
+
+static inline void *tagged_pointer(uintptr_t word) {
+    return (void *)(word & TAGGED_POINTER_MASK);
+}
+
+// The word to install in place of previous: pointer with the tag one step on
+static inline uintptr_t tagged_successor(uintptr_t previous, void *pointer) {
+    return (uintptr_t)pointer | (((previous >> TAGGED_POINTER_BITS) + 1) << TAGGED_POINTER_BITS);
+}
+
+// Hazard-pointer reclamation (Michael, 2004) for the linked lock-free queues. Before a
+// thread dereferences a shared node it publishes the node's address in one of its slots;
+// a removed node is retired rather than freed, and is only freed once a scan finds no thread
+// publishing it. Each thread claims a record on first use and gives it back when it exits;
+// nodes still retired at that point stay with the record for the next thread to claim it.
+
+// Function to publish the node *source points to in slot and return the tagged word read,
+// retrying until the published node is still the one *source holds
+uintptr_t hazard_protect(_Atomic uintptr_t *source, int slot);
+
+// Function to publish the node word points to in slot without validating it; the caller
+// re-reads whatever word was loaded from before relying on it
+void hazard_set(int slot, uintptr_t word);
+
+// Function to withdraw the calling thread's hazard pointer in slot
+void hazard_clear(int slot);
+
+// Function to hand a node unlinked by the calling thread to reclaim once no thread protects it
+void hazard_retire(void *node, void (*reclaim)(void *));
+
+// Function to free every node the calling thread has retired that no thread still protects
+void hazard_scan(void);
+
+#endif // HAZARD_POINTER_H
@@ -0,0 +1,61 @@
+#ifndef HISTORY_CODEC_H
+#define HISTORY_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "kline_store.h"
+#include "market_data_columns.h"
+
+// Compressed kline history: a file header followed by self-describing blocks of up to
+// HISTORY_BLOCK_ROWS rows. Each block header carries its time span and the offset and
+// scheme of every column stream (streams are indexed by KlineColumn), so any block can
+// be located by time and decoded on its own.
+#define HISTORY_MAGIC "KGOR"
+#define HISTORY_VERSION 1
+#define HISTORY_BLOCK_ROWS 4096
+
+typedef enum {
+    HISTORY_SCHEME_REGULAR,         // int64 on a fixed grid: first value and one delta
+    HISTORY_SCHEME_DELTA_OF_DELTA,  // int64 timestamps, Gorilla delta-of-delta buckets
+    HISTORY_SCHEME_XOR,             // doubles, Gorilla XOR against the previous value
+    HISTORY_SCHEME_FIXED_POINT,     // doubles exact at 8 decimals, zigzag varint deltas of value * 1e8
+    HISTORY_SCHEME_ZIGZAG_DELTA     // int64 counts, zigzag varint of the change from the previous row
+} HistoryScheme;
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint64_t block_count;
+} HistoryFileHeader;
+
+typedef struct {
+    uint32_t row_count;
+    uint32_t block_bytes;           // header and all streams, a multiple of 8
+    int64_t first_open_time;
+    int64_t last_open_time;
+    uint32_t stream_offsets[KLINE_COLUMN_COUNT];
+    uint8_t schemes[KLINE_COLUMN_COUNT];
+    uint8_t reserved[(8 - (KLINE_COLUMN_COUNT * 5) % 8) % 8];
+} HistoryBlockHeader;
+
+typedef struct {
+    uint8_t *data;                  // file header followed by the blocks
+    size_t size;
+    size_t capacity;
+    size_t *block_offsets;
+    size_t block_count;
+    size_t row_count;
+    bool mapped;                    // data is a read-only file mapping
+} CompressedHistory;
+
+CompressedHistory *history_compress(const MarketDataColumns *columns);
+const HistoryBlockHeader *history_block(const CompressedHistory *history, size_t block);
+size_t history_find_block(const CompressedHistory *history, int64_t time_ms);
+bool history_decompress_block(const CompressedHistory *history, size_t block, MarketDataColumns *out);
+MarketDataColumns *history_decompress_range(const CompressedHistory *history, int64_t start_time_ms, int64_t end_time_ms);
+int history_write(const char *path, const CompressedHistory *history);
+CompressedHistory *history_open(const char *path);
+void history_free(CompressedHistory *history);
+
+#endif // HISTORY_CODEC_H
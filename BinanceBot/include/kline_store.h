@@ -0,0 +1,62 @@
+#ifndef KLINE_STORE_H
+#define KLINE_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "market_data_array.h"
+
+// .kbin layout: a fixed header followed by one contiguous array per column.
+// Every column starts on a KLINE_STORE_ALIGNMENT boundary and values are in
+// host byte order, so a mapped file can be used in place.
+#define KLINE_STORE_MAGIC "KBIN"
+#define KLINE_STORE_VERSION 1
+#define KLINE_STORE_ALIGNMENT 64
+
+typedef enum {
+    KLINE_COL_OPEN_TIME,    // int64 epoch ms
+    KLINE_COL_CLOSE_TIME,   // int64 epoch ms
+    KLINE_COL_OPEN,         // double
+    KLINE_COL_HIGH,
+    KLINE_COL_LOW,
+    KLINE_COL_CLOSE,
+    KLINE_COL_VOLUME,
+    KLINE_COL_QUOTE_AV,
+    KLINE_COL_TRADES,       // int64
+    KLINE_COL_TB_BASE_AV,   // double
+    KLINE_COL_TB_QUOTE_AV,
+    KLINE_COLUMN_COUNT
+} KlineColumn;
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint64_t row_count;
+    uint32_t column_count;
+    uint32_t reserved;
+    uint64_t column_offsets[KLINE_COLUMN_COUNT];
+} KlineStoreHeader;
+
+// Read-only view over a mapped .kbin file; the column pointers alias the mapping
+typedef struct {
+    size_t row_count;
+    const int64_t *open_time;
+    const int64_t *close_time;
+    const double *open;
+    const double *high;
+    const double *low;
+    const double *close;
+    const double *volume;
+    const double *quote_av;
+    const int64_t *trades;
+    const double *tb_base_av;
+    const double *tb_quote_av;
+    void *mapping;
+    size_t mapping_size;
+} KlineStore;
+
+int kline_store_write(const char *path, const MarketDataArray *array);
+KlineStore *kline_store_open(const char *path);
+void kline_store_row(const KlineStore *store, size_t index, MarketData *out);
+void kline_store_close(KlineStore *store);
+
+#endif // KLINE_STORE_H
@@ -2,23 +2,34 @@
 #define LOCK_FREE_QUEUE_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
 #include "market_data_array.h"
 
 //typedef struct MarketData MarketData; // Forward declaration of MarketData
 
 typedef struct LockFreeQueueNode {
     MarketData *data;
-    struct LockFreeQueueNode *next;
+    _Atomic uintptr_t next;   // tagged pointer to the next node
 } LockFreeQueueNode;
 
+// Michael-Scott queue for any number of producers and consumers. head and tail are tagged
+// pointers, and nodes are reclaimed through hazard pointers, so a consumer never frees a
+// node another thread is still reading.
 typedef struct LockFreeQueue {
-    LockFreeQueueNode *head;
-    LockFreeQueueNode *tail;
+    _Alignas(64) _Atomic uintptr_t head;
+    _Alignas(64) _Atomic uintptr_t tail;
 } LockFreeQueue;
 
 LockFreeQueue *lock_free_queue_init();
 bool lock_free_queue_enqueue(LockFreeQueue *queue, MarketData *data);
 MarketData *lock_free_queue_dequeue(LockFreeQueue *queue);
+// Link up to count items as one chain with a single swap on the tail node; returns how many
+// were queued, fewer than count only if node allocation fails
+size_t lock_free_queue_enqueue_bulk(LockFreeQueue *queue, MarketData *const *items, size_t count);
+// Take up to max of the oldest items with a single swap on the head; returns how many were taken
+size_t lock_free_queue_dequeue_bulk(LockFreeQueue *queue, MarketData **items, size_t max);
 void lock_free_queue_destroy(LockFreeQueue *queue);
 
 #endif // LOCK_FREE_QUEUE_H
@@ -2,17 +2,18 @@
 #define MARKET_DATA_ARRAY_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
 
-// Define a struct to hold the market data
+// Define a struct to hold the market data; times are epoch milliseconds (UTC)
 typedef struct {
-    char timestamp[20]; 
+    int64_t open_time_ms;
     double open;
     double high;
     double low;
     double close;
     double volume;
-    char close_time[20];
+    int64_t close_time_ms;
     double quote_av;
     int trades;
     double tb_base_av;
@@ -27,10 +28,32 @@ typedef struct {
     size_t capacity;
 } MarketDataArray;
 
+// Incremental CSV reader holding only one buffer of the file at a time
+#define MARKET_DATA_STREAM_BUFFER (1 << 20)
+
+typedef struct {
+    int fd;
+    char *buffer;
+    size_t capacity;
+    size_t begin;
+    size_t end;
+    bool eof;
+    bool header_skipped;
+    bool discarding;      // inside a line longer than the buffer, skipping to its newline
+} MarketDataStream;
+
 // Function prototypes
 MarketDataArray *market_data_array_init(size_t initial_capacity);
 void market_data_array_resize(MarketDataArray *array);
 void market_data_array_free(MarketDataArray *array);
 void read_csv_file(const char *filename, MarketDataArray *array);
+int read_csv_file_mmap(const char *filename, MarketDataArray *array);
+int read_csv_file_parallel(const char *filename, MarketDataArray *array, int thread_count);
+long long market_data_parse_time_ms(const char *text);
+MarketDataStream *market_data_stream_open(const char *filename);
+MarketDataStream *market_data_stream_open_buffered(const char *filename, size_t buffer_size);
+int market_data_stream_next(MarketDataStream *stream, MarketData *out);
+void market_data_stream_close(MarketDataStream *stream);
+bool market_data_array_seek(const MarketDataArray *array, int64_t start_time_ms, int64_t end_time_ms, size_t *first, size_t *last);
 
 #endif // MARKET_DATA_ARRAY_H
@@ -0,0 +1,43 @@
+#ifndef MARKET_DATA_COLUMNS_H
+#define MARKET_DATA_COLUMNS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "market_data_array.h"
+#include "kline_store.h"
+
+// Column arrays start on a cache line so scans stay aligned for SIMD loads
+#define MARKET_DATA_COLUMN_ALIGNMENT 64
+
+// Structure-of-arrays counterpart of MarketDataArray: one array per field,
+// timestamps as int64 epoch milliseconds. Columns borrowed from a KlineStore
+// are read-only and owns_data is false.
+typedef struct {
+    int64_t *open_time;
+    int64_t *close_time;
+    double *open;
+    double *high;
+    double *low;
+    double *close;
+    double *volume;
+    double *quote_av;
+    int64_t *trades;
+    double *tb_base_av;
+    double *tb_quote_av;
+    size_t length;
+    size_t capacity;
+    bool owns_data;
+} MarketDataColumns;
+
+MarketDataColumns *market_data_columns_init(size_t initial_capacity);
+MarketDataColumns *market_data_columns_from_array(const MarketDataArray *array);
+MarketDataColumns *market_data_columns_from_store(const KlineStore *store);
+bool market_data_columns_reserve(MarketDataColumns *columns, size_t min_capacity);
+bool market_data_columns_append(MarketDataColumns *columns, const MarketData *row);
+void market_data_columns_row(const MarketDataColumns *columns, size_t index, MarketData *out);
+void market_data_columns_slice(const MarketDataColumns *columns, size_t first, size_t last, MarketDataColumns *view);
+bool market_data_columns_seek(const MarketDataColumns *columns, int64_t start_time_ms, int64_t end_time_ms, size_t *first, size_t *last);
+void market_data_columns_free(MarketDataColumns *columns);
+
+#endif // MARKET_DATA_COLUMNS_H
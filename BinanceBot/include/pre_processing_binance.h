@@ -8,8 +8,10 @@
 #include <math.h>
 #include <stdbool.h>
 #include <string.h>
+#include <stdatomic.h>
 #include "market_data_array.h"
-#include "lock_free_queue.h"
+#include "market_data_columns.h"
+#include "spsc_ring.h"
 #include "proces_queue.h"
 
 typedef struct {
@@ -34,7 +36,7 @@ typedef struct {
     double trend_strength;
 } TrendInfo;
 
-typedef struct {
+typedef struct PreProcessedData {
     double *price_differences;
     size_t price_difference_count;
     double transaction_costs;
@@ -52,8 +54,11 @@ typedef struct {
 } PreProcessedData;
 
 typedef struct PreProcessingArgs {
-    LockFreeQueue *input_queue;
+    SpscRing *input_queue;
     ProcesLockFreeNode *output_queue;  // Changed from LockFreeQueue *output_queue
+    SpscRing *free_queue;              // consumed rows go back here when set, otherwise they are freed
+    atomic_bool input_finished;        // producer has enqueued its last row
+    int64_t resample_interval_ms;      // rows are aggregated to this interval first when non-zero
     // Other members of the struct...
 } PreProcessingArgs;
 
@@ -66,20 +71,23 @@ typedef struct PriceLevels
 
 #define DEFAULT_CALCULATION_INTERVAL 1000
 #define MAX_RECORDS_TO_PROCESS 10000
+#define PRE_PROCESSING_BATCH 64   // rows taken from the input ring at once
+#define PUBLISH_RETRIES 10        // attempts to publish a batch while queue nodes cannot be allocated
 #define WINDOW_SIZE 100
 #define EMA_ALPHA 0.1
 #define RSI_PERIOD 14
 #define BOLLINGER_MULTIPLIER 2
 
 
-PreProcessedData *pre_process_data(const MarketData *market_data, size_t data_count, size_t rolling_volatility_window_size, size_t custom_window_size);
-double *calculate_price_differences(const MarketData *market_data, size_t data_count);
+// The indicator functions scan plain column arrays (see MarketDataColumns) so each pass is sequential
+PreProcessedData *pre_process_data(const MarketDataColumns *columns, size_t rolling_volatility_window_size, size_t custom_window_size);
+double *calculate_price_differences(const double *close, size_t data_count);
 double *calculate_rolling_volatilities(const double *price_differences, size_t price_difference_count, size_t window_size);
-PriceLevels calculate_price_levels(const MarketData *market_data, size_t data_count);
-double calculate_support_level(const MarketData *market_data, size_t data_count);
-double calculate_resistance_level(const MarketData *market_data, size_t data_count);
-void update_price_differences(PreProcessedData *data, const MarketData *new_data, size_t new_data_count);
-void update_rolling_volatilities(PreProcessedData *data, const MarketData *new_data, size_t new_data_count, size_t window_size);
+PriceLevels calculate_price_levels(const double *high, const double *low, const double *close, size_t data_count);
+double calculate_support_level(const double *high, const double *low, const double *close, size_t data_count);
+double calculate_resistance_level(const double *high, const double *low, const double *close, size_t data_count);
+void update_price_differences(PreProcessedData *data, const double *new_close, size_t new_data_count);
+void update_rolling_volatilities(PreProcessedData *data, const double *new_close, size_t new_data_count, size_t window_size);
 void *pre_processing_thread(void *args);
 
 #endif // PRE_PROCESSING_BINANCE_H
@@ -3,25 +3,34 @@
 
 #include <stdlib.h>
 #include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include "market_data_array.h"
-#include "pre_processing_binance.h"
+
+// Full definition lives in pre_processing_binance.h, which includes this header
+typedef struct PreProcessedData PreProcessedData;
 
 typedef struct ProcessQueueNode ProcessQueueNode;
 typedef struct ProcesLockFreeNode ProcesLockFreeNode;
 
 struct ProcessQueueNode {
     PreProcessedData *data;
-    ProcessQueueNode *next;
+    _Atomic uintptr_t next;   // tagged pointer to the next node
 };
 
+// Same Michael-Scott queue as LockFreeQueue: tagged head and tail, nodes reclaimed
+// through hazard pointers
 struct ProcesLockFreeNode {
-    ProcessQueueNode *head;
-    ProcessQueueNode *tail;
+    _Alignas(64) _Atomic uintptr_t head;
+    _Alignas(64) _Atomic uintptr_t tail;
 };
 
 ProcesLockFreeNode *proces_queue_init();
 bool proces_enqueue(ProcesLockFreeNode *queue, PreProcessedData *data);
 PreProcessedData *proces_dequeue(ProcesLockFreeNode *queue);
+// Bulk forms of the two above, each a single swap on the shared queue; see lock_free_queue.h
+size_t proces_enqueue_bulk(ProcesLockFreeNode *queue, PreProcessedData *const *items, size_t count);
+size_t proces_dequeue_bulk(ProcesLockFreeNode *queue, PreProcessedData **items, size_t max);
 void proces_queue_destroy(ProcesLockFreeNode *queue);
 
 #endif // PROCES_QUEUE_H
@@ -0,0 +1,34 @@
+#ifndef STREAM_READER_H
+#define STREAM_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "market_data_array.h"
+#include "spsc_ring.h"
+
+// Arguments for a reader thread that parses a CSV file row by row into a queue.
+// Rows are taken from free_queue and returned there by the consumer, so the
+// number of rows alive at once never exceeds the slots seeded into it.
+typedef struct StreamReaderArgs {
+    const char *filename;
+    SpscRing *output_queue;
+    SpscRing *free_queue;
+    int64_t start_time_ms;    // rows opening before this are skipped
+    int64_t end_time_ms;      // reading stops at the first row opening at or after this
+    size_t max_records;
+    atomic_bool *finished;    // set once the last row has been enqueued
+    size_t rows_read;
+    int status;
+} StreamReaderArgs;
+
+#define STREAM_READER_BACKOFF_US 50
+
+bool stream_reader_seed(SpscRing *free_queue, size_t slots);
+// Function to push onto a ring, backing off while the consumer catches up
+void stream_reader_push(SpscRing *queue, MarketData *row);
+// Function to push a run of rows onto a ring, one index update per attempt
+void stream_reader_push_bulk(SpscRing *queue, MarketData *const *rows, size_t count);
+void *stream_reader_thread(void *args);
+
+#endif // STREAM_READER_H
@@ -0,0 +1,242 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bar_resampler.h"
+
+// Reductions keep four independent lanes so there is no loop-carried dependency
+// on a single accumulator; the compiler maps the lanes onto SIMD max/min/add
+#define RESAMPLE_LANES 4
+
+// Start of the epoch-aligned bucket holding time_ms, correct for negative times too
+static inline int64_t bucket_start(int64_t time_ms, int64_t interval_ms) {
+    int64_t offset = time_ms % interval_ms;
+    return time_ms - (offset + (offset < 0) * interval_ms);
+}
+
+static double reduce_max(const double *restrict values, size_t count) {
+    double lane[RESAMPLE_LANES] = {values[0], values[0], values[0], values[0]};
+    size_t i = 0;
+    for (; i + RESAMPLE_LANES <= count; i += RESAMPLE_LANES) {
+        for (size_t k = 0; k < RESAMPLE_LANES; k++) {
+            lane[k] = values[i + k] > lane[k] ? values[i + k] : lane[k];
+        }
+    }
+    for (; i < count; i++) {
+        lane[0] = values[i] > lane[0] ? values[i] : lane[0];
+    }
+    double a = lane[0] > lane[1] ? lane[0] : lane[1];
+    double b = lane[2] > lane[3] ? lane[2] : lane[3];
+    return a > b ? a : b;
+}
+
+static double reduce_min(const double *restrict values, size_t count) {
+    double lane[RESAMPLE_LANES] = {values[0], values[0], values[0], values[0]};
+    size_t i = 0;
+    for (; i + RESAMPLE_LANES <= count; i += RESAMPLE_LANES) {
+        for (size_t k = 0; k < RESAMPLE_LANES; k++) {
+            lane[k] = values[i + k] < lane[k] ? values[i + k] : lane[k];
+        }
+    }
+    for (; i < count; i++) {
+        lane[0] = values[i] < lane[0] ? values[i] : lane[0];
+    }
+    double a = lane[0] < lane[1] ? lane[0] : lane[1];
+    double b = lane[2] < lane[3] ? lane[2] : lane[3];
+    return a < b ? a : b;
+}
+
+static double reduce_sum(const double *restrict values, size_t count) {
+    double lane[RESAMPLE_LANES] = {0};
+    size_t i = 0;
+    for (; i + RESAMPLE_LANES <= count; i += RESAMPLE_LANES) {
+        for (size_t k = 0; k < RESAMPLE_LANES; k++) {
+            lane[k] += values[i + k];
+        }
+    }
+    for (; i < count; i++) {
+        lane[0] += values[i];
+    }
+    return (lane[0] + lane[1]) + (lane[2] + lane[3]);
+}
+
+static int64_t reduce_sum_int(const int64_t *restrict values, size_t count) {
+    int64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+// Function to convert an interval such as "5m", "15m", "1h" or "1d" to milliseconds, 0 if invalid
+int64_t resample_interval_ms(const char *interval) {
+    char *end;
+    long long count = strtoll(interval, &end, 10);
+    if (end == interval || count <= 0 || end[0] == '\0' || end[1] != '\0') {
+        return 0;
+    }
+
+    int64_t unit;
+    switch (end[0]) {
+    case 'm': unit = 60LL * 1000; break;
+    case 'h': unit = 60LL * 60 * 1000; break;
+    case 'd': unit = 24LL * 60 * 60 * 1000; break;
+    default: return 0;
+    }
+    int64_t interval_ms = (int64_t)count * unit;
+    return interval_ms <= RESAMPLE_MAX_INTERVAL_MS ? interval_ms : 0;
+}
+
+// Function to aggregate columns into interval_ms bars; rows must be in time order and finer than the interval
+MarketDataColumns *resample_columns(const MarketDataColumns *columns, int64_t interval_ms, bool fill_gaps) {
+    size_t count = columns->length;
+    if (interval_ms <= 0) {
+        printf("Invalid resample interval\n");
+        return NULL;
+    }
+    if (count > 0 && columns->close_time[0] - columns->open_time[0] >= interval_ms) {
+        printf("Resample interval is not coarser than the source bars\n");
+        return NULL;
+    }
+
+    // Pass 1: indices where a new bucket starts, compacted without a branch
+    size_t *starts = (size_t *)malloc((count + 1) * sizeof(size_t));
+    if (starts == NULL) {
+        return NULL;
+    }
+    size_t bucket_count = 0;
+    int64_t previous = count > 0 ? bucket_start(columns->open_time[0], interval_ms) - interval_ms : 0;
+    for (size_t i = 0; i < count; i++) {
+        int64_t bucket = bucket_start(columns->open_time[i], interval_ms);
+        starts[bucket_count] = i;
+        bucket_count += bucket != previous;
+        previous = bucket;
+    }
+    starts[bucket_count] = count;
+
+    MarketDataColumns *out = market_data_columns_init(bucket_count);
+    if (out == NULL) {
+        free(starts);
+        return NULL;
+    }
+
+    // Pass 2: each bucket is a contiguous run, reduced column by column
+    for (size_t k = 0; k < bucket_count; k++) {
+        size_t first = starts[k];
+        size_t length = starts[k + 1] - first;
+        MarketData bar;
+        bar.open_time_ms = bucket_start(columns->open_time[first], interval_ms);
+        bar.close_time_ms = bar.open_time_ms + interval_ms - 1;
+
+        if (fill_gaps && out->length > 0) {
+            MarketData flat;
+            market_data_columns_row(out, out->length - 1, &flat);
+            flat.open = flat.high = flat.low = flat.close;
+            flat.volume = flat.quote_av = flat.tb_base_av = flat.tb_quote_av = 0;
+            flat.trades = 0;
+            for (flat.open_time_ms += interval_ms; flat.open_time_ms < bar.open_time_ms; flat.open_time_ms += interval_ms) {
+                flat.close_time_ms = flat.open_time_ms + interval_ms - 1;
+                if (!market_data_columns_append(out, &flat)) {
+                    market_data_columns_free(out);
+                    free(starts);
+                    return NULL;
+                }
+            }
+        }
+
+        bar.open = columns->open[first];
+        bar.close = columns->close[first + length - 1];
+        bar.high = reduce_max(columns->high + first, length);
+        bar.low = reduce_min(columns->low + first, length);
+        bar.volume = reduce_sum(columns->volume + first, length);
+        bar.quote_av = reduce_sum(columns->quote_av + first, length);
+        bar.trades = (int)reduce_sum_int(columns->trades + first, length);
+        bar.tb_base_av = reduce_sum(columns->tb_base_av + first, length);
+        bar.tb_quote_av = reduce_sum(columns->tb_quote_av + first, length);
+        bar.ignore = 0;
+        if (!market_data_columns_append(out, &bar)) {
+            market_data_columns_free(out);
+            free(starts);
+            return NULL;
+        }
+    }
+
+    free(starts);
+    return out;
+}
+
+// Function to resample a MarketDataArray into out, replacing its contents
+int resample_market_data(const MarketDataArray *array, int64_t interval_ms, bool fill_gaps, MarketDataArray *out) {
+    MarketDataColumns *columns = market_data_columns_from_array(array);
+    MarketDataColumns *bars = columns ? resample_columns(columns, interval_ms, fill_gaps) : NULL;
+    market_data_columns_free(columns);
+    if (bars == NULL) {
+        return -1;
+    }
+
+    out->length = 0;
+    for (size_t i = 0; i < bars->length; i++) {
+        if (out->length == out->capacity) {
+            market_data_array_resize(out);
+        }
+        market_data_columns_row(bars, i, &out->data[out->length++]);
+    }
+    market_data_columns_free(bars);
+    return 0;
+}
+
+// Function to start resampling a stream
+void bar_resampler_init(BarResampler *resampler, int64_t interval_ms) {
+    memset(resampler, 0, sizeof(*resampler));
+    resampler->interval_ms = interval_ms;
+}
+
+// Function to add one row; completed bars are written to out and their count returned (at most 2).
+// A bar completes as soon as the row closing its bucket arrives, or when a row from a later bucket
+// shows the rest of it is missing.
+size_t bar_resampler_push(BarResampler *resampler, const MarketData *row, MarketData *out, size_t out_capacity) {
+    size_t emitted = 0;
+    MarketData *bar = &resampler->bar;
+    int64_t bucket = bucket_start(row->open_time_ms, resampler->interval_ms);
+
+    if (resampler->has_bar && bucket != bar->open_time_ms) {
+        if (emitted < out_capacity) {
+            out[emitted++] = *bar;
+        }
+        resampler->has_bar = false;
+    }
+
+    if (!resampler->has_bar) {
+        *bar = *row;
+        bar->open_time_ms = bucket;
+        bar->close_time_ms = bucket + resampler->interval_ms - 1;
+        bar->ignore = 0;
+        resampler->has_bar = true;
+    } else {
+        bar->high = row->high > bar->high ? row->high : bar->high;
+        bar->low = row->low < bar->low ? row->low : bar->low;
+        bar->close = row->close;
+        bar->volume += row->volume;
+        bar->quote_av += row->quote_av;
+        bar->trades += row->trades;
+        bar->tb_base_av += row->tb_base_av;
+        bar->tb_quote_av += row->tb_quote_av;
+    }
+
+    if (row->close_time_ms >= bar->close_time_ms) {
+        if (emitted < out_capacity) {
+            out[emitted++] = *bar;
+        }
+        resampler->has_bar = false;
+    }
+    return emitted;
+}
+
+// Function to emit the partially aggregated bar at the end of a stream, false if there is none
+bool bar_resampler_flush(BarResampler *resampler, MarketData *out) {
+    if (!resampler->has_bar) {
+        return false;
+    }
+    *out = resampler->bar;
+    resampler->has_bar = false;
+    return true;
+}
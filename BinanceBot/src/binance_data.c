@@ -1,14 +1,132 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
 #include "market_data_array.h"
 
+// Largest numeric field handed to the strtod fallback
+#define CSV_MAX_FIELD 64
+
+// Upper bound on loader threads, and the smallest chunk worth giving a thread
+#define CSV_MAX_THREADS 64
+#define CSV_MIN_CHUNK_BYTES (1 << 20)
+
+// Exact powers of ten; mantissa / 10^n is correctly rounded while both are exact doubles
+static const double pow10_table[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Function to create a MarketDataArray
+MarketDataArray *market_data_array_init(size_t initial_capacity) {
+    MarketDataArray *array = (MarketDataArray *)malloc(sizeof(MarketDataArray));
+    if (array == NULL) {
+        return NULL;
+    }
+
+    if (initial_capacity == 0) {
+        initial_capacity = 1;
+    }
+
+    array->data = (MarketData *)malloc(initial_capacity * sizeof(MarketData));
+    if (array->data == NULL) {
+        free(array);
+        return NULL;
+    }
+    array->length = 0;
+    array->capacity = initial_capacity;
+
+    return array;
+}
+
 // Function to resize a MarketDataArray
 void market_data_array_resize(MarketDataArray *array) {
     array->capacity *= 2;
     array->data = realloc(array->data, array->capacity * sizeof(MarketData));
 }
 
+// Function to grow a MarketDataArray to hold at least min_capacity records
+static bool market_data_array_reserve(MarketDataArray *array, size_t min_capacity) {
+    if (array->capacity >= min_capacity) {
+        return true;
+    }
+
+    MarketData *data = realloc(array->data, min_capacity * sizeof(MarketData));
+    if (data == NULL) {
+        return false;
+    }
+    array->data = data;
+    array->capacity = min_capacity;
+    return true;
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date
+static long long days_from_civil(long long year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    long long era = (year >= 0 ? year : year - 399) / 400;
+    unsigned yoe = (unsigned)(year - era * 400);
+    unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (long long)doe - 719468;
+}
+
+// Function to convert "YYYY-MM-DD HH:MM:SS" (UTC) or epoch-millisecond text to epoch milliseconds, -1 on error
+long long market_data_parse_time_ms(const char *text) {
+    const char *p = text;
+    long long value = 0;
+    while ((unsigned)(*p - '0') < 10) {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    if (p == text) {
+        return -1;
+    }
+    if (*p == '\0' || *p == '.') {
+        return value;
+    }
+
+    unsigned month, day, hour = 0, minute = 0, second = 0;
+    if (*p != '-' || sscanf(p, "-%2u-%2u %2u:%2u:%2u", &month, &day, &hour, &minute, &second) < 2 ||
+        month < 1 || month > 12 || day < 1 || day > 31) {
+        return -1;
+    }
+
+    long long days = days_from_civil(value, month, day);
+    return ((days * 24 + hour) * 60 + minute) * 60000LL + second * 1000LL;
+}
+
+// Function to find the rows with open time in [start_time_ms, end_time_ms) by binary search,
+// returns false when the span is empty; rows must be in time order
+bool market_data_array_seek(const MarketDataArray *array, int64_t start_time_ms, int64_t end_time_ms, size_t *first, size_t *last) {
+    size_t lo = 0, hi = array->length;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (array->data[mid].open_time_ms < start_time_ms) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    *first = lo;
+
+    hi = array->length;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (array->data[mid].open_time_ms < end_time_ms) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    *last = lo;
+
+    return *first < *last;
+}
+
 // Function to free a MarketDataArray
 void market_data_array_free(MarketDataArray *array) {
     free(array->data);
@@ -27,6 +145,8 @@ void read_csv_file(const char *filename, MarketDataArray *array) {
     char line[200];
     fgets(line, sizeof(line), file);
 
+    char timestamp[20];
+    char close_time[20];
     while (fgets(line, sizeof(line), file)) {
         // Resize the array if it's full
         if (array->length == array->capacity) {
@@ -37,20 +157,527 @@ void read_csv_file(const char *filename, MarketDataArray *array) {
 
         // Parse the line into the MarketData structure
         sscanf(line, "%19[^,],%lf,%lf,%lf,%lf,%lf,%19[^,],%lf,%d,%lf,%lf,%d",
-            data->timestamp,
+            timestamp,
             &data->open,
             &data->high,
             &data->low,
             &data->close,
             &data->volume,
-            data->close_time,
+            close_time,
             &data->quote_av,
             &data->trades,
             &data->tb_base_av,
             &data->tb_quote_av,
             &data->ignore
         );
+        data->open_time_ms = market_data_parse_time_ms(timestamp);
+        data->close_time_ms = market_data_parse_time_ms(close_time);
     }
 
     fclose(file);
-}
\ No newline at end of file
+}
+
+// Slow path for decimals that do not fit the fast scanner (long mantissas, large exponents)
+static const char *scan_double_fallback(const char *p, const char *end, double *out) {
+    char buf[CSV_MAX_FIELD];
+    size_t n = 0;
+    while (p + n < end && n < sizeof(buf) - 1 && p[n] != ',' && p[n] != '\n' && p[n] != '\r') {
+        buf[n] = p[n];
+        n++;
+    }
+    buf[n] = '\0';
+
+    char *stop;
+    *out = strtod(buf, &stop);
+    return stop == buf ? NULL : p + (stop - buf);
+}
+
+// Scan a decimal such as "-29374.15000000" or "1.5e-05" in place, returns the first unread byte or NULL
+static const char *scan_double(const char *p, const char *end, double *out) {
+    const char *start = p;
+    bool negative = false;
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    int scale = 0;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+
+    while (p < end && (unsigned)(*p - '0') < 10) {
+        mantissa = mantissa * 10 + (unsigned)(*p - '0');
+        digits++;
+        p++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && (unsigned)(*p - '0') < 10) {
+            mantissa = mantissa * 10 + (unsigned)(*p - '0');
+            digits++;
+            scale++;
+            p++;
+        }
+    }
+    if (digits == 0) {
+        return NULL;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        return scan_double_fallback(start, end, out);
+    }
+
+    // More than 19 digits may have overflowed, and 2^53 bounds exact integer doubles
+    if (digits > 19 || mantissa > (1ULL << 53) || scale > 22) {
+        return scan_double_fallback(start, end, out);
+    }
+
+    double value = (double)mantissa / pow10_table[scale];
+    *out = negative ? -value : value;
+    return p;
+}
+
+// Scan a signed decimal integer in place, returns the first unread byte or NULL
+static const char *scan_int(const char *p, const char *end, int *out) {
+    bool negative = false;
+    long long value = 0;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+
+    // Stop before overflow; the leftover digits then fail the separator check
+    const char *digits_start = p;
+    while (p < end && (unsigned)(*p - '0') < 10 && value < 1000000000000LL) {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    if (p == digits_start) {
+        return NULL;
+    }
+
+    // pandas writes integer columns loaded as floats with a trailing ".0"
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && (unsigned)(*p - '0') < 10) {
+            p++;
+        }
+    }
+
+    *out = (int)(negative ? -value : value);
+    return p;
+}
+
+// Read exactly width digits at p into *out, returns false on any non-digit
+static inline bool scan_fixed_digits(const char *p, int width, unsigned *out) {
+    unsigned value = 0;
+    for (int i = 0; i < width; i++) {
+        unsigned digit = (unsigned)(p[i] - '0');
+        if (digit > 9) {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+    *out = value;
+    return true;
+}
+
+// Scan epoch-millisecond digits or a "YYYY-MM-DD HH:MM:SS" UTC time into epoch ms, returns the first unread byte or NULL
+static const char *scan_time_ms(const char *p, const char *end, int64_t *out) {
+    const char *start = p;
+    int64_t value = 0;
+    while (p < end && (unsigned)(*p - '0') < 10) {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    if (p == start) {
+        return NULL;
+    }
+    if (p == end || *p != '-') {
+        *out = value;
+        return p;
+    }
+
+    // Fixed-position date; the digits before '-' were the year
+    unsigned month, day, hour, minute, second;
+    if (p - start != 4 || end - p < 15 || p[3] != '-' || p[6] != ' ' || p[9] != ':' || p[12] != ':' ||
+        !scan_fixed_digits(p + 1, 2, &month) || !scan_fixed_digits(p + 4, 2, &day) ||
+        !scan_fixed_digits(p + 7, 2, &hour) || !scan_fixed_digits(p + 10, 2, &minute) ||
+        !scan_fixed_digits(p + 13, 2, &second) || month < 1 || month > 12 || day < 1) {
+        return NULL;
+    }
+    p += 15;
+
+    // Skip fractional seconds if present
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && (unsigned)(*p - '0') < 10) {
+            p++;
+        }
+    }
+
+    int64_t days = days_from_civil(value, month, day);
+    *out = ((days * 24 + hour) * 60 + minute) * 60000LL + second * 1000LL;
+    return p;
+}
+
+// Expect a ',' separator at p, returns the byte after it or NULL
+static inline const char *expect_comma(const char *p, const char *end) {
+    return (p != NULL && p < end && *p == ',') ? p + 1 : NULL;
+}
+
+// Parse one kline row spanning [p, end) without the newline, returns true on a complete row
+static bool parse_kline_row(const char *p, const char *end, MarketData *data) {
+    p = expect_comma(scan_time_ms(p, end, &data->open_time_ms), end);
+    if (p) p = expect_comma(scan_double(p, end, &data->open), end);
+    if (p) p = expect_comma(scan_double(p, end, &data->high), end);
+    if (p) p = expect_comma(scan_double(p, end, &data->low), end);
+    if (p) p = expect_comma(scan_double(p, end, &data->close), end);
+    if (p) p = expect_comma(scan_double(p, end, &data->volume), end);
+    if (p) p = expect_comma(scan_time_ms(p, end, &data->close_time_ms), end);
+    if (p) p = expect_comma(scan_double(p, end, &data->quote_av), end);
+    if (p) p = expect_comma(scan_int(p, end, &data->trades), end);
+    if (p) p = expect_comma(scan_double(p, end, &data->tb_base_av), end);
+    if (p) p = expect_comma(scan_double(p, end, &data->tb_quote_av), end);
+    if (p) p = scan_int(p, end, &data->ignore);
+    return p != NULL;
+}
+
+// Map a whole file read-only; an empty file maps to NULL with size 0
+static int map_csv_file(const char *filename, const char **base, size_t *size) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("Could not open file: %s\n", filename);
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        printf("Could not stat file: %s\n", filename);
+        close(fd);
+        return -1;
+    }
+
+    *base = NULL;
+    *size = (size_t)st.st_size;
+    if (*size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    const char *mapped = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        printf("Could not map file: %s\n", filename);
+        return -1;
+    }
+    madvise((void *)mapped, *size, MADV_SEQUENTIAL);
+
+    *base = mapped;
+    return 0;
+}
+
+// Skip the header line of a mapped CSV file
+static const char *skip_csv_header(const char *base, const char *end) {
+    const char *nl = memchr(base, '\n', (size_t)(end - base));
+    return nl ? nl + 1 : end;
+}
+
+// Count the lines in [p, end), including an unterminated last line
+static size_t count_csv_lines(const char *p, const char *end) {
+    size_t line_count = 0;
+    while (p < end) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        p = nl ? nl + 1 : end;
+        line_count++;
+    }
+    return line_count;
+}
+
+// Parse every line in [p, end) into out, returns the number of rows written
+static size_t parse_csv_lines(const char *p, const char *end, MarketData *out) {
+    size_t rows = 0;
+    while (p < end) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        const char *line_end = nl ? nl : end;
+        const char *next = nl ? nl + 1 : end;
+
+        if (line_end > p && line_end[-1] == '\r') {
+            line_end--;
+        }
+
+        // Malformed and blank rows are dropped rather than left half-filled
+        if (line_end > p && parse_kline_row(p, line_end, &out[rows])) {
+            rows++;
+        }
+        p = next;
+    }
+    return rows;
+}
+
+// Function to read a CSV file through a read-only mapping, parsing every field in place
+int read_csv_file_mmap(const char *filename, MarketDataArray *array) {
+    const char *base;
+    size_t size;
+    if (map_csv_file(filename, &base, &size) != 0) {
+        return -1;
+    }
+    if (size == 0) {
+        return 0;
+    }
+
+    const char *end = base + size;
+    const char *p = skip_csv_header(base, end);
+
+    // Count the remaining lines once so the array is sized exactly
+    size_t line_count = count_csv_lines(p, end);
+    if (!market_data_array_reserve(array, array->length + line_count)) {
+        printf("Not enough memory for %zu rows from %s\n", line_count, filename);
+        munmap((void *)base, size);
+        return -1;
+    }
+
+    array->length += parse_csv_lines(p, end, &array->data[array->length]);
+
+    munmap((void *)base, size);
+    return 0;
+}
+
+typedef struct CsvChunk {
+    const char *begin;
+    const char *end;
+    MarketData *out;
+    size_t line_count;
+    size_t rows;
+} CsvChunk;
+
+static void *count_csv_chunk(void *arg) {
+    CsvChunk *chunk = (CsvChunk *)arg;
+    chunk->line_count = count_csv_lines(chunk->begin, chunk->end);
+    return NULL;
+}
+
+static void *parse_csv_chunk(void *arg) {
+    CsvChunk *chunk = (CsvChunk *)arg;
+    chunk->rows = parse_csv_lines(chunk->begin, chunk->end, chunk->out);
+    return NULL;
+}
+
+// Run fn over every chunk, chunk 0 on the calling thread; returns false if a thread could not start
+static bool run_csv_chunks(CsvChunk *chunks, pthread_t *threads, int chunk_count, void *(*fn)(void *)) {
+    int started = 1;
+    bool ok = true;
+    for (; started < chunk_count; started++) {
+        if (pthread_create(&threads[started], NULL, fn, &chunks[started]) != 0) {
+            ok = false;
+            break;
+        }
+    }
+
+    fn(&chunks[0]);
+
+    for (int i = 1; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    // Finish any chunks whose thread failed to start inline
+    for (int i = started; i < chunk_count; i++) {
+        fn(&chunks[i]);
+    }
+    return ok;
+}
+
+// Function to read a CSV file with thread_count threads, each parsing a newline-aligned chunk
+int read_csv_file_parallel(const char *filename, MarketDataArray *array, int thread_count) {
+    if (thread_count <= 1) {
+        return read_csv_file_mmap(filename, array);
+    }
+    if (thread_count > CSV_MAX_THREADS) {
+        thread_count = CSV_MAX_THREADS;
+    }
+
+    const char *base;
+    size_t size;
+    if (map_csv_file(filename, &base, &size) != 0) {
+        return -1;
+    }
+    if (size == 0) {
+        return 0;
+    }
+
+    const char *end = base + size;
+    const char *body = skip_csv_header(base, end);
+    size_t body_size = (size_t)(end - body);
+
+    // Small files are not worth a thread per core
+    size_t max_chunks = body_size / CSV_MIN_CHUNK_BYTES + 1;
+    if ((size_t)thread_count > max_chunks) {
+        thread_count = (int)max_chunks;
+    }
+
+    CsvChunk chunks[CSV_MAX_THREADS];
+    pthread_t threads[CSV_MAX_THREADS];
+
+    // Split at nominal offsets, then move each boundary past the next newline
+    const char *begin = body;
+    for (int i = 0; i < thread_count; i++) {
+        const char *chunk_end = end;
+        if (i < thread_count - 1) {
+            chunk_end = body + body_size / (size_t)thread_count * (size_t)(i + 1);
+            if (chunk_end < begin) {
+                chunk_end = begin;
+            }
+            const char *nl = memchr(chunk_end, '\n', (size_t)(end - chunk_end));
+            chunk_end = nl ? nl + 1 : end;
+        }
+        chunks[i].begin = begin;
+        chunks[i].end = chunk_end;
+        begin = chunk_end;
+    }
+
+    // First pass counts lines so every chunk gets its own slice of the output array
+    run_csv_chunks(chunks, threads, thread_count, count_csv_chunk);
+
+    size_t line_count = 0;
+    for (int i = 0; i < thread_count; i++) {
+        line_count += chunks[i].line_count;
+    }
+    if (!market_data_array_reserve(array, array->length + line_count)) {
+        printf("Not enough memory for %zu rows from %s\n", line_count, filename);
+        munmap((void *)base, size);
+        return -1;
+    }
+
+    MarketData *out = &array->data[array->length];
+    for (int i = 0; i < thread_count; i++) {
+        chunks[i].out = out;
+        out += chunks[i].line_count;
+    }
+
+    run_csv_chunks(chunks, threads, thread_count, parse_csv_chunk);
+
+    // Stitch the slices together in file order, closing gaps left by dropped rows
+    for (int i = 0; i < thread_count; i++) {
+        MarketData *dst = &array->data[array->length];
+        if (chunks[i].out != dst) {
+            memmove(dst, chunks[i].out, chunks[i].rows * sizeof(MarketData));
+        }
+        array->length += chunks[i].rows;
+    }
+
+    munmap((void *)base, size);
+    return 0;
+}
+
+// Function to open a CSV file for incremental reading through a fixed-size buffer
+MarketDataStream *market_data_stream_open(const char *filename) {
+    return market_data_stream_open_buffered(filename, MARKET_DATA_STREAM_BUFFER);
+}
+
+// Function to open a stream reading through a buffer of buffer_size bytes; rows longer than
+// the buffer are skipped
+MarketDataStream *market_data_stream_open_buffered(const char *filename, size_t buffer_size) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("Could not open file: %s\n", filename);
+        return NULL;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    MarketDataStream *stream = (MarketDataStream *)malloc(sizeof(MarketDataStream));
+    char *buffer = (char *)malloc(buffer_size);
+    if (stream == NULL || buffer == NULL) {
+        free(stream);
+        free(buffer);
+        close(fd);
+        return NULL;
+    }
+
+    stream->fd = fd;
+    stream->buffer = buffer;
+    stream->capacity = buffer_size;
+    stream->begin = 0;
+    stream->end = 0;
+    stream->eof = false;
+    stream->header_skipped = false;
+    stream->discarding = false;
+    return stream;
+}
+
+// Move the unread tail to the front of the buffer and top it up, returns false on a read error
+static bool market_data_stream_fill(MarketDataStream *stream) {
+    size_t pending = stream->end - stream->begin;
+    if (stream->begin > 0) {
+        memmove(stream->buffer, stream->buffer + stream->begin, pending);
+        stream->begin = 0;
+        stream->end = pending;
+    }
+
+    while (stream->end < stream->capacity) {
+        ssize_t n = read(stream->fd, stream->buffer + stream->end, stream->capacity - stream->end);
+        if (n < 0) {
+            return false;
+        }
+        if (n == 0) {
+            stream->eof = true;
+            break;
+        }
+        stream->end += (size_t)n;
+    }
+    return true;
+}
+
+// Function to parse the next row into out, returns 1 for a row, 0 at end of file and -1 on a read error
+int market_data_stream_next(MarketDataStream *stream, MarketData *out) {
+    for (;;) {
+        const char *p = stream->buffer + stream->begin;
+        size_t available = stream->end - stream->begin;
+        const char *nl = memchr(p, '\n', available);
+
+        if (nl == NULL) {
+            if (!stream->eof) {
+                // A line longer than the whole buffer is not a kline row; drop what we have of it
+                // and the rest of it up to its newline
+                if (available == stream->capacity) {
+                    stream->begin = stream->end;
+                    stream->discarding = true;
+                }
+                if (!market_data_stream_fill(stream)) {
+                    return -1;
+                }
+                continue;
+            }
+            if (available == 0) {
+                return 0;
+            }
+            // Unterminated last line
+            nl = p + available;
+        }
+
+        const char *line_end = nl;
+        stream->begin = (size_t)(nl - stream->buffer) + (nl < stream->buffer + stream->end ? 1 : 0);
+        if (line_end > p && line_end[-1] == '\r') {
+            line_end--;
+        }
+
+        if (stream->discarding) {
+            stream->discarding = false;
+            continue;
+        }
+        if (!stream->header_skipped) {
+            stream->header_skipped = true;
+            continue;
+        }
+        if (line_end > p && parse_kline_row(p, line_end, out)) {
+            return 1;
+        }
+    }
+}
+
+// Function to close a stream opened with market_data_stream_open
+void market_data_stream_close(MarketDataStream *stream) {
+    if (stream) {
+        close(stream->fd);
+        free(stream->buffer);
+        free(stream);
+    }
+}
@@ -23,6 +23,54 @@ int load_config(const char *config_file_path, ConfigParams *params)
         config_lookup_int(&cfg, "DEFAULTS.RSI_PERIOD", &(params->rsi_period)) &&
         config_lookup_float(&cfg, "DEFAULTS.BOLLINGER_MULTIPLIER", &(params->bollinger_multiplier)))
     {
+        // Optional settings keep their defaults when absent
+        if (!config_lookup_int(&cfg, "DEFAULTS.LOAD_THREADS", &(params->load_threads)))
+        {
+            params->load_threads = 1;
+        }
+        if (!config_lookup_int64(&cfg, "DEFAULTS.START_TIME_MS", &(params->start_time_ms)))
+        {
+            params->start_time_ms = 0;
+        }
+        if (!config_lookup_int64(&cfg, "DEFAULTS.END_TIME_MS", &(params->end_time_ms)))
+        {
+            params->end_time_ms = 0;
+        }
+        if (!config_lookup_int(&cfg, "DEFAULTS.STREAM_INPUT", &(params->stream_input)))
+        {
+            params->stream_input = 0;
+        }
+        if (!config_lookup_int(&cfg, "DEFAULTS.STREAM_QUEUE_ROWS", &(params->stream_queue_rows)) ||
+            params->stream_queue_rows <= 0)
+        {
+            params->stream_queue_rows = 4096;
+        }
+        const char *text;
+        if (!config_lookup_string(&cfg, "DEFAULTS.SYMBOL", &text))
+        {
+            text = "BTCUSDT";
+        }
+        snprintf(params->symbol, sizeof(params->symbol), "%s", text);
+        if (!config_lookup_string(&cfg, "DEFAULTS.INTERVAL", &text))
+        {
+            text = "1m";
+        }
+        snprintf(params->interval, sizeof(params->interval), "%s", text);
+        if (!config_lookup_int(&cfg, "DEFAULTS.CATALOG_MEMORY_MB", &(params->catalog_memory_mb)) ||
+            params->catalog_memory_mb <= 0)
+        {
+            params->catalog_memory_mb = 1024;
+        }
+        if (!config_lookup_string(&cfg, "DEFAULTS.RESAMPLE_INTERVAL", &text))
+        {
+            text = "";
+        }
+        snprintf(params->resample_interval, sizeof(params->resample_interval), "%s", text);
+        if (!config_lookup_int(&cfg, "DEFAULTS.RESAMPLE_FILL_GAPS", &(params->resample_fill_gaps)))
+        {
+            params->resample_fill_gaps = 0;
+        }
+
         config_destroy(&cfg);
         return(EXIT_SUCCESS);
     }
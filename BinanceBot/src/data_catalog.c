@@ -0,0 +1,316 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "data_catalog.h"
+
+// FNV-1a over "symbol\0interval"
+static uint64_t catalog_hash(const char *symbol, const char *interval) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (const char *p = symbol; *p; p++) {
+        hash = (hash ^ (uint8_t)*p) * 1099511628211ULL;
+    }
+    hash = (hash ^ 0) * 1099511628211ULL;
+    for (const char *p = interval; *p; p++) {
+        hash = (hash ^ (uint8_t)*p) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Split SYMBOL_INTERVAL.kbin or SYMBOL_INTERVAL.kgor into its parts, false for files that are not catalog entries
+static bool parse_file_name(const char *name, char *symbol, char *interval, bool *compressed) {
+    size_t length = strlen(name);
+    if (length <= 5) {
+        return false;
+    }
+    *compressed = strcmp(name + length - 5, ".kgor") == 0;
+    if (!*compressed && strcmp(name + length - 5, ".kbin") != 0) {
+        return false;
+    }
+    length -= 5;
+
+    const char *separator = NULL;
+    for (const char *p = name; p < name + length; p++) {
+        if (*p == '_') {
+            separator = p;
+        }
+    }
+    if (separator == NULL || separator == name) {
+        return false;
+    }
+
+    size_t symbol_length = (size_t)(separator - name);
+    size_t interval_length = length - symbol_length - 1;
+    if (interval_length == 10 && strncmp(separator + 1, "MinuteBars", 10) == 0) {
+        strcpy(interval, "1m");
+    } else if (interval_length == 0 || interval_length >= DATA_CATALOG_INTERVAL_LENGTH) {
+        return false;
+    } else {
+        memcpy(interval, separator + 1, interval_length);
+        interval[interval_length] = '\0';
+    }
+    if (symbol_length >= DATA_CATALOG_SYMBOL_LENGTH) {
+        return false;
+    }
+    memcpy(symbol, name, symbol_length);
+    symbol[symbol_length] = '\0';
+    return true;
+}
+
+static void lru_unlink(DataCatalog *catalog, DataCatalogEntry *entry) {
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        catalog->lru_head = entry->lru_next;
+    }
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        catalog->lru_tail = entry->lru_prev;
+    }
+    entry->lru_prev = entry->lru_next = NULL;
+}
+
+static void lru_push_front(DataCatalog *catalog, DataCatalogEntry *entry) {
+    entry->lru_prev = NULL;
+    entry->lru_next = catalog->lru_head;
+    if (catalog->lru_head) {
+        catalog->lru_head->lru_prev = entry;
+    } else {
+        catalog->lru_tail = entry;
+    }
+    catalog->lru_head = entry;
+}
+
+static void unmap_entry(DataCatalog *catalog, DataCatalogEntry *entry) {
+    lru_unlink(catalog, entry);
+    market_data_columns_free(entry->columns);
+    kline_store_close(entry->store);
+    entry->columns = NULL;
+    entry->store = NULL;
+    catalog->mapped_bytes -= entry->resident_bytes;
+    entry->resident_bytes = 0;
+}
+
+// Map a .kbin file or decode a .kgor history; a decoded history is charged at its decoded size
+static bool load_entry(DataCatalogEntry *entry) {
+    if (entry->compressed) {
+        CompressedHistory *history = history_open(entry->path);
+        entry->columns = history ? history_decompress_range(history, INT64_MIN, INT64_MAX) : NULL;
+        if (history) {
+            entry->file_size = history->size;
+        }
+        history_free(history);
+        if (entry->columns == NULL) {
+            return false;
+        }
+        entry->resident_bytes = entry->columns->capacity * KLINE_COLUMN_COUNT * sizeof(int64_t);
+        return true;
+    }
+
+    entry->store = kline_store_open(entry->path);
+    entry->columns = entry->store ? market_data_columns_from_store(entry->store) : NULL;
+    if (entry->columns == NULL) {
+        kline_store_close(entry->store);
+        entry->store = NULL;
+        return false;
+    }
+    // The file may have been rewritten since the directory was indexed; charge what is mapped now
+    entry->file_size = entry->store->mapping_size;
+    entry->resident_bytes = entry->file_size;
+    return true;
+}
+
+// Unmap cold files from the tail until the mapped total fits the budget; pinned files stay
+static void evict_over_budget(DataCatalog *catalog) {
+    DataCatalogEntry *entry = catalog->lru_tail;
+    while (entry != NULL && catalog->mapped_bytes > catalog->memory_budget) {
+        DataCatalogEntry *previous = entry->lru_prev;
+        if (entry->pin_count == 0) {
+            unmap_entry(catalog, entry);
+        }
+        entry = previous;
+    }
+}
+
+static int compare_keys(const DataCatalogEntry *left, const DataCatalogEntry *right) {
+    int order = strcmp(left->symbol, right->symbol);
+    return order != 0 ? order : strcmp(left->interval, right->interval);
+}
+
+// Files with the same key are ordered by path, so which one the lookup keeps does not depend
+// on the directory's listing order
+static int compare_entries(const void *a, const void *b) {
+    const DataCatalogEntry *left = (const DataCatalogEntry *)a;
+    const DataCatalogEntry *right = (const DataCatalogEntry *)b;
+    int order = compare_keys(left, right);
+    return order != 0 ? order : strcmp(left->path, right->path);
+}
+
+// Function to index the .kbin and .kgor files in a directory; nothing is loaded until first access
+DataCatalog *data_catalog_open(const char *directory, size_t memory_budget) {
+    DIR *dir = opendir(directory);
+    if (dir == NULL) {
+        printf("Could not open directory: %s\n", directory);
+        return NULL;
+    }
+
+    DataCatalog *catalog = (DataCatalog *)calloc(1, sizeof(DataCatalog));
+    if (catalog == NULL) {
+        closedir(dir);
+        return NULL;
+    }
+    catalog->memory_budget = memory_budget;
+    pthread_mutex_init(&catalog->lock, NULL);
+
+    size_t capacity = 0;
+    struct dirent *dirent;
+    while ((dirent = readdir(dir)) != NULL) {
+        char symbol[DATA_CATALOG_SYMBOL_LENGTH];
+        char interval[DATA_CATALOG_INTERVAL_LENGTH];
+        bool compressed;
+        if (!parse_file_name(dirent->d_name, symbol, interval, &compressed)) {
+            continue;
+        }
+
+        size_t path_length = strlen(directory) + strlen(dirent->d_name) + 2;
+        char *path = (char *)malloc(path_length);
+        struct stat st;
+        if (path == NULL) {
+            continue;
+        }
+        snprintf(path, path_length, "%s/%s", directory, dirent->d_name);
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+            free(path);
+            continue;
+        }
+
+        if (catalog->entry_count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            DataCatalogEntry *entries = (DataCatalogEntry *)realloc(catalog->entries, capacity * sizeof(DataCatalogEntry));
+            if (entries == NULL) {
+                free(path);
+                break;
+            }
+            catalog->entries = entries;
+        }
+        DataCatalogEntry *entry = &catalog->entries[catalog->entry_count++];
+        memset(entry, 0, sizeof(*entry));
+        strcpy(entry->symbol, symbol);
+        strcpy(entry->interval, interval);
+        entry->path = path;
+        entry->file_size = (size_t)st.st_size;
+        entry->compressed = compressed;
+    }
+    closedir(dir);
+
+    // Sorted so listings are stable; the hash below gives the O(1) lookup
+    if (catalog->entry_count > 1) {
+        qsort(catalog->entries, catalog->entry_count, sizeof(DataCatalogEntry), compare_entries);
+    }
+
+    size_t slot_count = 16;
+    while (slot_count < catalog->entry_count * 2) {
+        slot_count *= 2;
+    }
+    catalog->slots = (size_t *)calloc(slot_count, sizeof(size_t));
+    if (catalog->slots == NULL) {
+        data_catalog_close(catalog);
+        return NULL;
+    }
+    catalog->slot_mask = slot_count - 1;
+
+    for (size_t i = 0; i < catalog->entry_count; i++) {
+        DataCatalogEntry *entry = &catalog->entries[i];
+        size_t slot = catalog_hash(entry->symbol, entry->interval) & catalog->slot_mask;
+        while (catalog->slots[slot] != 0) {
+            // A file with the same key (e.g. both BTCUSDT_1m and BTCUSDT_MinuteBars, or a .kbin and a .kgor)
+            // keeps the first by path: a .kbin before a .kgor of the same name
+            DataCatalogEntry *other = &catalog->entries[catalog->slots[slot] - 1];
+            if (compare_keys(entry, other) == 0) {
+                break;
+            }
+            slot = (slot + 1) & catalog->slot_mask;
+        }
+        if (catalog->slots[slot] == 0) {
+            catalog->slots[slot] = i + 1;
+        }
+    }
+    return catalog;
+}
+
+// Function to look up a file by symbol and interval, NULL if the catalog has none
+DataCatalogEntry *data_catalog_find(DataCatalog *catalog, const char *symbol, const char *interval) {
+    size_t slot = catalog_hash(symbol, interval) & catalog->slot_mask;
+    while (catalog->slots[slot] != 0) {
+        DataCatalogEntry *entry = &catalog->entries[catalog->slots[slot] - 1];
+        if (strcmp(entry->symbol, symbol) == 0 && strcmp(entry->interval, interval) == 0) {
+            return entry;
+        }
+        slot = (slot + 1) & catalog->slot_mask;
+    }
+    return NULL;
+}
+
+// Function to pin a file and find its rows in [start_time_ms, end_time_ms), loading it if needed
+int data_catalog_acquire(DataCatalog *catalog, const char *symbol, const char *interval,
+                         int64_t start_time_ms, int64_t end_time_ms, DataCatalogSlice *slice) {
+    memset(slice, 0, sizeof(*slice));
+    pthread_mutex_lock(&catalog->lock);
+
+    DataCatalogEntry *entry = data_catalog_find(catalog, symbol, interval);
+    if (entry == NULL) {
+        pthread_mutex_unlock(&catalog->lock);
+        printf("No data for %s %s\n", symbol, interval);
+        return -1;
+    }
+
+    if (entry->columns == NULL) {
+        if (!load_entry(entry)) {
+            pthread_mutex_unlock(&catalog->lock);
+            return -1;
+        }
+        catalog->mapped_bytes += entry->resident_bytes;
+    } else {
+        lru_unlink(catalog, entry);
+    }
+    lru_push_front(catalog, entry);
+    entry->pin_count++;
+    evict_over_budget(catalog);
+    pthread_mutex_unlock(&catalog->lock);
+
+    slice->entry = entry;
+    slice->columns = entry->columns;
+    market_data_columns_seek(entry->columns, start_time_ms, end_time_ms, &slice->first, &slice->last);
+    return 0;
+}
+
+// Function to unpin a slice; the file may be unmapped once nothing else holds it
+void data_catalog_release(DataCatalog *catalog, DataCatalogSlice *slice) {
+    if (slice->entry == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&catalog->lock);
+    slice->entry->pin_count--;
+    evict_over_budget(catalog);
+    pthread_mutex_unlock(&catalog->lock);
+    memset(slice, 0, sizeof(*slice));
+}
+
+// Function to unmap every file and free the catalog
+void data_catalog_close(DataCatalog *catalog) {
+    if (catalog == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < catalog->entry_count; i++) {
+        if (catalog->entries[i].columns) {
+            unmap_entry(catalog, &catalog->entries[i]);
+        }
+        free(catalog->entries[i].path);
+    }
+    pthread_mutex_destroy(&catalog->lock);
+    free(catalog->entries);
+    free(catalog->slots);
+    free(catalog);
+}
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "hazard_pointer.h"
+
+typedef struct {
+    void *node;
+    void (*reclaim)(void *);
+} RetiredNode;
+
+typedef struct {
+    _Alignas(64) _Atomic(void *) hazards[HAZARD_SLOTS];
+    atomic_bool active;                    // claimed by a live thread
+    size_t retired_count;
+    RetiredNode retired[HAZARD_RETIRE_THRESHOLD];
+} HazardRecord;
+
+static HazardRecord records[HAZARD_MAX_THREADS];
+// Records ever claimed; scans only look this far
+static atomic_int record_count;
+static _Thread_local HazardRecord *thread_record;
+static pthread_key_t record_key;
+static pthread_once_t record_key_once = PTHREAD_ONCE_INIT;
+
+static int compare_addresses(const void *a, const void *b) {
+    uintptr_t left = (uintptr_t)*(void *const *)a;
+    uintptr_t right = (uintptr_t)*(void *const *)b;
+    return (left > right) - (left < right);
+}
+
+// Free the record's retired nodes that no thread has published
+static void scan_record(HazardRecord *record) {
+    void *protected_nodes[HAZARD_MAX_THREADS * HAZARD_SLOTS];
+    size_t protected_count = 0;
+    int count = atomic_load(&record_count);
+    for (int i = 0; i < count; i++) {
+        for (int slot = 0; slot < HAZARD_SLOTS; slot++) {
+            void *node = atomic_load(&records[i].hazards[slot]);
+            if (node) {
+                protected_nodes[protected_count++] = node;
+            }
+        }
+    }
+    qsort(protected_nodes, protected_count, sizeof(void *), compare_addresses);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < record->retired_count; i++) {
+        RetiredNode retired = record->retired[i];
+        if (bsearch(&retired.node, protected_nodes, protected_count, sizeof(void *), compare_addresses)) {
+            record->retired[kept++] = retired;
+        } else {
+            retired.reclaim(retired.node);
+        }
+    }
+    record->retired_count = kept;
+}
+
+// Give the record back when its thread exits
+static void release_record(void *arg) {
+    HazardRecord *record = (HazardRecord *)arg;
+    for (int slot = 0; slot < HAZARD_SLOTS; slot++) {
+        atomic_store(&record->hazards[slot], NULL);
+    }
+    scan_record(record);
+    atomic_store(&record->active, false);
+}
+
+static void create_record_key(void) {
+    pthread_key_create(&record_key, release_record);
+}
+
+static HazardRecord *own_record(void) {
+    if (thread_record) {
+        return thread_record;
+    }
+    pthread_once(&record_key_once, create_record_key);
+    for (int i = 0; i < HAZARD_MAX_THREADS; i++) {
+        bool expected = false;
+        if (!atomic_load(&records[i].active) && atomic_compare_exchange_strong(&records[i].active, &expected, true)) {
+            int count = atomic_load(&record_count);
+            while (count < i + 1 && !atomic_compare_exchange_weak(&record_count, &count, i + 1)) {
+            }
+            thread_record = &records[i];
+            pthread_setspecific(record_key, thread_record);
+            return thread_record;
+        }
+    }
+    // Running on without a record would free nodes other threads are reading
+    printf("More than %d threads are using the lock-free queues\n", HAZARD_MAX_THREADS);
+    abort();
+}
+
+uintptr_t hazard_protect(_Atomic uintptr_t *source, int slot) {
+    HazardRecord *record = own_record();
+    uintptr_t word = atomic_load(source);
+    for (;;) {
+        atomic_store(&record->hazards[slot], tagged_pointer(word));
+        // The node may have been retired before the hazard became visible; only a
+        // second read that still finds it proves it was not
+        uintptr_t again = atomic_load(source);
+        if (again == word) {
+            return word;
+        }
+        word = again;
+    }
+}
+
+void hazard_set(int slot, uintptr_t word) {
+    atomic_store(&own_record()->hazards[slot], tagged_pointer(word));
+}
+
+void hazard_clear(int slot) {
+    atomic_store_explicit(&own_record()->hazards[slot], NULL, memory_order_release);
+}
+
+void hazard_retire(void *node, void (*reclaim)(void *)) {
+    HazardRecord *record = own_record();
+    record->retired[record->retired_count++] = (RetiredNode){node, reclaim};
+    if (record->retired_count >= HAZARD_RETIRE_THRESHOLD) {
+        scan_record(record);
+    }
+}
+
+void hazard_scan(void) {
+    scan_record(own_record());
+}
@@ -0,0 +1,645 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "history_codec.h"
+#include "market_data_columns.h"
+
+_Static_assert(sizeof(HistoryBlockHeader) % 8 == 0, "block header must keep streams 8-byte aligned");
+
+// Streams are zero-padded by this much so the bit reader can always load a whole word
+#define HISTORY_STREAM_PADDING 8
+#define HISTORY_FIXED_POINT_SCALE 1e8
+
+// Growable byte buffer used for streams and for the assembled history
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+} ByteBuffer;
+
+static bool buffer_reserve(ByteBuffer *buffer, size_t extra) {
+    if (buffer->size + extra <= buffer->capacity) {
+        return true;
+    }
+    size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+    while (capacity < buffer->size + extra) {
+        capacity *= 2;
+    }
+    uint8_t *data = realloc(buffer->data, capacity);
+    if (data == NULL) {
+        return false;
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return true;
+}
+
+static bool buffer_append(ByteBuffer *buffer, const void *bytes, size_t count) {
+    if (!buffer_reserve(buffer, count)) {
+        return false;
+    }
+    memcpy(buffer->data + buffer->size, bytes, count);
+    buffer->size += count;
+    return true;
+}
+
+// MSB-first bit writer
+typedef struct {
+    ByteBuffer *out;
+    uint64_t accumulator;
+    int pending_bits;
+    bool ok;
+} BitWriter;
+
+static void write_bits(BitWriter *writer, uint64_t value, int bits) {
+    if (bits > 32) {
+        write_bits(writer, value >> 32, bits - 32);
+        value &= 0xffffffffULL;
+        bits = 32;
+    }
+    if (bits == 0) {
+        return;
+    }
+    writer->accumulator = (writer->accumulator << bits) | (value & ((1ULL << bits) - 1));
+    writer->pending_bits += bits;
+    while (writer->pending_bits >= 8) {
+        writer->pending_bits -= 8;
+        uint8_t byte = (uint8_t)(writer->accumulator >> writer->pending_bits);
+        writer->ok = writer->ok && buffer_append(writer->out, &byte, 1);
+    }
+}
+
+static void flush_bits(BitWriter *writer) {
+    if (writer->pending_bits > 0) {
+        write_bits(writer, 0, 8 - writer->pending_bits);
+    }
+}
+
+// MSB-first bit reader; relies on HISTORY_STREAM_PADDING bytes after the stream
+typedef struct {
+    const uint8_t *data;
+    size_t bit_position;
+} BitReader;
+
+static inline uint64_t read_bits(BitReader *reader, int bits) {
+    if (bits > 32) {
+        uint64_t high = read_bits(reader, bits - 32);
+        return (high << 32) | read_bits(reader, 32);
+    }
+    if (bits == 0) {
+        return 0;
+    }
+    uint64_t word;
+    memcpy(&word, reader->data + (reader->bit_position >> 3), sizeof(word));
+    word = __builtin_bswap64(word);
+    word <<= reader->bit_position & 7;
+    reader->bit_position += (size_t)bits;
+    return word >> (64 - bits);
+}
+
+static inline uint64_t zigzag_encode(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t zigzag_decode(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static bool write_varint(ByteBuffer *out, uint64_t value) {
+    uint8_t bytes[10];
+    size_t n = 0;
+    while (value >= 0x80) {
+        bytes[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    bytes[n++] = (uint8_t)value;
+    return buffer_append(out, bytes, n);
+}
+
+static inline uint64_t read_varint(const uint8_t **p) {
+    uint64_t value = 0;
+    int shift = 0;
+    uint8_t byte;
+    do {
+        byte = *(*p)++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return value;
+}
+
+static inline uint64_t double_bits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline double bits_double(uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// ---- timestamps ----
+
+static bool is_regular(const int64_t *values, size_t count) {
+    for (size_t i = 2; i < count; i++) {
+        if (values[i] - values[i - 1] != values[1] - values[0]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool encode_regular(const int64_t *values, size_t count, ByteBuffer *out) {
+    int64_t header[2] = {values[0], count > 1 ? values[1] - values[0] : 0};
+    return buffer_append(out, header, sizeof(header));
+}
+
+static void decode_regular(const uint8_t *stream, size_t count, int64_t *out) {
+    int64_t header[2];
+    memcpy(header, stream, sizeof(header));
+    // Independent iterations, so this loop vectorizes
+    for (size_t i = 0; i < count; i++) {
+        out[i] = header[0] + (int64_t)i * header[1];
+    }
+}
+
+static bool encode_delta_of_delta(const int64_t *values, size_t count, ByteBuffer *out) {
+    BitWriter writer = {.out = out, .ok = true};
+    write_bits(&writer, (uint64_t)values[0], 64);
+    int64_t previous_delta = 0;
+    for (size_t i = 1; i < count; i++) {
+        int64_t delta = values[i] - values[i - 1];
+        int64_t dod = delta - previous_delta;
+        previous_delta = delta;
+
+        if (dod == 0) {
+            write_bits(&writer, 0x0, 1);
+        } else if (dod >= -63 && dod <= 64) {
+            write_bits(&writer, 0x2, 2);
+            write_bits(&writer, (uint64_t)(dod + 63), 7);
+        } else if (dod >= -255 && dod <= 256) {
+            write_bits(&writer, 0x6, 3);
+            write_bits(&writer, (uint64_t)(dod + 255), 9);
+        } else if (dod >= -2047 && dod <= 2048) {
+            write_bits(&writer, 0xe, 4);
+            write_bits(&writer, (uint64_t)(dod + 2047), 12);
+        } else {
+            write_bits(&writer, 0xf, 4);
+            write_bits(&writer, (uint64_t)dod, 64);
+        }
+    }
+    flush_bits(&writer);
+    return writer.ok;
+}
+
+static void decode_delta_of_delta(const uint8_t *stream, size_t count, int64_t *out) {
+    BitReader reader = {.data = stream};
+    out[0] = (int64_t)read_bits(&reader, 64);
+    int64_t delta = 0;
+    for (size_t i = 1; i < count; i++) {
+        int64_t dod;
+        if (read_bits(&reader, 1) == 0) {
+            dod = 0;
+        } else if (read_bits(&reader, 1) == 0) {
+            dod = (int64_t)read_bits(&reader, 7) - 63;
+        } else if (read_bits(&reader, 1) == 0) {
+            dod = (int64_t)read_bits(&reader, 9) - 255;
+        } else if (read_bits(&reader, 1) == 0) {
+            dod = (int64_t)read_bits(&reader, 12) - 2047;
+        } else {
+            dod = (int64_t)read_bits(&reader, 64);
+        }
+        delta += dod;
+        out[i] = out[i - 1] + delta;
+    }
+}
+
+// ---- doubles ----
+
+static bool encode_xor(const double *values, size_t count, ByteBuffer *out) {
+    BitWriter writer = {.out = out, .ok = true};
+    uint64_t previous = double_bits(values[0]);
+    write_bits(&writer, previous, 64);
+
+    int previous_leading = -1;
+    int previous_trailing = 0;
+    for (size_t i = 1; i < count; i++) {
+        uint64_t current = double_bits(values[i]);
+        uint64_t x = current ^ previous;
+        previous = current;
+
+        if (x == 0) {
+            write_bits(&writer, 0, 1);
+            continue;
+        }
+        write_bits(&writer, 1, 1);
+
+        int leading = __builtin_clzll(x);
+        int trailing = __builtin_ctzll(x);
+        if (leading > 31) {
+            leading = 31;
+        }
+
+        // Reuse the previous window when the meaningful bits still fit inside it
+        if (previous_leading >= 0 && leading >= previous_leading && trailing >= previous_trailing) {
+            write_bits(&writer, 0, 1);
+            write_bits(&writer, x >> previous_trailing, 64 - previous_leading - previous_trailing);
+        } else {
+            int significant = 64 - leading - trailing;
+            write_bits(&writer, 1, 1);
+            write_bits(&writer, (uint64_t)leading, 5);
+            write_bits(&writer, (uint64_t)(significant & 63), 6);  // 64 is stored as 0
+            write_bits(&writer, x >> trailing, significant);
+            previous_leading = leading;
+            previous_trailing = trailing;
+        }
+    }
+    flush_bits(&writer);
+    return writer.ok;
+}
+
+static void decode_xor(const uint8_t *stream, size_t count, double *out) {
+    BitReader reader = {.data = stream};
+    uint64_t previous = read_bits(&reader, 64);
+    out[0] = bits_double(previous);
+
+    int leading = 0;
+    int trailing = 0;
+    for (size_t i = 1; i < count; i++) {
+        if (read_bits(&reader, 1) != 0) {
+            if (read_bits(&reader, 1) != 0) {
+                leading = (int)read_bits(&reader, 5);
+                int significant = (int)read_bits(&reader, 6);
+                if (significant == 0) {
+                    significant = 64;
+                }
+                trailing = 64 - leading - significant;
+            }
+            previous ^= read_bits(&reader, 64 - leading - trailing) << trailing;
+        }
+        out[i] = bits_double(previous);
+    }
+}
+
+// True when every value survives a round trip through an int64 count of 1e-8 units,
+// which holds for exchange prices and quantities quoted to at most 8 decimals
+static bool fits_fixed_point(const double *values, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        double scaled = values[i] * HISTORY_FIXED_POINT_SCALE;
+        if (!(fabs(scaled) < 9e18)) {
+            return false;
+        }
+        // Compare bits so -0.0 and NaN fall back to XOR
+        if (double_bits((double)llround(scaled) / HISTORY_FIXED_POINT_SCALE) != double_bits(values[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool encode_fixed_point(const double *values, size_t count, ByteBuffer *out) {
+    bool ok = true;
+    int64_t previous = 0;
+    for (size_t i = 0; i < count && ok; i++) {
+        int64_t scaled = llround(values[i] * HISTORY_FIXED_POINT_SCALE);
+        ok = write_varint(out, zigzag_encode(scaled - previous));
+        previous = scaled;
+    }
+    return ok;
+}
+
+static void decode_fixed_point(const uint8_t *stream, size_t count, double *out) {
+    const uint8_t *p = stream;
+    int64_t previous = 0;
+    for (size_t i = 0; i < count; i++) {
+        previous += zigzag_decode(read_varint(&p));
+        out[i] = (double)previous / HISTORY_FIXED_POINT_SCALE;
+    }
+}
+
+// ---- counts ----
+
+static bool encode_zigzag_delta(const int64_t *values, size_t count, ByteBuffer *out) {
+    bool ok = true;
+    int64_t previous = 0;
+    for (size_t i = 0; i < count && ok; i++) {
+        ok = write_varint(out, zigzag_encode(values[i] - previous));
+        previous = values[i];
+    }
+    return ok;
+}
+
+static void decode_zigzag_delta(const uint8_t *stream, size_t count, int64_t *out) {
+    const uint8_t *p = stream;
+    int64_t previous = 0;
+    for (size_t i = 0; i < count; i++) {
+        previous += zigzag_decode(read_varint(&p));
+        out[i] = previous;
+    }
+}
+
+// ---- blocks ----
+
+static bool column_is_time(int column) {
+    return column == KLINE_COL_OPEN_TIME || column == KLINE_COL_CLOSE_TIME;
+}
+
+// Column arrays of a MarketDataColumns in KlineColumn order
+static void *column_pointer(const MarketDataColumns *columns, int column) {
+    switch (column) {
+    case KLINE_COL_OPEN_TIME:   return columns->open_time;
+    case KLINE_COL_CLOSE_TIME:  return columns->close_time;
+    case KLINE_COL_OPEN:        return columns->open;
+    case KLINE_COL_HIGH:        return columns->high;
+    case KLINE_COL_LOW:         return columns->low;
+    case KLINE_COL_CLOSE:       return columns->close;
+    case KLINE_COL_VOLUME:      return columns->volume;
+    case KLINE_COL_QUOTE_AV:    return columns->quote_av;
+    case KLINE_COL_TRADES:      return columns->trades;
+    case KLINE_COL_TB_BASE_AV:  return columns->tb_base_av;
+    case KLINE_COL_TB_QUOTE_AV: return columns->tb_quote_av;
+    }
+    return NULL;
+}
+
+static bool encode_stream(const MarketDataColumns *columns, int column, size_t first, size_t count, ByteBuffer *out, uint8_t *scheme) {
+    if (column_is_time(column)) {
+        const int64_t *values = (const int64_t *)column_pointer(columns, column) + first;
+        if (is_regular(values, count)) {
+            *scheme = HISTORY_SCHEME_REGULAR;
+            return encode_regular(values, count, out);
+        }
+        *scheme = HISTORY_SCHEME_DELTA_OF_DELTA;
+        return encode_delta_of_delta(values, count, out);
+    }
+    if (column == KLINE_COL_TRADES) {
+        *scheme = HISTORY_SCHEME_ZIGZAG_DELTA;
+        return encode_zigzag_delta(columns->trades + first, count, out);
+    }
+
+    const double *values = (const double *)column_pointer(columns, column) + first;
+    if (fits_fixed_point(values, count)) {
+        *scheme = HISTORY_SCHEME_FIXED_POINT;
+        return encode_fixed_point(values, count, out);
+    }
+    *scheme = HISTORY_SCHEME_XOR;
+    return encode_xor(values, count, out);
+}
+
+static bool append_block(ByteBuffer *history, const MarketDataColumns *columns, size_t first, size_t count) {
+    size_t block_start = history->size;
+    HistoryBlockHeader header;
+    memset(&header, 0, sizeof(header));
+    header.row_count = (uint32_t)count;
+    header.first_open_time = columns->open_time[first];
+    header.last_open_time = columns->open_time[first + count - 1];
+
+    if (!buffer_append(history, &header, sizeof(header))) {
+        return false;
+    }
+
+    static const uint8_t padding[HISTORY_STREAM_PADDING + 8] = {0};
+    for (int column = 0; column < KLINE_COLUMN_COUNT; column++) {
+        header.stream_offsets[column] = (uint32_t)(history->size - block_start);
+        if (!encode_stream(columns, column, first, count, history, &header.schemes[column])) {
+            return false;
+        }
+        // Read-ahead padding, then round up so the next stream starts 8-byte aligned
+        size_t pad = HISTORY_STREAM_PADDING + (8 - (history->size % 8)) % 8;
+        if (!buffer_append(history, padding, pad)) {
+            return false;
+        }
+    }
+
+    header.block_bytes = (uint32_t)(history->size - block_start);
+    memcpy(history->data + block_start, &header, sizeof(header));
+    return true;
+}
+
+// Build the block index by walking the self-describing block headers
+static bool index_blocks(CompressedHistory *history) {
+    const HistoryFileHeader *file_header = (const HistoryFileHeader *)history->data;
+    history->block_count = (size_t)file_header->block_count;
+    history->block_offsets = (size_t *)malloc((history->block_count ? history->block_count : 1) * sizeof(size_t));
+    if (history->block_offsets == NULL) {
+        return false;
+    }
+
+    size_t offset = sizeof(HistoryFileHeader);
+    history->row_count = 0;
+    for (size_t i = 0; i < history->block_count; i++) {
+        if (offset + sizeof(HistoryBlockHeader) > history->size) {
+            return false;
+        }
+        const HistoryBlockHeader *header = (const HistoryBlockHeader *)(history->data + offset);
+        if (header->block_bytes < sizeof(HistoryBlockHeader) || offset + header->block_bytes > history->size) {
+            return false;
+        }
+        history->block_offsets[i] = offset;
+        history->row_count += header->row_count;
+        offset += header->block_bytes;
+    }
+    return true;
+}
+
+// Function to compress columns into blocks of HISTORY_BLOCK_ROWS rows
+CompressedHistory *history_compress(const MarketDataColumns *columns) {
+    ByteBuffer buffer = {0};
+    HistoryFileHeader file_header;
+    memcpy(file_header.magic, HISTORY_MAGIC, sizeof(file_header.magic));
+    file_header.version = HISTORY_VERSION;
+    file_header.block_count = (columns->length + HISTORY_BLOCK_ROWS - 1) / HISTORY_BLOCK_ROWS;
+
+    bool ok = buffer_append(&buffer, &file_header, sizeof(file_header));
+    for (size_t first = 0; ok && first < columns->length; first += HISTORY_BLOCK_ROWS) {
+        size_t count = columns->length - first < HISTORY_BLOCK_ROWS ? columns->length - first : HISTORY_BLOCK_ROWS;
+        ok = append_block(&buffer, columns, first, count);
+    }
+
+    CompressedHistory *history = (CompressedHistory *)calloc(1, sizeof(CompressedHistory));
+    if (!ok || history == NULL) {
+        free(buffer.data);
+        free(history);
+        return NULL;
+    }
+    history->data = buffer.data;
+    history->size = buffer.size;
+    history->capacity = buffer.capacity;
+    if (!index_blocks(history)) {
+        history_free(history);
+        return NULL;
+    }
+    return history;
+}
+
+// Function to get the header of one block
+const HistoryBlockHeader *history_block(const CompressedHistory *history, size_t block) {
+    return (const HistoryBlockHeader *)(history->data + history->block_offsets[block]);
+}
+
+// Function to find the first block whose rows could open at or after time_ms, block_count if none
+size_t history_find_block(const CompressedHistory *history, int64_t time_ms) {
+    size_t lo = 0, hi = history->block_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (history_block(history, mid)->last_open_time < time_ms) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Function to decode one block and append its rows to out
+bool history_decompress_block(const CompressedHistory *history, size_t block, MarketDataColumns *out) {
+    const HistoryBlockHeader *header = history_block(history, block);
+    size_t count = header->row_count;
+    if (!market_data_columns_reserve(out, out->length + count)) {
+        return false;
+    }
+
+    const uint8_t *base = (const uint8_t *)header;
+    for (int column = 0; column < KLINE_COLUMN_COUNT; column++) {
+        const uint8_t *stream = base + header->stream_offsets[column];
+        void *target = column_pointer(out, column);
+        switch (header->schemes[column]) {
+        case HISTORY_SCHEME_REGULAR:
+            decode_regular(stream, count, (int64_t *)target + out->length);
+            break;
+        case HISTORY_SCHEME_DELTA_OF_DELTA:
+            decode_delta_of_delta(stream, count, (int64_t *)target + out->length);
+            break;
+        case HISTORY_SCHEME_XOR:
+            decode_xor(stream, count, (double *)target + out->length);
+            break;
+        case HISTORY_SCHEME_FIXED_POINT:
+            decode_fixed_point(stream, count, (double *)target + out->length);
+            break;
+        case HISTORY_SCHEME_ZIGZAG_DELTA:
+            decode_zigzag_delta(stream, count, (int64_t *)target + out->length);
+            break;
+        default:
+            return false;
+        }
+    }
+    out->length += count;
+    return true;
+}
+
+// Function to decode only the blocks overlapping [start_time_ms, end_time_ms) and trim to that span
+MarketDataColumns *history_decompress_range(const CompressedHistory *history, int64_t start_time_ms, int64_t end_time_ms) {
+    MarketDataColumns *columns = market_data_columns_init(HISTORY_BLOCK_ROWS);
+    if (columns == NULL) {
+        return NULL;
+    }
+
+    for (size_t block = history_find_block(history, start_time_ms);
+         block < history->block_count && history_block(history, block)->first_open_time < end_time_ms; block++) {
+        if (!history_decompress_block(history, block, columns)) {
+            market_data_columns_free(columns);
+            return NULL;
+        }
+    }
+
+    size_t first, last;
+    market_data_columns_seek(columns, start_time_ms, end_time_ms, &first, &last);
+    if (first > 0) {
+        for (int column = 0; column < KLINE_COLUMN_COUNT; column++) {
+            uint64_t *values = (uint64_t *)column_pointer(columns, column);
+            memmove(values, values + first, (last - first) * sizeof(uint64_t));
+        }
+    }
+    columns->length = last - first;
+    return columns;
+}
+
+// Function to write a compressed history to path, replacing it atomically
+int history_write(const char *path, const CompressedHistory *history) {
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *file = fopen(tmp_path, "wb");
+    if (file == NULL) {
+        printf("Could not create file: %s\n", tmp_path);
+        return -1;
+    }
+
+    int status = fwrite(history->data, 1, history->size, file) == history->size ? 0 : -1;
+    if (fflush(file) != 0 || fsync(fileno(file)) != 0) {
+        status = -1;
+    }
+    fclose(file);
+
+    if (status != 0 || rename(tmp_path, path) != 0) {
+        printf("Could not write file: %s\n", path);
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+// Function to map a compressed history file, NULL if it is missing or malformed
+CompressedHistory *history_open(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Could not open file: %s\n", path);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(HistoryFileHeader)) {
+        printf("Not a compressed history: %s\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        printf("Could not map file: %s\n", path);
+        return NULL;
+    }
+
+    const HistoryFileHeader *file_header = (const HistoryFileHeader *)mapping;
+    CompressedHistory *history = (CompressedHistory *)calloc(1, sizeof(CompressedHistory));
+    if (history == NULL || memcmp(file_header->magic, HISTORY_MAGIC, sizeof(file_header->magic)) != 0 ||
+        file_header->version != HISTORY_VERSION) {
+        printf("Not a compressed history: %s\n", path);
+        free(history);
+        munmap(mapping, size);
+        return NULL;
+    }
+
+    history->data = (uint8_t *)mapping;
+    history->size = size;
+    history->capacity = size;
+    history->mapped = true;
+    if (!index_blocks(history)) {
+        printf("Corrupt compressed history: %s\n", path);
+        history_free(history);
+        return NULL;
+    }
+    return history;
+}
+
+// Function to release a compressed history, whether built in memory or mapped
+void history_free(CompressedHistory *history) {
+    if (history == NULL) {
+        return;
+    }
+    if (history->mapped) {
+        munmap(history->data, history->size);
+    } else {
+        free(history->data);
+    }
+    free(history->block_offsets);
+    free(history);
+}
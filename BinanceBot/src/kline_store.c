@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "kline_store.h"
+#include "market_data_array.h"
+
+static size_t align_up(size_t value) {
+    return (value + KLINE_STORE_ALIGNMENT - 1) & ~(size_t)(KLINE_STORE_ALIGNMENT - 1);
+}
+
+// Fill header offsets for row_count rows, returns the total file size
+static size_t kline_store_layout(KlineStoreHeader *header, size_t row_count) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, KLINE_STORE_MAGIC, sizeof(header->magic));
+    header->version = KLINE_STORE_VERSION;
+    header->row_count = row_count;
+    header->column_count = KLINE_COLUMN_COUNT;
+
+    // Every column is 8 bytes wide, whether int64 or double
+    size_t offset = align_up(sizeof(KlineStoreHeader));
+    for (int column = 0; column < KLINE_COLUMN_COUNT; column++) {
+        header->column_offsets[column] = offset;
+        offset = align_up(offset + row_count * sizeof(int64_t));
+    }
+    return offset;
+}
+
+// Gather one field of every row into a column buffer and write it at its offset
+static int write_column(FILE *file, const KlineStoreHeader *header, int column, const void *values, size_t count) {
+    if (fseeko(file, (off_t)header->column_offsets[column], SEEK_SET) != 0) {
+        return -1;
+    }
+    return fwrite(values, sizeof(int64_t), count, file) == count ? 0 : -1;
+}
+
+// Function to write a MarketDataArray as a .kbin file, replacing path atomically
+int kline_store_write(const char *path, const MarketDataArray *array) {
+    size_t rows = array->length;
+    KlineStoreHeader header;
+    size_t file_size = kline_store_layout(&header, rows);
+
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *file = fopen(tmp_path, "wb");
+    if (file == NULL) {
+        printf("Could not create file: %s\n", tmp_path);
+        return -1;
+    }
+
+    // One reusable 8-byte-wide buffer is enough to transpose each column in turn
+    union { int64_t i; double d; } *column = malloc((rows ? rows : 1) * sizeof(*column));
+    int status = column ? 0 : -1;
+
+    if (status == 0 && fwrite(&header, sizeof(header), 1, file) != 1) {
+        status = -1;
+    }
+
+    for (int c = 0; c < KLINE_COLUMN_COUNT && status == 0; c++) {
+        for (size_t i = 0; i < rows; i++) {
+            const MarketData *row = &array->data[i];
+            switch (c) {
+            case KLINE_COL_OPEN_TIME:   column[i].i = row->open_time_ms; break;
+            case KLINE_COL_CLOSE_TIME:  column[i].i = row->close_time_ms; break;
+            case KLINE_COL_OPEN:        column[i].d = row->open; break;
+            case KLINE_COL_HIGH:        column[i].d = row->high; break;
+            case KLINE_COL_LOW:         column[i].d = row->low; break;
+            case KLINE_COL_CLOSE:       column[i].d = row->close; break;
+            case KLINE_COL_VOLUME:      column[i].d = row->volume; break;
+            case KLINE_COL_QUOTE_AV:    column[i].d = row->quote_av; break;
+            case KLINE_COL_TRADES:      column[i].i = row->trades; break;
+            case KLINE_COL_TB_BASE_AV:  column[i].d = row->tb_base_av; break;
+            case KLINE_COL_TB_QUOTE_AV: column[i].d = row->tb_quote_av; break;
+            }
+        }
+        status = write_column(file, &header, c, column, rows);
+    }
+
+    // Pad the tail so the last column's alignment padding is part of the file
+    if (status == 0 && ftruncate(fileno(file), (off_t)file_size) != 0) {
+        status = -1;
+    }
+    if (fflush(file) != 0 || fsync(fileno(file)) != 0) {
+        status = -1;
+    }
+    fclose(file);
+    free(column);
+
+    if (status != 0 || rename(tmp_path, path) != 0) {
+        printf("Could not write file: %s\n", path);
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+// Function to map a .kbin file and expose its columns, NULL if it is missing or malformed
+KlineStore *kline_store_open(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Could not open file: %s\n", path);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(KlineStoreHeader)) {
+        printf("Not a kline store: %s\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        printf("Could not map file: %s\n", path);
+        return NULL;
+    }
+
+    const KlineStoreHeader *header = (const KlineStoreHeader *)mapping;
+    KlineStoreHeader expected;
+    // Row counts the mapping cannot hold are rejected before the layout multiplies them, so a
+    // corrupt count cannot wrap the computed size back under the file size
+    size_t max_rows = (size - sizeof(KlineStoreHeader)) / (KLINE_COLUMN_COUNT * sizeof(int64_t));
+    if (memcmp(header->magic, KLINE_STORE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != KLINE_STORE_VERSION || header->column_count != KLINE_COLUMN_COUNT ||
+        header->row_count > max_rows ||
+        kline_store_layout(&expected, header->row_count) > size ||
+        memcmp(expected.column_offsets, header->column_offsets, sizeof(expected.column_offsets)) != 0) {
+        printf("Not a kline store: %s\n", path);
+        munmap(mapping, size);
+        return NULL;
+    }
+
+    KlineStore *store = (KlineStore *)malloc(sizeof(KlineStore));
+    if (store == NULL) {
+        munmap(mapping, size);
+        return NULL;
+    }
+
+    const char *base = (const char *)mapping;
+    const uint64_t *offsets = header->column_offsets;
+    store->row_count = header->row_count;
+    store->open_time = (const int64_t *)(base + offsets[KLINE_COL_OPEN_TIME]);
+    store->close_time = (const int64_t *)(base + offsets[KLINE_COL_CLOSE_TIME]);
+    store->open = (const double *)(base + offsets[KLINE_COL_OPEN]);
+    store->high = (const double *)(base + offsets[KLINE_COL_HIGH]);
+    store->low = (const double *)(base + offsets[KLINE_COL_LOW]);
+    store->close = (const double *)(base + offsets[KLINE_COL_CLOSE]);
+    store->volume = (const double *)(base + offsets[KLINE_COL_VOLUME]);
+    store->quote_av = (const double *)(base + offsets[KLINE_COL_QUOTE_AV]);
+    store->trades = (const int64_t *)(base + offsets[KLINE_COL_TRADES]);
+    store->tb_base_av = (const double *)(base + offsets[KLINE_COL_TB_BASE_AV]);
+    store->tb_quote_av = (const double *)(base + offsets[KLINE_COL_TB_QUOTE_AV]);
+    store->mapping = mapping;
+    store->mapping_size = size;
+
+    return store;
+}
+
+// Function to rebuild one row as a MarketData record, for code that still consumes rows
+void kline_store_row(const KlineStore *store, size_t index, MarketData *out) {
+    out->open_time_ms = store->open_time[index];
+    out->close_time_ms = store->close_time[index];
+    out->open = store->open[index];
+    out->high = store->high[index];
+    out->low = store->low[index];
+    out->close = store->close[index];
+    out->volume = store->volume[index];
+    out->quote_av = store->quote_av[index];
+    out->trades = (int)store->trades[index];
+    out->tb_base_av = store->tb_base_av[index];
+    out->tb_quote_av = store->tb_quote_av[index];
+    out->ignore = 0;
+}
+
+// Function to unmap a kline store
+void kline_store_close(KlineStore *store) {
+    if (store) {
+        munmap(store->mapping, store->mapping_size);
+        free(store);
+    }
+}
@@ -2,75 +2,200 @@
 #include <stdatomic.h>
 #include "lock_free_queue.h"
 #include "market_data_array.h"
+#include "hazard_pointer.h"
 
 LockFreeQueue *lock_free_queue_init() {
     LockFreeQueueNode *dummy = (LockFreeQueueNode *)malloc(sizeof(LockFreeQueueNode));
-    dummy->next = NULL;
+    atomic_init(&dummy->next, 0);
 
-    LockFreeQueue *queue = (LockFreeQueue *)malloc(sizeof(LockFreeQueue));
-    queue->head = dummy;
-    queue->tail = dummy;
+    LockFreeQueue *queue = (LockFreeQueue *)aligned_alloc(_Alignof(LockFreeQueue), sizeof(LockFreeQueue));
+    atomic_init(&queue->head, (uintptr_t)dummy);
+    atomic_init(&queue->tail, (uintptr_t)dummy);
 
     return queue;
 }
 
 bool lock_free_queue_enqueue(LockFreeQueue *queue, MarketData *data) {
     LockFreeQueueNode *node = (LockFreeQueueNode *)malloc(sizeof(LockFreeQueueNode));
+    if (node == NULL)
+        return false;
     node->data = data;
-    node->next = NULL;
+    atomic_init(&node->next, 0);
 
-    LockFreeQueueNode *tail, *next;
+    uintptr_t tail, next;
 
     while (1) {
-        tail = queue->tail;
-        next = tail->next;
+        // The tail node is only read while it is protected, so it cannot be freed under us
+        tail = hazard_protect(&queue->tail, 0);
+        LockFreeQueueNode *tail_node = tagged_pointer(tail);
+        next = atomic_load(&tail_node->next);
 
-        if (tail == queue->tail) {
-            if (next == NULL) {
-                if (atomic_compare_exchange_weak(&tail->next, &next, node))
+        if (tail == atomic_load(&queue->tail)) {
+            if (tagged_pointer(next) == NULL) {
+                if (atomic_compare_exchange_weak(&tail_node->next, &next, tagged_successor(next, node)))
                     break;
             } else {
-                atomic_compare_exchange_weak(&queue->tail, &tail, next);
+                // Another producer linked a node but has not swung the tail yet; help it
+                atomic_compare_exchange_weak(&queue->tail, &tail, tagged_successor(tail, tagged_pointer(next)));
             }
         }
     }
 
-    atomic_compare_exchange_weak(&queue->tail, &tail, node);
+    atomic_compare_exchange_strong(&queue->tail, &tail, tagged_successor(tail, node));
+    hazard_clear(0);
     return true;
 }
 
 MarketData *lock_free_queue_dequeue(LockFreeQueue *queue) {
-    LockFreeQueueNode *head, *tail, *next;
+    uintptr_t head, tail, next;
     MarketData *data;
 
     while (1) {
-        head = queue->head;
-        tail = queue->tail;
-        next = head->next;
+        head = hazard_protect(&queue->head, 0);
+        LockFreeQueueNode *head_node = tagged_pointer(head);
+        tail = atomic_load(&queue->tail);
+        next = atomic_load(&head_node->next);
+        // The successor stays linked, and so unreclaimed, for as long as head has not moved
+        hazard_set(1, next);
 
-        if (head == queue->head) {
-            if (head == tail) {
-                if (next == NULL)
+        if (head == atomic_load(&queue->head)) {
+            if (tagged_pointer(head) == tagged_pointer(tail)) {
+                if (tagged_pointer(next) == NULL) {
+                    hazard_clear(0);
+                    hazard_clear(1);
                     return NULL;
+                }
 
-                atomic_compare_exchange_weak(&queue->tail, &tail, next);
+                atomic_compare_exchange_weak(&queue->tail, &tail, tagged_successor(tail, tagged_pointer(next)));
             } else {
-                data = next->data;
-                if (atomic_compare_exchange_weak(&queue->head, &head, next))
+                data = ((LockFreeQueueNode *)tagged_pointer(next))->data;
+                if (atomic_compare_exchange_weak(&queue->head, &head, tagged_successor(head, tagged_pointer(next))))
                     break;
             }
         }
     }
 
-    free(head);
+    hazard_clear(0);
+    hazard_clear(1);
+    // Other consumers may still be reading the old dummy; it is freed once none are
+    hazard_retire(tagged_pointer(head), free);
     return data;
 }
 
+size_t lock_free_queue_enqueue_bulk(LockFreeQueue *queue, MarketData *const *items, size_t count) {
+    // The nodes are linked privately, then published to consumers as one chain
+    LockFreeQueueNode *first = NULL, *last = NULL;
+    size_t linked = 0;
+    for (; linked < count; linked++) {
+        LockFreeQueueNode *node = (LockFreeQueueNode *)malloc(sizeof(LockFreeQueueNode));
+        if (node == NULL)
+            break;
+        node->data = items[linked];
+        atomic_init(&node->next, 0);
+        if (last)
+            atomic_store_explicit(&last->next, (uintptr_t)node, memory_order_relaxed);
+        else
+            first = node;
+        last = node;
+    }
+    if (linked == 0)
+        return 0;
+
+    uintptr_t tail, next;
+
+    while (1) {
+        tail = hazard_protect(&queue->tail, 0);
+        LockFreeQueueNode *tail_node = tagged_pointer(tail);
+        next = atomic_load(&tail_node->next);
+
+        if (tail == atomic_load(&queue->tail)) {
+            if (tagged_pointer(next) == NULL) {
+                if (atomic_compare_exchange_weak(&tail_node->next, &next, tagged_successor(next, first)))
+                    break;
+            } else {
+                atomic_compare_exchange_weak(&queue->tail, &tail, tagged_successor(tail, tagged_pointer(next)));
+            }
+        }
+    }
+
+    // If another thread has already started moving the tail along the chain, this fails and
+    // the threads that find the tail short of the end move it the rest of the way
+    atomic_compare_exchange_strong(&queue->tail, &tail, tagged_successor(tail, last));
+    hazard_clear(0);
+    return linked;
+}
+
+size_t lock_free_queue_dequeue_bulk(LockFreeQueue *queue, MarketData **items, size_t max) {
+    uintptr_t head, tail, next;
+    LockFreeQueueNode *last;
+    size_t count;
+
+    if (max == 0)
+        return 0;
+
+    while (1) {
+        head = hazard_protect(&queue->head, 0);
+        LockFreeQueueNode *head_node = tagged_pointer(head);
+        tail = atomic_load(&queue->tail);
+        next = atomic_load(&head_node->next);
+        hazard_set(1, next);
+
+        if (head != atomic_load(&queue->head))
+            continue;
+        if (tagged_pointer(head) == tagged_pointer(tail)) {
+            if (tagged_pointer(next) == NULL) {
+                hazard_clear(0);
+                hazard_clear(1);
+                return 0;
+            }
+            atomic_compare_exchange_weak(&queue->tail, &tail, tagged_successor(tail, tagged_pointer(next)));
+            continue;
+        }
+
+        // Walk the run hand over hand: each node is published before the head is checked
+        // again, and a node past an unmoved head cannot have been retired. The walk stops
+        // at the tail so the head never overtakes it.
+        last = tagged_pointer(next);
+        items[0] = last->data;
+        count = 1;
+        bool head_moved = false;
+        while (count < max && last != tagged_pointer(tail)) {
+            uintptr_t following = atomic_load(&last->next);
+            if (tagged_pointer(following) == NULL)
+                break;
+            hazard_set(1, following);
+            if (head != atomic_load(&queue->head)) {
+                head_moved = true;
+                break;
+            }
+            last = tagged_pointer(following);
+            items[count++] = last->data;
+        }
+        if (head_moved)
+            continue;
+
+        if (atomic_compare_exchange_weak(&queue->head, &head, tagged_successor(head, last)))
+            break;
+    }
+
+    hazard_clear(0);
+    hazard_clear(1);
+    // The claimed nodes now belong to this thread alone; all but the new dummy are retired
+    LockFreeQueueNode *node = tagged_pointer(head);
+    while (node != last) {
+        LockFreeQueueNode *following = tagged_pointer(atomic_load(&node->next));
+        hazard_retire(node, free);
+        node = following;
+    }
+    return count;
+}
+
 void lock_free_queue_destroy(LockFreeQueue *queue) {
     MarketData *data;
     while ((data = lock_free_queue_dequeue(queue)) != NULL)
         free(data);
 
-    free(queue->head);
+    hazard_scan();
+    free(tagged_pointer(atomic_load(&queue->head)));
     free(queue);
 }
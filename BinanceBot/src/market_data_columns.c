@@ -0,0 +1,187 @@
+#include <stdlib.h>
+#include <string.h>
+#include "market_data_columns.h"
+#include "market_data_array.h"
+#include "kline_store.h"
+
+// Every column is 8 bytes wide, so the same allocation helper serves all of them
+static void *alloc_column(size_t capacity) {
+    size_t bytes = capacity * sizeof(double);
+    bytes = (bytes + MARKET_DATA_COLUMN_ALIGNMENT - 1) & ~(size_t)(MARKET_DATA_COLUMN_ALIGNMENT - 1);
+    return aligned_alloc(MARKET_DATA_COLUMN_ALIGNMENT, bytes ? bytes : MARKET_DATA_COLUMN_ALIGNMENT);
+}
+
+// Grow one column; aligned_alloc has no realloc counterpart so the live prefix is copied
+static bool grow_column(void **column, size_t length, size_t capacity) {
+    void *grown = alloc_column(capacity);
+    if (grown == NULL) {
+        return false;
+    }
+    if (*column) {
+        memcpy(grown, *column, length * sizeof(double));
+        free(*column);
+    }
+    *column = grown;
+    return true;
+}
+
+#define FOR_EACH_COLUMN(columns, X) \
+    X((columns)->open_time) X((columns)->close_time) X((columns)->open) X((columns)->high) \
+    X((columns)->low) X((columns)->close) X((columns)->volume) X((columns)->quote_av) \
+    X((columns)->trades) X((columns)->tb_base_av) X((columns)->tb_quote_av)
+
+// Function to create an empty, owning MarketDataColumns
+MarketDataColumns *market_data_columns_init(size_t initial_capacity) {
+    MarketDataColumns *columns = (MarketDataColumns *)calloc(1, sizeof(MarketDataColumns));
+    if (columns == NULL) {
+        return NULL;
+    }
+    columns->owns_data = true;
+
+    if (!market_data_columns_reserve(columns, initial_capacity ? initial_capacity : 1)) {
+        market_data_columns_free(columns);
+        return NULL;
+    }
+    return columns;
+}
+
+// Function to grow every column to hold at least min_capacity rows
+bool market_data_columns_reserve(MarketDataColumns *columns, size_t min_capacity) {
+    if (!columns->owns_data) {
+        return false;
+    }
+    if (columns->capacity >= min_capacity) {
+        return true;
+    }
+
+    bool ok = true;
+#define GROW(column) ok = ok && grow_column((void **)&column, columns->length, min_capacity);
+    FOR_EACH_COLUMN(columns, GROW)
+#undef GROW
+    if (!ok) {
+        return false;
+    }
+    columns->capacity = min_capacity;
+    return true;
+}
+
+// Function to append one row
+bool market_data_columns_append(MarketDataColumns *columns, const MarketData *row) {
+    if (columns->length == columns->capacity &&
+        !market_data_columns_reserve(columns, columns->capacity * 2)) {
+        return false;
+    }
+
+    size_t i = columns->length++;
+    columns->open_time[i] = row->open_time_ms;
+    columns->close_time[i] = row->close_time_ms;
+    columns->open[i] = row->open;
+    columns->high[i] = row->high;
+    columns->low[i] = row->low;
+    columns->close[i] = row->close;
+    columns->volume[i] = row->volume;
+    columns->quote_av[i] = row->quote_av;
+    columns->trades[i] = row->trades;
+    columns->tb_base_av[i] = row->tb_base_av;
+    columns->tb_quote_av[i] = row->tb_quote_av;
+    return true;
+}
+
+// Function to read one row back out of the columns
+void market_data_columns_row(const MarketDataColumns *columns, size_t index, MarketData *out) {
+    out->open_time_ms = columns->open_time[index];
+    out->close_time_ms = columns->close_time[index];
+    out->open = columns->open[index];
+    out->high = columns->high[index];
+    out->low = columns->low[index];
+    out->close = columns->close[index];
+    out->volume = columns->volume[index];
+    out->quote_av = columns->quote_av[index];
+    out->trades = (int)columns->trades[index];
+    out->tb_base_av = columns->tb_base_av[index];
+    out->tb_quote_av = columns->tb_quote_av[index];
+    out->ignore = 0;
+}
+
+// Function to fill view with a borrowed window over rows [first, last) of columns
+void market_data_columns_slice(const MarketDataColumns *columns, size_t first, size_t last, MarketDataColumns *view) {
+#define SLICE(column) view->column = columns->column + first;
+    SLICE(open_time) SLICE(close_time) SLICE(open) SLICE(high) SLICE(low) SLICE(close)
+    SLICE(volume) SLICE(quote_av) SLICE(trades) SLICE(tb_base_av) SLICE(tb_quote_av)
+#undef SLICE
+    view->length = last - first;
+    view->capacity = last - first;
+    view->owns_data = false;
+}
+
+// Function to transpose a MarketDataArray into freshly allocated columns
+MarketDataColumns *market_data_columns_from_array(const MarketDataArray *array) {
+    MarketDataColumns *columns = market_data_columns_init(array->length);
+    if (columns == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < array->length; i++) {
+        market_data_columns_append(columns, &array->data[i]);
+    }
+    return columns;
+}
+
+// Function to borrow the columns of a mapped kline store without copying; the store must outlive the view
+MarketDataColumns *market_data_columns_from_store(const KlineStore *store) {
+    MarketDataColumns *columns = (MarketDataColumns *)calloc(1, sizeof(MarketDataColumns));
+    if (columns == NULL) {
+        return NULL;
+    }
+
+    columns->open_time = (int64_t *)store->open_time;
+    columns->close_time = (int64_t *)store->close_time;
+    columns->open = (double *)store->open;
+    columns->high = (double *)store->high;
+    columns->low = (double *)store->low;
+    columns->close = (double *)store->close;
+    columns->volume = (double *)store->volume;
+    columns->quote_av = (double *)store->quote_av;
+    columns->trades = (int64_t *)store->trades;
+    columns->tb_base_av = (double *)store->tb_base_av;
+    columns->tb_quote_av = (double *)store->tb_quote_av;
+    columns->length = store->row_count;
+    columns->capacity = store->row_count;
+    columns->owns_data = false;
+    return columns;
+}
+
+// First index whose time is not before time_ms
+static size_t lower_bound_time(const int64_t *times, size_t count, int64_t time_ms) {
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (times[mid] < time_ms) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Function to find the rows with open time in [start_time_ms, end_time_ms) by binary search over
+// open_time, returns false when the span is empty. On a store-backed view only the probed pages
+// and the returned span are ever faulted in.
+bool market_data_columns_seek(const MarketDataColumns *columns, int64_t start_time_ms, int64_t end_time_ms, size_t *first, size_t *last) {
+    *first = lower_bound_time(columns->open_time, columns->length, start_time_ms);
+    *last = *first + lower_bound_time(columns->open_time + *first, columns->length - *first, end_time_ms);
+    return *first < *last;
+}
+
+// Function to free a MarketDataColumns; borrowed columns are left to their store
+void market_data_columns_free(MarketDataColumns *columns) {
+    if (columns == NULL) {
+        return;
+    }
+    if (columns->owns_data) {
+#define RELEASE(column) free(column);
+        FOR_EACH_COLUMN(columns, RELEASE)
+#undef RELEASE
+    }
+    free(columns);
+}
@@ -8,12 +8,19 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <string.h>
+#include <stdint.h>
 // pre_processing.c
 #include "pre_processing_binance.h"
 #include "config_parser.h"
 #include "market_data_array.h"
-#include "lock_free_queue.h"
+#include "spsc_ring.h"
 #include "proces_queue.h"
+#include "kline_store.h"
+#include "stream_reader.h"
+#include "data_catalog.h"
+#include "bar_resampler.h"
+#include <sys/stat.h>
 
 
 typedef struct BinanaceData {
@@ -33,20 +40,21 @@ typedef struct BinanaceData {
 } BinanceData;
 
 
-PreProcessedData *pre_process_data(const MarketData *market_data, size_t data_count, size_t rolling_volatility_window_size, size_t custom_window_size)
+PreProcessedData *pre_process_data(const MarketDataColumns *columns, size_t rolling_volatility_window_size, size_t custom_window_size)
 {
-    PreProcessedData *data = (PreProcessedData *)malloc(sizeof(PreProcessedData));
-    data->price_differences = calculate_price_differences(market_data, data_count);
+    size_t data_count = columns->length;
+    PreProcessedData *data = (PreProcessedData *)calloc(1, sizeof(PreProcessedData));
+    data->price_differences = calculate_price_differences(columns->close, data_count);
     data->price_difference_count = data_count - 1;
     data->rolling_volatilities = calculate_rolling_volatilities(data->price_differences, data->price_difference_count, custom_window_size ? custom_window_size : rolling_volatility_window_size);
     data->rolling_volatility_count = data_count - rolling_volatility_window_size;
 
     // Calculate and store resistance and support levels
-    data->resistance_level = calculate_resistance_level(market_data, data_count);
-    data->support_level = calculate_support_level(market_data, data_count);
+    data->resistance_level = calculate_resistance_level(columns->high, columns->low, columns->close, data_count);
+    data->support_level = calculate_support_level(columns->high, columns->low, columns->close, data_count);
 
     // Calculate price levels
-    PriceLevels price_levels = calculate_price_levels(market_data, data_count);
+    PriceLevels price_levels = calculate_price_levels(columns->high, columns->low, columns->close, data_count);
     data->lower_price_level = price_levels.lower;
     data->upper_price_level = price_levels.upper;
     
@@ -125,13 +133,13 @@ void calculate_rate_of_change(BinanceData *data, double *window, size_t window_s
     }
 }
 
-double *calculate_price_differences(const MarketData *market_data, size_t data_count)
+double *calculate_price_differences(const double *restrict close, size_t data_count)
 {
-    double *price_differences = (double *)malloc(sizeof(double) * (data_count - 1));
+    double *restrict price_differences = (double *)malloc(sizeof(double) * (data_count - 1));
 
     for (size_t i = 0; i < data_count - 1; i++)
     {
-        price_differences[i] = market_data[i + 1].close - market_data[i].close;
+        price_differences[i] = close[i + 1] - close[i];
     }
 
     return price_differences;
@@ -139,6 +147,12 @@ double *calculate_price_differences(const MarketData *market_data, size_t data_c
 
 double *calculate_rolling_volatilities(const double *price_differences, size_t price_difference_count, size_t window_size)
 {
+    // Not enough differences for a single full window
+    if (window_size == 0 || price_difference_count < window_size)
+    {
+        return NULL;
+    }
+
     double *rolling_volatilities = (double *)malloc(sizeof(double) * (price_difference_count - window_size + 1));
     double sum = 0, mean = 0, variance = 0;
 
@@ -175,37 +189,32 @@ double *calculate_rolling_volatilities(const double *price_differences, size_t p
 
     return rolling_volatilities;
 }
-PriceLevels calculate_price_levels(const MarketData *market_data, size_t data_count)
+PriceLevels calculate_price_levels(const double *restrict high, const double *restrict low, const double *restrict close, size_t data_count)
 {
     // Initialize the highest value as the smallest possible double
     // and the lowest value as the largest possible double
     PriceLevels levels = {.upper = -DBL_MAX, .lower = DBL_MAX};
 
     // Check for valid data
-    if (data_count < 1 || !market_data) {
+    if (data_count < 1 || !high || !low || !close) {
         fprintf(stderr, "No market data available.\n");
         // Here you may return a PriceLevels with default values, or handle it in other ways
         return levels; 
     }
 
     // Use the most recent closing price as the initial pivot point
-    levels.pivot_point = market_data[data_count - 1].close;
+    levels.pivot_point = close[data_count - 1];
 
-    // Iterate through all market data
+    // Branch-free max/min over contiguous columns so the compiler can vectorize both reductions
+    double upper = levels.upper;
+    double lower = levels.lower;
     for (size_t i = 0; i < data_count; i++)
     {
-        // If the high of the current data point is greater than the current upper level, update it
-        if (market_data[i].high > levels.upper)
-        {
-            levels.upper = market_data[i].high;
-        }
-        
-        // If the low of the current data point is lower than the current lower level, update it
-        if (market_data[i].low < levels.lower)
-        {
-            levels.lower = market_data[i].low;
-        }
+        upper = high[i] > upper ? high[i] : upper;
+        lower = low[i] < lower ? low[i] : lower;
     }
+    levels.upper = upper;
+    levels.lower = lower;
 
     // Calculate the pivot point as the average of the upper level, lower level, and most recent close
     levels.pivot_point = (levels.upper + levels.lower + levels.pivot_point) / 3.0;
@@ -213,22 +222,22 @@ PriceLevels calculate_price_levels(const MarketData *market_data, size_t data_co
     return levels;
 }
 
-double calculate_support_level(const MarketData *market_data, size_t data_count)
+double calculate_support_level(const double *high, const double *low, const double *close, size_t data_count)
 {
-    PriceLevels levels = calculate_price_levels(market_data, data_count);
+    PriceLevels levels = calculate_price_levels(high, low, close, data_count);
     return 2 * levels.pivot_point - levels.upper;
 }
 
-double calculate_resistance_level(const MarketData *market_data, size_t data_count)
+double calculate_resistance_level(const double *high, const double *low, const double *close, size_t data_count)
 {
-    PriceLevels levels = calculate_price_levels(market_data, data_count);
+    PriceLevels levels = calculate_price_levels(high, low, close, data_count);
     return 2 * levels.pivot_point - levels.lower;
 }
 
-void update_price_differences(PreProcessedData *data, const MarketData *new_data, size_t new_data_count)
+void update_price_differences(PreProcessedData *data, const double *new_close, size_t new_data_count)
 {
     size_t new_price_difference_count = new_data_count - 1;
-    double *new_price_differences = calculate_price_differences(new_data, new_data_count);
+    double *new_price_differences = calculate_price_differences(new_close, new_data_count);
 
     double *updated_price_differences = (double *)realloc(data->price_differences, sizeof(double) * (data->price_difference_count + new_price_difference_count));
     if (updated_price_differences == NULL)
@@ -247,10 +256,10 @@ void update_price_differences(PreProcessedData *data, const MarketData *new_data
     free(new_price_differences);
 }
 
-void update_rolling_volatilities(PreProcessedData *data, const MarketData *new_data, size_t new_data_count, size_t window_size)
+void update_rolling_volatilities(PreProcessedData *data, const double *new_close, size_t new_data_count, size_t window_size)
 {
     size_t new_price_difference_count = new_data_count - 1;
-    double *new_price_differences = calculate_price_differences(new_data, new_data_count);
+    double *new_price_differences = calculate_price_differences(new_close, new_data_count);
 
     double *extended_price_differences = (double *)realloc(data->price_differences, sizeof(double) * (data->price_difference_count + new_price_difference_count));
     if (extended_price_differences == NULL)
@@ -267,6 +276,11 @@ void update_rolling_volatilities(PreProcessedData *data, const MarketData *new_d
     data->price_difference_count += new_price_difference_count;
 
     double *new_rolling_volatilities = calculate_rolling_volatilities(data->price_differences, data->price_difference_count, window_size);
+    if (new_rolling_volatilities == NULL)
+    {
+        free(new_price_differences);
+        return;
+    }
     size_t new_rolling_volatility_count = data->price_difference_count - window_size + 1;
 
     double *updated_rolling_volatilities = (double *)realloc(data->rolling_volatilities, sizeof(double) * new_rolling_volatility_count);
@@ -287,58 +301,178 @@ void update_rolling_volatilities(PreProcessedData *data, const MarketData *new_d
     free(new_rolling_volatilities);
 }
 
+// Each column holds the window twice over so the latest WINDOW_SIZE bars are
+// always contiguous and in time order, starting at index + 1
+typedef struct {
+    double close[2 * WINDOW_SIZE];
+    double high[2 * WINDOW_SIZE];
+    double low[2 * WINDOW_SIZE];
+    size_t index;
+} PriceWindow;
+
+// Add one bar to the window and refresh the indicators; the caller publishes them
+static void process_bar(PriceWindow *window, PreProcessedData *preProcessedData, const MarketData *bar)
+{
+    // Update the window data
+    size_t index_data = window->index;
+    window->close[index_data] = window->close[index_data + WINDOW_SIZE] = bar->close;
+    window->high[index_data] = window->high[index_data + WINDOW_SIZE] = bar->high;
+    window->low[index_data] = window->low[index_data + WINDOW_SIZE] = bar->low;
+
+    const double *close = &window->close[index_data + 1];
+    const double *high = &window->high[index_data + 1];
+    const double *low = &window->low[index_data + 1];
+
+    // Update rolling volatilities
+    update_rolling_volatilities(preProcessedData, close, WINDOW_SIZE, WINDOW_SIZE);
+
+    // Update price differences
+    update_price_differences(preProcessedData, close, WINDOW_SIZE);
+
+    // Calculate and store resistance and support levels
+    preProcessedData->resistance_level = calculate_resistance_level(high, low, close, WINDOW_SIZE);
+    preProcessedData->support_level = calculate_support_level(high, low, close, WINDOW_SIZE);
+
+    // Calculate price levels
+    PriceLevels price_levels = calculate_price_levels(high, low, close, WINDOW_SIZE);
+    preProcessedData->lower_price_level = price_levels.lower;
+    preProcessedData->upper_price_level = price_levels.upper;
+
+    // Update index values
+    window->index = (index_data + 1) % WINDOW_SIZE;
+}
+
+// A bulk enqueue stops short only when a queue node cannot be allocated, so the rest of the
+// batch is retried after a pause; entries still unpublished after PUBLISH_RETRIES are reported
+static void publish_output(ProcesLockFreeNode *output_queue, PreProcessedData *const *items, size_t count, size_t retry_interval)
+{
+    size_t sent = proces_enqueue_bulk(output_queue, items, count);
+    for (int attempt = 0; sent < count && attempt < PUBLISH_RETRIES; attempt++)
+    {
+        usleep(retry_interval);
+        sent += proces_enqueue_bulk(output_queue, items + sent, count - sent);
+    }
+    if (sent < count)
+    {
+        fprintf(stderr, "Dropped %zu of %zu pre-processed records: out of memory for the output queue\n", count - sent, count);
+    }
+}
+
 void *pre_processing_thread(void *args)
 {
     PreProcessingArgs *pre_processing_args = (PreProcessingArgs *)args;
 
     size_t records_processed = 0;
-    MarketData window_data[WINDOW_SIZE] = {0};
-    size_t index_data = 0;
+    PriceWindow window = {0};
     size_t calculation_interval = DEFAULT_CALCULATION_INTERVAL;
-    PreProcessedData *preProcessedData = (PreProcessedData *)malloc(sizeof(PreProcessedData));
+    PreProcessedData *preProcessedData = (PreProcessedData *)calloc(1, sizeof(PreProcessedData));
+
+    // Rows are aggregated into coarser bars before they reach the window when resampling
+    BarResampler resampler;
+    bar_resampler_init(&resampler, pre_processing_args->resample_interval_ms);
+    MarketData bars[2];
+    ProcesLockFreeNode *output_queue = (ProcesLockFreeNode *)pre_processing_args->output_queue;
+
+    // Rows are taken and handed back a batch at a time, and the batch's bars are published
+    // together, so each ring and the output queue see one index update per batch
+    MarketData *rows[PRE_PROCESSING_BATCH];
+    PreProcessedData *published[2 * PRE_PROCESSING_BATCH];
 
     while (records_processed < MAX_RECORDS_TO_PROCESS)
     {
-        MarketData *new_data = lock_free_queue_dequeue(pre_processing_args->input_queue);
-        if (new_data == NULL)
+        size_t row_count = spsc_ring_pop_bulk(pre_processing_args->input_queue, (void **)rows, PRE_PROCESSING_BATCH);
+        if (row_count == 0)
         {
-            usleep(calculation_interval);
-            continue;
+            // Rows are enqueued before the flag is set, so one more look settles it
+            if (atomic_load(&pre_processing_args->input_finished) &&
+                (row_count = spsc_ring_pop_bulk(pre_processing_args->input_queue, (void **)rows, PRE_PROCESSING_BATCH)) == 0)
+            {
+                // The last bucket may still be partial; it is published like any other bar
+                if (bar_resampler_flush(&resampler, &bars[0]))
+                {
+                    process_bar(&window, preProcessedData, &bars[0]);
+                    publish_output(output_queue, &preProcessedData, 1, calculation_interval);
+                }
+                break;
+            }
+            if (row_count == 0)
+            {
+                usleep(calculation_interval);
+                continue;
+            }
         }
 
-        // Update the window data
-        window_data[index_data] = *new_data;
-
-        // Update rolling volatilities
-        update_rolling_volatilities(preProcessedData, window_data, WINDOW_SIZE, WINDOW_SIZE);
-
-        // Update price differences
-        update_price_differences(preProcessedData, window_data, WINDOW_SIZE);
-
-        // Calculate and store resistance and support levels
-        preProcessedData->resistance_level = calculate_resistance_level(window_data, WINDOW_SIZE);
-        preProcessedData->support_level = calculate_support_level(window_data, WINDOW_SIZE);
-
-        // Calculate price levels
-        PriceLevels price_levels = calculate_price_levels(window_data, WINDOW_SIZE);
-        preProcessedData->lower_price_level = price_levels.lower;
-        preProcessedData->upper_price_level = price_levels.upper;
-
-        proces_enqueue((ProcesLockFreeNode*)pre_processing_args->output_queue, preProcessedData);
+        size_t published_count = 0;
+        for (size_t row = 0; row < row_count; row++)
+        {
+            size_t bar_count = 1;
+            if (pre_processing_args->resample_interval_ms > 0)
+            {
+                bar_count = bar_resampler_push(&resampler, rows[row], bars, 2);
+            }
+            else
+            {
+                bars[0] = *rows[row];
+            }
+
+            for (size_t i = 0; i < bar_count && records_processed < MAX_RECORDS_TO_PROCESS; i++)
+            {
+                process_bar(&window, preProcessedData, &bars[i]);
+                published[published_count++] = preProcessedData;
+                records_processed++;
+            }
+        }
 
+        if (pre_processing_args->free_queue)
+        {
+            stream_reader_push_bulk(pre_processing_args->free_queue, rows, row_count);
+        }
+        else
+        {
+            for (size_t row = 0; row < row_count; row++)
+            {
+                free(rows[row]);
+            }
+        }
+        publish_output(output_queue, published, published_count, calculation_interval);
+    }
+    return NULL;
+}
 
-        // Update index values
-        index_data = (index_data + 1) % WINDOW_SIZE;
+// Every entry in the output queue aliases the thread's single PreProcessedData, so drain
+// the queue and release that record once instead of once per entry
+static void release_pre_processed_output(ProcesLockFreeNode *output_queue)
+{
+    PreProcessedData *latest = NULL;
+    PreProcessedData *entry;
+    while ((entry = proces_dequeue(output_queue)) != NULL)
+    {
+        latest = entry;
+    }
+    if (latest)
+    {
+        free(latest->price_differences);
+        free(latest->rolling_volatilities);
+        free(latest);
+    }
+    proces_queue_destroy(output_queue);
+}
 
-        records_processed++;
+// Free the rows still held by a ring, then the ring itself
+static void release_rows(SpscRing *ring)
+{
+    MarketData *row;
+    while ((row = spsc_ring_pop(ring)) != NULL)
+    {
+        free(row);
     }
-    return NULL;
+    spsc_ring_destroy(ring);
 }
 
 int main(int argc, char* argv[]) {
     // Check if config file path is provided
     if (argc < 3) {
-        printf("Usage: ./program config.ini data.csv\n");
+        printf("Usage: ./program config.ini data.csv|data.kbin|data_dir [SYMBOL]\n");
         return 1;
     }
 
@@ -353,13 +487,43 @@ int main(int argc, char* argv[]) {
     char* csv_file_name = argv[2];
 
     // Prepare queues
-    LockFreeQueue *input_queue = lock_free_queue_init();
+    SpscRing *input_queue = spsc_ring_init(SPSC_RING_DEFAULT_CAPACITY);
     ProcesLockFreeNode *output_queue = proces_queue_init();
 
     // Prepare arguments
     PreProcessingArgs args;
     args.input_queue = input_queue;
     args.output_queue = output_queue;
+    args.free_queue = NULL;
+    atomic_init(&args.input_finished, false);
+    args.resample_interval_ms = 0;
+
+    // Coarser bars are aggregated locally from the loaded rows rather than fetched
+    int64_t resample_ms = 0;
+    if (params.resample_interval[0] != '\0') {
+        resample_ms = resample_interval_ms(params.resample_interval);
+        if (resample_ms == 0) {
+            printf("Invalid RESAMPLE_INTERVAL: %s\n", params.resample_interval);
+            return 1;
+        }
+    }
+
+    size_t name_length = strlen(csv_file_name);
+    struct stat path_stat;
+    bool is_catalog = stat(csv_file_name, &path_stat) == 0 && S_ISDIR(path_stat.st_mode);
+    bool is_store = name_length > 5 && strcmp(csv_file_name + name_length - 5, ".kbin") == 0;
+    bool streaming = params.stream_input && !is_store && !is_catalog;
+
+    // Streaming recycles a fixed set of rows between the reader and the pre-processing thread,
+    // which also does the resampling one row at a time
+    if (streaming) {
+        args.resample_interval_ms = resample_ms;
+        args.free_queue = spsc_ring_init((size_t)params.stream_queue_rows);
+        if (args.free_queue == NULL || !stream_reader_seed(args.free_queue, (size_t)params.stream_queue_rows)) {
+            printf("Failed to allocate the stream buffer\n");
+            return 1;
+        }
+    }
 
     // Create thread
     pthread_t pre_processing_thread_id;
@@ -369,37 +533,154 @@ int main(int argc, char* argv[]) {
         return err;
     }
 
-    // Initialize the dynamic array
-    MarketDataArray *array = market_data_array_init(MAX_RECORDS_TO_PROCESS);
+    // Restrict the run to the configured [START_TIME_MS, END_TIME_MS) span
+    int64_t range_start = params.start_time_ms;
+    int64_t range_end = params.end_time_ms > 0 ? params.end_time_ms : INT64_MAX;
+
+    if (streaming) {
+        // This thread becomes the reader: rows flow to the queue as they are parsed and
+        // the pre-processing thread starts on the first one, nothing else is held
+        StreamReaderArgs reader_args = {
+            .filename = csv_file_name,
+            .output_queue = input_queue,
+            .free_queue = args.free_queue,
+            .start_time_ms = range_start,
+            .end_time_ms = range_end,
+            .max_records = MAX_RECORDS_TO_PROCESS,
+            .finished = &args.input_finished
+        };
+        stream_reader_thread(&reader_args);
+        pthread_join(pre_processing_thread_id, NULL);
+
+        release_rows(input_queue);
+        release_rows(args.free_queue);
+        release_pre_processed_output(output_queue);
+        return reader_args.status == 0 ? 0 : 1;
+    }
+
+    // A directory is a catalog of SYMBOL_INTERVAL.kbin/.kgor files, .kbin stores are mapped
+    // and read in place, anything else is parsed as CSV
+    DataCatalog *catalog = NULL;
+    DataCatalogSlice slice = {0};
+    KlineStore *store = NULL;
+    MarketDataArray *array = NULL;
+    size_t first, last;
+    if (is_catalog) {
+        const char *symbol = argc > 3 ? argv[3] : params.symbol;
+        const char *interval = params.interval;
+        catalog = data_catalog_open(csv_file_name, (size_t)params.catalog_memory_mb << 20);
+
+        // An interval the catalog lacks is built from the symbol's minute bars
+        if (catalog && data_catalog_find(catalog, symbol, interval) == NULL &&
+            data_catalog_find(catalog, symbol, "1m") != NULL && resample_ms == 0 &&
+            resample_interval_ms(interval) > 0) {
+            resample_ms = resample_interval_ms(interval);
+            interval = "1m";
+        }
+        if (catalog == NULL ||
+            data_catalog_acquire(catalog, symbol, interval, range_start, range_end, &slice) != 0) {
+            data_catalog_close(catalog);
+            return 1;
+        }
+        first = slice.first;
+        last = slice.last;
+    } else if (is_store) {
+        store = kline_store_open(csv_file_name);
+        if (store == NULL) {
+            return 1;
+        }
+    } else {
+        // Initialize the dynamic array
+        array = market_data_array_init(MAX_RECORDS_TO_PROCESS);
 
-    // Read the data from the CSV file
-    read_csv_file(csv_file_name, array);
+        // Read the data from the CSV file
+        if (read_csv_file_parallel(csv_file_name, array, params.load_threads) != 0) {
+            market_data_array_free(array);
+            return 1;
+        }
+    }
+
+    // Binary search for the span's rows
+    if (store) {
+        MarketDataColumns *view = market_data_columns_from_store(store);
+        market_data_columns_seek(view, range_start, range_end, &first, &last);
+        market_data_columns_free(view);
+    } else if (array) {
+        market_data_array_seek(array, range_start, range_end, &first, &last);
+    }
+    // Catalog files are read through their columns, whether mapped or decoded from a history
+    const MarketDataColumns *catalog_rows = catalog ? slice.columns : NULL;
+    const KlineStore *rows = store;
+
+    // Batch resampling aggregates the whole span in one vectorized pass
+    MarketDataColumns *resampled = NULL;
+    if (resample_ms > 0 && first < last) {
+        MarketDataColumns span;
+        MarketDataColumns *loaded = NULL;
+        if (catalog_rows) {
+            market_data_columns_slice(catalog_rows, first, last, &span);
+            resampled = resample_columns(&span, resample_ms, params.resample_fill_gaps != 0);
+        } else if (rows) {
+            loaded = market_data_columns_from_store(rows);
+        } else {
+            MarketDataArray array_span = {.data = array->data + first, .length = last - first, .capacity = last - first};
+            loaded = market_data_columns_from_array(&array_span);
+        }
+        if (loaded) {
+            if (rows) {
+                market_data_columns_slice(loaded, first, last, &span);
+            } else {
+                market_data_columns_slice(loaded, 0, last - first, &span);
+            }
+            resampled = resample_columns(&span, resample_ms, params.resample_fill_gaps != 0);
+            market_data_columns_free(loaded);
+        }
+        if (resampled == NULL) {
+            printf("Failed to resample to %lld ms bars\n", (long long)resample_ms);
+            return 1;
+        }
+        first = 0;
+        last = resampled->length;
+    }
 
     // Main processing logic, enqueueing MarketData into input_queue
-    for (size_t i = 0; i < array->length; i++) {
+    for (size_t i = first; i < last; i++) {
         // Enqueue the MarketData
         MarketData *market_data = (MarketData*)malloc(sizeof(MarketData));
-        *market_data = array->data[i];
-        lock_free_queue_enqueue(input_queue, market_data);
+        if (resampled) {
+            market_data_columns_row(resampled, i, market_data);
+        } else if (catalog_rows) {
+            market_data_columns_row(catalog_rows, i, market_data);
+        } else if (rows) {
+            kline_store_row(rows, i, market_data);
+        } else {
+            *market_data = array->data[i];
+        }
+        stream_reader_push(input_queue, market_data);
 
         // Check if we have reached the maximum number of records to process
-        if(i == MAX_RECORDS_TO_PROCESS - 1) {
+        if(i - first == MAX_RECORDS_TO_PROCESS - 1) {
             break;
         }
     }
-    // When stopping condition met, enqueue stop signal
-    MarketData *stop_signal = NULL; // Assuming NULL is the stop signal
-    lock_free_queue_enqueue(input_queue, stop_signal);
+    // When stopping condition met, signal the end of input
+    atomic_store(&args.input_finished, true);
 
     // Clean up resources
-    market_data_array_free(array);
+    market_data_columns_free(resampled);
+    if (array) {
+        market_data_array_free(array);
+    }
+    kline_store_close(store);
+    data_catalog_release(catalog, &slice);
+    data_catalog_close(catalog);
 
     // Wait for pre-processing thread to exit
     pthread_join(pre_processing_thread_id, NULL);
 
     // Clean up queues
-    lock_free_queue_destroy(input_queue);
-    proces_queue_destroy(output_queue);
+    release_rows(input_queue);
+    release_pre_processed_output(output_queue);
     
     return 0;
 }
@@ -3,75 +3,200 @@
 #include "market_data_array.h"
 #include "pre_processing_binance.h"
 #include "proces_queue.h"
+#include "hazard_pointer.h"
 
 ProcesLockFreeNode *proces_queue_init() {
     ProcessQueueNode *dummy = (ProcessQueueNode *)malloc(sizeof(ProcessQueueNode));
-    dummy->next = NULL;
+    atomic_init(&dummy->next, 0);
 
-    ProcesLockFreeNode *queue = (ProcesLockFreeNode *)malloc(sizeof(ProcesLockFreeNode));
-    queue->head = dummy;
-    queue->tail = dummy;
+    ProcesLockFreeNode *queue = (ProcesLockFreeNode *)aligned_alloc(_Alignof(ProcesLockFreeNode), sizeof(ProcesLockFreeNode));
+    atomic_init(&queue->head, (uintptr_t)dummy);
+    atomic_init(&queue->tail, (uintptr_t)dummy);
 
     return queue;
 }
 
 bool proces_enqueue(ProcesLockFreeNode *queue, PreProcessedData *data) {
     ProcessQueueNode *node = (ProcessQueueNode *)malloc(sizeof(ProcessQueueNode));
+    if (node == NULL)
+        return false;
     node->data = data;
-    node->next = NULL;
+    atomic_init(&node->next, 0);
 
-    ProcessQueueNode *tail, *next;
+    uintptr_t tail, next;
 
     while (1) {
-        tail = queue->tail;
-        next = tail->next;
+        // The tail node is only read while it is protected, so it cannot be freed under us
+        tail = hazard_protect(&queue->tail, 0);
+        ProcessQueueNode *tail_node = tagged_pointer(tail);
+        next = atomic_load(&tail_node->next);
 
-        if (tail == queue->tail) {
-            if (next == NULL) {
-                if (atomic_compare_exchange_weak(&tail->next, &next, node))
+        if (tail == atomic_load(&queue->tail)) {
+            if (tagged_pointer(next) == NULL) {
+                if (atomic_compare_exchange_weak(&tail_node->next, &next, tagged_successor(next, node)))
                     break;
             } else {
-                atomic_compare_exchange_weak(&queue->tail, &tail, next);
+                // Another producer linked a node but has not swung the tail yet; help it
+                atomic_compare_exchange_weak(&queue->tail, &tail, tagged_successor(tail, tagged_pointer(next)));
             }
         }
     }
 
-    atomic_compare_exchange_weak(&queue->tail, &tail, node);
+    atomic_compare_exchange_strong(&queue->tail, &tail, tagged_successor(tail, node));
+    hazard_clear(0);
     return true;
 }
 
 PreProcessedData *proces_dequeue(ProcesLockFreeNode *queue) {
-    ProcessQueueNode *head, *tail, *next;
+    uintptr_t head, tail, next;
     PreProcessedData *data;
 
     while (1) {
-        head = queue->head;
-        tail = queue->tail;
-        next = head->next;
+        head = hazard_protect(&queue->head, 0);
+        ProcessQueueNode *head_node = tagged_pointer(head);
+        tail = atomic_load(&queue->tail);
+        next = atomic_load(&head_node->next);
+        // The successor stays linked, and so unreclaimed, for as long as head has not moved
+        hazard_set(1, next);
 
-        if (head == queue->head) {
-            if (head == tail) {
-                if (next == NULL)
+        if (head == atomic_load(&queue->head)) {
+            if (tagged_pointer(head) == tagged_pointer(tail)) {
+                if (tagged_pointer(next) == NULL) {
+                    hazard_clear(0);
+                    hazard_clear(1);
                     return NULL;
+                }
 
-                atomic_compare_exchange_weak(&queue->tail, &tail, next);
+                atomic_compare_exchange_weak(&queue->tail, &tail, tagged_successor(tail, tagged_pointer(next)));
             } else {
-                data = next->data;
-                if (atomic_compare_exchange_weak(&queue->head, &head, next))
+                data = ((ProcessQueueNode *)tagged_pointer(next))->data;
+                if (atomic_compare_exchange_weak(&queue->head, &head, tagged_successor(head, tagged_pointer(next))))
                     break;
             }
         }
     }
 
-    free(head);
+    hazard_clear(0);
+    hazard_clear(1);
+    // Other consumers may still be reading the old dummy; it is freed once none are
+    hazard_retire(tagged_pointer(head), free);
     return data;
 }
 
+size_t proces_enqueue_bulk(ProcesLockFreeNode *queue, PreProcessedData *const *items, size_t count) {
+    // The nodes are linked privately, then published to consumers as one chain
+    ProcessQueueNode *first = NULL, *last = NULL;
+    size_t linked = 0;
+    for (; linked < count; linked++) {
+        ProcessQueueNode *node = (ProcessQueueNode *)malloc(sizeof(ProcessQueueNode));
+        if (node == NULL)
+            break;
+        node->data = items[linked];
+        atomic_init(&node->next, 0);
+        if (last)
+            atomic_store_explicit(&last->next, (uintptr_t)node, memory_order_relaxed);
+        else
+            first = node;
+        last = node;
+    }
+    if (linked == 0)
+        return 0;
+
+    uintptr_t tail, next;
+
+    while (1) {
+        tail = hazard_protect(&queue->tail, 0);
+        ProcessQueueNode *tail_node = tagged_pointer(tail);
+        next = atomic_load(&tail_node->next);
+
+        if (tail == atomic_load(&queue->tail)) {
+            if (tagged_pointer(next) == NULL) {
+                if (atomic_compare_exchange_weak(&tail_node->next, &next, tagged_successor(next, first)))
+                    break;
+            } else {
+                atomic_compare_exchange_weak(&queue->tail, &tail, tagged_successor(tail, tagged_pointer(next)));
+            }
+        }
+    }
+
+    // If another thread has already started moving the tail along the chain, this fails and
+    // the threads that find the tail short of the end move it the rest of the way
+    atomic_compare_exchange_strong(&queue->tail, &tail, tagged_successor(tail, last));
+    hazard_clear(0);
+    return linked;
+}
+
+size_t proces_dequeue_bulk(ProcesLockFreeNode *queue, PreProcessedData **items, size_t max) {
+    uintptr_t head, tail, next;
+    ProcessQueueNode *last;
+    size_t count;
+
+    if (max == 0)
+        return 0;
+
+    while (1) {
+        head = hazard_protect(&queue->head, 0);
+        ProcessQueueNode *head_node = tagged_pointer(head);
+        tail = atomic_load(&queue->tail);
+        next = atomic_load(&head_node->next);
+        hazard_set(1, next);
+
+        if (head != atomic_load(&queue->head))
+            continue;
+        if (tagged_pointer(head) == tagged_pointer(tail)) {
+            if (tagged_pointer(next) == NULL) {
+                hazard_clear(0);
+                hazard_clear(1);
+                return 0;
+            }
+            atomic_compare_exchange_weak(&queue->tail, &tail, tagged_successor(tail, tagged_pointer(next)));
+            continue;
+        }
+
+        // Walk the run hand over hand: each node is published before the head is checked
+        // again, and a node past an unmoved head cannot have been retired. The walk stops
+        // at the tail so the head never overtakes it.
+        last = tagged_pointer(next);
+        items[0] = last->data;
+        count = 1;
+        bool head_moved = false;
+        while (count < max && last != tagged_pointer(tail)) {
+            uintptr_t following = atomic_load(&last->next);
+            if (tagged_pointer(following) == NULL)
+                break;
+            hazard_set(1, following);
+            if (head != atomic_load(&queue->head)) {
+                head_moved = true;
+                break;
+            }
+            last = tagged_pointer(following);
+            items[count++] = last->data;
+        }
+        if (head_moved)
+            continue;
+
+        if (atomic_compare_exchange_weak(&queue->head, &head, tagged_successor(head, last)))
+            break;
+    }
+
+    hazard_clear(0);
+    hazard_clear(1);
+    // The claimed nodes now belong to this thread alone; all but the new dummy are retired
+    ProcessQueueNode *node = tagged_pointer(head);
+    while (node != last) {
+        ProcessQueueNode *following = tagged_pointer(atomic_load(&node->next));
+        hazard_retire(node, free);
+        node = following;
+    }
+    return count;
+}
+
 void proces_queue_destroy(ProcesLockFreeNode *queue) {
     PreProcessedData *data;
     while ((data = proces_dequeue(queue)) != NULL)
         free(data);
 
-    free(queue->head);
+    hazard_scan();
+    free(tagged_pointer(atomic_load(&queue->head)));
     free(queue);
 }
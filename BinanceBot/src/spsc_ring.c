@@ -0,0 +1,101 @@
+#include <stdlib.h>
+#include <string.h>
+#include "spsc_ring.h"
+
+SpscRing *spsc_ring_init(size_t capacity) {
+    size_t slots = 2;
+    while (slots < capacity) {
+        slots <<= 1;
+    }
+
+    SpscRing *ring = (SpscRing *)aligned_alloc(_Alignof(SpscRing), sizeof(SpscRing));
+    if (ring == NULL) {
+        return NULL;
+    }
+    memset(ring, 0, sizeof(SpscRing));
+    ring->slots = (void **)calloc(slots, sizeof(void *));
+    if (ring->slots == NULL) {
+        free(ring);
+        return NULL;
+    }
+    ring->mask = slots - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    return ring;
+}
+
+bool spsc_ring_push(SpscRing *ring, void *item) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if (tail - ring->cached_head > ring->mask) {
+        // Only a ring that looks full is worth a look at the consumer's index
+        ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (tail - ring->cached_head > ring->mask) {
+            return false;
+        }
+    }
+    ring->slots[tail & ring->mask] = item;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+void *spsc_ring_pop(SpscRing *ring) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (head == ring->cached_tail) {
+        ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head == ring->cached_tail) {
+            return NULL;
+        }
+    }
+    void *item = ring->slots[head & ring->mask];
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return item;
+}
+
+size_t spsc_ring_push_bulk(SpscRing *ring, void *const *items, size_t count) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t capacity = ring->mask + 1;
+    if (capacity - (tail - ring->cached_head) < count) {
+        ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    }
+    size_t room = capacity - (tail - ring->cached_head);
+    if (count > room) {
+        count = room;
+    }
+    // The run may wrap past the end of the slot array
+    size_t start = tail & ring->mask;
+    size_t first = count < capacity - start ? count : capacity - start;
+    memcpy(&ring->slots[start], items, first * sizeof(void *));
+    memcpy(ring->slots, items + first, (count - first) * sizeof(void *));
+    atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+    return count;
+}
+
+size_t spsc_ring_pop_bulk(SpscRing *ring, void **items, size_t max) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (ring->cached_tail - head < max) {
+        ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    }
+    size_t count = ring->cached_tail - head;
+    if (count > max) {
+        count = max;
+    }
+    size_t capacity = ring->mask + 1;
+    size_t start = head & ring->mask;
+    size_t first = count < capacity - start ? count : capacity - start;
+    memcpy(items, &ring->slots[start], first * sizeof(void *));
+    memcpy(items + first, ring->slots, (count - first) * sizeof(void *));
+    atomic_store_explicit(&ring->head, head + count, memory_order_release);
+    return count;
+}
+
+bool spsc_ring_is_empty(SpscRing *ring) {
+    return atomic_load_explicit(&ring->head, memory_order_acquire) ==
+           atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
+
+void spsc_ring_destroy(SpscRing *ring) {
+    if (ring) {
+        free(ring->slots);
+        free(ring);
+    }
+}
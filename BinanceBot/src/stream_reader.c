@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "stream_reader.h"
+#include "market_data_array.h"
+#include "spsc_ring.h"
+
+// Function to fill free_queue with slots empty rows for a stream reader to recycle
+// The ring must have room for every slot
+bool stream_reader_seed(SpscRing *free_queue, size_t slots) {
+    for (size_t i = 0; i < slots; i++) {
+        MarketData *row = (MarketData *)malloc(sizeof(MarketData));
+        if (row == NULL) {
+            return false;
+        }
+        if (!spsc_ring_push(free_queue, row)) {
+            free(row);
+            return false;
+        }
+    }
+    return true;
+}
+
+void stream_reader_push(SpscRing *queue, MarketData *row) {
+    while (!spsc_ring_push(queue, row)) {
+        usleep(STREAM_READER_BACKOFF_US);
+    }
+}
+
+void stream_reader_push_bulk(SpscRing *queue, MarketData *const *rows, size_t count) {
+    size_t pushed = 0;
+    while ((pushed += spsc_ring_push_bulk(queue, (void *const *)rows + pushed, count - pushed)) < count) {
+        usleep(STREAM_READER_BACKOFF_US);
+    }
+}
+
+// Wait for the consumer to hand back a slot; this is the reader's backpressure point
+static MarketData *take_free_slot(SpscRing *free_queue) {
+    MarketData *row;
+    while ((row = spsc_ring_pop(free_queue)) == NULL) {
+        usleep(STREAM_READER_BACKOFF_US);
+    }
+    return row;
+}
+
+void *stream_reader_thread(void *args) {
+    StreamReaderArgs *reader_args = (StreamReaderArgs *)args;
+    reader_args->rows_read = 0;
+    reader_args->status = 0;
+
+    MarketDataStream *stream = market_data_stream_open(reader_args->filename);
+    if (stream == NULL) {
+        reader_args->status = -1;
+        atomic_store(reader_args->finished, true);
+        return NULL;
+    }
+
+    MarketData *row = NULL;
+    while (reader_args->rows_read < reader_args->max_records) {
+        if (row == NULL) {
+            row = take_free_slot(reader_args->free_queue);
+        }
+
+        int result = market_data_stream_next(stream, row);
+        if (result <= 0) {
+            reader_args->status = result;
+            break;
+        }
+        if (row->open_time_ms < reader_args->start_time_ms) {
+            continue;
+        }
+        if (row->open_time_ms >= reader_args->end_time_ms) {
+            break;
+        }
+
+        stream_reader_push(reader_args->output_queue, row);
+        reader_args->rows_read++;
+        row = NULL;
+    }
+
+    // A slot still in hand was never published
+    if (row) {
+        stream_reader_push(reader_args->free_queue, row);
+    }
+    market_data_stream_close(stream);
+    atomic_store(reader_args->finished, true);
+    return NULL;
+}
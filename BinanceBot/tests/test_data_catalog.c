@@ -0,0 +1,235 @@
+// test_data_catalog.c
+// Builds a catalog directory of small .kbin files plus one .kgor history and walks the
+// LRU budget: files past the budget are dropped coldest first, pinned files stay loaded
+// however cold they are, dropped files load again on the next lookup with the same rows,
+// and a file rewritten after the directory scan is charged at its new size. A .kbin whose
+// row count is corrupted to wrap the computed file size back to its real one must not open,
+// and of several files with one key the catalog keeps the first by path whatever the listing order.
+//
+// Usage: ./bin/test_data_catalog
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <sys/stat.h>
+#include "data_catalog.h"
+#include "history_codec.h"
+#include "kline_store.h"
+#include "market_data_columns.h"
+
+#define ROWS 1000
+#define BASE_TIME_MS 1609459200000LL
+
+static int failures;
+
+#define CHECK(condition, ...)          \
+    do {                               \
+        if (!(condition)) {            \
+            printf("FAIL " __VA_ARGS__); \
+            printf("\n");              \
+            failures++;                \
+        }                              \
+    } while (0)
+
+// Rows whose prices identify the file they came from
+static MarketDataArray *make_rows(size_t count, int tag) {
+    MarketDataArray *array = market_data_array_init(count);
+    for (size_t i = 0; i < count; i++) {
+        MarketData *row = &array->data[i];
+        memset(row, 0, sizeof(*row));
+        row->open_time_ms = BASE_TIME_MS + (int64_t)i * 60000;
+        row->close_time_ms = row->open_time_ms + 59999;
+        row->open = tag * 1000.0 + i;
+        row->high = row->open + 2;
+        row->low = row->open - 1;
+        row->close = row->open + 0.5;
+        row->volume = 1.25 * tag;
+        row->trades = (int)i;
+    }
+    array->length = count;
+    return array;
+}
+
+static void write_kbin(const char *directory, const char *name, size_t rows, int tag) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+    MarketDataArray *array = make_rows(rows, tag);
+    if (kline_store_write(path, array) != 0) {
+        printf("FAIL could not write %s\n", path);
+        exit(1);
+    }
+    market_data_array_free(array);
+}
+
+static void write_kgor(const char *directory, const char *name, size_t rows, int tag) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+    MarketDataArray *array = make_rows(rows, tag);
+    MarketDataColumns *columns = market_data_columns_from_array(array);
+    CompressedHistory *history = columns ? history_compress(columns) : NULL;
+    if (history == NULL || history_write(path, history) != 0) {
+        printf("FAIL could not write %s\n", path);
+        exit(1);
+    }
+    history_free(history);
+    market_data_columns_free(columns);
+    market_data_array_free(array);
+}
+
+static size_t file_size(const char *directory, const char *name) {
+    char path[512];
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+    return stat(path, &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+static bool loaded(DataCatalog *catalog, const char *symbol) {
+    DataCatalogEntry *entry = data_catalog_find(catalog, symbol, "1m");
+    return entry != NULL && entry->columns != NULL;
+}
+
+// Acquire a whole file, check its rows carry the tag, and optionally keep it pinned
+static bool touch(DataCatalog *catalog, const char *symbol, int tag, size_t rows, DataCatalogSlice *keep) {
+    DataCatalogSlice slice;
+    if (data_catalog_acquire(catalog, symbol, "1m", 0, INT64_MAX, &slice) != 0) {
+        printf("FAIL could not acquire %s\n", symbol);
+        failures++;
+        return false;
+    }
+    bool ok = slice.last - slice.first == rows;
+    for (size_t i = slice.first; ok && i < slice.last; i++) {
+        MarketData row;
+        market_data_columns_row(slice.columns, i, &row);
+        ok = row.open == tag * 1000.0 + (double)i && row.open_time_ms == BASE_TIME_MS + (int64_t)i * 60000;
+    }
+    CHECK(ok, "%s came back with %zu rows or the wrong values", symbol, slice.last - slice.first);
+    if (keep) {
+        *keep = slice;
+    } else {
+        data_catalog_release(catalog, &slice);
+    }
+    return ok;
+}
+
+int main(void) {
+    char directory[] = "/tmp/test_data_catalog_XXXXXX";
+    if (mkdtemp(directory) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+    write_kbin(directory, "AAAUSDT_1m.kbin", ROWS, 1);
+    write_kbin(directory, "BBBUSDT_1m.kbin", ROWS, 2);
+    write_kbin(directory, "CCCUSDT_1m.kbin", ROWS, 3);
+    write_kgor(directory, "DDDUSDT_1m.kgor", ROWS, 4);
+    size_t one_file = file_size(directory, "AAAUSDT_1m.kbin");
+
+    // Room for two mapped files but not three
+    DataCatalog *catalog = data_catalog_open(directory, one_file * 2 + one_file / 2);
+    if (catalog == NULL) {
+        printf("FAIL could not open the catalog\n");
+        return 1;
+    }
+    CHECK(catalog->entry_count == 4, "catalog indexed %zu files", catalog->entry_count);
+
+    // Eviction past the budget drops the least recently used file
+    touch(catalog, "AAAUSDT", 1, ROWS, NULL);
+    touch(catalog, "BBBUSDT", 2, ROWS, NULL);
+    CHECK(loaded(catalog, "AAAUSDT") && loaded(catalog, "BBBUSDT"), "two files should fit the budget");
+    touch(catalog, "CCCUSDT", 3, ROWS, NULL);
+    CHECK(!loaded(catalog, "AAAUSDT"), "the coldest file was not dropped");
+    CHECK(loaded(catalog, "BBBUSDT") && loaded(catalog, "CCCUSDT"), "warmer files were dropped");
+    CHECK(catalog->mapped_bytes <= catalog->memory_budget, "%zu bytes loaded over a %zu budget",
+          catalog->mapped_bytes, catalog->memory_budget);
+
+    // Lookup after eviction loads the file again with the same rows
+    touch(catalog, "AAAUSDT", 1, ROWS, NULL);
+    CHECK(loaded(catalog, "AAAUSDT") && !loaded(catalog, "BBBUSDT"), "reloading did not drop the next coldest");
+
+    // A pinned file stays loaded while everything else cycles past it, even over budget
+    DataCatalogSlice pinned;
+    touch(catalog, "AAAUSDT", 1, ROWS, &pinned);
+    touch(catalog, "BBBUSDT", 2, ROWS, NULL);
+    touch(catalog, "CCCUSDT", 3, ROWS, NULL);
+    touch(catalog, "DDDUSDT", 4, ROWS, NULL);
+    CHECK(loaded(catalog, "AAAUSDT"), "a pinned file was dropped");
+    MarketData row;
+    market_data_columns_row(pinned.columns, ROWS - 1, &row);
+    CHECK(row.open == 1000.0 + ROWS - 1, "a pinned file's rows changed under its slice");
+    data_catalog_release(catalog, &pinned);
+    CHECK(catalog->mapped_bytes <= catalog->memory_budget, "releasing the pin left %zu bytes over a %zu budget",
+          catalog->mapped_bytes, catalog->memory_budget);
+
+    // A decoded history is charged at its decoded size, not its file size
+    DataCatalogEntry *history = data_catalog_find(catalog, "DDDUSDT", "1m");
+    touch(catalog, "DDDUSDT", 4, ROWS, &pinned);
+    CHECK(history->resident_bytes >= ROWS * KLINE_COLUMN_COUNT * sizeof(int64_t),
+          "decoded history charged %zu bytes", history->resident_bytes);
+    data_catalog_release(catalog, &pinned);
+
+    // A file rewritten after the scan is charged at its new size on the next load
+    DataCatalogEntry *grown = data_catalog_find(catalog, "BBBUSDT", "1m");
+    size_t indexed_size = grown->file_size;
+    touch(catalog, "AAAUSDT", 1, ROWS, NULL);
+    touch(catalog, "CCCUSDT", 3, ROWS, NULL);
+    CHECK(!loaded(catalog, "BBBUSDT"), "BBBUSDT should be cold by now");
+    write_kbin(directory, "BBBUSDT_1m.kbin", ROWS * 2, 2);
+    size_t before = catalog->mapped_bytes;
+    DataCatalogSlice slice;
+    touch(catalog, "BBBUSDT", 2, ROWS * 2, &slice);
+    CHECK(grown->file_size == file_size(directory, "BBBUSDT_1m.kbin") && grown->file_size > indexed_size,
+          "grown file recorded as %zu bytes, %zu on disk", grown->file_size, file_size(directory, "BBBUSDT_1m.kbin"));
+    CHECK(catalog->mapped_bytes >= grown->file_size && catalog->mapped_bytes - grown->file_size <= before,
+          "loaded total %zu does not include the grown file", catalog->mapped_bytes);
+    data_catalog_release(catalog, &slice);
+    CHECK(catalog->mapped_bytes <= catalog->memory_budget, "%zu bytes loaded over a %zu budget after growth",
+          catalog->mapped_bytes, catalog->memory_budget);
+
+    data_catalog_close(catalog);
+
+    // 2^61 extra rows wrap to zero extra bytes, so the offsets still match the real layout
+    write_kbin(directory, "EEEUSDT_1m.kbin", ROWS, 5);
+    char corrupt_path[512];
+    snprintf(corrupt_path, sizeof(corrupt_path), "%s/EEEUSDT_1m.kbin", directory);
+    uint64_t wrapped_rows = ((uint64_t)1 << 61) + ROWS;
+    int fd = open(corrupt_path, O_WRONLY);
+    CHECK(fd >= 0 && pwrite(fd, &wrapped_rows, sizeof(wrapped_rows), offsetof(KlineStoreHeader, row_count)) == sizeof(wrapped_rows),
+          "could not corrupt %s", corrupt_path);
+    close(fd);
+    KlineStore *corrupt = kline_store_open(corrupt_path);
+    CHECK(corrupt == NULL, "a store claiming %llu rows was opened", (unsigned long long)wrapped_rows);
+    if (corrupt) {
+        kline_store_close(corrupt);
+    }
+
+    // Three files share FFFUSDT 1m; FFFUSDT_1m.kbin sorts first by path and is the one served
+    write_kgor(directory, "FFFUSDT_1m.kgor", ROWS, 7);
+    write_kbin(directory, "FFFUSDT_MinuteBars.kbin", ROWS, 8);
+    write_kbin(directory, "FFFUSDT_1m.kbin", ROWS, 6);
+    catalog = data_catalog_open(directory, SIZE_MAX);
+    if (catalog == NULL) {
+        printf("FAIL could not reopen the catalog\n");
+        return 1;
+    }
+    DataCatalogEntry *duplicate = data_catalog_find(catalog, "FFFUSDT", "1m");
+    const char *winner = duplicate ? strrchr(duplicate->path, '/') + 1 : "nothing";
+    CHECK(strcmp(winner, "FFFUSDT_1m.kbin") == 0, "FFFUSDT 1m resolved to %s", winner);
+    touch(catalog, "FFFUSDT", 6, ROWS, NULL);
+    data_catalog_close(catalog);
+
+    const char *names[] = {"AAAUSDT_1m.kbin", "BBBUSDT_1m.kbin", "CCCUSDT_1m.kbin", "DDDUSDT_1m.kgor", "EEEUSDT_1m.kbin",
+                           "FFFUSDT_1m.kgor", "FFFUSDT_MinuteBars.kbin", "FFFUSDT_1m.kbin"};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", directory, names[i]);
+        unlink(path);
+    }
+    rmdir(directory);
+
+    if (failures) {
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
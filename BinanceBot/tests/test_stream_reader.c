@@ -0,0 +1,263 @@
+// test_stream_reader.c
+// Feeds kline CSV through a FIFO a few bytes per write and parses it with a buffer smaller than
+// two rows, so nearly every row is split across reads and buffer refills. Checks every row
+// arrives intact and in order, that a line longer than the buffer is skipped whole, and that
+// the stream reader thread stops reading while the consumer holds all of its free slots.
+//
+// Usage: ./bin/test_stream_reader
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "market_data_array.h"
+#include "spsc_ring.h"
+#include "stream_reader.h"
+
+#define ROWS 2000
+#define SMALL_BUFFER 256
+#define WRITE_CHUNK 7
+#define FREE_SLOTS 4
+#define BASE_TIME_MS 1609459200000LL
+// The overlong line goes in after this row
+#define LONG_LINE_AFTER 700
+
+static int failures;
+
+typedef struct {
+    const char *path;
+    const char *text;
+    size_t length;
+} WriterArgs;
+
+// Write the CSV into the FIFO in small pieces, the way a slow producer or pipe would deliver it
+static void *writer_thread(void *args) {
+    WriterArgs *writer = (WriterArgs *)args;
+    int fd = open(writer->path, O_WRONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    for (size_t offset = 0; offset < writer->length;) {
+        size_t chunk = writer->length - offset < WRITE_CHUNK ? writer->length - offset : WRITE_CHUNK;
+        ssize_t n = write(fd, writer->text + offset, chunk);
+        if (n <= 0) {
+            break;
+        }
+        offset += (size_t)n;
+    }
+    close(fd);
+    return NULL;
+}
+
+static void append(char **text, size_t *length, size_t *capacity, const char *line) {
+    size_t n = strlen(line);
+    if (*length + n + 1 > *capacity) {
+        *capacity = (*capacity + n + 1) * 2;
+        *text = (char *)realloc(*text, *capacity);
+    }
+    memcpy(*text + *length, line, n + 1);
+    *length += n;
+}
+
+// Header, ROWS rows (some CRLF, some with date-string times), one line longer than the small
+// buffer whose tail is itself a well-formed row, and an unterminated last row
+static char *build_csv(size_t *length) {
+    size_t capacity = 0;
+    char *text = NULL;
+    char line[512];
+    *length = 0;
+    append(&text, length, &capacity,
+           "timestamp,open,high,low,close,volume,close_time,quote_av,trades,tb_base_av,tb_quote_av,ignore\n");
+    for (int i = 0; i < ROWS; i++) {
+        long long open_time = BASE_TIME_MS + i * 60000LL;
+        char time_text[32];
+        if (i % 3 == 0) {
+            long long minutes = i;
+            snprintf(time_text, sizeof(time_text), "2021-01-%02lld %02lld:%02lld:00", 1 + minutes / 1440,
+                     (minutes / 60) % 24, minutes % 60);
+        } else {
+            snprintf(time_text, sizeof(time_text), "%lld", open_time);
+        }
+        snprintf(line, sizeof(line), "%s,%d.25000000,%d.50000000,%d.75000000,%d.12500000,%d.00100000,%lld,%d.5,%d,%d.25,%d.75,0%s",
+                 time_text, i, i + 1, i, i, i, open_time + 59999, i, i, i, i,
+                 i == ROWS - 1 ? "" : (i % 5 == 0 ? "\r\n" : "\n"));
+        append(&text, length, &capacity, line);
+        if (i == LONG_LINE_AFTER) {
+            // A stream that only dropped the buffer's worth of this line would parse the rest
+            // as a row with open time 42
+            char junk[SMALL_BUFFER];
+            memset(junk, 'x', sizeof(junk) - 2);
+            junk[sizeof(junk) - 2] = ',';
+            junk[sizeof(junk) - 1] = '\0';
+            append(&text, length, &capacity, junk);
+            append(&text, length, &capacity, "42,1,1,1,1,1,42,1,1,1,1,0\n");
+        }
+    }
+    return text;
+}
+
+static bool row_matches(const MarketData *row, int i) {
+    return row->open_time_ms == BASE_TIME_MS + i * 60000LL && row->open == i + 0.25 && row->high == i + 1.5 &&
+           row->low == i + 0.75 && row->close == i + 0.125 && row->volume == i + 0.001 &&
+           row->close_time_ms == BASE_TIME_MS + i * 60000LL + 59999 && row->trades == i && row->ignore == 0;
+}
+
+static void make_fifo(const char *path, const char *csv, size_t length, pthread_t *writer, WriterArgs *args) {
+    unlink(path);
+    if (mkfifo(path, 0600) != 0) {
+        perror("mkfifo");
+        exit(1);
+    }
+    *args = (WriterArgs){path, csv, length};
+    pthread_create(writer, NULL, writer_thread, args);
+}
+
+static void test_split_lines(const char *path, const char *csv, size_t length) {
+    pthread_t writer;
+    WriterArgs writer_args;
+    make_fifo(path, csv, length, &writer, &writer_args);
+
+    MarketDataStream *stream = market_data_stream_open_buffered(path, SMALL_BUFFER);
+    if (stream == NULL) {
+        printf("FAIL could not open the FIFO\n");
+        failures++;
+        return;
+    }
+    MarketData row;
+    int rows = 0;
+    int result;
+    while ((result = market_data_stream_next(stream, &row)) == 1) {
+        if (rows >= ROWS || !row_matches(&row, rows)) {
+            printf("FAIL row %d came back as open time %lld, open %.8f\n", rows, (long long)row.open_time_ms, row.open);
+            failures++;
+            break;
+        }
+        rows++;
+    }
+    market_data_stream_close(stream);
+    pthread_join(writer, NULL);
+    if (result != 0 || rows != ROWS) {
+        printf("FAIL %d-byte buffer read %d of %d rows, last result %d\n", SMALL_BUFFER, rows, ROWS, result);
+        failures++;
+    }
+}
+
+static void test_backpressure(const char *path, const char *csv, size_t length) {
+    pthread_t writer;
+    WriterArgs writer_args;
+    make_fifo(path, csv, length, &writer, &writer_args);
+
+    SpscRing *input_queue = spsc_ring_init(64);
+    SpscRing *free_queue = spsc_ring_init(FREE_SLOTS);
+    atomic_bool finished = false;
+    if (!stream_reader_seed(free_queue, FREE_SLOTS)) {
+        printf("FAIL could not seed %d free slots\n", FREE_SLOTS);
+        failures++;
+        return;
+    }
+    StreamReaderArgs reader_args = {
+        .filename = path,
+        .output_queue = input_queue,
+        .free_queue = free_queue,
+        .start_time_ms = 0,
+        .end_time_ms = INT64_MAX,
+        .max_records = ROWS,
+        .finished = &finished,
+    };
+    pthread_t reader;
+    pthread_create(&reader, NULL, stream_reader_thread, &reader_args);
+
+    // Hold off consuming: the reader must stall once every slot is queued
+    usleep(100 * 1000);
+    MarketData *held[FREE_SLOTS + 1];
+    size_t queued = 0;
+    while (queued < FREE_SLOTS + 1 && (held[queued] = (MarketData *)spsc_ring_pop(input_queue)) != NULL) {
+        queued++;
+    }
+    if (queued != FREE_SLOTS || atomic_load(&finished)) {
+        printf("FAIL reader queued %zu rows with %d free slots and %s\n", queued, FREE_SLOTS,
+               atomic_load(&finished) ? "finished early" : "kept waiting");
+        failures++;
+    }
+
+    MarketData *seen[FREE_SLOTS * 2];
+    size_t distinct = 0;
+    int next = 0;
+    for (size_t i = 0; i < queued; i++) {
+        if (!row_matches(held[i], next)) {
+            printf("FAIL row %d queued before the stall is damaged\n", next);
+            failures++;
+        }
+        next++;
+        seen[distinct++] = held[i];
+        stream_reader_push(free_queue, held[i]);
+    }
+    for (;;) {
+        MarketData *row = (MarketData *)spsc_ring_pop(input_queue);
+        if (row == NULL) {
+            if (atomic_load(&finished) && spsc_ring_is_empty(input_queue)) {
+                break;
+            }
+            sched_yield();
+            continue;
+        }
+        if (!row_matches(row, next)) {
+            printf("FAIL reader delivered row %d out of order or damaged\n", next);
+            failures++;
+            break;
+        }
+        next++;
+        bool known = false;
+        for (size_t i = 0; i < distinct; i++) {
+            known |= seen[i] == row;
+        }
+        if (!known && distinct < FREE_SLOTS * 2) {
+            seen[distinct++] = row;
+        }
+        stream_reader_push(free_queue, row);
+    }
+    pthread_join(reader, NULL);
+    pthread_join(writer, NULL);
+
+    // Every row travelled in one of the seeded slots
+    if (next != ROWS || reader_args.rows_read != ROWS || reader_args.status != 0 || distinct > FREE_SLOTS) {
+        printf("FAIL backpressure run: %d of %d rows, reader read %zu (status %d), %zu distinct slots\n", next, ROWS,
+               reader_args.rows_read, reader_args.status, distinct);
+        failures++;
+    }
+    MarketData *row;
+    while ((row = (MarketData *)spsc_ring_pop(free_queue)) != NULL) {
+        free(row);
+    }
+    spsc_ring_destroy(free_queue);
+    spsc_ring_destroy(input_queue);
+}
+
+int main(void) {
+    char path[] = "/tmp/test_stream_reader_XXXXXX";
+    if (mkdtemp(path) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+    char fifo[sizeof(path) + 16];
+    snprintf(fifo, sizeof(fifo), "%s/klines.csv", path);
+
+    size_t length;
+    char *csv = build_csv(&length);
+    test_split_lines(fifo, csv, length);
+    test_backpressure(fifo, csv, length);
+    free(csv);
+    unlink(fifo);
+    rmdir(path);
+
+    if (failures) {
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
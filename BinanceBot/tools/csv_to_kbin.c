@@ -0,0 +1,74 @@
+// csv_to_kbin.c
+// One-shot converter from the collectors' *_MinuteBars.csv files to .kbin column stores.
+//
+// Usage: ./bin/csv_to_kbin input.csv [output.kbin|output.kgor] [threads]
+// The output defaults to the input path with its extension replaced by .kbin. An output
+// ending in .kgor is written as a compressed history instead, which the data catalog
+// decodes on first access.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "market_data_array.h"
+#include "kline_store.h"
+#include "market_data_columns.h"
+#include "history_codec.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        printf("Usage: %s input.csv [output.kbin|output.kgor] [threads]\n", argv[0]);
+        return 1;
+    }
+
+    const char *input = argv[1];
+    char output[4096];
+    if (argc > 2) {
+        snprintf(output, sizeof(output), "%s", argv[2]);
+    } else {
+        snprintf(output, sizeof(output), "%s", input);
+        char *dot = strrchr(output, '.');
+        char *slash = strrchr(output, '/');
+        if (dot == NULL || (slash && dot < slash)) {
+            dot = output + strlen(output);
+        }
+        snprintf(dot, sizeof(output) - (size_t)(dot - output), ".kbin");
+    }
+    int threads = argc > 3 ? atoi(argv[3]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    double start = now_seconds();
+    MarketDataArray *array = market_data_array_init(1024);
+    if (array == NULL || read_csv_file_parallel(input, array, threads) != 0) {
+        return 1;
+    }
+    double parsed = now_seconds();
+
+    size_t output_length = strlen(output);
+    int status;
+    if (output_length > 5 && strcmp(output + output_length - 5, ".kgor") == 0) {
+        MarketDataColumns *columns = market_data_columns_from_array(array);
+        CompressedHistory *history = columns ? history_compress(columns) : NULL;
+        status = history ? history_write(output, history) : -1;
+        history_free(history);
+        market_data_columns_free(columns);
+    } else {
+        status = kline_store_write(output, array);
+    }
+    if (status != 0) {
+        market_data_array_free(array);
+        return 1;
+    }
+    double written = now_seconds();
+
+    printf("%s -> %s: %zu rows (parse %.3f s, write %.3f s)\n",
+           input, output, array->length, parsed - start, written - parsed);
+
+    market_data_array_free(array);
+    return 0;
+}
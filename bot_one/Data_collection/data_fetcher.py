@@ -1,7 +1,7 @@
 import os
 import json
+import time
 import datetime
-import pandas as pd
 from binance.client import Client
 from binance.exceptions import BinanceAPIException, BinanceRequestException
 
@@ -25,15 +25,15 @@ def create_client(api_key, api_secret):
         print(f'Error creating client: {e}')
         return None
 
-# Fetch data from the Binance API
-def fetch_data(bclient, symbol, interval, start_date, end_date):
-    print('Fetching data from Binance...')
+# Fetch data from the Binance API; start and end are epoch milliseconds
+def fetch_data(bclient, symbol, interval, start_ms, end_ms):
+    print(f'Fetching {symbol} data from Binance...')
     try:
         klines = bclient.get_historical_klines(
             symbol,
             interval,
-            start_date.strftime("%d %b %Y %H:%M:%S"),
-            end_date.strftime("%d %b %Y %H:%M:%S"),
+            start_ms,
+            end_ms,
             limit=1000
         )
         return klines
@@ -45,23 +45,90 @@ def fetch_data(bclient, symbol, interval, start_date, end_date):
         print(f'An error occurred: {e}')
     return None
 
-# Convert raw data to DataFrame and save to CSV
-def process_and_save_data(raw_data, symbol):
-    print('Processing data and saving to CSV...')
+HEADER = ('timestamp,open,high,low,close,volume,close_time,quote_asset_volume,number_of_trades,'
+          'taker_buy_base_volume,taker_buy_quote_volume,ignore\n')
+
+# Minute bars keep their original file name, other intervals are SYMBOL_INTERVAL.csv
+def history_path(symbol, interval):
+    if interval == '1m':
+        return f'data/{symbol}_MinuteBars.csv'
+    return f'data/{symbol}_{interval}.csv'
+
+# Cut a partial last line left by an interrupted append and return the close time of the
+# last stored bar, or None when there is no history yet
+def last_close_time(filename):
+    if not os.path.exists(filename):
+        return None
+    with open(filename, 'rb+') as f:
+        size = f.seek(0, os.SEEK_END)
+        tail = b''
+        while size > 0 and b'\n' not in tail:
+            start = max(0, size - 4096)
+            f.seek(start)
+            tail = f.read(size - start)
+            if b'\n' not in tail:
+                size = start
+        clean = size - len(tail) + tail.rfind(b'\n') + 1 if b'\n' in tail else 0
+        if clean != f.seek(0, os.SEEK_END):
+            print(f'Dropping a partial line from {filename}')
+            f.truncate(clean)
+            os.fsync(f.fileno())
+        f.seek(max(0, clean - 4096))
+        lines = f.read(clean - max(0, clean - 4096)).splitlines()
+    if not lines or lines[-1].startswith(b'timestamp'):
+        return None
+    return int(lines[-1].split(b',')[6])
+
+# Append closed bars to the history as one block; earlier rows are never rewritten
+def append_bars(raw_data, filename, now_ms):
+    rows = []
+    for k in raw_data:
+        # The bar still forming closes in the future and is never stored
+        if int(k[6]) >= now_ms:
+            break
+        timestamp = datetime.datetime.fromtimestamp(int(k[0]) / 1000, datetime.timezone.utc).strftime('%Y-%m-%d %H:%M:%S')
+        rows.append(f'{timestamp},{k[1]},{k[2]},{k[3]},{k[4]},{k[5]},{int(k[6])},{k[7]},{int(k[8])},{k[9]},{k[10]},0\n')
+    if not rows:
+        return 0
+
+    os.makedirs('data', exist_ok=True)
+    fd = os.open(filename, os.O_WRONLY | os.O_CREAT | os.O_APPEND, 0o644)
     try:
-        data = pd.DataFrame(raw_data, columns=[
-            'timestamp', 'open', 'high', 'low', 'close', 'volume',
-            'close_time', 'quote_asset_volume', 'number_of_trades',
-            'taker_buy_base_volume', 'taker_buy_quote_volume', 'ignore'
-        ])
-        data['timestamp'] = pd.to_datetime(data['timestamp'], unit='ms')
-        data.set_index('timestamp', inplace=True)
-        filename = f'data/{symbol}_MinuteBars.csv'
-        os.makedirs('data', exist_ok=True)
-        data.to_csv(filename)
-        print(f'Data saved to {filename}')
-    except Exception as e:
-        print(f'Error processing and saving data: {e}')
+        size = os.fstat(fd).st_size
+        block = memoryview((('' if size else HEADER) + ''.join(rows)).encode())
+        try:
+            # os.write may take only part of the block, so keep writing until it is all down
+            while block:
+                block = block[os.write(fd, block):]
+            os.fsync(fd)
+        except OSError:
+            os.ftruncate(fd, size)
+            raise
+    finally:
+        os.close(fd)
+    return len(rows)
+
+# Fetch only the bars closed since the last stored one and append them
+def sync_symbol(bclient, symbol, interval, start_ms, end_ms):
+    filename = history_path(symbol, interval)
+    last = last_close_time(filename)
+    if last is not None:
+        start_ms = last + 1
+    now_ms = int(time.time() * 1000)
+    end_ms = min(end_ms, now_ms) if end_ms else now_ms
+    if start_ms >= end_ms:
+        print(f'{symbol}: up to date')
+        return
+
+    raw_data = fetch_data(bclient, symbol, interval, start_ms, end_ms)
+    if raw_data is None:
+        return
+    count = append_bars(raw_data, filename, now_ms)
+    print(f'{symbol}: {count} new bars appended to {filename}')
+
+def date_to_ms(date_str):
+    date = datetime.datetime.strptime(date_str, '%d %b %Y').replace(tzinfo=datetime.timezone.utc)
+    return int(date.timestamp() * 1000)
 
 # Main function to coordinate the extraction
 def binance_bar_extractor():
@@ -71,17 +138,14 @@ def binance_bar_extractor():
     if bclient is None:
         return
 
-    symbol = config.get('symbol', 'BTCUSDT')
+    symbols = config.get('symbols', [config.get('symbol', 'BTCUSDT')])
     interval = config.get('interval', Client.KLINE_INTERVAL_1MINUTE)
-    start_date_str = config.get('start_date', '1 Jan 2021')
-    end_date_str = config.get('end_date', datetime.datetime.today().strftime('%d %b %Y'))
-    start_date = datetime.datetime.strptime(start_date_str, '%d %b %Y')
-    end_date = datetime.datetime.strptime(end_date_str, '%d %b %Y')
+    start_ms = date_to_ms(config.get('start_date', '1 Jan 2021'))
+    end_date_str = config.get('end_date', 'today')
+    end_ms = None if end_date_str == 'today' else date_to_ms(end_date_str)
 
-    raw_data = fetch_data(bclient, symbol, interval, start_date, end_date)
-    if raw_data is None:
-        return
-    process_and_save_data(raw_data, symbol)
+    for symbol in symbols:
+        sync_symbol(bclient, symbol, interval, start_ms, end_ms)
     print('Data extraction finished!')
 
 if __name__ == '__main__':
@@ -0,0 +1,87 @@
+// include/capture_log.h
+#ifndef CAPTURE_LOG_H
+#define CAPTURE_LOG_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#define CAPTURE_MAGIC "TBCAP001"
+#define CAPTURE_VERSION 1
+// Hand-off between the feed thread and the writer; must be a power of two
+#define CAPTURE_RING_BYTES (16 * 1024 * 1024)
+// Disk space is reserved this far ahead of the write position
+#define CAPTURE_PREALLOCATE_BYTES (64 * 1024 * 1024)
+// Largest block the writer hands to one pwrite
+#define CAPTURE_WRITE_BYTES (1024 * 1024)
+// How long the writer sleeps when the ring is empty
+#define CAPTURE_IDLE_US 500
+// Records start on this alignment
+#define CAPTURE_ALIGN 8
+
+// File layout: one CaptureFileHeader, then records back to back, each a CaptureRecordHeader
+// followed by the raw message padded to CAPTURE_ALIGN. The clocks sampled at creation
+// map receive times onto wall time. Space past the last record is zero until written, so a
+// record with length 0 marks the end of a log that was not closed cleanly.
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    int64_t created_realtime_ns;
+    int64_t created_monotonic_ns;
+} CaptureFileHeader;
+
+typedef struct {
+    int64_t receive_ns;       // CLOCK_MONOTONIC when the message's bytes were read from the socket
+    uint32_t length;          // message bytes, excluding padding
+    uint32_t source;          // which connection the message came from
+} CaptureRecordHeader;
+
+// Append-only capture of every raw feed message. The feed thread copies each record into
+// a single-producer/single-consumer byte ring and returns; a dedicated writer thread drains
+// the ring into the file in large blocks, so the feed never waits on disk. If the writer
+// falls a whole ring behind, the record is dropped and counted rather than blocking.
+typedef struct {
+    _Alignas(64) _Atomic size_t head;   // ring bytes published by the feed thread
+    size_t cached_tail;                 // feed thread's last view of tail
+    _Alignas(64) _Atomic size_t tail;   // ring bytes written to disk
+    _Alignas(64) char *ring;
+    int fd;
+    pthread_t writer;
+    atomic_int running;
+    off_t written;            // file bytes written, header included
+    off_t allocated;          // file bytes reserved
+    size_t records;           // records accepted by capture_log_append
+    size_t dropped;           // records dropped because the ring was full
+    int write_error;
+} CaptureLog;
+
+// Reads a capture back in order; the file is mapped, so messages point into it
+typedef struct {
+    const char *data;
+    size_t size;
+    size_t offset;
+    CaptureFileHeader header;
+} CaptureReader;
+
+// Function to create the log at path, which must not exist yet, and start its writer thread
+int capture_log_open(CaptureLog *log, const char *path);
+
+// Function to queue one message from the feed thread; returns -1 if it was dropped
+int capture_log_append(CaptureLog *log, long long receive_ns, uint32_t source, const char *message, size_t length);
+
+// Function to write out everything queued, trim the unused reservation and close the file
+int capture_log_close(CaptureLog *log);
+
+// Function to open a capture for reading
+int capture_reader_open(CaptureReader *reader, const char *path);
+
+// Function to read the next record; returns 1 for a record, 0 at the end, -1 if the file is corrupt
+int capture_reader_next(CaptureReader *reader, CaptureRecordHeader *record, const char **message);
+
+// Function to unmap the capture
+void capture_reader_close(CaptureReader *reader);
+
+#endif // CAPTURE_LOG_H
@@ -3,6 +3,7 @@
 
 #include <stddef.h>
 #include "types.h"
+#include "wait_strategy.h"
 
 typedef struct {
     // Trading parameters
@@ -20,7 +21,23 @@ typedef struct {
     char interval[16];
     char start_date[32];
     char end_date[32];
-    
+    char base_url[128];       // REST endpoint, https://api.binance.com unless overridden
+    char data_dir[128];       // directory of per-symbol kline history files
+    int backfill_concurrency; // kline pages in flight during a backfill
+    char cache_dir[128];      // parsed kline pages cached here between runs
+    int cache_max_mb;         // response cache size cap, 0 disables the cache
+    int rate_limit_weight;    // REQUEST_WEIGHT the fetcher may spend per minute, 0 disables pacing
+    char stream_url[256];     // ws:// or wss:// market stream; empty keeps the simulated feed
+    char replay_file[256];    // recorded .jsonl stream capture or .csv kline history fed in place of the live feed
+    double replay_speed;      // replay pace as a multiple of the recorded one, 0 replays as fast as possible
+    char capture_dir[128];    // raw stream messages are recorded here when set, one .cap file per run
+    char depth_stream_url[256]; // ws:// or wss:// diff depth stream feeding the order book; empty disables it
+    double tick_size;         // price increment of the symbol, the order book's level spacing
+
+    // How the pre-processing thread waits for ticks and the strategy loop for processed ones
+    WaitMode input_wait;
+    WaitMode output_wait;
+
     // Add these fields for millisecond timestamps
     long long start_time_ms;  // Start time in milliseconds
     long long end_time_ms;    // End time in milliseconds
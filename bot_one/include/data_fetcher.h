@@ -3,14 +3,12 @@
 
 #include "config_parser.h"
 #include "pre_processing.h"
-
-// Structure to hold memory for libcurl response
-struct MemoryStruct {
-    char *memory;
-    size_t size;
-};
+#include "fetcher_context.h"
 
 // Function to fetch data from Binance API
-int fetch_data(const ConfigParams *config, RawData *raw_data);
+int fetch_data(FetcherContext *context, const ConfigParams *config, RawData *raw_data);
+
+// Function to append klines closed since the last stored bar to the symbol's history file
+int sync_history(FetcherContext *context, const ConfigParams *config, const char *symbol, size_t *rows_appended);
 
 #endif // DATA_FETCHER_H
@@ -0,0 +1,31 @@
+// include/depth_stream.h
+#ifndef DEPTH_STREAM_H
+#define DEPTH_STREAM_H
+
+#include <stddef.h>
+#include "order_book.h"
+#include "fetcher_context.h"
+
+// Levels requested in a REST depth snapshot, and the request weight Binance charges for it
+#define DEPTH_SNAPSHOT_LIMIT 1000
+#define DEPTH_SNAPSHOT_WEIGHT 50
+// Pause before asking for another snapshot when the last one predated the buffered diffs
+#define DEPTH_SNAPSHOT_RETRY_MS 250
+
+// Keeps an order book in step with a Binance diff depth stream
+// (wss://.../ws/<symbol>@depth@100ms): diffs go straight to the book, and whenever the book
+// is out of sync a REST snapshot is fetched and the buffered diffs are replayed on top of it.
+typedef struct {
+    const char *url;
+    OrderBook *book;
+    FetcherContext *fetcher;      // REST client for /api/v3/depth snapshots
+    const int *running;           // the stream stops once this reads 0
+    size_t messages;              // diff messages received
+    size_t snapshots;             // snapshots applied
+} DepthStream;
+
+// Function to follow stream->url until *stream->running is 0, reconnecting and resyncing
+// the book whenever the connection drops
+int depth_stream_run(DepthStream *stream);
+
+#endif // DEPTH_STREAM_H
@@ -0,0 +1,57 @@
+// include/fetcher_context.h
+#ifndef FETCHER_CONTEXT_H
+#define FETCHER_CONTEXT_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <curl/curl.h>
+#include "rate_limiter.h"
+
+// Response buffers start this large so a full 1000-kline page never reallocates
+#define FETCHER_RESPONSE_RESERVE (256 * 1024)
+// Seconds a resolved host stays in the shared DNS cache
+#define FETCHER_DNS_CACHE_SECONDS 300
+
+// Structure to hold memory for libcurl response
+struct MemoryStruct {
+    char *memory;
+    size_t size;
+    size_t capacity;
+};
+
+// One keep-alive easy handle and the buffer its responses land in
+typedef struct {
+    CURL *easy;
+    struct MemoryStruct body;
+    long http_code;
+    long used_weight;    // X-MBX-USED-WEIGHT-1M of the last response, -1 if absent
+    long retry_after_s;  // Retry-After of the last response, -1 if absent
+    bool in_use;
+} FetcherConnection;
+
+// Long-lived fetcher state: a pool of easy handles that share one DNS cache, TLS session
+// cache and connection cache, so after the first request to a host each request costs a
+// single round trip. Every request is charged to the limiter, which paces it against the
+// host's weight budget. Safe to use from several threads once main() has called
+// curl_global_init.
+typedef struct {
+    char base_url[128];
+    CURLSH *share;
+    pthread_mutex_t share_locks[CURL_LOCK_DATA_LAST];
+    FetcherConnection *connections;
+    int connection_count;
+    pthread_mutex_t lock;
+    pthread_cond_t released;
+    RateLimiter limiter;
+} FetcherContext;
+
+FetcherContext *fetcher_context_create(const char *base_url, int connection_count);
+FetcherConnection *fetcher_acquire(FetcherContext *context);
+void fetcher_release(FetcherContext *context, FetcherConnection *connection);
+void fetcher_prepare(FetcherContext *context, FetcherConnection *connection, const char *path);
+void fetcher_prepare_stream(FetcherContext *context, FetcherConnection *connection, const char *path, curl_write_callback write, void *userdata);
+int fetcher_get(FetcherContext *context, FetcherConnection *connection, const char *path, RequestPriority priority, int weight);
+void fetcher_context_destroy(FetcherContext *context);
+
+#endif // FETCHER_CONTEXT_H
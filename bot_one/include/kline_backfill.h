@@ -0,0 +1,24 @@
+// include/kline_backfill.h
+#ifndef KLINE_BACKFILL_H
+#define KLINE_BACKFILL_H
+
+#include "config_parser.h"
+#include "pre_processing.h"
+#include "fetcher_context.h"
+
+// Binance returns at most this many klines per request
+#define KLINE_PAGE_LIMIT 1000
+// Attempts per page before the backfill gives up
+#define KLINE_PAGE_ATTEMPTS 3
+// REQUEST_WEIGHT Binance charges for one /api/v3/klines request
+#define KLINE_REQUEST_WEIGHT 2
+
+// Function to convert a Binance interval ("1m", "4h", "1d", "1w") to milliseconds, 0 if unsupported
+long long kline_interval_ms(const char *interval);
+
+// Function to fetch [start_time_ms, end_time_ms] for symbol as KLINE_PAGE_LIMIT-bar pages,
+// with up to config->backfill_concurrency pooled connections in flight, and reassemble them in order.
+// Pages are sent at backfill priority, so they only spend weight that live requests leave.
+int backfill_klines(FetcherContext *context, const ConfigParams *config, const char *symbol, long long start_time_ms, long long end_time_ms, RawData *raw_data);
+
+#endif // KLINE_BACKFILL_H
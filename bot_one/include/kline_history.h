@@ -0,0 +1,22 @@
+// include/kline_history.h
+#ifndef KLINE_HISTORY_H
+#define KLINE_HISTORY_H
+
+#include <stddef.h>
+
+// Append-only kline history in the CSV layout written by Data_collection/data_fetcher.py:
+// timestamp,open,high,low,close,volume,close_time,... with one closed bar per line.
+// Appends are whole lines in a single write followed by fsync, and a torn last line
+// left by a crash is cut off on the next open, so earlier rows are never rewritten.
+#define KLINE_HISTORY_HEADER "timestamp,open,high,low,close,volume,close_time,quote_asset_volume,number_of_trades,taker_buy_base_volume,taker_buy_quote_volume,ignore\n"
+
+// Function to build the history path for a symbol, data/BTCUSDT_MinuteBars.csv style
+void kline_history_path(const char *data_dir, const char *symbol, const char *interval, char *path, size_t path_size);
+
+// Function to read the close time of the last stored bar, -1 when the file is missing or has no rows
+long long kline_history_last_close_time(const char *path);
+
+// Function to append complete CSV lines to the history, creating it with a header if needed
+int kline_history_append(const char *path, const char *lines, size_t length);
+
+#endif // KLINE_HISTORY_H
@@ -0,0 +1,62 @@
+// include/kline_parser.h
+#ifndef KLINE_PARSER_H
+#define KLINE_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Longest number text the parser accepts; Binance prices are at most ~20 characters
+#define KLINE_NUMBER_MAX 40
+
+// Destination columns for parsed klines. Row i of the response lands at index i of every
+// non-NULL column; NULL columns are skipped without converting the field.
+typedef struct {
+    long long *open_times;
+    double *open;
+    double *high;
+    double *low;
+    double *close;
+    double *volume;
+    size_t capacity;
+} KlineColumns;
+
+// Incremental parser for the Binance kline response, an array of arrays
+// [open_time, "open", "high", "low", "close", "volume", close_time, ...]. Bytes can be fed in
+// chunks split at any point; numbers are converted as their digits arrive, with no DOM and no
+// per-field allocation.
+typedef struct {
+    KlineColumns columns;
+    size_t row_count;
+    int state;
+    int field;
+    bool escaped;
+    bool failed;
+
+    // Number being accumulated
+    uint64_t mantissa;
+    int mantissa_digits;
+    int fraction_digits;
+    int exponent;
+    bool negative;
+    bool exponent_negative;
+    int number_phase;
+    char text[KLINE_NUMBER_MAX];
+    int text_length;
+} KlineParser;
+
+// Function to reset parser to the start of a response that fills columns
+void kline_parser_init(KlineParser *parser, const KlineColumns *columns);
+
+// Function to consume the next chunk of the response; returns -1 once the input is malformed
+// or holds more rows than the columns can take, after which further input is ignored
+int kline_parser_feed(KlineParser *parser, const char *data, size_t length);
+
+// Function to check that the whole response was seen and well formed; returns 0 or -1
+int kline_parser_finish(const KlineParser *parser);
+
+// curl write callback that feeds a KlineParser passed as userp. It always accepts the bytes so
+// the transfer (and its keep-alive connection) completes; check kline_parser_finish afterwards.
+size_t kline_parser_write(char *contents, size_t size, size_t nmemb, void *userp);
+
+#endif // KLINE_PARSER_H
@@ -0,0 +1,90 @@
+// include/order_book.h
+#ifndef ORDER_BOOK_H
+#define ORDER_BOOK_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+// Price levels tracked per side; the window spans this many ticks around the touch
+#define ORDER_BOOK_DEFAULT_LEVELS 16384
+// The window is recentred once the touch comes within this fraction of either edge
+#define ORDER_BOOK_RECENTER_DIVISOR 8
+// Diff events held while waiting for a snapshot
+#define ORDER_BOOK_PENDING_MAX 4096
+
+typedef enum {
+    BOOK_SIDE_BID,
+    BOOK_SIDE_ASK
+} BookSide;
+
+// Outcome of a depth diff event
+typedef enum {
+    ORDER_BOOK_APPLIED = 0,    // the book moved forward
+    ORDER_BOOK_BUFFERED = 1,   // held until a snapshot arrives
+    ORDER_BOOK_STALE = 2,      // already covered by the snapshot, or not a depth update
+    ORDER_BOOK_GAP = -1        // an update was missed; the book needs a new snapshot
+} OrderBookStatus;
+
+// Level-2 book for one symbol, kept as two flat arrays of resting quantity indexed by the
+// price's tick offset from base_tick. An update is one array store, the best bid and ask
+// are cached indices that only need a scan when the touch level is emptied, and a depth
+// query is a sequential walk out from the touch, so the hot paths stay in a few cache lines.
+// Levels further from the touch than the window reaches are not tracked.
+//
+// Synchronisation follows Binance's diff-depth rules: diffs that arrive before the REST
+// snapshot are buffered, those the snapshot already covers are dropped, and from then on
+// each diff must start right after the previous one, or the book is marked out of sync
+// until the next snapshot. Readers and the updating thread share the book under its lock.
+typedef struct {
+    char symbol[16];
+    double tick_size;
+    size_t levels;
+    long long base_tick;          // tick of index 0
+    double *bids;                 // quantity resting at each level
+    double *asks;
+    long best_bid;                // index of the best level, -1 while the side is empty
+    long best_ask;
+    long long last_update_id;     // final update id applied
+    bool synced;
+    char **pending;               // diff messages received before the snapshot
+    size_t *pending_lengths;
+    size_t pending_count;
+    size_t updates;               // diff events applied
+    size_t outside_window;        // level changes that fell outside the window
+    size_t resyncs;               // gaps that forced a new snapshot
+    pthread_mutex_t lock;
+} OrderBook;
+
+// Function to set up an empty book; levels of 0 uses ORDER_BOOK_DEFAULT_LEVELS
+int order_book_init(OrderBook *book, const char *symbol, double tick_size, size_t levels);
+
+// Function to replace the book with a REST depth snapshot ({"lastUpdateId":..,"bids":[..],"asks":[..]})
+// and apply the buffered diffs that follow it; returns -1 if the snapshot is malformed or
+// older than the buffered diffs, in which case a newer snapshot is needed
+int order_book_apply_snapshot(OrderBook *book, const char *json, size_t length);
+
+// Function to apply one depthUpdate stream message, raw or wrapped in a combined stream
+OrderBookStatus order_book_apply_diff(OrderBook *book, const char *json, size_t length);
+
+// Function to empty the book and drop buffered diffs, e.g. after the diff stream reconnects
+void order_book_reset(OrderBook *book);
+
+// Function to tell whether diffs are waiting on a snapshot
+bool order_book_needs_snapshot(OrderBook *book);
+
+// Function to read the best bid and ask; returns -1 while a side is empty, as it is whenever
+// the book is out of sync
+int order_book_top(OrderBook *book, double *bid, double *bid_quantity, double *ask, double *ask_quantity);
+
+// Function to sum the quantity and notional resting on one side within bps of that side's
+// best price; returns -1 while the side is empty
+int order_book_depth(OrderBook *book, BookSide side, double bps, double *quantity, double *notional);
+
+// Function to set one level directly, for books not fed from Binance messages; a quantity of 0 removes it
+void order_book_set_level(OrderBook *book, BookSide side, double price, double quantity);
+
+// Function to release the book
+void order_book_destroy(OrderBook *book);
+
+#endif // ORDER_BOOK_H
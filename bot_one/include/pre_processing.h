@@ -4,8 +4,10 @@
 #include <stddef.h>
 #include "types.h"
 #include "market_data.h"
-#include "lock_free_queue.h"
+#include "spsc_ring.h"
+#include "wait_strategy.h"
 #include "config_parser.h"
+#include "order_book.h"
 
 typedef struct {
     double *prices;
@@ -23,6 +25,7 @@ typedef struct {
     TrendInfo trend_info;
     double *liquidity;
     size_t liquidity_count;
+    OrderBook *order_book;   // L2 book for the symbol; NULL judges liquidity by bar volume
     size_t trend_period;
     double *macd;
     double *signal_line;
@@ -41,8 +44,10 @@ typedef struct {
 
 
 typedef struct {
-    LockFreeQueue *input_queue;
-    LockFreeQueue *output_queue;
+    SpscRing *input_queue;
+    SpscRing *output_queue;
+    WaitStrategy *input_wait;    // how this thread waits for input
+    WaitStrategy *output_wait;   // notified after each push to output_queue
     size_t window_size;
     double ema_alpha;
     int rsi_period;
@@ -51,6 +56,7 @@ typedef struct {
 } PreProcessingArgs;
 
 typedef struct {
+    long long *open_times;  // Bar open times, epoch ms
     double *prices;       // Close prices
     double *high_prices;
     double *low_prices;
@@ -0,0 +1,62 @@
+// include/rate_limiter.h
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <pthread.h>
+
+// Binance counts REQUEST_WEIGHT per calendar minute
+#define RATE_LIMIT_WINDOW_MS 60000
+// Spot REQUEST_WEIGHT allowed per window
+#define RATE_LIMIT_DEFAULT_WEIGHT 6000
+// Percentage of each window's budget that only live requests may spend
+#define RATE_LIMIT_LIVE_RESERVE_PERCENT 10
+
+// Request classes in the order they are served
+typedef enum {
+    REQUEST_PRIORITY_LIVE,      // latest-price polling; must not queue behind history
+    REQUEST_PRIORITY_BACKFILL,  // historical pages; spends whatever live polling leaves
+    REQUEST_PRIORITY_COUNT
+} RequestPriority;
+
+// Weight budget shared by every request to one API host. The bucket holds the weight left
+// in the server's current window and is refilled when the window rolls over, because the
+// server counts fixed windows: a bucket refilled continuously would let up to twice the
+// limit through one window. Every response reports the weight the server has counted
+// (X-MBX-USED-WEIGHT-1M), which pulls the bucket down when other clients share the budget,
+// and a 429/418 blocks all requests until its Retry-After has passed.
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    int weight_limit;            // weight allowed per window, 0 disables limiting
+    long long window_ms;
+    long long window_start_ms;   // wall-clock start of the window the bucket belongs to
+    int tokens;                  // weight still available in this window
+    int in_flight;               // weight sent but not yet answered
+    long long blocked_until_ms;  // wall-clock time before which nothing is sent
+    int waiting[REQUEST_PRIORITY_COUNT];
+    unsigned long granted[REQUEST_PRIORITY_COUNT];
+    long long max_wait_ms[REQUEST_PRIORITY_COUNT];  // longest a blocking acquire waited
+    unsigned long rejected;      // 429 and 418 responses seen
+} RateLimiter;
+
+// Function to set up a limiter allowing weight_limit per window_ms; weight_limit <= 0 disables it
+void rate_limiter_init(RateLimiter *limiter, int weight_limit, long long window_ms);
+
+// Function to change the budget of a limiter in use; the bucket restarts full at the new budget
+void rate_limiter_configure(RateLimiter *limiter, int weight_limit, long long window_ms);
+
+// Function to wait until weight can be sent at priority; returns the window it was charged to,
+// or -1 without charging anything if weight is more than the whole budget of a window
+long long rate_limiter_acquire(RateLimiter *limiter, RequestPriority priority, int weight);
+
+// Function to charge weight without waiting; returns 0 and sets *window if granted,
+// otherwise the milliseconds until it is worth asking again, or -1 if weight never fits a window
+long long rate_limiter_try_acquire(RateLimiter *limiter, RequestPriority priority, int weight, long long *window);
+
+// Function to account for the response to a granted request; used_weight and retry_after_s are
+// the X-MBX-USED-WEIGHT-1M and Retry-After headers, or -1 when the response had none
+void rate_limiter_complete(RateLimiter *limiter, long long window, int weight, long http_code, long used_weight, long retry_after_s);
+
+void rate_limiter_destroy(RateLimiter *limiter);
+
+#endif // RATE_LIMITER_H
@@ -0,0 +1,46 @@
+// include/replay.h
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stddef.h>
+#include "market_stream.h"
+
+// Longest single sleep between ticks, so a stop request is noticed during quiet stretches
+#define REPLAY_MAX_SLEEP_MS 200
+// The last stretch before a tick is due is spun rather than slept, since a sleep can
+// overshoot by tens of microseconds and would blur the recorded spacing
+#define REPLAY_SPIN_US 200
+
+typedef enum {
+    REPLAY_FORMAT_STREAM_JSONL,   // one Binance stream message per line, timed by its event time "E"
+    REPLAY_FORMAT_KLINE_CSV,      // kline history as written by kline_history, timed by close_time
+    REPLAY_FORMAT_CAPTURE         // capture_log recording, timed by each message's receive time
+} ReplayFormat;
+
+// Replays a recording into the pipeline at the pace it was recorded, in the layout given by
+// the file name: .csv for kline history, .cap for a capture log, anything else for a stream
+// capture with one message per line. Each tick is due at
+// first_time + (event_time - first_event_time) / speed on the monotonic clock, so a slow
+// consumer delays the ticks behind it but never stretches the schedule.
+typedef struct {
+    const char *path;
+    double speed;                 // 1 = recorded pace, 10 = ten times faster, 0 = as fast as possible
+    MarketTickHandler on_tick;
+    void *userdata;
+    const int *running;           // the replay stops once this reads 0
+    size_t records;               // lines or capture records read
+    size_t ticks;                 // ticks handed to on_tick
+    size_t skipped;               // records that were malformed or had no timestamp
+    long long recorded_ms;        // event time covered, first tick to last
+    long long elapsed_ns;         // wall time from first tick to last
+    long long lag_ns_total;       // how late on_tick was called against the schedule, summed over ticks
+    long long lag_ns_max;
+} ReplaySource;
+
+// Function to replay replay->path into replay->on_tick until the file ends or
+// *replay->running is 0; returns -1 if the file cannot be opened or ends inside a record,
+// after delivering every tick before the damage; the counters are reset first, so they
+// describe the latest run
+int replay_run(ReplaySource *replay);
+
+#endif // REPLAY_H
@@ -0,0 +1,46 @@
+// include/response_cache.h
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "kline_parser.h"
+
+#define RESPONSE_CACHE_MAGIC "KCACHE01"
+#define RESPONSE_CACHE_SUFFIX ".kcache"
+
+// What a cached response answers; two requests with equal keys get the same klines
+typedef struct {
+    const char *endpoint;
+    const char *symbol;
+    const char *interval;
+    long long start_time_ms;
+    long long end_time_ms;
+} ResponseCacheKey;
+
+// On-disk cache of parsed kline responses, one file per key named by its hash. Entries hold
+// the columns RawData uses (open time, close, high, low, volume) ready to copy back, so a hit
+// skips both the request and the JSON parse.
+// File modification times order the LRU: a hit touches its file. The directory is scanned
+// once at init and stores keep a running total; only a store that takes the total past
+// max_bytes rescans it and removes the oldest files until it fits again.
+// Keys whose text does not fit RESPONSE_CACHE_KEY_MAX are never cached.
+#define RESPONSE_CACHE_KEY_MAX 256
+
+typedef struct {
+    char dir[256];
+    size_t max_bytes;
+    size_t total_bytes;  // size of every entry in dir, as of the last scan plus stores since
+    bool enabled;
+} ResponseCache;
+
+// Function to set up a cache in dir (created if missing) capped at max_mb; max_mb <= 0 disables it
+int response_cache_init(ResponseCache *cache, const char *dir, int max_mb);
+
+// Function to copy a cached response into columns; returns the row count, or -1 on a miss
+long response_cache_load(const ResponseCache *cache, const ResponseCacheKey *key, const KlineColumns *columns);
+
+// Function to store row_count rows of columns under key, evicting down to the size cap if it is crossed
+int response_cache_store(ResponseCache *cache, const ResponseCacheKey *key, const KlineColumns *columns, size_t row_count);
+
+#endif // RESPONSE_CACHE_H
@@ -24,6 +24,7 @@ typedef struct {
 typedef struct {
     double minimum_liquidity;
     double slippage_factor; // New field to represent slippage per unit time
+    double depth_bps;       // book depth within this many basis points of the touch counts as liquidity
 } LiquidityInfo;
 
 typedef struct {
@@ -0,0 +1,49 @@
+// include/wait_strategy.h
+#ifndef WAIT_STRATEGY_H
+#define WAIT_STRATEGY_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// How a consumer waits for its queue to fill
+typedef enum {
+    WAIT_MODE_SPIN,    // poll continuously: lowest latency, burns a core
+    WAIT_MODE_YIELD,   // poll, then give the core away between polls
+    WAIT_MODE_PARK     // poll, then sleep on a futex until a producer wakes it
+} WaitMode;
+
+// Polls before a yielding or parking consumer backs off
+#define WAIT_SPIN_LIMIT 2000
+// A parked consumer re-checks its stop flag this often even if nobody wakes it
+#define WAIT_PARK_TIMEOUT_MS 100
+
+// Wait strategy for the single consumer of one queue. Producers call wait_strategy_notify
+// after each push; that costs a fence and a load unless the consumer has announced it is
+// parked, and then only the first producer to see the announcement makes the wake-up
+// system call.
+typedef struct {
+    WaitMode mode;
+    _Alignas(64) atomic_uint epoch;   // futex word, bumped by every wake-up
+    atomic_int parked;                // set while the consumer is parked or about to park
+    size_t parks;                     // times the consumer went to sleep
+    atomic_size_t wakes;              // futex wake calls made by producers
+} WaitStrategy;
+
+// Function to set up a strategy with the given mode
+void wait_strategy_init(WaitStrategy *wait, WaitMode mode);
+
+// Function to block the consumer until ready(arg) is true or *running reads 0; returns
+// ready's last answer
+bool wait_strategy_wait(WaitStrategy *wait, bool (*ready)(void *), void *arg, const int *running);
+
+// Function for a producer to call after publishing an item
+void wait_strategy_notify(WaitStrategy *wait);
+
+// Function to wake every parked consumer, e.g. once *running has been cleared
+void wait_strategy_wake_all(WaitStrategy *wait);
+
+// Function to read "spin", "yield" or "park"; returns -1 for anything else
+int wait_mode_parse(const char *name, WaitMode *mode);
+
+#endif // WAIT_STRATEGY_H
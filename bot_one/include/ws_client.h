@@ -0,0 +1,64 @@
+// include/ws_client.h
+#ifndef WS_CLIENT_H
+#define WS_CLIENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <curl/curl.h>
+
+// Largest message the client will reassemble; Binance stream messages are well under 4 KB
+#define WS_MAX_MESSAGE (1 << 20)
+// Initial receive buffer, large enough for a burst of stream messages
+#define WS_BUFFER_RESERVE (64 * 1024)
+// How long the opening handshake may take
+#define WS_HANDSHAKE_TIMEOUT_MS 5000
+
+typedef enum {
+    WS_OPCODE_CONTINUATION = 0x0,
+    WS_OPCODE_TEXT = 0x1,
+    WS_OPCODE_BINARY = 0x2,
+    WS_OPCODE_CLOSE = 0x8,
+    WS_OPCODE_PING = 0x9,
+    WS_OPCODE_PONG = 0xA
+} WsOpcode;
+
+// Called once per complete data message; message points into the client's buffers and is
+// only valid for the duration of the call
+typedef void (*WsMessageHandler)(const char *message, size_t length, void *userdata);
+
+// RFC 6455 client over a libcurl CONNECT_ONLY connection, so ws:// and wss:// URLs share one
+// code path and TLS comes from the library already linked for the REST fetcher
+typedef struct {
+    CURL *easy;
+    curl_socket_t socket;
+    char *buffer;               // received bytes not yet consumed as frames
+    size_t buffer_length;
+    size_t buffer_capacity;
+    char *message;              // fragments of a message split over continuation frames
+    size_t message_length;
+    size_t message_capacity;
+    bool in_fragmented_message;
+    bool closed;
+    uint32_t mask_state;        // xorshift state for client frame masks
+    long long received_ns;      // monotonic time the newest bytes arrived
+} WsClient;
+
+// Function to open url ("ws://host:port/path" or "wss://...") and complete the upgrade handshake;
+// main() must have called curl_global_init before any thread connects
+int ws_client_connect(WsClient *client, const char *url);
+
+// Function to wait up to timeout_ms for data and deliver every complete message to handler;
+// returns the number of messages delivered (0 on timeout), or -1 once the connection is closed
+int ws_client_poll(WsClient *client, int timeout_ms, WsMessageHandler handler, void *userdata);
+
+// Function to send one masked frame
+int ws_client_send(WsClient *client, WsOpcode opcode, const char *payload, size_t length);
+
+// Function to send a close frame if still open and release the connection
+void ws_client_close(WsClient *client);
+
+// Function to get the current CLOCK_MONOTONIC time in nanoseconds
+long long ws_monotonic_ns(void);
+
+#endif // WS_CLIENT_H
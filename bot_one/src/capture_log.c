@@ -0,0 +1,232 @@
+// src/capture_log.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "capture_log.h"
+
+#define CAPTURE_RING_MASK (CAPTURE_RING_BYTES - 1)
+
+static size_t padded_length(size_t length) {
+    return (length + CAPTURE_ALIGN - 1) & ~(size_t)(CAPTURE_ALIGN - 1);
+}
+
+// Copy bytes into the ring at position, wrapping at the end
+static void ring_copy(char *ring, size_t position, const void *bytes, size_t length) {
+    size_t start = position & CAPTURE_RING_MASK;
+    size_t first = length < CAPTURE_RING_BYTES - start ? length : CAPTURE_RING_BYTES - start;
+    memcpy(ring + start, bytes, first);
+    memcpy(ring, (const char *)bytes + first, length - first);
+}
+
+// Write the whole block at offset, retrying short writes
+static int write_block(int fd, const char *block, size_t length, off_t offset) {
+    while (length > 0) {
+        ssize_t n = pwrite(fd, block, length, offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            printf("Capture write failed: %s\n", strerror(errno));
+            return -1;
+        }
+        block += n;
+        length -= (size_t)n;
+        offset += n;
+    }
+    return 0;
+}
+
+// Drain the ring to disk until the log is closed and everything queued is written
+static void *capture_writer_thread(void *args) {
+    CaptureLog *log = (CaptureLog *)args;
+    for (;;) {
+        size_t tail = atomic_load_explicit(&log->tail, memory_order_relaxed);
+        size_t head = atomic_load_explicit(&log->head, memory_order_acquire);
+        if (head == tail) {
+            if (!atomic_load(&log->running)) {
+                break;
+            }
+            struct timespec idle = {0, CAPTURE_IDLE_US * 1000L};
+            nanosleep(&idle, NULL);
+            continue;
+        }
+
+        // One contiguous stretch of the ring per write
+        size_t start = tail & CAPTURE_RING_MASK;
+        size_t bytes = head - tail;
+        if (bytes > CAPTURE_RING_BYTES - start) {
+            bytes = CAPTURE_RING_BYTES - start;
+        }
+        if (bytes > CAPTURE_WRITE_BYTES) {
+            bytes = CAPTURE_WRITE_BYTES;
+        }
+
+        if (!log->write_error) {
+            // Reserving ahead keeps block allocation out of the steady-state writes
+            if (log->written + (off_t)bytes > log->allocated) {
+                int status = posix_fallocate(log->fd, log->allocated, CAPTURE_PREALLOCATE_BYTES);
+                if (status != 0) {
+                    printf("Capture preallocation failed: %s\n", strerror(status));
+                } else {
+                    log->allocated += CAPTURE_PREALLOCATE_BYTES;
+                }
+            }
+            if (write_block(log->fd, log->ring + start, bytes, log->written) != 0) {
+                // Keep draining so the feed thread is never held up by a failed disk
+                log->write_error = 1;
+            } else {
+                log->written += (off_t)bytes;
+            }
+        }
+        atomic_store_explicit(&log->tail, tail + bytes, memory_order_release);
+    }
+    return NULL;
+}
+
+int capture_log_open(CaptureLog *log, const char *path) {
+    memset(log, 0, sizeof(*log));
+    log->fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (log->fd < 0) {
+        printf("Could not create capture %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    log->ring = (char *)malloc(CAPTURE_RING_BYTES);
+    if (log->ring == NULL) {
+        close(log->fd);
+        return -1;
+    }
+    // Touch every page now so the feed thread never takes a page fault on the ring
+    memset(log->ring, 0, CAPTURE_RING_BYTES);
+
+    CaptureFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+    header.version = CAPTURE_VERSION;
+    header.header_size = sizeof(header);
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    header.created_realtime_ns = (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    header.created_monotonic_ns = (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    if (write_block(log->fd, (const char *)&header, sizeof(header), 0) != 0) {
+        free(log->ring);
+        close(log->fd);
+        return -1;
+    }
+    log->written = sizeof(header);
+    log->allocated = sizeof(header);
+
+    atomic_store(&log->running, 1);
+    if (pthread_create(&log->writer, NULL, capture_writer_thread, log) != 0) {
+        printf("Could not start the capture writer\n");
+        free(log->ring);
+        close(log->fd);
+        return -1;
+    }
+    return 0;
+}
+
+int capture_log_append(CaptureLog *log, long long receive_ns, uint32_t source, const char *message, size_t length) {
+    size_t record_bytes = sizeof(CaptureRecordHeader) + padded_length(length);
+    size_t head = atomic_load_explicit(&log->head, memory_order_relaxed);
+    // The writer's position is only re-read when the cached one says the ring is full
+    if (head + record_bytes - log->cached_tail > CAPTURE_RING_BYTES) {
+        log->cached_tail = atomic_load_explicit(&log->tail, memory_order_acquire);
+        if (head + record_bytes - log->cached_tail > CAPTURE_RING_BYTES) {
+            log->dropped++;
+            return -1;
+        }
+    }
+
+    CaptureRecordHeader record = {receive_ns, (uint32_t)length, source};
+    static const char padding[CAPTURE_ALIGN];
+    ring_copy(log->ring, head, &record, sizeof(record));
+    ring_copy(log->ring, head + sizeof(record), message, length);
+    ring_copy(log->ring, head + sizeof(record) + length, padding, padded_length(length) - length);
+    atomic_store_explicit(&log->head, head + record_bytes, memory_order_release);
+    log->records++;
+    return 0;
+}
+
+int capture_log_close(CaptureLog *log) {
+    atomic_store(&log->running, 0);
+    pthread_join(log->writer, NULL);
+    // Give back the reservation past the last record
+    int status = log->write_error ? -1 : 0;
+    if (ftruncate(log->fd, log->written) != 0 || fsync(log->fd) != 0) {
+        printf("Could not finish the capture: %s\n", strerror(errno));
+        status = -1;
+    }
+    close(log->fd);
+    free(log->ring);
+    log->ring = NULL;
+    log->fd = -1;
+    return status;
+}
+
+int capture_reader_open(CaptureReader *reader, const char *path) {
+    memset(reader, 0, sizeof(*reader));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Could not open capture %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CaptureFileHeader)) {
+        printf("%s is not a capture\n", path);
+        close(fd);
+        return -1;
+    }
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        printf("Could not map capture %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    posix_madvise(data, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+
+    memcpy(&reader->header, data, sizeof(reader->header));
+    if (memcmp(reader->header.magic, CAPTURE_MAGIC, sizeof(reader->header.magic)) != 0 ||
+        reader->header.version != CAPTURE_VERSION || reader->header.header_size < sizeof(CaptureFileHeader) ||
+        reader->header.header_size > (size_t)st.st_size) {
+        printf("%s is not a version %d capture\n", path, CAPTURE_VERSION);
+        munmap(data, (size_t)st.st_size);
+        return -1;
+    }
+    reader->data = (const char *)data;
+    reader->size = (size_t)st.st_size;
+    reader->offset = reader->header.header_size;
+    return 0;
+}
+
+int capture_reader_next(CaptureReader *reader, CaptureRecordHeader *record, const char **message) {
+    if (reader->offset + sizeof(*record) > reader->size) {
+        return 0;
+    }
+    memcpy(record, reader->data + reader->offset, sizeof(*record));
+    if (record->length == 0 && record->receive_ns == 0) {
+        return 0;  // zeroed reservation after the last record of an unclosed log
+    }
+    size_t record_bytes = sizeof(*record) + padded_length(record->length);
+    if (record_bytes > reader->size - reader->offset) {
+        printf("Capture ends inside a record at offset %zu\n", reader->offset);
+        return -1;
+    }
+    *message = reader->data + reader->offset + sizeof(*record);
+    reader->offset += record_bytes;
+    return 1;
+}
+
+void capture_reader_close(CaptureReader *reader) {
+    if (reader->data) {
+        munmap((void *)reader->data, reader->size);
+    }
+    reader->data = NULL;
+}
@@ -4,6 +4,32 @@
 #include "config_parser.h"
 #include <libconfig.h>
 
+// Days since 1970-01-01 for a proleptic Gregorian date
+static long long days_from_civil(int year, int month, int day) {
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int year_of_era = year - era * 400;
+    int day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return (long long)era * 146097 + day_of_era - 719468;
+}
+
+// Convert a "1 Jan 2021" date to epoch milliseconds at midnight UTC, 0 for "today" or anything unparsable
+static long long parse_date_ms(const char *date) {
+    static const char *months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+    int day, year;
+    char month_name[4];
+    if (sscanf(date, "%d %3s %d", &day, month_name, &year) != 3) {
+        return 0;
+    }
+    for (int month = 0; month < 12; month++) {
+        if (strcmp(month_name, months[month]) == 0) {
+            return days_from_civil(year, month + 1, day) * 86400000LL;
+        }
+    }
+    return 0;
+}
+
 int load_config(const char *config_file_path, ConfigParams *params) {
     config_t cfg;
     config_setting_t *setting;
@@ -36,6 +62,14 @@ int load_config(const char *config_file_path, ConfigParams *params) {
     }
 
     // Load API
+    snprintf(params->base_url, sizeof(params->base_url), "%s", "https://api.binance.com");
+    snprintf(params->data_dir, sizeof(params->data_dir), "%s", "data");
+    params->backfill_concurrency = 4;
+    snprintf(params->cache_dir, sizeof(params->cache_dir), "%s", "cache");
+    params->cache_max_mb = 256;
+    params->rate_limit_weight = 6000;
+    params->replay_speed = 1.0;
+    params->tick_size = 0.01;
     if ((setting = config_lookup(&cfg, "API")) != NULL) {
         if (config_setting_lookup_string(setting, "API_KEY", &str))
             snprintf(params->api_key, sizeof(params->api_key), "%s", str);
@@ -49,13 +83,50 @@ int load_config(const char *config_file_path, ConfigParams *params) {
             snprintf(params->start_date, sizeof(params->start_date), "%s", str);
         if (config_setting_lookup_string(setting, "END_DATE", &str))
             snprintf(params->end_date, sizeof(params->end_date), "%s", str);
+        if (config_setting_lookup_string(setting, "BASE_URL", &str))
+            snprintf(params->base_url, sizeof(params->base_url), "%s", str);
+        if (config_setting_lookup_string(setting, "DATA_DIR", &str))
+            snprintf(params->data_dir, sizeof(params->data_dir), "%s", str);
+        config_setting_lookup_int(setting, "BACKFILL_CONCURRENCY", &params->backfill_concurrency);
+        if (config_setting_lookup_string(setting, "CACHE_DIR", &str))
+            snprintf(params->cache_dir, sizeof(params->cache_dir), "%s", str);
+        config_setting_lookup_int(setting, "CACHE_MAX_MB", &params->cache_max_mb);
+        config_setting_lookup_int(setting, "RATE_LIMIT_WEIGHT", &params->rate_limit_weight);
+        if (config_setting_lookup_string(setting, "STREAM_URL", &str))
+            snprintf(params->stream_url, sizeof(params->stream_url), "%s", str);
+        if (config_setting_lookup_string(setting, "REPLAY_FILE", &str))
+            snprintf(params->replay_file, sizeof(params->replay_file), "%s", str);
+        config_setting_lookup_float(setting, "REPLAY_SPEED", &params->replay_speed);
+        if (config_setting_lookup_string(setting, "CAPTURE_DIR", &str))
+            snprintf(params->capture_dir, sizeof(params->capture_dir), "%s", str);
+        if (config_setting_lookup_string(setting, "DEPTH_STREAM_URL", &str))
+            snprintf(params->depth_stream_url, sizeof(params->depth_stream_url), "%s", str);
+        config_setting_lookup_float(setting, "TICK_SIZE", &params->tick_size);
+        params->start_time_ms = parse_date_ms(params->start_date);
+        params->end_time_ms = parse_date_ms(params->end_date);
+    }
+
+    // Load PIPELINE
+    params->input_wait = WAIT_MODE_PARK;
+    params->output_wait = WAIT_MODE_PARK;
+    if ((setting = config_lookup(&cfg, "PIPELINE")) != NULL) {
+        if (config_setting_lookup_string(setting, "INPUT_WAIT", &str) && wait_mode_parse(str, &params->input_wait) != 0) {
+            config_destroy(&cfg);
+            return(EXIT_FAILURE);
+        }
+        if (config_setting_lookup_string(setting, "OUTPUT_WAIT", &str) && wait_mode_parse(str, &params->output_wait) != 0) {
+            config_destroy(&cfg);
+            return(EXIT_FAILURE);
+        }
     }
 
     // Load RISK_MANAGEMENT
+    params->liquidity_info.depth_bps = 10.0;
     if ((setting = config_lookup(&cfg, "RISK_MANAGEMENT")) != NULL) {
         config_setting_lookup_float(setting, "RISK_MULTIPLIER", &params->risk_multiplier);
         config_setting_lookup_float(setting, "MAX_POSITION_SIZE", &params->max_position_size);
         config_setting_lookup_float(setting, "MINIMUM_LIQUIDITY", &params->minimum_liquidity);
+        config_setting_lookup_float(setting, "LIQUIDITY_DEPTH_BPS", &params->liquidity_info.depth_bps);
     }
 
     // Load ADVANCED
@@ -3,101 +3,135 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <curl/curl.h>
 #include "config_parser.h"
 #include "pre_processing.h"
+#include "data_fetcher.h"
+#include "kline_history.h"
+#include "kline_backfill.h"
 #include "cJSON.h"
 
-struct MemoryStruct {
-    char *memory;
-    size_t size;
-};
 
-static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp) {
-    size_t real_size = size * nmemb;
-    struct MemoryStruct *mem = (struct MemoryStruct *)userp;
-
-    char *ptr = realloc(mem->memory, mem->size + real_size + 1);
-    if (!ptr) {
-        printf("Not enough memory (realloc returned NULL)\n");
-        return 0;
+int fetch_data(FetcherContext *context, const ConfigParams *config, RawData *raw_data) {
+    // The range is fetched as concurrent 1000-bar pages so long spans are not truncated
+    long long end_time_ms = config->end_time_ms;
+    if (end_time_ms <= 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        end_time_ms = (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
     }
-
-    mem->memory = ptr;
-    memcpy(&(mem->memory[mem->size]), contents, real_size);
-    mem->size += real_size;
-    mem->memory[mem->size] = '\0';
-
-    return real_size;
+    return backfill_klines(context, config, config->symbol, config->start_time_ms, end_time_ms, raw_data);
 }
 
-int fetch_data(ConfigParams *config, RawData *raw_data) {
-    CURL *curl_handle;
-    CURLcode res;
-    struct MemoryStruct chunk;
-
-    chunk.memory = malloc(1);
-    chunk.size = 0;
-
-    curl_global_init(CURL_GLOBAL_DEFAULT);
-    curl_handle = curl_easy_init();
-
-    if (!curl_handle) {
-        printf("Failed to initialize curl\n");
+// Format one kline array as a history line; returns the close time, or -1 if the entry is malformed
+static long long format_kline_line(cJSON *kline, char *line, size_t line_size) {
+    if (!cJSON_IsArray(kline) || cJSON_GetArraySize(kline) < 11) {
+        return -1;
+    }
+    const char *text[11] = {0};
+    for (int i = 1; i <= 10; i++) {
+        cJSON *field = cJSON_GetArrayItem(kline, i);
+        if (cJSON_IsString(field)) {
+            text[i] = field->valuestring;
+        } else if (!cJSON_IsNumber(field)) {
+            return -1;
+        }
+    }
+    if (!text[1] || !text[2] || !text[3] || !text[4] || !text[5] || !text[7] || !text[9] || !text[10]) {
         return -1;
     }
 
-    // Build the URL
-    char url[512];
-    snprintf(url, sizeof(url), "https://api.binance.com/api/v3/klines?symbol=%s&interval=%s&startTime=%lld&endTime=%lld&limit=1000",
-             config->symbol, config->interval, config->start_time_ms, config->end_time_ms);
-
-    curl_easy_setopt(curl_handle, CURLOPT_URL, url);
-    curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
-    curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void *)&chunk);
+    long long open_time = (long long)cJSON_GetArrayItem(kline, 0)->valuedouble;
+    long long close_time = (long long)cJSON_GetArrayItem(kline, 6)->valuedouble;
+    long long trades = (long long)cJSON_GetArrayItem(kline, 8)->valuedouble;
 
-    res = curl_easy_perform(curl_handle);
+    // Same timestamp text as the pandas index written by data_fetcher.py
+    time_t seconds = (time_t)(open_time / 1000);
+    struct tm tm;
+    char timestamp[32];
+    gmtime_r(&seconds, &tm);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &tm);
 
-    if (res != CURLE_OK) {
-        printf("curl_easy_perform() failed: %s\n", curl_easy_strerror(res));
-        curl_easy_cleanup(curl_handle);
-        free(chunk.memory);
-        curl_global_cleanup();
-        return -1;
-    }
+    int n = snprintf(line, line_size, "%s,%s,%s,%s,%s,%s,%lld,%s,%lld,%s,%s,0\n",
+                     timestamp, text[1], text[2], text[3], text[4], text[5], close_time, text[7], trades, text[9], text[10]);
+    return n > 0 && (size_t)n < line_size ? close_time : -1;
+}
 
-    // Parse JSON response
-    cJSON *json = cJSON_Parse(chunk.memory);
-    if (!json) {
-        printf("Error parsing JSON response\n");
-        curl_easy_cleanup(curl_handle);
-        free(chunk.memory);
-        curl_global_cleanup();
-        return -1;
+int sync_history(FetcherContext *context, const ConfigParams *config, const char *symbol, size_t *rows_appended) {
+    char path[512];
+    kline_history_path(config->data_dir, symbol, config->interval, path, sizeof(path));
+    *rows_appended = 0;
+
+    // Resume one millisecond after the last stored close, or from the configured start
+    long long last_close_time = kline_history_last_close_time(path);
+    long long next_start = last_close_time >= 0 ? last_close_time + 1 : config->start_time_ms;
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    long long now_ms = (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+    long long end_time = config->end_time_ms > 0 && config->end_time_ms < now_ms ? config->end_time_ms : now_ms;
+
+    // Pages are fetched one after another on a single pooled keep-alive connection
+    FetcherConnection *connection = fetcher_acquire(context);
+    size_t buffer_size = (size_t)KLINE_PAGE_LIMIT * 256;
+    char *lines = (char *)malloc(buffer_size);
+    int status = 0;
+
+    while (lines && next_start < end_time) {
+        char request[256];
+        snprintf(request, sizeof(request), "/api/v3/klines?symbol=%s&interval=%s&startTime=%lld&endTime=%lld&limit=%d",
+                 symbol, config->interval, next_start, end_time, KLINE_PAGE_LIMIT);
+        if (fetcher_get(context, connection, request, REQUEST_PRIORITY_BACKFILL, KLINE_REQUEST_WEIGHT) != 0) {
+            status = -1;
+            break;
+        }
+
+        struct MemoryStruct *chunk = &connection->body;
+        cJSON *json = chunk->size > 0 ? cJSON_Parse(chunk->memory) : NULL;
+        if (!cJSON_IsArray(json)) {
+            printf("Error parsing JSON response\n");
+            cJSON_Delete(json);
+            status = -1;
+            break;
+        }
+
+        int count = cJSON_GetArraySize(json);
+        size_t length = 0;
+        size_t page_rows = 0;
+        bool reached_open_bar = false;
+        // A page longer than asked for is cut at KLINE_PAGE_LIMIT; the rest comes with the next page
+        for (int i = 0; i < count && i < KLINE_PAGE_LIMIT; i++) {
+            long long close_time = format_kline_line(cJSON_GetArrayItem(json, i), lines + length, buffer_size - length);
+            if (close_time < 0) {
+                printf("Skipping malformed kline for %s\n", symbol);
+                continue;
+            }
+            // The bar still forming has a close time in the future and is never stored
+            if (close_time >= now_ms) {
+                reached_open_bar = true;
+                break;
+            }
+            length += strlen(lines + length);
+            page_rows++;
+            next_start = close_time + 1;
+        }
+        cJSON_Delete(json);
+
+        if (length > 0 && kline_history_append(path, lines, length) != 0) {
+            status = -1;
+            break;
+        }
+        *rows_appended += page_rows;
+        if (reached_open_bar || count < KLINE_PAGE_LIMIT || page_rows == 0) {
+            break;
+        }
     }
-
-    size_t data_size = cJSON_GetArraySize(json);
-    raw_data->price_count = data_size;
-    raw_data->prices = malloc(sizeof(double) * data_size);
-    raw_data->high_prices = malloc(sizeof(double) * data_size);
-    raw_data->low_prices = malloc(sizeof(double) * data_size);
-    raw_data->prices = malloc(sizeof(double) * data_size);
-    raw_data->volumes = malloc(sizeof(double) * data_size);
-
-    for (size_t i = 0; i < data_size; i++) {
-        cJSON *data_point = cJSON_GetArrayItem(json, i);
-        raw_data->prices[i] = atof(cJSON_GetArrayItem(data_point, 4)->valuestring);
-        raw_data->high_prices[i] = atof(cJSON_GetArrayItem(data_point, 2)->valuestring);
-        raw_data->low_prices[i] = atof(cJSON_GetArrayItem(data_point, 3)->valuestring);
-        raw_data->prices[i] = raw_data->prices[i];
-        raw_data->volumes[i] = atof(cJSON_GetArrayItem(data_point, 5)->valuestring);
+    if (lines == NULL) {
+        status = -1;
     }
 
-    // Clean up
-    cJSON_Delete(json);
-    curl_easy_cleanup(curl_handle);
-    free(chunk.memory);
-    curl_global_cleanup();
-
-    return 0;
+    free(lines);
+    fetcher_release(context, connection);
+    return status;
 }
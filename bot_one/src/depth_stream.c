@@ -0,0 +1,68 @@
+// src/depth_stream.c
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <time.h>
+#include "depth_stream.h"
+#include "market_stream.h"
+#include "ws_client.h"
+
+static void handle_message(const char *message, size_t length, void *userdata) {
+    DepthStream *stream = (DepthStream *)userdata;
+    stream->messages++;
+    order_book_apply_diff(stream->book, message, length);
+}
+
+// Sleep for up to milliseconds, returning early once the stream is stopped
+static void wait_while_running(const DepthStream *stream, int milliseconds) {
+    struct timespec step = {0, 50 * 1000000L};
+    for (int waited = 0; waited < milliseconds && *stream->running; waited += 50) {
+        nanosleep(&step, NULL);
+    }
+}
+
+// Fetch a snapshot and lay the buffered diffs over it; -1 if another snapshot is needed
+static int resync(DepthStream *stream) {
+    char path[128];
+    snprintf(path, sizeof(path), "/api/v3/depth?symbol=%s&limit=%d", stream->book->symbol, DEPTH_SNAPSHOT_LIMIT);
+    FetcherConnection *connection = fetcher_acquire(stream->fetcher);
+    int status = fetcher_get(stream->fetcher, connection, path, REQUEST_PRIORITY_LIVE, DEPTH_SNAPSHOT_WEIGHT);
+    if (status == 0) {
+        status = order_book_apply_snapshot(stream->book, connection->body.memory, connection->body.size);
+    }
+    fetcher_release(stream->fetcher, connection);
+    if (status == 0) {
+        stream->snapshots++;
+    }
+    return status;
+}
+
+int depth_stream_run(DepthStream *stream) {
+    while (*stream->running) {
+        WsClient client;
+        if (ws_client_connect(&client, stream->url) != 0) {
+            wait_while_running(stream, MARKET_STREAM_RECONNECT_MS);
+            continue;
+        }
+        printf("Following %s depth from %s\n", stream->book->symbol, stream->url);
+
+        while (*stream->running) {
+            if (ws_client_poll(&client, MARKET_STREAM_POLL_MS, handle_message, stream) < 0) {
+                printf("Depth stream disconnected, reconnecting\n");
+                break;
+            }
+            // Snapshots are only requested once a diff is buffered, so they start inside the stream
+            if (order_book_needs_snapshot(stream->book) && resync(stream) != 0) {
+                wait_while_running(stream, DEPTH_SNAPSHOT_RETRY_MS);
+            }
+        }
+        bool dropped = client.closed;
+        ws_client_close(&client);
+        // Diffs missed while disconnected leave the book unusable until the next snapshot
+        order_book_reset(stream->book);
+        if (dropped) {
+            wait_while_running(stream, MARKET_STREAM_RECONNECT_MS);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,208 @@
+// src/fetcher_context.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "fetcher_context.h"
+
+static size_t WriteMemoryCallback(char *contents, size_t size, size_t nmemb, void *userp) {
+    size_t real_size = size * nmemb;
+    struct MemoryStruct *mem = (struct MemoryStruct *)userp;
+
+    // Grow geometrically; with the reserve in place this only happens for unusually large responses
+    if (mem->size + real_size + 1 > mem->capacity) {
+        size_t capacity = mem->capacity ? mem->capacity : FETCHER_RESPONSE_RESERVE;
+        while (capacity < mem->size + real_size + 1) {
+            capacity *= 2;
+        }
+        char *ptr = realloc(mem->memory, capacity);
+        if (!ptr) {
+            printf("Not enough memory (realloc returned NULL)\n");
+            return 0;
+        }
+        mem->memory = ptr;
+        mem->capacity = capacity;
+    }
+
+    memcpy(&(mem->memory[mem->size]), contents, real_size);
+    mem->size += real_size;
+    mem->memory[mem->size] = '\0';
+
+    return real_size;
+}
+
+// Copy the numeric value of header name, if line is that header
+static void header_value(const char *line, size_t length, const char *name, long *value) {
+    size_t name_length = strlen(name);
+    if (length > name_length && strncasecmp(line, name, name_length) == 0) {
+        // Header lines end in CRLF, which stops strtol inside the buffer
+        *value = strtol(line + name_length, NULL, 10);
+    }
+}
+
+static size_t HeaderCallback(char *buffer, size_t size, size_t nitems, void *userp) {
+    size_t length = size * nitems;
+    FetcherConnection *connection = (FetcherConnection *)userp;
+    header_value(buffer, length, "X-MBX-USED-WEIGHT-1M:", &connection->used_weight);
+    header_value(buffer, length, "Retry-After:", &connection->retry_after_s);
+    return length;
+}
+
+static void share_lock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userp) {
+    (void)handle;
+    (void)access;
+    FetcherContext *context = (FetcherContext *)userp;
+    pthread_mutex_lock(&context->share_locks[data]);
+}
+
+static void share_unlock(CURL *handle, curl_lock_data data, void *userp) {
+    (void)handle;
+    FetcherContext *context = (FetcherContext *)userp;
+    pthread_mutex_unlock(&context->share_locks[data]);
+}
+
+FetcherContext *fetcher_context_create(const char *base_url, int connection_count) {
+    if (connection_count < 1) {
+        connection_count = 1;
+    }
+
+    FetcherContext *context = (FetcherContext *)calloc(1, sizeof(FetcherContext));
+    if (!context) {
+        return NULL;
+    }
+    snprintf(context->base_url, sizeof(context->base_url), "%s", base_url);
+    pthread_mutex_init(&context->lock, NULL);
+    pthread_cond_init(&context->released, NULL);
+    rate_limiter_init(&context->limiter, RATE_LIMIT_DEFAULT_WEIGHT, RATE_LIMIT_WINDOW_MS);
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&context->share_locks[i], NULL);
+    }
+
+    context->share = curl_share_init();
+    if (!context->share) {
+        fetcher_context_destroy(context);
+        return NULL;
+    }
+    curl_share_setopt(context->share, CURLSHOPT_LOCKFUNC, share_lock);
+    curl_share_setopt(context->share, CURLSHOPT_UNLOCKFUNC, share_unlock);
+    curl_share_setopt(context->share, CURLSHOPT_USERDATA, context);
+    curl_share_setopt(context->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(context->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(context->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+
+    context->connections = (FetcherConnection *)calloc((size_t)connection_count, sizeof(FetcherConnection));
+    if (!context->connections) {
+        fetcher_context_destroy(context);
+        return NULL;
+    }
+    context->connection_count = connection_count;
+
+    for (int i = 0; i < connection_count; i++) {
+        FetcherConnection *connection = &context->connections[i];
+        connection->easy = curl_easy_init();
+        connection->body.memory = (char *)malloc(FETCHER_RESPONSE_RESERVE);
+        if (!connection->easy || !connection->body.memory) {
+            printf("Failed to initialize curl\n");
+            fetcher_context_destroy(context);
+            return NULL;
+        }
+        connection->body.capacity = FETCHER_RESPONSE_RESERVE;
+
+        // Options that stay the same for every request are set once
+        CURL *easy = connection->easy;
+        curl_easy_setopt(easy, CURLOPT_SHARE, context->share);
+        curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(easy, CURLOPT_TCP_NODELAY, 1L);
+        curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(easy, CURLOPT_DNS_CACHE_TIMEOUT, (long)FETCHER_DNS_CACHE_SECONDS);
+        curl_easy_setopt(easy, CURLOPT_ACCEPT_ENCODING, "");
+        curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, HeaderCallback);
+        curl_easy_setopt(easy, CURLOPT_HEADERDATA, connection);
+    }
+    return context;
+}
+
+// Function to take a free connection from the pool, waiting until one is released
+FetcherConnection *fetcher_acquire(FetcherContext *context) {
+    pthread_mutex_lock(&context->lock);
+    for (;;) {
+        for (int i = 0; i < context->connection_count; i++) {
+            if (!context->connections[i].in_use) {
+                context->connections[i].in_use = true;
+                pthread_mutex_unlock(&context->lock);
+                return &context->connections[i];
+            }
+        }
+        pthread_cond_wait(&context->released, &context->lock);
+    }
+}
+
+// Function to return a connection to the pool; its socket stays open for the next request
+void fetcher_release(FetcherContext *context, FetcherConnection *connection) {
+    pthread_mutex_lock(&context->lock);
+    connection->in_use = false;
+    pthread_cond_signal(&context->released);
+    pthread_mutex_unlock(&context->lock);
+}
+
+// Function to point a connection at base_url + path and empty its buffer, for use with curl_multi
+void fetcher_prepare(FetcherContext *context, FetcherConnection *connection, const char *path) {
+    fetcher_prepare_stream(context, connection, path, WriteMemoryCallback, &connection->body);
+}
+
+// Function to point a connection at base_url + path with the response handed to write as it arrives
+void fetcher_prepare_stream(FetcherContext *context, FetcherConnection *connection, const char *path, curl_write_callback write, void *userdata) {
+    char url[512];
+    snprintf(url, sizeof(url), "%s%s", context->base_url, path);
+    curl_easy_setopt(connection->easy, CURLOPT_URL, url);
+    curl_easy_setopt(connection->easy, CURLOPT_WRITEFUNCTION, write);
+    curl_easy_setopt(connection->easy, CURLOPT_WRITEDATA, userdata);
+    connection->body.size = 0;
+    connection->body.memory[0] = '\0';
+    connection->http_code = 0;
+    connection->used_weight = -1;
+    connection->retry_after_s = -1;
+}
+
+// Function to GET base_url + path on a pooled connection once the limiter allows weight at
+// priority; the response is left in connection->body
+int fetcher_get(FetcherContext *context, FetcherConnection *connection, const char *path, RequestPriority priority, int weight) {
+    fetcher_prepare(context, connection, path);
+    long long window = rate_limiter_acquire(&context->limiter, priority, weight);
+    if (window < 0) {
+        printf("Request %s not sent: weight %d is over the rate limit\n", path, weight);
+        return -1;
+    }
+    CURLcode res = curl_easy_perform(connection->easy);
+    curl_easy_getinfo(connection->easy, CURLINFO_RESPONSE_CODE, &connection->http_code);
+    rate_limiter_complete(&context->limiter, window, weight, connection->http_code, connection->used_weight, connection->retry_after_s);
+    if (res != CURLE_OK || connection->http_code != 200) {
+        printf("Request %s failed: %s (HTTP %ld)\n", path, curl_easy_strerror(res), connection->http_code);
+        return -1;
+    }
+    return 0;
+}
+
+void fetcher_context_destroy(FetcherContext *context) {
+    if (!context) {
+        return;
+    }
+    for (int i = 0; context->connections && i < context->connection_count; i++) {
+        if (context->connections[i].easy) {
+            curl_easy_cleanup(context->connections[i].easy);
+        }
+        free(context->connections[i].body.memory);
+    }
+    free(context->connections);
+    if (context->share) {
+        curl_share_cleanup(context->share);
+    }
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_destroy(&context->share_locks[i]);
+    }
+    rate_limiter_destroy(&context->limiter);
+    pthread_cond_destroy(&context->released);
+    pthread_mutex_destroy(&context->lock);
+    free(context);
+}
@@ -0,0 +1,302 @@
+// src/kline_backfill.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <curl/curl.h>
+#include "kline_backfill.h"
+#include "data_fetcher.h"
+#include "kline_parser.h"
+#include "response_cache.h"
+
+#define KLINES_ENDPOINT "/api/v3/klines"
+
+// One page of the backfill; its rows are parsed into the page's slots of raw_data as bytes arrive
+typedef struct {
+    long long start_time_ms;
+    long long end_time_ms;
+    FetcherConnection *connection;  // set while the page is in flight
+    long long rate_window;      // limiter window the request in flight was charged to
+    int attempts;
+    long long retry_at_ms;      // monotonic time before which a failed page is not reissued
+    size_t first_row;           // index of the page's first slot in raw_data
+    size_t row_count;
+    bool cached;                // filled from the response cache, never requested
+    KlineParser parser;
+} KlinePage;
+
+long long kline_interval_ms(const char *interval) {
+    char *end;
+    long long count = strtoll(interval, &end, 10);
+    if (end == interval || count <= 0 || end[0] == '\0' || end[1] != '\0') {
+        return 0;
+    }
+    switch (end[0]) {
+    case 'm': return count * 60LL * 1000;
+    case 'h': return count * 60LL * 60 * 1000;
+    case 'd': return count * 24LL * 60 * 60 * 1000;
+    case 'w': return count * 7LL * 24 * 60 * 60 * 1000;
+    default: return 0;  // "1M" months have no fixed length
+    }
+}
+
+static long long monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static long long realtime_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// The page's slots in raw_data
+static KlineColumns page_columns(const RawData *raw_data, const KlinePage *page) {
+    KlineColumns columns = {
+        .open_times = raw_data->open_times + page->first_row,
+        .high = raw_data->high_prices + page->first_row,
+        .low = raw_data->low_prices + page->first_row,
+        .close = raw_data->prices + page->first_row,
+        .volume = raw_data->volumes + page->first_row,
+        .capacity = KLINE_PAGE_LIMIT,
+    };
+    return columns;
+}
+
+static ResponseCacheKey page_key(const ConfigParams *config, const char *symbol, const KlinePage *page) {
+    ResponseCacheKey key = {KLINES_ENDPOINT, symbol, config->interval, page->start_time_ms, page->end_time_ms};
+    return key;
+}
+
+static void start_page(CURLM *multi, FetcherContext *context, FetcherConnection *connection, const ConfigParams *config, const char *symbol, RawData *raw_data, KlinePage *page) {
+    char path[256];
+    snprintf(path, sizeof(path), KLINES_ENDPOINT "?symbol=%s&interval=%s&startTime=%lld&endTime=%lld&limit=%d",
+             symbol, config->interval, page->start_time_ms, page->end_time_ms, KLINE_PAGE_LIMIT);
+
+    // A retried page starts over in the same slots
+    KlineColumns columns = page_columns(raw_data, page);
+    kline_parser_init(&page->parser, &columns);
+
+    page->attempts++;
+    page->connection = connection;
+    fetcher_prepare_stream(context, connection, path, kline_parser_write, &page->parser);
+    curl_easy_setopt(connection->easy, CURLOPT_PRIVATE, (void *)page);
+    curl_multi_add_handle(multi, connection->easy);
+}
+
+// Function to allocate KLINE_PAGE_LIMIT slots per page in every raw_data column
+static int reserve_pages(size_t page_count, RawData *raw_data) {
+    size_t bytes = page_count * KLINE_PAGE_LIMIT * sizeof(double);
+    raw_data->open_times = (long long *)malloc(bytes);
+    raw_data->prices = (double *)malloc(bytes);
+    raw_data->high_prices = (double *)malloc(bytes);
+    raw_data->low_prices = (double *)malloc(bytes);
+    raw_data->volumes = (double *)malloc(bytes);
+    raw_data->price_count = 0;
+    if (!raw_data->open_times || !raw_data->prices || !raw_data->high_prices || !raw_data->low_prices || !raw_data->volumes) {
+        return -1;
+    }
+    return 0;
+}
+
+// Close the gaps left by short pages so the rows are contiguous and in time order
+static void compact_pages(const KlinePage *pages, size_t page_count, RawData *raw_data) {
+    size_t offset = 0;
+    for (size_t i = 0; i < page_count; i++) {
+        size_t from = pages[i].first_row;
+        size_t n = pages[i].row_count;
+        if (offset != from) {
+            memmove(raw_data->open_times + offset, raw_data->open_times + from, n * sizeof(long long));
+            memmove(raw_data->prices + offset, raw_data->prices + from, n * sizeof(double));
+            memmove(raw_data->high_prices + offset, raw_data->high_prices + from, n * sizeof(double));
+            memmove(raw_data->low_prices + offset, raw_data->low_prices + from, n * sizeof(double));
+            memmove(raw_data->volumes + offset, raw_data->volumes + from, n * sizeof(double));
+        }
+        offset += n;
+    }
+    raw_data->price_count = offset;
+}
+
+int backfill_klines(FetcherContext *context, const ConfigParams *config, const char *symbol, long long start_time_ms, long long end_time_ms, RawData *raw_data) {
+    long long interval_ms = kline_interval_ms(config->interval);
+    if (interval_ms == 0 || end_time_ms < start_time_ms) {
+        printf("Invalid backfill range or interval %s\n", config->interval);
+        return -1;
+    }
+
+    // Pages tile the range exactly, each covering KLINE_PAGE_LIMIT bars
+    long long page_span = interval_ms * KLINE_PAGE_LIMIT;
+    size_t page_count = (size_t)((end_time_ms - start_time_ms) / page_span + 1);
+    KlinePage *pages = (KlinePage *)calloc(page_count, sizeof(KlinePage));
+    if (pages == NULL) {
+        return -1;
+    }
+    for (size_t i = 0; i < page_count; i++) {
+        pages[i].start_time_ms = start_time_ms + (long long)i * page_span;
+        pages[i].end_time_ms = pages[i].start_time_ms + page_span - 1;
+        if (pages[i].end_time_ms > end_time_ms) {
+            pages[i].end_time_ms = end_time_ms;
+        }
+        pages[i].first_row = i * KLINE_PAGE_LIMIT;
+    }
+    if (reserve_pages(page_count, raw_data) != 0) {
+        free(pages);
+        return -1;
+    }
+
+    // Pages already in the response cache are copied straight into their slots
+    ResponseCache cache;
+    response_cache_init(&cache, config->cache_dir, config->cache_max_mb);
+    size_t completed = 0;
+    for (size_t i = 0; i < page_count; i++) {
+        ResponseCacheKey key = page_key(config, symbol, &pages[i]);
+        KlineColumns columns = page_columns(raw_data, &pages[i]);
+        long rows = response_cache_load(&cache, &key, &columns);
+        if (rows >= 0) {
+            pages[i].row_count = (size_t)rows;
+            pages[i].cached = true;
+            completed++;
+        }
+    }
+    if (completed > 0) {
+        printf("%zu of %zu kline pages for %s loaded from cache\n", completed, page_count, symbol);
+    }
+
+    // Concurrency is bounded by the pool; the pooled connections stay warm between backfills
+    int concurrency = config->backfill_concurrency > 0 ? config->backfill_concurrency : 1;
+    if (concurrency > context->connection_count) {
+        concurrency = context->connection_count;
+    }
+    if ((size_t)concurrency > page_count - completed) {
+        concurrency = (int)(page_count - completed);
+    }
+
+    CURLM *multi = curl_multi_init();
+    FetcherConnection **acquired = (FetcherConnection **)calloc((size_t)concurrency + 1, sizeof(FetcherConnection *));
+    FetcherConnection **idle = (FetcherConnection **)calloc((size_t)concurrency + 1, sizeof(FetcherConnection *));
+    size_t *retry = (size_t *)calloc(page_count, sizeof(size_t));
+    int status = multi && acquired && idle && retry ? 0 : -1;
+
+    size_t idle_count = 0;
+    for (int i = 0; status == 0 && i < concurrency; i++) {
+        acquired[i] = idle[idle_count++] = fetcher_acquire(context);
+    }
+
+    // Pages are handed out in order; failed pages go to the retry list and are reissued
+    // ahead of new ones once their back-off has passed. Each page waits for the limiter
+    // to grant its weight, and the loop sleeps until then rather than sending it early.
+    size_t next_page = 0;
+    size_t retry_count = 0;
+    int running = 0;
+    while (status == 0 && completed < page_count) {
+        long long now = monotonic_ms();
+        int wait_ms = 1000;
+        bool throttled = false;
+        while (idle_count > 0) {
+            while (next_page < page_count && pages[next_page].cached) {
+                next_page++;
+            }
+            bool is_retry = retry_count > 0 && pages[retry[retry_count - 1]].retry_at_ms <= now;
+            if (!is_retry && next_page >= page_count) {
+                break;
+            }
+            long long window;
+            long long throttle_ms = rate_limiter_try_acquire(&context->limiter, REQUEST_PRIORITY_BACKFILL, KLINE_REQUEST_WEIGHT, &window);
+            if (throttle_ms < 0) {
+                printf("Backfill page weight %d is over the rate limit\n", KLINE_REQUEST_WEIGHT);
+                status = -1;
+                break;
+            }
+            if (throttle_ms > 0) {
+                wait_ms = throttle_ms < wait_ms ? (int)throttle_ms : wait_ms;
+                throttled = true;
+                break;
+            }
+            KlinePage *page = is_retry ? &pages[retry[--retry_count]] : &pages[next_page++];
+            page->rate_window = window;
+            start_page(multi, context, idle[--idle_count], config, symbol, raw_data, page);
+        }
+        if (retry_count > 0) {
+            long long due = pages[retry[retry_count - 1]].retry_at_ms - now;
+            wait_ms = due < 0 ? 0 : due < wait_ms ? (int)due : wait_ms;
+        }
+
+        curl_multi_perform(multi, &running);
+
+        CURLMsg *message;
+        int queued;
+        while ((message = curl_multi_info_read(multi, &queued)) != NULL) {
+            if (message->msg != CURLMSG_DONE) {
+                continue;
+            }
+            CURL *easy = message->easy_handle;
+            KlinePage *page;
+            long http_code = 0;
+            curl_easy_getinfo(easy, CURLINFO_PRIVATE, (char **)&page);
+            curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &http_code);
+            CURLcode result = message->data.result;
+            curl_multi_remove_handle(multi, easy);
+            FetcherConnection *connection = page->connection;
+            page->connection = NULL;
+            idle[idle_count++] = connection;
+            rate_limiter_complete(&context->limiter, page->rate_window, KLINE_REQUEST_WEIGHT, http_code,
+                                  connection->used_weight, connection->retry_after_s);
+
+            if (result == CURLE_OK && http_code == 200) {
+                if (kline_parser_finish(&page->parser) != 0) {
+                    printf("Error parsing JSON response\n");
+                    status = -1;
+                }
+                page->row_count = page->parser.row_count;
+                completed++;
+
+                // Only windows whose last bar has closed are cached, so the open bar is never served
+                if (status == 0 && page->end_time_ms + interval_ms <= realtime_ms()) {
+                    ResponseCacheKey key = page_key(config, symbol, page);
+                    KlineColumns columns = page_columns(raw_data, page);
+                    response_cache_store(&cache, &key, &columns, page->row_count);
+                }
+            } else if (page->attempts < KLINE_PAGE_ATTEMPTS) {
+                // 429/418 and 5xx are transient; the page backs off while the others keep going,
+                // and after a 429/418 the limiter holds every page until Retry-After has passed
+                printf("Kline page %lld failed (%s, HTTP %ld), retrying\n", page->start_time_ms, curl_easy_strerror(result), http_code);
+                page->retry_at_ms = monotonic_ms() + 100LL * page->attempts;
+                retry[retry_count++] = (size_t)(page - pages);
+            } else {
+                printf("Kline page %lld failed after %d attempts\n", page->start_time_ms, page->attempts);
+                status = -1;
+            }
+        }
+
+        if (status == 0 && completed < page_count && (running > 0 || retry_count > 0 || throttled)) {
+            curl_multi_poll(multi, NULL, 0, wait_ms, NULL);
+        }
+    }
+
+    if (status == 0) {
+        compact_pages(pages, page_count, raw_data);
+    }
+
+    // Connections still in flight after a failure are detached before they go back to the pool,
+    // and their weight is handed back to the limiter
+    for (size_t i = 0; status != 0 && i < page_count; i++) {
+        if (pages[i].connection) {
+            rate_limiter_complete(&context->limiter, pages[i].rate_window, KLINE_REQUEST_WEIGHT, 0, -1, -1);
+        }
+    }
+    for (int i = 0; acquired && i < concurrency; i++) {
+        if (acquired[i]) {
+            curl_multi_remove_handle(multi, acquired[i]->easy);
+            fetcher_release(context, acquired[i]);
+        }
+    }
+    free(pages);
+    free(acquired);
+    free(idle);
+    free(retry);
+    curl_multi_cleanup(multi);
+    return status;
+}
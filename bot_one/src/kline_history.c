@@ -0,0 +1,148 @@
+// src/kline_history.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "kline_history.h"
+
+// Bytes read from the end of the file to find the last line
+#define KLINE_HISTORY_TAIL_BYTES 4096
+
+void kline_history_path(const char *data_dir, const char *symbol, const char *interval, char *path, size_t path_size) {
+    // Minute bars keep the name the Python collector has always used
+    if (strcmp(interval, "1m") == 0) {
+        snprintf(path, path_size, "%s/%s_MinuteBars.csv", data_dir, symbol);
+    } else {
+        snprintf(path, path_size, "%s/%s_%s.csv", data_dir, symbol, interval);
+    }
+}
+
+// Cut a partial last line left by an interrupted append, returning the clean file size
+static off_t repair_tail(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return -1;
+    }
+
+    off_t size = st.st_size;
+    char buffer[KLINE_HISTORY_TAIL_BYTES];
+    while (size > 0) {
+        off_t start = size > (off_t)sizeof(buffer) ? size - (off_t)sizeof(buffer) : 0;
+        ssize_t n = pread(fd, buffer, (size_t)(size - start), start);
+        if (n != size - start) {
+            return -1;
+        }
+        ssize_t i = n - 1;
+        while (i >= 0 && buffer[i] != '\n') {
+            i--;
+        }
+        if (i >= 0) {
+            size = start + i + 1;
+            break;
+        }
+        size = start;
+    }
+
+    if (size != st.st_size) {
+        printf("Dropping %lld bytes of a partial line from the kline history\n", (long long)(st.st_size - size));
+        if (ftruncate(fd, size) != 0 || fsync(fd) != 0) {
+            return -1;
+        }
+    }
+    return size;
+}
+
+long long kline_history_last_close_time(const char *path) {
+    int fd = open(path, O_RDWR);
+    if (fd < 0) {
+        return -1;
+    }
+
+    off_t size = repair_tail(fd);
+    if (size <= 0) {
+        close(fd);
+        return -1;
+    }
+
+    // Only the last line is needed, so read a small block from the end
+    char buffer[KLINE_HISTORY_TAIL_BYTES + 1];
+    off_t start = size > KLINE_HISTORY_TAIL_BYTES ? size - KLINE_HISTORY_TAIL_BYTES : 0;
+    ssize_t n = pread(fd, buffer, (size_t)(size - start), start);
+    close(fd);
+    if (n <= 0) {
+        return -1;
+    }
+    buffer[n - 1] = '\0';  // drop the final newline
+
+    char *line = strrchr(buffer, '\n');
+    line = line ? line + 1 : buffer;
+    if (strncmp(line, "timestamp", 9) == 0) {
+        return -1;  // header only
+    }
+
+    // close_time is the 7th field
+    char *field = line;
+    for (int i = 0; i < 6 && field; i++) {
+        field = strchr(field, ',');
+        field = field ? field + 1 : NULL;
+    }
+    if (field == NULL) {
+        printf("Malformed last row in %s\n", path);
+        return -1;
+    }
+    return strtoll(field, NULL, 10);
+}
+
+int kline_history_append(const char *path, const char *lines, size_t length) {
+    int fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        printf("Could not open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    off_t size = repair_tail(fd);
+    if (size < 0) {
+        close(fd);
+        return -1;
+    }
+
+    const char *header = size == 0 ? KLINE_HISTORY_HEADER : "";
+    size_t header_length = strlen(header);
+    char *block = (char *)malloc(header_length + length);
+    if (block == NULL) {
+        close(fd);
+        return -1;
+    }
+    memcpy(block, header, header_length);
+    memcpy(block + header_length, lines, length);
+
+    // One write for the whole batch; on any failure the file is cut back to where it was
+    size_t total = header_length + length;
+    size_t written = 0;
+    while (written < total) {
+        ssize_t n = write(fd, block + written, total - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        written += (size_t)n;
+    }
+    free(block);
+
+    if (written != total || fsync(fd) != 0) {
+        printf("Could not append to %s: %s\n", path, strerror(errno));
+        if (ftruncate(fd, size) != 0) {
+            printf("Could not roll back %s\n", path);
+        }
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,341 @@
+// src/kline_parser.c
+
+#include <stdlib.h>
+#include <string.h>
+#include "kline_parser.h"
+
+// Where the parser is in the response; every state can be suspended at a chunk boundary
+enum {
+    PARSE_START,          // before the outer '['
+    PARSE_FIRST_ROW,      // after the outer '[': a row or the ']' of an empty response
+    PARSE_NEXT_ROW,       // after a row: ',' or the closing ']'
+    PARSE_ROW,            // after ',': the '[' of the next row
+    PARSE_FIELD,          // start of a field value
+    PARSE_STRING,         // inside a string that is not converted
+    PARSE_STRING_NUMBER,  // inside a quoted number that is converted
+    PARSE_NUMBER,         // inside a bare number that is converted
+    PARSE_SCALAR,         // inside a bare number or literal that is not converted
+    PARSE_AFTER_FIELD,    // after a value: ',' or the ']' closing the row
+    PARSE_DONE            // after the outer ']'
+};
+
+enum {
+    NUMBER_START,
+    NUMBER_SIGN,
+    NUMBER_INTEGER,
+    NUMBER_FRACTION,
+    NUMBER_EXPONENT_START,
+    NUMBER_EXPONENT_SIGN,
+    NUMBER_EXPONENT
+};
+
+// Fields before this index must all be present for a row to count
+#define KLINE_MIN_FIELDS 6
+// Mantissas up to 2^53 convert exactly, so one multiply or divide by an exact power of ten is correctly rounded
+#define EXACT_MANTISSA_LIMIT (1ULL << 53)
+#define MANTISSA_DIGITS_MAX 19
+
+static const double powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+void kline_parser_init(KlineParser *parser, const KlineColumns *columns) {
+    memset(parser, 0, sizeof(*parser));
+    parser->columns = *columns;
+    parser->state = PARSE_START;
+}
+
+static double *double_column(const KlineColumns *columns, int field) {
+    switch (field) {
+    case 1: return columns->open;
+    case 2: return columns->high;
+    case 3: return columns->low;
+    case 4: return columns->close;
+    case 5: return columns->volume;
+    default: return NULL;
+    }
+}
+
+static bool wants_field(const KlineParser *parser) {
+    if (parser->field == 0) {
+        return parser->columns.open_times != NULL;
+    }
+    return double_column(&parser->columns, parser->field) != NULL;
+}
+
+static void begin_number(KlineParser *parser) {
+    parser->mantissa = 0;
+    parser->mantissa_digits = 0;
+    parser->fraction_digits = 0;
+    parser->exponent = 0;
+    parser->negative = false;
+    parser->exponent_negative = false;
+    parser->number_phase = NUMBER_START;
+    parser->text_length = 0;
+}
+
+// Accumulate one character of a number; returns false if c cannot continue it
+static bool number_char(KlineParser *parser, char c) {
+    if (parser->text_length == KLINE_NUMBER_MAX - 1) {
+        return false;
+    }
+
+    if (c >= '0' && c <= '9') {
+        int digit = c - '0';
+        switch (parser->number_phase) {
+        case NUMBER_EXPONENT_START:
+        case NUMBER_EXPONENT_SIGN:
+        case NUMBER_EXPONENT:
+            parser->number_phase = NUMBER_EXPONENT;
+            if (parser->exponent < 10000) {
+                parser->exponent = parser->exponent * 10 + digit;
+            }
+            break;
+        default:
+            if (parser->number_phase != NUMBER_FRACTION) {
+                parser->number_phase = NUMBER_INTEGER;
+            } else {
+                parser->fraction_digits++;
+            }
+            // Leading zeros are not significant; past 19 digits the text is converted with strtod
+            if (parser->mantissa_digits < MANTISSA_DIGITS_MAX) {
+                parser->mantissa = parser->mantissa * 10 + (uint64_t)digit;
+                if (parser->mantissa != 0) {
+                    parser->mantissa_digits++;
+                }
+            } else {
+                parser->mantissa_digits = MANTISSA_DIGITS_MAX + 1;
+            }
+            break;
+        }
+    } else if (c == '-' && parser->number_phase == NUMBER_START) {
+        parser->negative = true;
+        parser->number_phase = NUMBER_SIGN;
+    } else if ((c == '-' || c == '+') && parser->number_phase == NUMBER_EXPONENT_START) {
+        parser->exponent_negative = c == '-';
+        parser->number_phase = NUMBER_EXPONENT_SIGN;
+    } else if (c == '.' && parser->number_phase == NUMBER_INTEGER) {
+        parser->number_phase = NUMBER_FRACTION;
+    } else if ((c == 'e' || c == 'E') && (parser->number_phase == NUMBER_INTEGER || parser->number_phase == NUMBER_FRACTION)) {
+        parser->number_phase = NUMBER_EXPONENT_START;
+    } else {
+        return false;
+    }
+
+    parser->text[parser->text_length++] = c;
+    return true;
+}
+
+// Consume the run of mantissa digits at p; returns the first byte that is not one
+static const char *number_digits(KlineParser *parser, const char *p, const char *end) {
+    if (parser->number_phase > NUMBER_FRACTION) {
+        return p;
+    }
+    uint64_t mantissa = parser->mantissa;
+    int digits = parser->mantissa_digits;
+    int length = parser->text_length;
+    const char *start = p;
+    while (p < end && (unsigned char)(*p - '0') < 10 && digits < MANTISSA_DIGITS_MAX && length < KLINE_NUMBER_MAX - 1) {
+        mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+        digits += mantissa != 0;
+        parser->text[length++] = *p++;
+    }
+    if (p != start) {
+        if (parser->number_phase == NUMBER_FRACTION) {
+            parser->fraction_digits += (int)(p - start);
+        } else {
+            parser->number_phase = NUMBER_INTEGER;
+        }
+    }
+    parser->mantissa = mantissa;
+    parser->mantissa_digits = digits;
+    parser->text_length = length;
+    return p;
+}
+
+static double number_value(KlineParser *parser) {
+    int scale = (parser->exponent_negative ? -parser->exponent : parser->exponent) - parser->fraction_digits;
+    if (parser->mantissa_digits <= MANTISSA_DIGITS_MAX && parser->mantissa <= EXACT_MANTISSA_LIMIT &&
+        scale >= -22 && scale <= 22) {
+        double value = (double)parser->mantissa;
+        value = scale < 0 ? value / powers_of_ten[-scale] : value * powers_of_ten[scale];
+        return parser->negative ? -value : value;
+    }
+    // Rare long or large numbers fall back to the library conversion
+    parser->text[parser->text_length] = '\0';
+    return strtod(parser->text, NULL);
+}
+
+// Store the finished number in its column; returns false if it never got a digit
+static bool store_number(KlineParser *parser) {
+    if (parser->number_phase != NUMBER_INTEGER && parser->number_phase != NUMBER_FRACTION &&
+        parser->number_phase != NUMBER_EXPONENT) {
+        return false;
+    }
+
+    size_t row = parser->row_count;
+    if (parser->field == 0) {
+        if (parser->number_phase == NUMBER_INTEGER && parser->mantissa_digits <= MANTISSA_DIGITS_MAX &&
+            parser->mantissa <= (uint64_t)INT64_MAX) {
+            long long value = (long long)parser->mantissa;
+            parser->columns.open_times[row] = parser->negative ? -value : value;
+        } else {
+            parser->columns.open_times[row] = (long long)number_value(parser);
+        }
+    } else {
+        double_column(&parser->columns, parser->field)[row] = number_value(parser);
+    }
+    return true;
+}
+
+int kline_parser_feed(KlineParser *parser, const char *data, size_t length) {
+    const char *p = data;
+    const char *end = data + length;
+
+    while (!parser->failed && p < end) {
+        char c = *p;
+        switch (parser->state) {
+        case PARSE_STRING: {
+            // Strings that are not converted are skipped in bulk up to the closing quote
+            if (parser->escaped) {
+                parser->escaped = false;
+                p++;
+                break;
+            }
+            const char *quote = memchr(p, '"', (size_t)(end - p));
+            const char *stop = quote ? quote : end;
+            const char *backslash = memchr(p, '\\', (size_t)(stop - p));
+            if (backslash) {
+                parser->escaped = true;
+                p = backslash + 1;
+            } else if (quote) {
+                parser->state = PARSE_AFTER_FIELD;
+                p = quote + 1;
+            } else {
+                p = end;
+            }
+            break;
+        }
+
+        case PARSE_STRING_NUMBER:
+            p = number_digits(parser, p, end);
+            if (p == end) {
+                break;
+            }
+            c = *p;
+            if (c == '"') {
+                parser->failed = !store_number(parser);
+                parser->state = PARSE_AFTER_FIELD;
+            } else {
+                parser->failed = !number_char(parser, c);
+            }
+            p++;
+            break;
+
+        case PARSE_NUMBER:
+            p = number_digits(parser, p, end);
+            if (p == end) {
+                break;
+            }
+            // The character ending a bare number is left for PARSE_AFTER_FIELD
+            if (number_char(parser, *p)) {
+                p++;
+            } else {
+                parser->failed = !store_number(parser);
+                parser->state = PARSE_AFTER_FIELD;
+            }
+            break;
+
+        case PARSE_SCALAR:
+            if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '.' || c == '-' || c == '+' || c == 'E') {
+                p++;
+            } else {
+                parser->state = PARSE_AFTER_FIELD;
+            }
+            break;
+
+        default:
+            p++;
+            if (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+                break;
+            }
+            switch (parser->state) {
+            case PARSE_START:
+                parser->state = PARSE_FIRST_ROW;
+                parser->failed = c != '[';
+                break;
+
+            case PARSE_FIRST_ROW:
+            case PARSE_ROW:
+                if (c == ']' && parser->state == PARSE_FIRST_ROW) {
+                    parser->state = PARSE_DONE;
+                } else if (c == '[' && parser->row_count < parser->columns.capacity) {
+                    parser->field = 0;
+                    parser->state = PARSE_FIELD;
+                } else {
+                    parser->failed = true;
+                }
+                break;
+
+            case PARSE_NEXT_ROW:
+                if (c == ',') {
+                    parser->state = PARSE_ROW;
+                } else if (c == ']') {
+                    parser->state = PARSE_DONE;
+                } else {
+                    parser->failed = true;
+                }
+                break;
+
+            case PARSE_FIELD:
+                if (c == '"') {
+                    parser->state = wants_field(parser) ? PARSE_STRING_NUMBER : PARSE_STRING;
+                    begin_number(parser);
+                } else if (c == '-' || (c >= '0' && c <= '9')) {
+                    parser->state = wants_field(parser) ? PARSE_NUMBER : PARSE_SCALAR;
+                    begin_number(parser);
+                    number_char(parser, c);
+                } else if (c == 't' || c == 'f' || c == 'n') {
+                    parser->state = PARSE_SCALAR;
+                } else if (c == ']' && parser->field == 0) {
+                    parser->state = PARSE_NEXT_ROW;
+                } else {
+                    parser->failed = true;
+                }
+                break;
+
+            case PARSE_AFTER_FIELD:
+                if (c == ',') {
+                    parser->field++;
+                    parser->state = PARSE_FIELD;
+                } else if (c == ']') {
+                    // Short rows are dropped; the next row overwrites whatever they stored
+                    if (parser->field + 1 >= KLINE_MIN_FIELDS) {
+                        parser->row_count++;
+                    }
+                    parser->state = PARSE_NEXT_ROW;
+                } else {
+                    parser->failed = true;
+                }
+                break;
+
+            default:
+                parser->failed = true;
+                break;
+            }
+            break;
+        }
+    }
+    return parser->failed ? -1 : 0;
+}
+
+int kline_parser_finish(const KlineParser *parser) {
+    return !parser->failed && parser->state == PARSE_DONE ? 0 : -1;
+}
+
+size_t kline_parser_write(char *contents, size_t size, size_t nmemb, void *userp) {
+    size_t real_size = size * nmemb;
+    kline_parser_feed((KlineParser *)userp, contents, real_size);
+    return real_size;
+}
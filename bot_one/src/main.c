@@ -1,25 +1,39 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <sched.h>
 #include <math.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <curl/curl.h>
 #include "market_data.h"
 #include "market_data_pool.h"
-#include "lock_free_queue.h"
+#include "spsc_ring.h"
+#include "wait_strategy.h"
 #include "pre_processing.h"
 #include "config_parser.h"
 #include "algorithm_execution.h"
 #include "risk_management.h"
 #include "data_fetcher.h"
+#include "market_stream.h"
+#include "replay.h"
+#include "capture_log.h"
+#include "depth_stream.h"
 #include "types.h"
 
-// Global variables for synchronization
-pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
-pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
-
 #define MAX_WINDOW_SIZE 1000
+// Ticks the pre-processing thread takes from its ring at once
+#define PRE_PROCESSING_BATCH 256
 
 int running = 1;
+// Cleared once a pipeline stage will push nothing more: input_open by the ingestion thread
+// when its source ends, output_open by the pre-processing thread once it has drained the
+// input after that, so a finite source such as a replay runs the pipeline dry and exits
+static int input_open = 1;
+static int output_open = 1;
 
 // Placeholder function to fetch market data
 MarketData *fetch_market_data() {
@@ -32,16 +46,141 @@ MarketData *fetch_market_data() {
     return data;
 }
 
+typedef struct {
+    SpscRing *queue;
+    WaitStrategy *wait;         // the pre-processing thread's wait on queue
+    const char *stream_url;
+    const char *replay_file;
+    double replay_speed;
+    const char *capture_dir;
+    int status;                 // nonzero if the source failed
+} DataIngestionArgs;
+
+// Push onto a pipeline ring, yielding to the consumer while it is full; false if the
+// pipeline stopped first
+static bool push_waiting(SpscRing *queue, void *data) {
+    while (!spsc_ring_push(queue, data)) {
+        if (!running) {
+            return false;
+        }
+        sched_yield();
+    }
+    return true;
+}
+
+// Push a batch onto a pipeline ring, yielding to the consumer while it is full; returns how
+// many were pushed before the pipeline stopped
+static size_t push_bulk_waiting(SpscRing *queue, void *const *items, size_t count) {
+    size_t pushed = 0;
+    while ((pushed += spsc_ring_push_bulk(queue, items + pushed, count - pushed)) < count) {
+        if (!running) {
+            break;
+        }
+        sched_yield();
+    }
+    return pushed;
+}
+
+static bool ring_has_items(void *ring) {
+    return !spsc_ring_is_empty((SpscRing *)ring);
+}
+
+// Tell a ring's consumer that nothing more will be pushed; items already pushed are still delivered
+static void close_stage(int *open, WaitStrategy *wait) {
+    __atomic_store_n(open, 0, __ATOMIC_RELEASE);
+    wait_strategy_wake_all(wait);
+}
+
+// True once a closed ring has been emptied, so its consumer can stop
+static bool stage_drained(const int *open, SpscRing *ring) {
+    return __atomic_load_n(open, __ATOMIC_ACQUIRE) == 0 && spsc_ring_is_empty(ring);
+}
+
+// Hand one tick to the pre-processing thread
+static void enqueue_tick(MarketData *data, void *userdata) {
+    DataIngestionArgs *ingestion_args = (DataIngestionArgs *)userdata;
+    if (!push_waiting(ingestion_args->queue, data)) {
+        free(data);
+        return;
+    }
+    wait_strategy_notify(ingestion_args->wait);
+}
+
+// Start a capture of this run's stream in dir, named by the UTC start time
+static int open_capture(const char *dir, CaptureLog *capture) {
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        printf("Could not create capture directory %s\n", dir);
+        return -1;
+    }
+    char path[320];
+    char stamp[32];
+    time_t now = time(NULL);
+    struct tm utc;
+    gmtime_r(&now, &utc);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &utc);
+    snprintf(path, sizeof(path), "%s/%s.cap", dir, stamp);
+    if (capture_log_open(capture, path) != 0) {
+        return -1;
+    }
+    printf("Capturing raw stream messages to %s\n", path);
+    return 0;
+}
+
 void *data_ingestion_thread(void *args) {
-    LockFreeQueue *queue = (LockFreeQueue *)args;
+    DataIngestionArgs *ingestion_args = (DataIngestionArgs *)args;
+
+    // A replay stands in for the live feed, pacing recorded ticks by their original spacing
+    if (ingestion_args->replay_file[0] != '\0') {
+        ReplaySource replay = {
+            .path = ingestion_args->replay_file,
+            .speed = ingestion_args->replay_speed,
+            .on_tick = enqueue_tick,
+            .userdata = ingestion_args,
+            .running = &running,
+        };
+        if (replay_run(&replay) != 0) {
+            ingestion_args->status = 1;
+        }
+        if (replay.ticks > 0) {
+            printf("Replay lag behind schedule: mean %.1f us, max %.1f us\n",
+                   replay.lag_ns_total / 1e3 / replay.ticks, replay.lag_ns_max / 1e3);
+        }
+        // The recording is over: what is queued is processed and then the run ends
+        close_stage(&input_open, ingestion_args->wait);
+        return NULL;
+    }
+
+    // With a stream configured every tick is queued the moment its frame is decoded
+    if (ingestion_args->stream_url[0] != '\0') {
+        MarketStream stream = {
+            .url = ingestion_args->stream_url,
+            .on_tick = enqueue_tick,
+            .userdata = ingestion_args,
+            .running = &running,
+        };
+        CaptureLog capture;
+        if (ingestion_args->capture_dir[0] != '\0' && open_capture(ingestion_args->capture_dir, &capture) == 0) {
+            stream.capture = &capture;
+        }
+        market_stream_run(&stream);
+        if (stream.capture) {
+            capture_log_close(&capture);
+            printf("Captured %zu messages, %zu dropped\n", capture.records, capture.dropped);
+        }
+        close_stage(&input_open, ingestion_args->wait);
+        return NULL;
+    }
+
     while (running) {
-        MarketData *data = fetch_market_data();
-        pthread_mutex_lock(&mutex);
-        lock_free_queue_enqueue(queue, data);
-        pthread_cond_signal(&cond);
-        pthread_mutex_unlock(&mutex);
+        enqueue_tick(fetch_market_data(), ingestion_args);
         sleep(10); // Sleep for 100 milliseconds
     }
+    close_stage(&input_open, ingestion_args->wait);
+    return NULL;
+}
+
+void *depth_stream_thread(void *args) {
+    depth_stream_run((DepthStream *)args);
     return NULL;
 }
 
@@ -61,105 +200,123 @@ void *pre_processing_thread(void *args) {
     size_t n = 0;
 
     double window_price_sum = 0.0;
+    double window_price_sq_sum = 0.0;
     double prev_ema = 0.0;
     double mean = 0.0;
     double variance = 0.0;
     double avg_gain = 0.0, avg_loss = 0.0;
     double prev_price = 0.0;
 
+    void *batch[PRE_PROCESSING_BATCH];
     while (running) {
-        pthread_mutex_lock(&mutex);
-        while (queue_is_empty(pre_processing_args->input_queue)) {
-            pthread_cond_wait(&cond, &mutex);
+        if (!wait_strategy_wait(pre_processing_args->input_wait, ring_has_items, pre_processing_args->input_queue, &input_open)) {
+            if (stage_drained(&input_open, pre_processing_args->input_queue)) {
+                break;
+            }
+            continue;
         }
-        pthread_mutex_unlock(&mutex);
 
-        MarketData *data = (MarketData *)lock_free_queue_dequeue(pre_processing_args->input_queue);
-        if (data == NULL) continue;
+        // Take everything waiting, up to a batch, with one update of the ring's head
+        size_t count = spsc_ring_pop_bulk(pre_processing_args->input_queue, batch, PRE_PROCESSING_BATCH);
+
+        // The window sums are recomputed once per batch and carried tick to tick inside it,
+        // so the bands cost the same per tick however wide the window is and rounding
+        // cannot build up across batches. Unfilled slots are zero.
+        window_price_sum = 0.0;
+        window_price_sq_sum = 0.0;
+        for (size_t i = 0; i < window_size; i++) {
+            window_price_sum += prices[i];
+            window_price_sq_sum += prices[i] * prices[i];
+        }
 
-        // Update price buffer
-        double old_price = prices[price_index];
-        prices[price_index] = data->price;
+        for (size_t b = 0; b < count; b++) {
+            MarketData *data = (MarketData *)batch[b];
 
-        // Update moving average
-        if (n < window_size) {
-            window_price_sum += data->price;
-            n++;
-            data->moving_average = window_price_sum / n;
-        } else {
-            window_price_sum = window_price_sum - old_price + data->price;
-            data->moving_average = window_price_sum / window_size;
-        }
+            // Update price buffer
+            double old_price = prices[price_index];
+            prices[price_index] = data->price;
 
-        // Update EMA
-        if (prev_ema == 0.0) {
-            prev_ema = data->price;
-        }
-        data->ema = ema_alpha * data->price + (1 - ema_alpha) * prev_ema;
-        prev_ema = data->ema;
+            // Update moving average
+            if (n < window_size) {
+                window_price_sum += data->price;
+                window_price_sq_sum += data->price * data->price;
+                n++;
+                data->moving_average = window_price_sum / n;
+            } else {
+                window_price_sum = window_price_sum - old_price + data->price;
+                window_price_sq_sum = window_price_sq_sum - old_price * old_price + data->price * data->price;
+                data->moving_average = window_price_sum / window_size;
+            }
 
-        // Update Bollinger Bands
-        if (n >= window_size) {
-            // Calculate mean and standard deviation over the window
-            double sum = 0.0, sum_sq = 0.0;
-            for (size_t i = 0; i < window_size; i++) {
-                sum += prices[i];
-                sum_sq += prices[i] * prices[i];
+            // Update EMA
+            if (prev_ema == 0.0) {
+                prev_ema = data->price;
             }
-            mean = sum / window_size;
-            variance = (sum_sq / window_size) - (mean * mean);
-            double stddev = sqrt(variance);
-            data->bollinger_upper = mean + bollinger_multiplier * stddev;
-            data->bollinger_lower = mean - bollinger_multiplier * stddev;
-        }
-
-        // Update RSI
-        if (prev_price != 0.0) {
-            double change = data->price - prev_price;
-            double gain = (change > 0) ? change : 0.0;
-            double loss = (change < 0) ? -change : 0.0;
-
-            gains[gain_loss_index % rsi_period] = gain;
-            losses[gain_loss_index % rsi_period] = loss;
-
-            if (n >= rsi_period) {
-                double total_gain = 0.0, total_loss = 0.0;
-                for (size_t i = 0; i < rsi_period; i++) {
-                    total_gain += gains[i];
-                    total_loss += losses[i];
-                }
-                avg_gain = total_gain / rsi_period;
-                avg_loss = total_loss / rsi_period;
-            } else {
-                avg_gain = ((avg_gain * (n - 1)) + gain) / n;
-                avg_loss = ((avg_loss * (n - 1)) + loss) / n;
+            data->ema = ema_alpha * data->price + (1 - ema_alpha) * prev_ema;
+            prev_ema = data->ema;
+
+            // Update Bollinger Bands
+            if (n >= window_size) {
+                // Calculate mean and standard deviation over the window
+                mean = window_price_sum / window_size;
+                variance = (window_price_sq_sum / window_size) - (mean * mean);
+                double stddev = variance > 0.0 ? sqrt(variance) : 0.0;
+                data->bollinger_upper = mean + bollinger_multiplier * stddev;
+                data->bollinger_lower = mean - bollinger_multiplier * stddev;
             }
 
-            if (avg_loss == 0) {
-                data->rsi = 100.0;
-            } else {
-                double rs = avg_gain / avg_loss;
-                data->rsi = 100 - (100 / (1 + rs));
+            // Update RSI
+            if (prev_price != 0.0) {
+                double change = data->price - prev_price;
+                double gain = (change > 0) ? change : 0.0;
+                double loss = (change < 0) ? -change : 0.0;
+
+                gains[gain_loss_index % rsi_period] = gain;
+                losses[gain_loss_index % rsi_period] = loss;
+
+                if (n >= rsi_period) {
+                    double total_gain = 0.0, total_loss = 0.0;
+                    for (size_t i = 0; i < rsi_period; i++) {
+                        total_gain += gains[i];
+                        total_loss += losses[i];
+                    }
+                    avg_gain = total_gain / rsi_period;
+                    avg_loss = total_loss / rsi_period;
+                } else {
+                    avg_gain = ((avg_gain * (n - 1)) + gain) / n;
+                    avg_loss = ((avg_loss * (n - 1)) + loss) / n;
+                }
+
+                if (avg_loss == 0) {
+                    data->rsi = 100.0;
+                } else {
+                    double rs = avg_gain / avg_loss;
+                    data->rsi = 100 - (100 / (1 + rs));
+                }
+
+                gain_loss_index++;
             }
 
-            gain_loss_index++;
+            prev_price = data->price;
+            price_index = (price_index + 1) % window_size;
         }
 
-        prev_price = data->price;
-        price_index = (price_index + 1) % window_size;
-
-        // Enqueue processed data
-        lock_free_queue_enqueue(pre_processing_args->output_queue, data);
+        // Publish the batch with one update of the output ring's tail and at most one wake-up
+        size_t pushed = push_bulk_waiting(pre_processing_args->output_queue, batch, count);
+        for (size_t b = pushed; b < count; b++) {
+            free(batch[b]);
+        }
+        if (pushed > 0) {
+            wait_strategy_notify(pre_processing_args->output_wait);
+        }
     }
+    close_stage(&output_open, pre_processing_args->output_wait);
     return NULL;
 }
 
 int main(int argc, char *argv[]) {
-    (void)argc;
-    (void)argv;
-
     const char *config_file_path = "../config/config.ini";
-    ConfigParams params;
+    ConfigParams params = {0};
 
     // Check if the file exists and can be read
     if (access(config_file_path, F_OK) != 0) {
@@ -176,18 +333,71 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
-    // Initialize queues
-    LockFreeQueue *input_queue = lock_free_queue_init();
-    LockFreeQueue *output_queue = lock_free_queue_init();
+    // libcurl's global state is set up once, before any fetcher or stream thread starts
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    // tradbot --sync [SYMBOL...] appends newly closed bars to each history file and exits
+    if (argc > 1 && strcmp(argv[1], "--sync") == 0) {
+        // One fetcher context for the whole run, so every symbol after the first reuses the connection
+        FetcherContext *context = fetcher_context_create(params.base_url, params.backfill_concurrency);
+        if (!context) {
+            return 1;
+        }
+        rate_limiter_configure(&context->limiter, params.rate_limit_weight, RATE_LIMIT_WINDOW_MS);
+        int status = 0;
+        int symbol_count = argc > 2 ? argc - 2 : 1;
+        for (int i = 0; i < symbol_count; i++) {
+            const char *symbol = argc > 2 ? argv[i + 2] : params.symbol;
+            size_t rows_appended = 0;
+            if (sync_history(context, &params, symbol, &rows_appended) != 0) {
+                status = 1;
+            }
+            printf("%s: %zu new bars\n", symbol, rows_appended);
+        }
+        fetcher_context_destroy(context);
+        curl_global_cleanup();
+        return status;
+    }
+
+    // tradbot --replay FILE [SPEED] feeds a recording through the pipeline instead of the live feed
+    if (argc > 2 && strcmp(argv[1], "--replay") == 0) {
+        snprintf(params.replay_file, sizeof(params.replay_file), "%s", argv[2]);
+        if (argc > 3) {
+            params.replay_speed = atof(argv[3]);
+        }
+    }
+
+    // Initialize queues; each has one producer and one consumer thread
+    SpscRing *input_queue = spsc_ring_init(SPSC_RING_DEFAULT_CAPACITY);
+    SpscRing *output_queue = spsc_ring_init(SPSC_RING_DEFAULT_CAPACITY);
+    if (!input_queue || !output_queue) {
+        fprintf(stderr, "Failed to allocate the pipeline queues.\n");
+        return 1;
+    }
+
+    // Each queue's consumer waits in its own way, so a push only ever wakes that consumer
+    WaitStrategy input_wait, output_wait;
+    wait_strategy_init(&input_wait, params.input_wait);
+    wait_strategy_init(&output_wait, params.output_wait);
 
     // Start data ingestion thread
     pthread_t data_thread, pre_process_thread;
-    pthread_create(&data_thread, NULL, data_ingestion_thread, input_queue);
+    DataIngestionArgs ingestion_args = {
+        .queue = input_queue,
+        .wait = &input_wait,
+        .stream_url = params.stream_url,
+        .replay_file = params.replay_file,
+        .replay_speed = params.replay_speed,
+        .capture_dir = params.capture_dir
+    };
+    pthread_create(&data_thread, NULL, data_ingestion_thread, &ingestion_args);
 
     // Start pre-processing thread
     PreProcessingArgs pre_processing_args = {
         .input_queue = input_queue,
         .output_queue = output_queue,
+        .input_wait = &input_wait,
+        .output_wait = &output_wait,
         .window_size = params.window_size,
         .ema_alpha = params.ema_alpha,
         .rsi_period = params.rsi_period,
@@ -195,6 +405,22 @@ int main(int argc, char *argv[]) {
     };
     pthread_create(&pre_process_thread, NULL, pre_processing_thread, &pre_processing_args);
 
+    // With a depth stream configured the strategy judges liquidity against the live order book
+    OrderBook order_book;
+    FetcherContext *depth_fetcher = NULL;
+    pthread_t depth_thread;
+    DepthStream depth_stream = {.url = params.depth_stream_url, .book = &order_book, .running = &running};
+    if (params.depth_stream_url[0] != '\0' && order_book_init(&order_book, params.symbol, params.tick_size, 0) == 0) {
+        depth_fetcher = fetcher_context_create(params.base_url, 1);
+        if (depth_fetcher) {
+            rate_limiter_configure(&depth_fetcher->limiter, params.rate_limit_weight, RATE_LIMIT_WINDOW_MS);
+            depth_stream.fetcher = depth_fetcher;
+            pthread_create(&depth_thread, NULL, depth_stream_thread, &depth_stream);
+        } else {
+            order_book_destroy(&order_book);
+        }
+    }
+
     // Initialize risk management settings
     RiskManagementSettings risk_settings = {
         .calculate_dynamic_stop_loss = NULL,  // Implement as needed
@@ -205,13 +431,12 @@ int main(int argc, char *argv[]) {
     // Main loop
     size_t records_processed = 0; // Use size_t
     while (records_processed < params.max_records_to_process) {
-        pthread_mutex_lock(&mutex);
-        while (queue_is_empty(output_queue)) {
-            pthread_cond_wait(&cond, &mutex);
+        if (!wait_strategy_wait(&output_wait, ring_has_items, output_queue, &output_open) &&
+            stage_drained(&output_open, output_queue)) {
+            break;
         }
-        pthread_mutex_unlock(&mutex);
 
-        MarketData *data = (MarketData *)lock_free_queue_dequeue(output_queue);
+        MarketData *data = (MarketData *)spsc_ring_pop(output_queue);
         if (data) {
             // Prepare PreProcessedData for the algorithm
             PreProcessedData pre_processed_data = {0};
@@ -223,6 +448,7 @@ int main(int argc, char *argv[]) {
             pre_processed_data.latency = params.latency;
             pre_processed_data.liquidity = &data->volume; // Using volume as liquidity
             pre_processed_data.liquidity_count = 1;
+            pre_processed_data.order_book = depth_fetcher ? &order_book : NULL;
             pre_processed_data.risk_management_params = params.risk_management_params;
             pre_processed_data.liquidity_info = params.liquidity_info;
             pre_processed_data.trend_info = params.trend_info;
@@ -242,11 +468,18 @@ int main(int argc, char *argv[]) {
     }
 
     running = 0;
+    close_stage(&input_open, &input_wait);
     pthread_join(data_thread, NULL);
     pthread_join(pre_process_thread, NULL);
+    if (depth_fetcher) {
+        pthread_join(depth_thread, NULL);
+        fetcher_context_destroy(depth_fetcher);
+        order_book_destroy(&order_book);
+    }
 
-    lock_free_queue_destroy(input_queue);
-    lock_free_queue_destroy(output_queue);
+    spsc_ring_destroy(input_queue);
+    spsc_ring_destroy(output_queue);
+    curl_global_cleanup();
 
-    return 0;
+    return ingestion_args.status;
 }
\ No newline at end of file
@@ -0,0 +1,133 @@
+// src/market_stream.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "market_stream.h"
+#include "ws_client.h"
+#include "cJSON.h"
+
+// State shared with the message handler for one connection
+typedef struct {
+    MarketStream *stream;
+    WsClient *client;
+} StreamSession;
+
+static double field_number(const cJSON *object, const char *key, int *ok) {
+    const cJSON *field = cJSON_GetObjectItemCaseSensitive(object, key);
+    if (cJSON_IsString(field)) {
+        return atof(field->valuestring);
+    }
+    if (cJSON_IsNumber(field)) {
+        return field->valuedouble;
+    }
+    *ok = 0;
+    return 0.0;
+}
+
+int market_stream_parse(const char *message, size_t length, MarketData *tick) {
+    cJSON *json = cJSON_ParseWithLength(message, length);
+    if (!cJSON_IsObject(json)) {
+        cJSON_Delete(json);
+        return -1;
+    }
+
+    // Combined streams wrap the event as {"stream": "...", "data": {...}}
+    const cJSON *event = cJSON_GetObjectItemCaseSensitive(json, "data");
+    if (!cJSON_IsObject(event)) {
+        event = json;
+    }
+    const cJSON *type = cJSON_GetObjectItemCaseSensitive(event, "e");
+    if (!cJSON_IsString(type)) {
+        cJSON_Delete(json);
+        return 0;
+    }
+
+    int ok = 1;
+    int status = 0;
+    memset(tick, 0, sizeof(*tick));
+    if (strcmp(type->valuestring, "trade") == 0 || strcmp(type->valuestring, "aggTrade") == 0) {
+        tick->price = field_number(event, "p", &ok);
+        tick->volume = field_number(event, "q", &ok);
+        status = ok ? 1 : -1;
+    } else if (strcmp(type->valuestring, "kline") == 0) {
+        // Every kline update carries the bar so far; its close is the latest price
+        const cJSON *kline = cJSON_GetObjectItemCaseSensitive(event, "k");
+        if (cJSON_IsObject(kline)) {
+            tick->price = field_number(kline, "c", &ok);
+            tick->volume = field_number(kline, "v", &ok);
+            status = ok ? 1 : -1;
+        } else {
+            status = -1;
+        }
+    }
+    cJSON_Delete(json);
+    return status;
+}
+
+static void handle_message(const char *message, size_t length, void *userdata) {
+    StreamSession *session = (StreamSession *)userdata;
+    MarketStream *stream = session->stream;
+    stream->messages++;
+    if (stream->capture) {
+        capture_log_append(stream->capture, session->client->received_ns, 0, message, length);
+    }
+
+    MarketData tick;
+    int status = market_stream_parse(message, length, &tick);
+    if (status < 0) {
+        printf("Skipping malformed stream message: %.*s\n", length > 120 ? 120 : (int)length, message);
+        return;
+    }
+    if (status == 0) {
+        return;
+    }
+
+    MarketData *data = (MarketData *)malloc(sizeof(MarketData));
+    if (data == NULL) {
+        return;
+    }
+    *data = tick;
+    stream->on_tick(data, stream->userdata);
+
+    long long latency = ws_monotonic_ns() - session->client->received_ns;
+    stream->ticks++;
+    stream->latency_ns_total += latency;
+    if (latency > stream->latency_ns_max) {
+        stream->latency_ns_max = latency;
+    }
+}
+
+// Sleep for up to milliseconds, returning early once the stream is stopped
+static void wait_while_running(const MarketStream *stream, int milliseconds) {
+    struct timespec step = {0, 50 * 1000000L};
+    for (int waited = 0; waited < milliseconds && *stream->running; waited += 50) {
+        nanosleep(&step, NULL);
+    }
+}
+
+int market_stream_run(MarketStream *stream) {
+    while (*stream->running) {
+        WsClient client;
+        if (ws_client_connect(&client, stream->url) != 0) {
+            wait_while_running(stream, MARKET_STREAM_RECONNECT_MS);
+            continue;
+        }
+        printf("Streaming market data from %s\n", stream->url);
+
+        StreamSession session = {stream, &client};
+        while (*stream->running) {
+            if (ws_client_poll(&client, MARKET_STREAM_POLL_MS, handle_message, &session) < 0) {
+                printf("Market stream disconnected, reconnecting\n");
+                break;
+            }
+        }
+        bool dropped = client.closed;
+        ws_client_close(&client);
+        if (dropped) {
+            wait_while_running(stream, MARKET_STREAM_RECONNECT_MS);
+        }
+    }
+    return 0;
+}
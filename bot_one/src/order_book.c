@@ -0,0 +1,379 @@
+// src/order_book.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "order_book.h"
+#include "cJSON.h"
+
+int order_book_init(OrderBook *book, const char *symbol, double tick_size, size_t levels) {
+    memset(book, 0, sizeof(*book));
+    // Set up first, so order_book_destroy can release it on every path
+    pthread_mutex_init(&book->lock, NULL);
+    snprintf(book->symbol, sizeof(book->symbol), "%s", symbol);
+    book->tick_size = tick_size;
+    book->levels = levels ? levels : ORDER_BOOK_DEFAULT_LEVELS;
+    book->best_bid = -1;
+    book->best_ask = -1;
+    book->bids = (double *)calloc(book->levels, sizeof(double));
+    book->asks = (double *)calloc(book->levels, sizeof(double));
+    book->pending = (char **)calloc(ORDER_BOOK_PENDING_MAX, sizeof(char *));
+    book->pending_lengths = (size_t *)calloc(ORDER_BOOK_PENDING_MAX, sizeof(size_t));
+    if (tick_size <= 0 || !book->bids || !book->asks || !book->pending || !book->pending_lengths) {
+        printf("Failed to initialize the %s order book\n", symbol);
+        order_book_destroy(book);
+        return -1;
+    }
+    return 0;
+}
+
+static long long price_tick(const OrderBook *book, double price) {
+    return llround(price / book->tick_size);
+}
+
+static void clear_levels(OrderBook *book) {
+    memset(book->bids, 0, book->levels * sizeof(double));
+    memset(book->asks, 0, book->levels * sizeof(double));
+    book->best_bid = -1;
+    book->best_ask = -1;
+}
+
+// Best bid at or below index, -1 if none
+static long scan_bids(const OrderBook *book, long index) {
+    while (index >= 0 && book->bids[index] == 0.0) {
+        index--;
+    }
+    return index;
+}
+
+// Best ask at or above index, -1 if none
+static long scan_asks(const OrderBook *book, long index) {
+    while (index < (long)book->levels && book->asks[index] == 0.0) {
+        index++;
+    }
+    return index < (long)book->levels ? index : -1;
+}
+
+static void place_level(OrderBook *book, BookSide side, long long tick, double quantity) {
+    long long offset = tick - book->base_tick;
+    if ((offset < 0 || offset >= (long long)book->levels) && book->best_bid < 0 && book->best_ask < 0) {
+        // An empty book centres its window on the first level it sees
+        book->base_tick = tick - (long long)book->levels / 2;
+        offset = tick - book->base_tick;
+    }
+    if (offset < 0 || offset >= (long long)book->levels) {
+        book->outside_window++;
+        return;
+    }
+    long index = (long)offset;
+
+    if (side == BOOK_SIDE_BID) {
+        book->bids[index] = quantity;
+        if (quantity > 0 && index > book->best_bid) {
+            book->best_bid = index;
+        } else if (quantity == 0 && index == book->best_bid) {
+            book->best_bid = scan_bids(book, index - 1);
+        }
+    } else {
+        book->asks[index] = quantity;
+        if (quantity > 0 && (book->best_ask < 0 || index < book->best_ask)) {
+            book->best_ask = index;
+        } else if (quantity == 0 && index == book->best_ask) {
+            book->best_ask = scan_asks(book, index + 1);
+        }
+    }
+}
+
+// Shift the window so the touch sits in the middle again once it drifts near an edge
+static void recenter(OrderBook *book) {
+    if (book->best_bid < 0 && book->best_ask < 0) {
+        return;
+    }
+    long low = book->best_bid >= 0 ? book->best_bid : book->best_ask;
+    long high = book->best_ask >= 0 ? book->best_ask : book->best_bid;
+    long margin = (long)(book->levels / ORDER_BOOK_RECENTER_DIVISOR);
+    if (low >= margin && high < (long)book->levels - margin) {
+        return;
+    }
+
+    long shift = (low + high) / 2 - (long)book->levels / 2;
+    size_t distance = (size_t)labs(shift);
+    if (distance >= book->levels) {
+        clear_levels(book);
+        return;
+    }
+    size_t kept = book->levels - distance;
+    double *sides[2] = {book->bids, book->asks};
+    for (int i = 0; i < 2; i++) {
+        if (shift > 0) {
+            memmove(sides[i], sides[i] + distance, kept * sizeof(double));
+            memset(sides[i] + kept, 0, distance * sizeof(double));
+        } else {
+            memmove(sides[i] + distance, sides[i], kept * sizeof(double));
+            memset(sides[i], 0, distance * sizeof(double));
+        }
+    }
+    book->base_tick += shift;
+
+    // A side whose best level fell off the window takes the best level left on it
+    long levels = (long)book->levels;
+    long bid = book->best_bid < 0 ? -1 : book->best_bid - shift;
+    long ask = book->best_ask < 0 ? -1 : book->best_ask - shift;
+    book->best_bid = bid >= levels ? scan_bids(book, levels - 1) : (bid < 0 ? -1 : bid);
+    book->best_ask = book->best_ask >= 0 && ask < 0 ? scan_asks(book, 0) : (ask >= levels ? -1 : ask);
+}
+
+// Apply every [price, quantity] pair of a bids or asks array; -1 if the array is malformed
+static int place_levels(OrderBook *book, BookSide side, const cJSON *levels) {
+    if (!cJSON_IsArray(levels)) {
+        return -1;
+    }
+    const cJSON *level;
+    cJSON_ArrayForEach(level, levels) {
+        const cJSON *price = cJSON_GetArrayItem(level, 0);
+        const cJSON *quantity = cJSON_GetArrayItem(level, 1);
+        if (!cJSON_IsString(price) || !cJSON_IsString(quantity)) {
+            return -1;
+        }
+        place_level(book, side, price_tick(book, atof(price->valuestring)), atof(quantity->valuestring));
+    }
+    return 0;
+}
+
+static long long field_id(const cJSON *object, const char *key) {
+    const cJSON *field = cJSON_GetObjectItemCaseSensitive(object, key);
+    return cJSON_IsNumber(field) ? (long long)field->valuedouble : -1;
+}
+
+// Apply a diff to a synced book; the book is left untouched on ORDER_BOOK_GAP
+static OrderBookStatus apply_update(OrderBook *book, const char *json, size_t length) {
+    cJSON *root = cJSON_ParseWithLength(json, length);
+    const cJSON *event = cJSON_GetObjectItemCaseSensitive(root, "data");
+    if (!cJSON_IsObject(event)) {
+        event = root;
+    }
+    const cJSON *type = cJSON_GetObjectItemCaseSensitive(event, "e");
+    if (!cJSON_IsString(type) || strcmp(type->valuestring, "depthUpdate") != 0) {
+        // Subscription replies and other events say nothing about the book
+        OrderBookStatus status = cJSON_IsObject(root) ? ORDER_BOOK_STALE : ORDER_BOOK_GAP;
+        cJSON_Delete(root);
+        return status;
+    }
+    long long first_id = field_id(event, "U");
+    long long final_id = field_id(event, "u");
+    if (first_id < 0 || final_id < first_id) {
+        printf("Malformed depth update for %s\n", book->symbol);
+        cJSON_Delete(root);
+        return ORDER_BOOK_GAP;
+    }
+    if (final_id <= book->last_update_id) {
+        cJSON_Delete(root);
+        return ORDER_BOOK_STALE;
+    }
+    // The first diff after a snapshot may straddle it; every later one starts where the last ended
+    if (first_id > book->last_update_id + 1) {
+        cJSON_Delete(root);
+        return ORDER_BOOK_GAP;
+    }
+    int status = place_levels(book, BOOK_SIDE_BID, cJSON_GetObjectItemCaseSensitive(event, "b"));
+    if (status == 0) {
+        status = place_levels(book, BOOK_SIDE_ASK, cJSON_GetObjectItemCaseSensitive(event, "a"));
+    }
+    cJSON_Delete(root);
+    if (status != 0) {
+        printf("Malformed depth update for %s\n", book->symbol);
+        return ORDER_BOOK_GAP;
+    }
+    book->last_update_id = final_id;
+    book->updates++;
+    recenter(book);
+    return ORDER_BOOK_APPLIED;
+}
+
+static void buffer_diff(OrderBook *book, const char *json, size_t length) {
+    if (book->pending_count == ORDER_BOOK_PENDING_MAX) {
+        // The snapshot is taking too long; start buffering afresh
+        for (size_t i = 0; i < book->pending_count; i++) {
+            free(book->pending[i]);
+        }
+        book->pending_count = 0;
+    }
+    char *copy = (char *)malloc(length);
+    if (copy == NULL) {
+        return;
+    }
+    memcpy(copy, json, length);
+    book->pending[book->pending_count] = copy;
+    book->pending_lengths[book->pending_count] = length;
+    book->pending_count++;
+}
+
+// Drop the first count buffered diffs
+static void discard_pending(OrderBook *book, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        free(book->pending[i]);
+    }
+    memmove(book->pending, book->pending + count, (book->pending_count - count) * sizeof(char *));
+    memmove(book->pending_lengths, book->pending_lengths + count, (book->pending_count - count) * sizeof(size_t));
+    book->pending_count -= count;
+}
+
+int order_book_apply_snapshot(OrderBook *book, const char *json, size_t length) {
+    cJSON *root = cJSON_ParseWithLength(json, length);
+    long long last_update_id = field_id(root, "lastUpdateId");
+    const cJSON *bids = cJSON_GetObjectItemCaseSensitive(root, "bids");
+    const cJSON *asks = cJSON_GetObjectItemCaseSensitive(root, "asks");
+    if (last_update_id < 0 || !cJSON_IsArray(bids) || !cJSON_IsArray(asks)) {
+        printf("Malformed depth snapshot for %s\n", book->symbol);
+        cJSON_Delete(root);
+        return -1;
+    }
+
+    pthread_mutex_lock(&book->lock);
+    clear_levels(book);
+    // Centre the window on the touch; snapshots list the best level of each side first
+    const cJSON *best_bid = cJSON_GetArrayItem(cJSON_GetArrayItem(bids, 0), 0);
+    const cJSON *best_ask = cJSON_GetArrayItem(cJSON_GetArrayItem(asks, 0), 0);
+    if (cJSON_IsString(best_bid) && cJSON_IsString(best_ask)) {
+        long long middle = (price_tick(book, atof(best_bid->valuestring)) + price_tick(book, atof(best_ask->valuestring))) / 2;
+        book->base_tick = middle - (long long)book->levels / 2;
+    }
+    int status = place_levels(book, BOOK_SIDE_BID, bids);
+    if (status == 0) {
+        status = place_levels(book, BOOK_SIDE_ASK, asks);
+    }
+    cJSON_Delete(root);
+    if (status != 0) {
+        printf("Malformed depth snapshot for %s\n", book->symbol);
+        clear_levels(book);
+        pthread_mutex_unlock(&book->lock);
+        return -1;
+    }
+    book->last_update_id = last_update_id;
+    book->synced = true;
+
+    // Bring the snapshot forward with the diffs received while it was fetched
+    size_t applied = 0;
+    for (; applied < book->pending_count; applied++) {
+        if (apply_update(book, book->pending[applied], book->pending_lengths[applied]) == ORDER_BOOK_GAP) {
+            // The snapshot predates the buffered diffs; keep them for the next one
+            printf("Depth snapshot for %s is older than the buffered updates\n", book->symbol);
+            clear_levels(book);
+            book->synced = false;
+            discard_pending(book, applied);
+            pthread_mutex_unlock(&book->lock);
+            return -1;
+        }
+    }
+    discard_pending(book, applied);
+    pthread_mutex_unlock(&book->lock);
+    return 0;
+}
+
+OrderBookStatus order_book_apply_diff(OrderBook *book, const char *json, size_t length) {
+    pthread_mutex_lock(&book->lock);
+    OrderBookStatus status = ORDER_BOOK_BUFFERED;
+    if (!book->synced) {
+        buffer_diff(book, json, length);
+    } else {
+        status = apply_update(book, json, length);
+        if (status == ORDER_BOOK_GAP) {
+            // Start over from a new snapshot, keeping this diff as the first to follow it
+            printf("Depth updates for %s skipped past %lld, resyncing\n", book->symbol, book->last_update_id);
+            clear_levels(book);
+            book->synced = false;
+            book->resyncs++;
+            buffer_diff(book, json, length);
+        }
+    }
+    pthread_mutex_unlock(&book->lock);
+    return status;
+}
+
+void order_book_reset(OrderBook *book) {
+    pthread_mutex_lock(&book->lock);
+    clear_levels(book);
+    book->synced = false;
+    discard_pending(book, book->pending_count);
+    pthread_mutex_unlock(&book->lock);
+}
+
+bool order_book_needs_snapshot(OrderBook *book) {
+    pthread_mutex_lock(&book->lock);
+    bool needed = !book->synced && book->pending_count > 0;
+    pthread_mutex_unlock(&book->lock);
+    return needed;
+}
+
+int order_book_top(OrderBook *book, double *bid, double *bid_quantity, double *ask, double *ask_quantity) {
+    pthread_mutex_lock(&book->lock);
+    if (book->best_bid < 0 || book->best_ask < 0) {
+        pthread_mutex_unlock(&book->lock);
+        return -1;
+    }
+    *bid = (book->base_tick + book->best_bid) * book->tick_size;
+    *bid_quantity = book->bids[book->best_bid];
+    *ask = (book->base_tick + book->best_ask) * book->tick_size;
+    *ask_quantity = book->asks[book->best_ask];
+    pthread_mutex_unlock(&book->lock);
+    return 0;
+}
+
+int order_book_depth(OrderBook *book, BookSide side, double bps, double *quantity, double *notional) {
+    *quantity = 0.0;
+    *notional = 0.0;
+    pthread_mutex_lock(&book->lock);
+    long best = side == BOOK_SIDE_BID ? book->best_bid : book->best_ask;
+    if (best < 0) {
+        pthread_mutex_unlock(&book->lock);
+        return -1;
+    }
+
+    // Walk away from the touch until the price is more than bps from it
+    long long best_tick = book->base_tick + best;
+    double band = best_tick * bps / 10000.0;
+    double sum_quantity = 0.0, sum_notional = 0.0;
+    if (side == BOOK_SIDE_BID) {
+        long long limit = (long long)ceil(best_tick - band - 1e-9) - book->base_tick;
+        long last = limit < 0 ? 0 : (long)limit;
+        for (long i = best; i >= last; i--) {
+            sum_quantity += book->bids[i];
+            sum_notional += book->bids[i] * (double)(book->base_tick + i);
+        }
+    } else {
+        long long limit = (long long)floor(best_tick + band + 1e-9) - book->base_tick;
+        long last = limit >= (long long)book->levels ? (long)book->levels - 1 : (long)limit;
+        for (long i = best; i <= last; i++) {
+            sum_quantity += book->asks[i];
+            sum_notional += book->asks[i] * (double)(book->base_tick + i);
+        }
+    }
+    pthread_mutex_unlock(&book->lock);
+    *quantity = sum_quantity;
+    *notional = sum_notional * book->tick_size;
+    return 0;
+}
+
+void order_book_set_level(OrderBook *book, BookSide side, double price, double quantity) {
+    pthread_mutex_lock(&book->lock);
+    place_level(book, side, price_tick(book, price), quantity);
+    recenter(book);
+    pthread_mutex_unlock(&book->lock);
+}
+
+void order_book_destroy(OrderBook *book) {
+    for (size_t i = 0; book->pending && i < book->pending_count; i++) {
+        free(book->pending[i]);
+    }
+    free(book->pending);
+    free(book->pending_lengths);
+    free(book->bids);
+    free(book->asks);
+    book->pending = NULL;
+    book->pending_lengths = NULL;
+    book->bids = NULL;
+    book->asks = NULL;
+    book->pending_count = 0;
+    pthread_mutex_destroy(&book->lock);
+}
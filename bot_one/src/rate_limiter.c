@@ -0,0 +1,186 @@
+// src/rate_limiter.c
+
+#include <stdio.h>
+#include <time.h>
+#include "rate_limiter.h"
+
+static long long realtime_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void rate_limiter_init(RateLimiter *limiter, int weight_limit, long long window_ms) {
+    pthread_mutex_init(&limiter->lock, NULL);
+    pthread_cond_init(&limiter->changed, NULL);
+    limiter->weight_limit = weight_limit > 0 ? weight_limit : 0;
+    limiter->window_ms = window_ms > 0 ? window_ms : RATE_LIMIT_WINDOW_MS;
+    limiter->window_start_ms = 0;
+    limiter->tokens = 0;
+    limiter->in_flight = 0;
+    limiter->blocked_until_ms = 0;
+    for (int i = 0; i < REQUEST_PRIORITY_COUNT; i++) {
+        limiter->waiting[i] = 0;
+        limiter->granted[i] = 0;
+        limiter->max_wait_ms[i] = 0;
+    }
+    limiter->rejected = 0;
+}
+
+void rate_limiter_configure(RateLimiter *limiter, int weight_limit, long long window_ms) {
+    pthread_mutex_lock(&limiter->lock);
+    limiter->weight_limit = weight_limit > 0 ? weight_limit : 0;
+    limiter->window_ms = window_ms > 0 ? window_ms : RATE_LIMIT_WINDOW_MS;
+    limiter->window_start_ms = 0;
+    pthread_cond_broadcast(&limiter->changed);
+    pthread_mutex_unlock(&limiter->lock);
+}
+
+// Refill the bucket once the window has rolled over; called with the lock held.
+// Local windows start window_ms / 100 late, so a server clock running slightly behind
+// ours still counts requests sent at the start of our window in its new window too.
+static void roll_window(RateLimiter *limiter, long long now) {
+    long long margin = limiter->window_ms / 100;
+    long long start = (now - margin) / limiter->window_ms * limiter->window_ms + margin;
+    if (start != limiter->window_start_ms) {
+        limiter->window_start_ms = start;
+        // Requests still in flight may land in the new window
+        limiter->tokens = limiter->weight_limit - limiter->in_flight;
+        pthread_cond_broadcast(&limiter->changed);
+    }
+}
+
+// Milliseconds until weight can be granted at priority, 0 if it can be now, or -1 if it
+// never can because it is more than a whole window's budget; called with the lock held
+static long long wait_time(RateLimiter *limiter, RequestPriority priority, int weight, long long now) {
+    if (weight > limiter->weight_limit) {
+        return -1;
+    }
+    if (now < limiter->blocked_until_ms) {
+        return limiter->blocked_until_ms - now;
+    }
+    roll_window(limiter, now);
+
+    // Backfill leaves the reserve for live requests, but never more than would starve it entirely
+    int floor = 0;
+    if (priority != REQUEST_PRIORITY_LIVE) {
+        floor = limiter->weight_limit * RATE_LIMIT_LIVE_RESERVE_PERCENT / 100;
+        if (floor > limiter->weight_limit - weight) {
+            floor = limiter->weight_limit - weight > 0 ? limiter->weight_limit - weight : 0;
+        }
+    }
+    if (limiter->tokens - weight < floor) {
+        return limiter->window_start_ms + limiter->window_ms - now;
+    }
+
+    // Higher classes that are already waiting go first
+    for (int p = 0; p < (int)priority; p++) {
+        if (limiter->waiting[p] > 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static long long grant(RateLimiter *limiter, RequestPriority priority, int weight) {
+    limiter->tokens -= weight;
+    limiter->in_flight += weight;
+    limiter->granted[priority]++;
+    return limiter->window_start_ms;
+}
+
+long long rate_limiter_acquire(RateLimiter *limiter, RequestPriority priority, int weight) {
+    pthread_mutex_lock(&limiter->lock);
+    if (limiter->weight_limit == 0) {
+        limiter->granted[priority]++;
+        pthread_mutex_unlock(&limiter->lock);
+        return 0;
+    }
+
+    limiter->waiting[priority]++;
+    long long requested = realtime_ms();
+    for (;;) {
+        long long now = realtime_ms();
+        long long wait = wait_time(limiter, priority, weight, now);
+        if (wait < 0) {
+            // Also reached when the budget is configured below weight while this request waits
+            limiter->waiting[priority]--;
+            printf("Request weight %d exceeds the limit of %d per window\n", weight, limiter->weight_limit);
+            pthread_cond_broadcast(&limiter->changed);
+            pthread_mutex_unlock(&limiter->lock);
+            return -1;
+        }
+        if (wait == 0) {
+            if (now - requested > limiter->max_wait_ms[priority]) {
+                limiter->max_wait_ms[priority] = now - requested;
+            }
+            break;
+        }
+        // Woken early by a response, a refill or a higher class leaving the queue
+        long long until = now + wait;
+        struct timespec deadline = {until / 1000, (until % 1000) * 1000000L};
+        pthread_cond_timedwait(&limiter->changed, &limiter->lock, &deadline);
+    }
+    limiter->waiting[priority]--;
+    long long window = grant(limiter, priority, weight);
+
+    // Lower classes held back by this request may now proceed
+    pthread_cond_broadcast(&limiter->changed);
+    pthread_mutex_unlock(&limiter->lock);
+    return window;
+}
+
+long long rate_limiter_try_acquire(RateLimiter *limiter, RequestPriority priority, int weight, long long *window) {
+    pthread_mutex_lock(&limiter->lock);
+    long long wait = 0;
+    if (limiter->weight_limit == 0) {
+        limiter->granted[priority]++;
+        *window = 0;
+    } else if ((wait = wait_time(limiter, priority, weight, realtime_ms())) == 0) {
+        *window = grant(limiter, priority, weight);
+    }
+    pthread_mutex_unlock(&limiter->lock);
+    return wait;
+}
+
+void rate_limiter_complete(RateLimiter *limiter, long long window, int weight, long http_code, long used_weight, long retry_after_s) {
+    pthread_mutex_lock(&limiter->lock);
+    if (limiter->weight_limit == 0) {
+        if (http_code == 429 || http_code == 418) {
+            limiter->rejected++;
+        }
+        pthread_mutex_unlock(&limiter->lock);
+        return;
+    }
+
+    long long now = realtime_ms();
+    limiter->in_flight -= weight;
+    if (limiter->in_flight < 0) {
+        limiter->in_flight = 0;
+    }
+    roll_window(limiter, now);
+
+    if (http_code == 429 || http_code == 418) {
+        // Sending during Retry-After turns a 429 into an IP ban, so everything waits it out
+        limiter->rejected++;
+        long long until = retry_after_s >= 0 ? now + retry_after_s * 1000 : limiter->window_start_ms + limiter->window_ms;
+        if (until > limiter->blocked_until_ms) {
+            limiter->blocked_until_ms = until;
+        }
+        limiter->tokens = 0;
+        printf("Rate limited (HTTP %ld), pausing requests for %lld ms\n", http_code, until - now);
+    } else if (used_weight >= 0 && window == limiter->window_start_ms) {
+        // The server's count also includes other clients on this IP; when it is higher it wins
+        long left = (long)limiter->weight_limit - used_weight - limiter->in_flight;
+        if (left < limiter->tokens) {
+            limiter->tokens = (int)left;
+        }
+    }
+    pthread_cond_broadcast(&limiter->changed);
+    pthread_mutex_unlock(&limiter->lock);
+}
+
+void rate_limiter_destroy(RateLimiter *limiter) {
+    pthread_cond_destroy(&limiter->changed);
+    pthread_mutex_destroy(&limiter->lock);
+}
@@ -0,0 +1,230 @@
+// src/replay.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "replay.h"
+#include "capture_log.h"
+#include "ws_client.h"
+
+// Read buffer for the recording, large enough that max-speed replay is not bound by reads
+#define REPLAY_READ_BUFFER (1 << 20)
+#define REPLAY_END -2
+#define REPLAY_ERROR -3
+
+// Decode one kline history row; returns 1 with the close time, 0 for the header, -1 if malformed
+static int parse_kline_row(char *line, MarketData *tick, long long *event_ms) {
+    if (strncmp(line, "timestamp", 9) == 0) {
+        return 0;
+    }
+    // close is the 5th field, volume the 6th and close_time the 7th
+    char *fields[7];
+    char *field = line;
+    for (int i = 0; i < 7; i++) {
+        if (field == NULL) {
+            return -1;
+        }
+        fields[i] = field;
+        field = strchr(field, ',');
+        field = field ? field + 1 : NULL;
+    }
+    char *end;
+    memset(tick, 0, sizeof(*tick));
+    tick->price = strtod(fields[4], NULL);
+    tick->volume = strtod(fields[5], NULL);
+    *event_ms = strtoll(fields[6], &end, 10);
+    return end == fields[6] ? -1 : 1;
+}
+
+// Decode one stream message; returns 1 with its event time, 0 for messages that are not ticks, -1 if malformed
+static int parse_stream_line(const char *line, size_t length, MarketData *tick, long long *event_ms) {
+    int status = market_stream_parse(line, length, tick);
+    if (status <= 0) {
+        return status;
+    }
+    // Raw and combined streams both carry the event time as "E" ahead of any nested "E"
+    const char *field = strstr(line, "\"E\":");
+    if (field == NULL) {
+        return -1;
+    }
+    char *end;
+    *event_ms = strtoll(field + 4, &end, 10);
+    return end == field + 4 ? -1 : 1;
+}
+
+// Wait until due_ns on the monotonic clock, returning early once the replay is stopped
+static void wait_until(const ReplaySource *replay, long long due_ns) {
+    long long now;
+    while (*replay->running && (now = ws_monotonic_ns()) < due_ns - REPLAY_SPIN_US * 1000LL) {
+        long long step_ns = due_ns - REPLAY_SPIN_US * 1000LL - now;
+        if (step_ns > REPLAY_MAX_SLEEP_MS * 1000000LL) {
+            step_ns = REPLAY_MAX_SLEEP_MS * 1000000LL;
+        }
+        struct timespec step = {step_ns / 1000000000LL, step_ns % 1000000000LL};
+        nanosleep(&step, NULL);
+    }
+    while (*replay->running && ws_monotonic_ns() < due_ns) {
+    }
+}
+
+// The recording being replayed, in whichever layout its name says
+typedef struct {
+    ReplayFormat format;
+    FILE *file;
+    char *line;
+    size_t capacity;
+    CaptureReader capture;
+} ReplayInput;
+
+static ReplayFormat replay_format(const char *path) {
+    size_t length = strlen(path);
+    if (length > 4 && strcmp(path + length - 4, ".csv") == 0) {
+        return REPLAY_FORMAT_KLINE_CSV;
+    }
+    if (length > 4 && strcmp(path + length - 4, ".cap") == 0) {
+        return REPLAY_FORMAT_CAPTURE;
+    }
+    return REPLAY_FORMAT_STREAM_JSONL;
+}
+
+// Read the next record; returns 1 with a tick and its time in ns, 0 for records that are not
+// ticks, -1 if malformed, REPLAY_END once the recording is exhausted and REPLAY_ERROR if it
+// cannot be read any further
+static int next_record(ReplaySource *replay, ReplayInput *input, MarketData *tick, long long *event_ns) {
+    if (input->format == REPLAY_FORMAT_CAPTURE) {
+        CaptureRecordHeader record;
+        const char *message;
+        int status = capture_reader_next(&input->capture, &record, &message);
+        if (status <= 0) {
+            return status == 0 ? REPLAY_END : REPLAY_ERROR;
+        }
+        replay->records++;
+        // The receive time is what the feed saw, so the spacing is reproduced to the nanosecond
+        *event_ns = record.receive_ns;
+        return market_stream_parse(message, record.length, tick);
+    }
+
+    ssize_t length = getline(&input->line, &input->capacity, input->file);
+    if (length <= 0) {
+        return ferror(input->file) ? REPLAY_ERROR : REPLAY_END;
+    }
+    replay->records++;
+    char *line = input->line;
+    if (line[length - 1] == '\n') {
+        line[--length] = '\0';
+    }
+    if (length == 0) {
+        return 0;
+    }
+    long long event_ms = 0;
+    int status = input->format == REPLAY_FORMAT_KLINE_CSV ? parse_kline_row(line, tick, &event_ms)
+                                                          : parse_stream_line(line, (size_t)length, tick, &event_ms);
+    *event_ns = event_ms * 1000000LL;
+    return status;
+}
+
+int replay_run(ReplaySource *replay) {
+    // The counters describe this run only, so a source can be replayed again
+    replay->records = 0;
+    replay->ticks = 0;
+    replay->skipped = 0;
+    replay->recorded_ms = 0;
+    replay->elapsed_ns = 0;
+    replay->lag_ns_total = 0;
+    replay->lag_ns_max = 0;
+
+    ReplayInput input;
+    memset(&input, 0, sizeof(input));
+    input.format = replay_format(replay->path);
+    if (input.format == REPLAY_FORMAT_CAPTURE) {
+        if (capture_reader_open(&input.capture, replay->path) != 0) {
+            return -1;
+        }
+    } else {
+        input.file = fopen(replay->path, "r");
+        if (input.file == NULL) {
+            printf("Could not open replay file %s\n", replay->path);
+            return -1;
+        }
+        setvbuf(input.file, NULL, _IOFBF, REPLAY_READ_BUFFER);
+    }
+    if (replay->speed > 0) {
+        printf("Replaying %s at %gx the recorded pace\n", replay->path, replay->speed);
+    } else {
+        printf("Replaying %s at full speed\n", replay->path);
+    }
+
+    long long first_event_ns = 0;
+    long long first_ns = 0;
+    long long last_event_ns = 0;
+    bool first = true;
+    int result = 0;
+    while (*replay->running) {
+        MarketData tick;
+        long long event_ns = 0;
+        int status = next_record(replay, &input, &tick, &event_ns);
+        if (status == REPLAY_END) {
+            break;
+        }
+        if (status == REPLAY_ERROR) {
+            printf("Replay of %s stopped after %zu records: the recording is truncated or unreadable\n",
+                   replay->path, replay->records);
+            result = -1;
+            break;
+        }
+        if (status < 0) {
+            replay->skipped++;
+            continue;
+        }
+        if (status == 0) {
+            continue;
+        }
+
+        long long due_ns;
+        if (first) {
+            first = false;
+            first_event_ns = event_ns;
+            first_ns = ws_monotonic_ns();
+            due_ns = first_ns;
+        } else if (replay->speed > 0) {
+            // Event times that step backwards are due at once rather than rewinding the schedule
+            double offset_ns = (double)(event_ns - first_event_ns) / replay->speed;
+            due_ns = first_ns + (offset_ns > 0 ? (long long)offset_ns : 0);
+            wait_until(replay, due_ns);
+            if (!*replay->running) {
+                break;
+            }
+        } else {
+            due_ns = ws_monotonic_ns();
+        }
+
+        MarketData *data = (MarketData *)malloc(sizeof(MarketData));
+        if (data == NULL) {
+            break;
+        }
+        *data = tick;
+        long long lag = ws_monotonic_ns() - due_ns;
+        replay->on_tick(data, replay->userdata);
+
+        replay->ticks++;
+        replay->lag_ns_total += lag;
+        if (lag > replay->lag_ns_max) {
+            replay->lag_ns_max = lag;
+        }
+        last_event_ns = event_ns;
+    }
+    if (replay->ticks > 0) {
+        replay->recorded_ms = (last_event_ns - first_event_ns) / 1000000;
+        replay->elapsed_ns = ws_monotonic_ns() - first_ns;
+    }
+    if (input.format == REPLAY_FORMAT_CAPTURE) {
+        capture_reader_close(&input.capture);
+    } else {
+        free(input.line);
+        fclose(input.file);
+    }
+    printf("Replayed %zu ticks covering %lld ms in %.3f s, %zu records skipped\n",
+           replay->ticks, replay->recorded_ms, replay->elapsed_ns / 1e9, replay->skipped);
+    return result;
+}
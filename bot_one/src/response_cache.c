@@ -0,0 +1,249 @@
+// src/response_cache.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "response_cache.h"
+
+// Fixed-size start of every cache file; the key text, then the columns, follow
+typedef struct {
+    char magic[8];
+    uint32_t key_length;
+    uint32_t reserved;
+    uint64_t row_count;
+} CacheHeader;
+
+typedef struct {
+    char name[64];
+    struct timespec mtime;
+    off_t size;
+} CacheEntry;
+
+// List the cache entries in the directory with their sizes and ages, totalling their bytes
+static CacheEntry *list_entries(const ResponseCache *cache, size_t *count, size_t *total) {
+    CacheEntry *entries = NULL;
+    size_t capacity = 0;
+    *count = 0;
+    *total = 0;
+    DIR *dir = opendir(cache->dir);
+    if (dir == NULL) {
+        return NULL;
+    }
+
+    size_t suffix_length = strlen(RESPONSE_CACHE_SUFFIX);
+    struct dirent *dirent;
+    while ((dirent = readdir(dir)) != NULL) {
+        size_t name_length = strlen(dirent->d_name);
+        if (name_length <= suffix_length || name_length >= sizeof(entries->name) ||
+            strcmp(dirent->d_name + name_length - suffix_length, RESPONSE_CACHE_SUFFIX) != 0) {
+            continue;
+        }
+        char path[512];
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%s", cache->dir, dirent->d_name);
+        if (stat(path, &st) != 0) {
+            continue;
+        }
+        if (*count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            CacheEntry *grown = (CacheEntry *)realloc(entries, capacity * sizeof(CacheEntry));
+            if (grown == NULL) {
+                break;
+            }
+            entries = grown;
+        }
+        snprintf(entries[*count].name, sizeof(entries[*count].name), "%s", dirent->d_name);
+        entries[*count].mtime = st.st_mtim;
+        entries[*count].size = st.st_size;
+        *total += (size_t)st.st_size;
+        (*count)++;
+    }
+    closedir(dir);
+    return entries;
+}
+
+int response_cache_init(ResponseCache *cache, const char *dir, int max_mb) {
+    memset(cache, 0, sizeof(*cache));
+    if (max_mb <= 0 || dir == NULL || dir[0] == '\0') {
+        return 0;
+    }
+    snprintf(cache->dir, sizeof(cache->dir), "%s", dir);
+    cache->max_bytes = (size_t)max_mb * 1024 * 1024;
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        printf("Could not create cache directory %s: %s\n", dir, strerror(errno));
+        return -1;
+    }
+    cache->enabled = true;
+
+    // Entries left by earlier runs count against the cap from the start
+    size_t count;
+    free(list_entries(cache, &count, &cache->total_bytes));
+    return 0;
+}
+
+// Returns the key text's length, or -1 if it does not fit: a truncated key could collide
+static int key_text(const ResponseCacheKey *key, char *text, size_t text_size) {
+    int length = snprintf(text, text_size, "%s|%s|%s|%lld|%lld", key->endpoint, key->symbol, key->interval,
+                          key->start_time_ms, key->end_time_ms);
+    return length >= 0 && (size_t)length < text_size ? length : -1;
+}
+
+// FNV-1a of the key text names the file
+static void entry_path(const ResponseCache *cache, const char *text, char *path, size_t path_size) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char *p = text; *p; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 1099511628211ULL;
+    }
+    snprintf(path, path_size, "%s/%016llx%s", cache->dir, (unsigned long long)hash, RESPONSE_CACHE_SUFFIX);
+}
+
+static int read_full(int fd, void *buffer, size_t bytes) {
+    char *p = (char *)buffer;
+    while (bytes > 0) {
+        ssize_t n = read(fd, p, bytes);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        bytes -= (size_t)n;
+    }
+    return 0;
+}
+
+static int write_full(int fd, const void *buffer, size_t bytes) {
+    const char *p = (const char *)buffer;
+    while (bytes > 0) {
+        ssize_t n = write(fd, p, bytes);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        bytes -= (size_t)n;
+    }
+    return 0;
+}
+
+long response_cache_load(const ResponseCache *cache, const ResponseCacheKey *key, const KlineColumns *columns) {
+    if (!cache->enabled) {
+        return -1;
+    }
+    char text[RESPONSE_CACHE_KEY_MAX];
+    char path[512];
+    int text_length = key_text(key, text, sizeof(text));
+    if (text_length < 0) {
+        return -1;
+    }
+    entry_path(cache, text, path, sizeof(path));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    CacheHeader header;
+    char stored_key[RESPONSE_CACHE_KEY_MAX];
+    long rows = -1;
+    if (read_full(fd, &header, sizeof(header)) == 0 &&
+        memcmp(header.magic, RESPONSE_CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+        header.key_length == (uint32_t)text_length && header.row_count <= columns->capacity &&
+        read_full(fd, stored_key, header.key_length) == 0 && memcmp(stored_key, text, header.key_length) == 0) {
+        size_t n = (size_t)header.row_count;
+        if (read_full(fd, columns->open_times, n * sizeof(long long)) == 0 &&
+            read_full(fd, columns->close, n * sizeof(double)) == 0 &&
+            read_full(fd, columns->high, n * sizeof(double)) == 0 &&
+            read_full(fd, columns->low, n * sizeof(double)) == 0 &&
+            read_full(fd, columns->volume, n * sizeof(double)) == 0) {
+            rows = (long)n;
+            // A hit moves the entry to the young end of the LRU
+            futimens(fd, NULL);
+        }
+    }
+    close(fd);
+    return rows;
+}
+
+static int compare_mtime(const void *a, const void *b) {
+    const struct timespec *x = &((const CacheEntry *)a)->mtime;
+    const struct timespec *y = &((const CacheEntry *)b)->mtime;
+    if (x->tv_sec != y->tv_sec) {
+        return x->tv_sec < y->tv_sec ? -1 : 1;
+    }
+    return (x->tv_nsec > y->tv_nsec) - (x->tv_nsec < y->tv_nsec);
+}
+
+// Rescan the directory and remove least recently used entries until it fits in max_bytes
+static void evict(ResponseCache *cache) {
+    size_t count, total;
+    CacheEntry *entries = list_entries(cache, &count, &total);
+    if (total > cache->max_bytes) {
+        qsort(entries, count, sizeof(CacheEntry), compare_mtime);
+        for (size_t i = 0; i < count && total > cache->max_bytes; i++) {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/%s", cache->dir, entries[i].name);
+            if (unlink(path) == 0) {
+                total -= (size_t)entries[i].size;
+            }
+        }
+    }
+    cache->total_bytes = total;
+    free(entries);
+}
+
+int response_cache_store(ResponseCache *cache, const ResponseCacheKey *key, const KlineColumns *columns, size_t row_count) {
+    if (!cache->enabled) {
+        return 0;
+    }
+    char text[RESPONSE_CACHE_KEY_MAX];
+    char path[512];
+    char temp_path[560];
+    int text_length = key_text(key, text, sizeof(text));
+    if (text_length < 0) {
+        return 0;
+    }
+    entry_path(cache, text, path, sizeof(path));
+    snprintf(temp_path, sizeof(temp_path), "%s.%ld.tmp", path, (long)getpid());
+
+    CacheHeader header = {.key_length = (uint32_t)text_length, .row_count = row_count};
+    memcpy(header.magic, RESPONSE_CACHE_MAGIC, sizeof(header.magic));
+
+    // Written to a temporary name and renamed, so readers never see a partial entry
+    int fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        printf("Could not write cache entry %s: %s\n", temp_path, strerror(errno));
+        return -1;
+    }
+    int status = write_full(fd, &header, sizeof(header)) == 0 &&
+                 write_full(fd, text, (size_t)text_length) == 0 &&
+                 write_full(fd, columns->open_times, row_count * sizeof(long long)) == 0 &&
+                 write_full(fd, columns->close, row_count * sizeof(double)) == 0 &&
+                 write_full(fd, columns->high, row_count * sizeof(double)) == 0 &&
+                 write_full(fd, columns->low, row_count * sizeof(double)) == 0 &&
+                 write_full(fd, columns->volume, row_count * sizeof(double)) == 0 ? 0 : -1;
+    // An entry stored again under the same key replaces the old file's bytes
+    struct stat replaced;
+    size_t replaced_size = stat(path, &replaced) == 0 ? (size_t)replaced.st_size : 0;
+    if (close(fd) != 0 || status != 0 || rename(temp_path, path) != 0) {
+        unlink(temp_path);
+        return -1;
+    }
+
+    size_t entry_size = sizeof(header) + (size_t)text_length + row_count * (sizeof(long long) + 4 * sizeof(double));
+    cache->total_bytes = cache->total_bytes + entry_size > replaced_size ? cache->total_bytes + entry_size - replaced_size : 0;
+    if (cache->total_bytes > cache->max_bytes) {
+        evict(cache);
+    }
+    return 0;
+}
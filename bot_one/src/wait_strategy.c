@@ -0,0 +1,106 @@
+// src/wait_strategy.c
+
+// syscall() is needed for futex, which has no libc wrapper
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "wait_strategy.h"
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ volatile("yield");
+#endif
+}
+
+static bool still_running(const int *running) {
+    return *(const volatile int *)running != 0;
+}
+
+void wait_strategy_init(WaitStrategy *wait, WaitMode mode) {
+    memset(wait, 0, sizeof(*wait));
+    wait->mode = mode;
+    atomic_init(&wait->epoch, 0);
+    atomic_init(&wait->parked, 0);
+    atomic_init(&wait->wakes, 0);
+}
+
+bool wait_strategy_wait(WaitStrategy *wait, bool (*ready)(void *), void *arg, const int *running) {
+    // Every mode starts by polling; items usually arrive within a few microseconds under load
+    for (int spins = 0; wait->mode == WAIT_MODE_SPIN || spins < WAIT_SPIN_LIMIT; spins++) {
+        if (ready(arg)) {
+            return true;
+        }
+        if (!still_running(running)) {
+            return false;
+        }
+        cpu_relax();
+    }
+
+    while (still_running(running)) {
+        if (wait->mode == WAIT_MODE_YIELD) {
+            if (ready(arg)) {
+                return true;
+            }
+            sched_yield();
+            continue;
+        }
+
+        // Announce the park before the final check. A producer publishes its item and then
+        // looks at parked, so either this check sees the item or the producer sees the park
+        unsigned int epoch = atomic_load(&wait->epoch);
+        atomic_store(&wait->parked, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (ready(arg) || !still_running(running)) {
+            atomic_store(&wait->parked, 0);
+            break;
+        }
+        wait->parks++;
+        // Returns at once if a wake-up bumped the epoch since it was read
+        struct timespec timeout = {0, WAIT_PARK_TIMEOUT_MS * 1000000L};
+        syscall(SYS_futex, &wait->epoch, FUTEX_WAIT_PRIVATE, epoch, &timeout, NULL, 0);
+        atomic_store(&wait->parked, 0);
+    }
+    return ready(arg);
+}
+
+void wait_strategy_notify(WaitStrategy *wait) {
+    if (wait->mode != WAIT_MODE_PARK) {
+        return;
+    }
+    // Pairs with the fence in wait_strategy_wait: the item is visible before parked is read
+    atomic_thread_fence(memory_order_seq_cst);
+    // The producer that clears the flag makes the one wake-up this park needs; pushes made
+    // before the consumer is back on a core find it clear and stay in user space
+    if (atomic_load_explicit(&wait->parked, memory_order_relaxed) && atomic_exchange(&wait->parked, 0)) {
+        atomic_fetch_add(&wait->epoch, 1);
+        atomic_fetch_add_explicit(&wait->wakes, 1, memory_order_relaxed);
+        syscall(SYS_futex, &wait->epoch, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+}
+
+void wait_strategy_wake_all(WaitStrategy *wait) {
+    atomic_fetch_add(&wait->epoch, 1);
+    syscall(SYS_futex, &wait->epoch, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+int wait_mode_parse(const char *name, WaitMode *mode) {
+    if (strcmp(name, "spin") == 0) {
+        *mode = WAIT_MODE_SPIN;
+    } else if (strcmp(name, "yield") == 0) {
+        *mode = WAIT_MODE_YIELD;
+    } else if (strcmp(name, "park") == 0) {
+        *mode = WAIT_MODE_PARK;
+    } else {
+        printf("Unknown wait strategy %s, expected spin, yield or park\n", name);
+        return -1;
+    }
+    return 0;
+}
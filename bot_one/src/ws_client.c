@@ -0,0 +1,545 @@
+// src/ws_client.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <poll.h>
+#include "ws_client.h"
+
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+// Free space kept at the end of the receive buffer before each read
+#define WS_READ_CHUNK 4096
+
+#define ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+long long ws_monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// SHA-1 of a message shorter than 120 bytes, which is all the handshake needs
+static void sha1_short(const unsigned char *data, size_t length, unsigned char digest[20]) {
+    unsigned char message[128] = {0};
+    size_t padded = length + 9 <= 64 ? 64 : 128;
+    memcpy(message, data, length);
+    message[length] = 0x80;
+    uint64_t bits = (uint64_t)length * 8;
+    for (int i = 0; i < 8; i++) {
+        message[padded - 1 - i] = (unsigned char)(bits >> (8 * i));
+    }
+
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    for (size_t chunk = 0; chunk < padded; chunk += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            const unsigned char *p = message + chunk + 4 * i;
+            w[i] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+        }
+        for (int i = 16; i < 80; i++) {
+            w[i] = ROTL(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t temp = ROTL(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = ROTL(b, 30);
+            b = a;
+            a = temp;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+
+    for (int i = 0; i < 5; i++) {
+        digest[4 * i] = (unsigned char)(h[i] >> 24);
+        digest[4 * i + 1] = (unsigned char)(h[i] >> 16);
+        digest[4 * i + 2] = (unsigned char)(h[i] >> 8);
+        digest[4 * i + 3] = (unsigned char)h[i];
+    }
+}
+
+static void base64_encode(const unsigned char *data, size_t length, char *out) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t o = 0;
+    for (size_t i = 0; i < length; i += 3) {
+        uint32_t v = (uint32_t)data[i] << 16;
+        if (i + 1 < length) v |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < length) v |= data[i + 2];
+        out[o++] = alphabet[(v >> 18) & 63];
+        out[o++] = alphabet[(v >> 12) & 63];
+        out[o++] = i + 1 < length ? alphabet[(v >> 6) & 63] : '=';
+        out[o++] = i + 2 < length ? alphabet[v & 63] : '=';
+    }
+    out[o] = '\0';
+}
+
+static uint32_t next_random(WsClient *client) {
+    uint32_t x = client->mask_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    client->mask_state = x;
+    return x;
+}
+
+static void seed_random(WsClient *client) {
+    uint32_t seed = 0;
+    FILE *urandom = fopen("/dev/urandom", "rb");
+    if (urandom) {
+        if (fread(&seed, sizeof(seed), 1, urandom) != 1) {
+            seed = 0;
+        }
+        fclose(urandom);
+    }
+    seed ^= (uint32_t)ws_monotonic_ns();
+    client->mask_state = seed ? seed : 0x9E3779B9u;
+}
+
+// Wait until the socket is ready for events; returns 1 if ready, 0 on timeout, -1 on error
+static int wait_socket(WsClient *client, short events, int timeout_ms) {
+    struct pollfd fd = {.fd = (int)client->socket, .events = events};
+    int ready = poll(&fd, 1, timeout_ms);
+    if (ready > 0 && (fd.revents & (POLLERR | POLLNVAL))) {
+        return -1;
+    }
+    return ready < 0 ? -1 : ready;
+}
+
+static int send_all(WsClient *client, const char *data, size_t length) {
+    while (length > 0) {
+        size_t sent = 0;
+        CURLcode res = curl_easy_send(client->easy, data, length, &sent);
+        if (res == CURLE_AGAIN) {
+            if (wait_socket(client, POLLOUT, WS_HANDSHAKE_TIMEOUT_MS) <= 0) {
+                return -1;
+            }
+            continue;
+        }
+        if (res != CURLE_OK) {
+            printf("WebSocket send failed: %s\n", curl_easy_strerror(res));
+            return -1;
+        }
+        data += sent;
+        length -= sent;
+    }
+    return 0;
+}
+
+// Read everything the connection has ready; returns bytes read (0 if none yet) or -1 if the peer closed
+static long receive(WsClient *client) {
+    long total = 0;
+    for (;;) {
+        if (client->buffer_capacity - client->buffer_length < WS_READ_CHUNK) {
+            size_t capacity = client->buffer_capacity * 2;
+            char *grown = (char *)realloc(client->buffer, capacity);
+            if (!grown) {
+                return -1;
+            }
+            client->buffer = grown;
+            client->buffer_capacity = capacity;
+        }
+
+        size_t n = 0;
+        CURLcode res = curl_easy_recv(client->easy, client->buffer + client->buffer_length,
+                                      client->buffer_capacity - client->buffer_length, &n);
+        if (res == CURLE_AGAIN) {
+            return total;
+        }
+        if (res != CURLE_OK || n == 0) {
+            if (res != CURLE_OK) {
+                printf("WebSocket receive failed: %s\n", curl_easy_strerror(res));
+            }
+            client->closed = true;
+            return total > 0 ? total : -1;
+        }
+        client->buffer_length += n;
+        client->received_ns = ws_monotonic_ns();
+        total += (long)n;
+    }
+}
+
+static void consume(WsClient *client, size_t bytes) {
+    memmove(client->buffer, client->buffer + bytes, client->buffer_length - bytes);
+    client->buffer_length -= bytes;
+}
+
+static int append_fragment(WsClient *client, const char *payload, size_t length) {
+    if (client->message_length + length > WS_MAX_MESSAGE) {
+        printf("WebSocket message exceeds %d bytes\n", WS_MAX_MESSAGE);
+        return -1;
+    }
+    if (client->message_length + length > client->message_capacity) {
+        size_t capacity = client->message_capacity ? client->message_capacity : WS_READ_CHUNK;
+        while (capacity < client->message_length + length) {
+            capacity *= 2;
+        }
+        char *grown = (char *)realloc(client->message, capacity);
+        if (!grown) {
+            return -1;
+        }
+        client->message = grown;
+        client->message_capacity = capacity;
+    }
+    memcpy(client->message + client->message_length, payload, length);
+    client->message_length += length;
+    return 0;
+}
+
+// Deliver every complete frame in the buffer; unfragmented messages are handed over in place
+static int parse_frames(WsClient *client, WsMessageHandler handler, void *userdata) {
+    int delivered = 0;
+    size_t offset = 0;
+
+    while (!client->closed) {
+        const unsigned char *frame = (const unsigned char *)client->buffer + offset;
+        size_t available = client->buffer_length - offset;
+        if (available < 2) {
+            break;
+        }
+
+        bool fin = frame[0] & 0x80;
+        int opcode = frame[0] & 0x0F;
+        bool masked = frame[1] & 0x80;
+        uint64_t length = frame[1] & 0x7F;
+        size_t header = 2;
+        if (length == 126) {
+            if (available < 4) {
+                break;
+            }
+            length = (uint64_t)frame[2] << 8 | frame[3];
+            header = 4;
+        } else if (length == 127) {
+            if (available < 10) {
+                break;
+            }
+            length = 0;
+            for (int i = 0; i < 8; i++) {
+                length = length << 8 | frame[2 + i];
+            }
+            header = 10;
+        }
+        if (length > WS_MAX_MESSAGE) {
+            printf("WebSocket frame of %llu bytes exceeds %d\n", (unsigned long long)length, WS_MAX_MESSAGE);
+            return -1;
+        }
+        size_t mask_offset = header;
+        if (masked) {
+            header += 4;
+        }
+        if (available < header + length) {
+            break;
+        }
+
+        char *payload = client->buffer + offset + header;
+        if (masked) {
+            // Servers should not mask, but a masked frame is still decoded rather than rejected
+            const unsigned char *mask = frame + mask_offset;
+            for (size_t i = 0; i < length; i++) {
+                payload[i] ^= (char)mask[i & 3];
+            }
+        }
+
+        switch (opcode) {
+        case WS_OPCODE_TEXT:
+        case WS_OPCODE_BINARY:
+            if (client->in_fragmented_message) {
+                printf("WebSocket data frame interleaved with a fragmented message\n");
+                return -1;
+            }
+            if (fin) {
+                handler(payload, (size_t)length, userdata);
+                delivered++;
+            } else {
+                client->message_length = 0;
+                client->in_fragmented_message = true;
+                if (append_fragment(client, payload, (size_t)length) != 0) {
+                    return -1;
+                }
+            }
+            break;
+        case WS_OPCODE_CONTINUATION:
+            if (!client->in_fragmented_message || append_fragment(client, payload, (size_t)length) != 0) {
+                return -1;
+            }
+            if (fin) {
+                handler(client->message, client->message_length, userdata);
+                client->in_fragmented_message = false;
+                delivered++;
+            }
+            break;
+        case WS_OPCODE_PING:
+            if (ws_client_send(client, WS_OPCODE_PONG, payload, (size_t)length) != 0) {
+                return -1;
+            }
+            break;
+        case WS_OPCODE_PONG:
+            break;
+        case WS_OPCODE_CLOSE:
+            // Echo the status code back, completing the closing handshake
+            ws_client_send(client, WS_OPCODE_CLOSE, payload, length >= 2 ? 2 : 0);
+            client->closed = true;
+            break;
+        default:
+            printf("WebSocket frame with unknown opcode %d\n", opcode);
+            return -1;
+        }
+        offset += header + (size_t)length;
+    }
+
+    consume(client, offset);
+    return delivered;
+}
+
+// Find the end of the HTTP response head in the buffer
+static size_t find_header_end(const WsClient *client) {
+    for (size_t i = 3; i < client->buffer_length; i++) {
+        if (memcmp(client->buffer + i - 3, "\r\n\r\n", 4) == 0) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+static int check_handshake(const char *head, const char *expected_accept) {
+    if (strncmp(head, "HTTP/1.1 101", 12) != 0) {
+        const char *line_end = strstr(head, "\r\n");
+        printf("WebSocket upgrade refused: %.*s\n", line_end ? (int)(line_end - head) : 32, head);
+        return -1;
+    }
+    for (const char *line = strstr(head, "\r\n"); line && line[2] != '\r'; line = strstr(line + 2, "\r\n")) {
+        const char *name = line + 2;
+        if (strncasecmp(name, "Sec-WebSocket-Accept:", 21) == 0) {
+            const char *value = name + 21;
+            while (*value == ' ') {
+                value++;
+            }
+            size_t n = strlen(expected_accept);
+            if (strncmp(value, expected_accept, n) == 0 && (value[n] == '\r' || value[n] == ' ')) {
+                return 0;
+            }
+            break;
+        }
+    }
+    printf("WebSocket upgrade has a missing or wrong Sec-WebSocket-Accept\n");
+    return -1;
+}
+
+int ws_client_connect(WsClient *client, const char *url) {
+    memset(client, 0, sizeof(*client));
+    client->socket = CURL_SOCKET_BAD;
+
+    // ws:// and wss:// become http:// and https:// so libcurl sets up TCP and TLS
+    const char *scheme_end = strstr(url, "://");
+    bool secure = strncmp(url, "wss://", 6) == 0;
+    if (!scheme_end || (!secure && strncmp(url, "ws://", 5) != 0)) {
+        printf("Unsupported WebSocket URL %s\n", url);
+        return -1;
+    }
+    const char *authority = scheme_end + 3;
+    const char *path = strchr(authority, '/');
+    int authority_length = path ? (int)(path - authority) : (int)strlen(authority);
+    if (!path) {
+        path = "/";
+    }
+    char http_url[512];
+    snprintf(http_url, sizeof(http_url), "%s://%.*s/", secure ? "https" : "http", authority_length, authority);
+
+    seed_random(client);
+    client->buffer = (char *)malloc(WS_BUFFER_RESERVE);
+    client->buffer_capacity = WS_BUFFER_RESERVE;
+    client->easy = curl_easy_init();
+    if (!client->buffer || !client->easy) {
+        client->closed = true;
+        ws_client_close(client);
+        return -1;
+    }
+
+    CURL *easy = client->easy;
+    curl_easy_setopt(easy, CURLOPT_URL, http_url);
+    curl_easy_setopt(easy, CURLOPT_CONNECT_ONLY, 1L);
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(easy, CURLOPT_TCP_NODELAY, 1L);
+    curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, (long)WS_HANDSHAKE_TIMEOUT_MS);
+    CURLcode res = curl_easy_perform(easy);
+    if (res == CURLE_OK) {
+        res = curl_easy_getinfo(easy, CURLINFO_ACTIVESOCKET, &client->socket);
+    }
+    if (res != CURLE_OK || client->socket == CURL_SOCKET_BAD) {
+        printf("WebSocket connect to %s failed: %s\n", url, curl_easy_strerror(res));
+        client->closed = true;
+        ws_client_close(client);
+        return -1;
+    }
+
+    // Opening handshake
+    unsigned char nonce[16];
+    for (int i = 0; i < 16; i += 4) {
+        uint32_t r = next_random(client);
+        memcpy(nonce + i, &r, 4);
+    }
+    char key[32];
+    base64_encode(nonce, sizeof(nonce), key);
+
+    char request[1024];
+    int request_length = snprintf(request, sizeof(request),
+        "GET %s HTTP/1.1\r\nHost: %.*s\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        "Sec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n\r\n",
+        path, authority_length, authority, key);
+
+    char accept_input[64];
+    unsigned char digest[20];
+    char expected_accept[32];
+    int accept_length = snprintf(accept_input, sizeof(accept_input), "%s%s", key, WS_GUID);
+    sha1_short((const unsigned char *)accept_input, (size_t)accept_length, digest);
+    base64_encode(digest, sizeof(digest), expected_accept);
+
+    if (request_length <= 0 || (size_t)request_length >= sizeof(request) ||
+        send_all(client, request, (size_t)request_length) != 0) {
+        client->closed = true;
+        ws_client_close(client);
+        return -1;
+    }
+
+    long long deadline = ws_monotonic_ns() + WS_HANDSHAKE_TIMEOUT_MS * 1000000LL;
+    size_t head_length = 0;
+    while ((head_length = find_header_end(client)) == 0) {
+        long long remaining_ms = (deadline - ws_monotonic_ns()) / 1000000;
+        if (receive(client) < 0 || remaining_ms <= 0 ||
+            (find_header_end(client) == 0 && wait_socket(client, POLLIN, (int)remaining_ms) < 0)) {
+            printf("WebSocket handshake with %s failed\n", url);
+            client->closed = true;
+            ws_client_close(client);
+            return -1;
+        }
+    }
+
+    char head[2048];
+    size_t copy = head_length < sizeof(head) ? head_length : sizeof(head) - 1;
+    memcpy(head, client->buffer, copy);
+    head[copy] = '\0';
+    // Bytes after the head are already frames and stay in the buffer
+    consume(client, head_length);
+    if (check_handshake(head, expected_accept) != 0) {
+        client->closed = true;
+        ws_client_close(client);
+        return -1;
+    }
+    return 0;
+}
+
+int ws_client_poll(WsClient *client, int timeout_ms, WsMessageHandler handler, void *userdata) {
+    if (client->closed) {
+        return -1;
+    }
+    int delivered = parse_frames(client, handler, userdata);
+    if (delivered != 0) {
+        return delivered;
+    }
+
+    long long deadline = ws_monotonic_ns() + (long long)timeout_ms * 1000000LL;
+    for (;;) {
+        // Drain the connection before polling, so bytes libcurl already decrypted are not missed
+        long received = receive(client);
+        if (received < 0) {
+            return -1;
+        }
+        if (received > 0) {
+            delivered = parse_frames(client, handler, userdata);
+            if (delivered != 0) {
+                return delivered;
+            }
+            if (client->closed) {
+                return -1;
+            }
+            continue;
+        }
+
+        long long remaining_ms = (deadline - ws_monotonic_ns() + 999999) / 1000000;
+        if (remaining_ms <= 0) {
+            return 0;
+        }
+        if (wait_socket(client, POLLIN, (int)remaining_ms) < 0) {
+            return -1;
+        }
+    }
+}
+
+int ws_client_send(WsClient *client, WsOpcode opcode, const char *payload, size_t length) {
+    char stack_frame[512];
+    size_t header = length < 126 ? 6 : length <= 0xFFFF ? 8 : 14;
+    char *frame = header + length <= sizeof(stack_frame) ? stack_frame : (char *)malloc(header + length);
+    if (!frame) {
+        return -1;
+    }
+
+    // Client frames are always masked (RFC 6455 section 5.3)
+    frame[0] = (char)(0x80 | opcode);
+    if (length < 126) {
+        frame[1] = (char)(0x80 | length);
+    } else if (length <= 0xFFFF) {
+        frame[1] = (char)(0x80 | 126);
+        frame[2] = (char)(length >> 8);
+        frame[3] = (char)length;
+    } else {
+        frame[1] = (char)(0x80 | 127);
+        for (int i = 0; i < 8; i++) {
+            frame[2 + i] = (char)((uint64_t)length >> (56 - 8 * i));
+        }
+    }
+    uint32_t mask_word = next_random(client);
+    unsigned char mask[4];
+    memcpy(mask, &mask_word, 4);
+    memcpy(frame + header - 4, mask, 4);
+    for (size_t i = 0; i < length; i++) {
+        frame[header + i] = (char)(payload[i] ^ mask[i & 3]);
+    }
+
+    int status = send_all(client, frame, header + length);
+    if (frame != stack_frame) {
+        free(frame);
+    }
+    return status;
+}
+
+void ws_client_close(WsClient *client) {
+    if (client->easy) {
+        if (!client->closed) {
+            // Normal closure, status 1000
+            const char status[2] = {(char)0x03, (char)0xE8};
+            ws_client_send(client, WS_OPCODE_CLOSE, status, sizeof(status));
+            client->closed = true;
+        }
+        curl_easy_cleanup(client->easy);
+        client->easy = NULL;
+    }
+    free(client->buffer);
+    free(client->message);
+    client->buffer = NULL;
+    client->message = NULL;
+    client->buffer_length = client->buffer_capacity = 0;
+    client->message_length = client->message_capacity = 0;
+    client->socket = CURL_SOCKET_BAD;
+}
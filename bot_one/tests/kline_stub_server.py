@@ -0,0 +1,146 @@
+# Local stand-in for the Binance REST API used by the fetcher tests.
+# Serves deterministic 1m klines from /api/v3/klines, honouring startTime,
+# endTime and limit, so results can be checked bar by bar.
+#
+# Like Binance it charges REQUEST_WEIGHT per fixed window, reports the weight used so far in
+# X-MBX-USED-WEIGHT-1M, answers requests over the limit with 429 and Retry-After, and bans
+# clients that keep sending during Retry-After with 418. GET /stats returns the counters.
+#
+# Usage: python3 tests/kline_stub_server.py PORT [LATENCY_MS] [FAIL_EVERY] [WEIGHT_LIMIT] [WINDOW_MS]
+#   LATENCY_MS    delay added to every response, to make round trips visible
+#   FAIL_EVERY    answer every Nth request with HTTP 503 to exercise retries
+#   WEIGHT_LIMIT  weight allowed per window, 0 (the default) never rejects
+#   WINDOW_MS     length of the weight window, 60000 like Binance unless shortened for tests
+import json
+import math
+import sys
+import threading
+import time
+import urllib.parse
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+INTERVAL_MS = 60000
+FIRST_OPEN_MS = 1609459200000  # 1 Jan 2021
+KLINES_WEIGHT = 2
+# Requests sent during Retry-After that turn a 429 into a ban
+BAN_AFTER_VIOLATIONS = 10
+
+
+# Close price of the bar opening at open_ms; tests recompute this to check the data
+def close_price(open_ms):
+    return 100 + (open_ms // INTERVAL_MS) % 97 + 0.5
+
+
+def kline(open_ms):
+    close = close_price(open_ms)
+    return [open_ms, '%.8f' % (close - 0.5), '%.8f' % (close + 0.5), '%.8f' % (close - 1.5),
+            '%.8f' % close, '1.00000000', open_ms + INTERVAL_MS - 1, '%.8f' % (close * 1.0),
+            7, '0.50000000', '%.8f' % (close * 0.5), '0']
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+    disable_nagle_algorithm = True  # headers and body go out in separate writes
+    latency = 0.0
+    fail_every = 0
+    weight_limit = 0
+    window_ms = 60000
+    requests = 0
+    lock = threading.Lock()
+    window = -1
+    used_weight = 0
+    retry_until_ms = 0
+    banned_until_ms = 0
+    violations = 0
+    stats = {'requests': 0, 'weight': 0, 'rejected_429': 0, 'rejected_418': 0}
+
+    def log_message(self, *args):
+        pass
+
+    def send_json(self, status, payload, headers=()):
+        body = json.dumps(payload, separators=(',', ':')).encode()
+        self.send_response(status)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(body)))
+        for name, value in headers:
+            self.send_header(name, value)
+        self.end_headers()
+        self.wfile.write(body)
+
+    # Charge weight to the current window; returns (status, used weight, retry after seconds)
+    @staticmethod
+    def charge(weight):
+        now_ms = int(time.time() * 1000)
+        window = now_ms // Handler.window_ms
+        window_end_ms = (window + 1) * Handler.window_ms
+        with Handler.lock:
+            Handler.stats['requests'] += 1
+            if window != Handler.window:
+                Handler.window = window
+                Handler.used_weight = 0
+            if now_ms < Handler.banned_until_ms:
+                Handler.stats['rejected_418'] += 1
+                return 418, Handler.used_weight, math.ceil((Handler.banned_until_ms - now_ms) / 1000)
+            if now_ms < Handler.retry_until_ms:
+                Handler.violations += 1
+                if Handler.violations >= BAN_AFTER_VIOLATIONS:
+                    Handler.banned_until_ms = now_ms + 2 * Handler.window_ms
+                    Handler.stats['rejected_418'] += 1
+                    return 418, Handler.used_weight, math.ceil(2 * Handler.window_ms / 1000)
+            Handler.used_weight += weight
+            Handler.stats['weight'] += weight
+            if Handler.weight_limit and Handler.used_weight > Handler.weight_limit:
+                Handler.retry_until_ms = window_end_ms
+                Handler.stats['rejected_429'] += 1
+                return 429, Handler.used_weight, math.ceil((window_end_ms - now_ms) / 1000)
+            return 200, Handler.used_weight, 0
+
+    def do_GET(self):
+        url = urllib.parse.urlparse(self.path)
+        query = dict(urllib.parse.parse_qsl(url.query))
+        with Handler.lock:
+            Handler.requests += 1
+            count = Handler.requests
+        time.sleep(Handler.latency)
+
+        if url.path == '/stats':
+            with Handler.lock:
+                self.send_json(200, Handler.stats)
+            return
+        if url.path != '/api/v3/klines':
+            self.send_json(404, {'code': -1, 'msg': 'not found'})
+            return
+        status, used, retry_after = Handler.charge(KLINES_WEIGHT)
+        weight_header = ('X-MBX-USED-WEIGHT-1M', str(used))
+        if status != 200:
+            self.send_json(status, {'code': -1003, 'msg': 'Too many requests'},
+                           [weight_header, ('Retry-After', str(retry_after))])
+            return
+        if Handler.fail_every and count % Handler.fail_every == 0:
+            self.send_json(503, {'code': -1001, 'msg': 'Service unavailable'}, [weight_header])
+            return
+
+        now_ms = int(time.time() * 1000)
+        start = max(int(query.get('startTime', FIRST_OPEN_MS)), FIRST_OPEN_MS)
+        start = (start + INTERVAL_MS - 1) // INTERVAL_MS * INTERVAL_MS
+        end = int(query.get('endTime', now_ms))
+        limit = min(int(query.get('limit', 500)), 1000)
+
+        rows = []
+        open_ms = start
+        while open_ms <= end and open_ms <= now_ms and len(rows) < limit:
+            rows.append(kline(open_ms))
+            open_ms += INTERVAL_MS
+        self.send_json(200, rows, [weight_header])
+
+
+if __name__ == '__main__':
+    port = int(sys.argv[1]) if len(sys.argv) > 1 else 18080
+    Handler.latency = (int(sys.argv[2]) if len(sys.argv) > 2 else 0) / 1000.0
+    Handler.fail_every = int(sys.argv[3]) if len(sys.argv) > 3 else 0
+    Handler.weight_limit = int(sys.argv[4]) if len(sys.argv) > 4 else 0
+    Handler.window_ms = int(sys.argv[5]) if len(sys.argv) > 5 else 60000
+    server = ThreadingHTTPServer(('127.0.0.1', port), Handler)
+    server.daemon_threads = True
+    print(f'kline stub listening on {port}', flush=True)
+    server.serve_forever()
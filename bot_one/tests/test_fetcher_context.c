@@ -0,0 +1,81 @@
+// tests/test_fetcher_context.c
+// Polls tests/kline_stub_server.py repeatedly through a FetcherContext and checks that
+// only the first request opens a connection, then compares steady-state latency with
+// a fresh easy handle per request (the old fetch_data behaviour).
+//
+// Usage: ./bin/test_fetcher_context http://127.0.0.1:18080
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "fetcher_context.h"
+
+#define POLL_COUNT 200
+#define POLL_PATH "/api/v3/klines?symbol=BTCUSDT&interval=1m&startTime=1609459200000&limit=1"
+#define POLL_WEIGHT 2
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static size_t discard(void *contents, size_t size, size_t nmemb, void *userp) {
+    (void)contents;
+    (void)userp;
+    return size * nmemb;
+}
+
+int main(int argc, char *argv[]) {
+    const char *base_url = argc > 1 ? argv[1] : "http://127.0.0.1:18080";
+    char url[512];
+    snprintf(url, sizeof(url), "%s%s", base_url, POLL_PATH);
+
+    // Old behaviour: global init, new handle, new connection, teardown on every request
+    double start = now_seconds();
+    for (int i = 0; i < POLL_COUNT; i++) {
+        curl_global_init(CURL_GLOBAL_DEFAULT);
+        CURL *easy = curl_easy_init();
+        curl_easy_setopt(easy, CURLOPT_URL, url);
+        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, discard);
+        curl_easy_perform(easy);
+        curl_easy_cleanup(easy);
+        curl_global_cleanup();
+    }
+    double fresh_seconds = now_seconds() - start;
+
+    // New behaviour: main() initializes libcurl once and the context keeps its handles
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    FetcherContext *context = fetcher_context_create(base_url, 2);
+    if (context == NULL) {
+        return 1;
+    }
+
+    long connects = 0;
+    int failures = 0;
+    start = now_seconds();
+    for (int i = 0; i < POLL_COUNT; i++) {
+        FetcherConnection *connection = fetcher_acquire(context);
+        if (fetcher_get(context, connection, POLL_PATH, REQUEST_PRIORITY_LIVE, POLL_WEIGHT) != 0 || connection->body.size == 0) {
+            failures++;
+        }
+        long opened = 0;
+        curl_easy_getinfo(connection->easy, CURLINFO_NUM_CONNECTS, &opened);
+        connects += opened;
+        fetcher_release(context, connection);
+    }
+    double pooled_seconds = now_seconds() - start;
+    fetcher_context_destroy(context);
+
+    printf("fresh handle per request: %8.3f ms/request\n", fresh_seconds * 1e3 / POLL_COUNT);
+    printf("pooled context:           %8.3f ms/request, %ld connection(s) opened for %d requests\n",
+           pooled_seconds * 1e3 / POLL_COUNT, connects, POLL_COUNT);
+
+    if (failures || connects != 1) {
+        printf("FAIL: %d failed requests, expected exactly one new connection\n", failures);
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,194 @@
+// tests/test_kline_parser.c
+// Checks the streaming kline parser against cJSON on a generated 1000-row response, split at
+// every possible chunk boundary, then compares parse throughput of the two.
+//
+// Usage: ./bin/test_kline_parser
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "kline_parser.h"
+#include "kline_backfill.h"
+#include "cJSON.h"
+
+#define BENCH_ROUNDS 200
+
+typedef struct {
+    long long open_times[KLINE_PAGE_LIMIT];
+    double open[KLINE_PAGE_LIMIT];
+    double high[KLINE_PAGE_LIMIT];
+    double low[KLINE_PAGE_LIMIT];
+    double close[KLINE_PAGE_LIMIT];
+    double volume[KLINE_PAGE_LIMIT];
+    size_t count;
+} Klines;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Build a response shaped like /api/v3/klines, with prices of varying magnitude and precision
+static size_t build_response(char *out, size_t out_size) {
+    size_t length = (size_t)snprintf(out, out_size, "[");
+    long long open_ms = 1609459200000LL;
+    for (int i = 0; i < KLINE_PAGE_LIMIT; i++, open_ms += 60000) {
+        double base = i % 3 == 0 ? 29000.0 + i * 0.37 : i % 3 == 1 ? 0.000123 * (i + 1) : 1.5e3 + i;
+        length += (size_t)snprintf(out + length, out_size - length,
+            "%s[%lld,\"%.8f\",\"%.8f\",\"%.8f\",\"%.8f\",\"%.8f\",%lld,\"%.8f\",%d,\"%.8f\",\"%.8f\",\"0\"]",
+            i ? "," : "", open_ms, base, base * 1.01, base * 0.99, base * 1.001, 12.5 + i / 7.0,
+            open_ms + 59999, base * 3.3, 100 + i, 6.25, base * 1.6);
+    }
+    length += (size_t)snprintf(out + length, out_size - length, "]");
+    return length;
+}
+
+static double field_number(cJSON *kline, int index) {
+    cJSON *field = cJSON_GetArrayItem(kline, index);
+    return cJSON_IsString(field) ? atof(field->valuestring) : field->valuedouble;
+}
+
+// The previous parsing path: whole-body DOM, then atof on every wanted field
+static int parse_with_cjson(const char *body, Klines *out) {
+    cJSON *json = cJSON_Parse(body);
+    if (!cJSON_IsArray(json)) {
+        cJSON_Delete(json);
+        return -1;
+    }
+    size_t rows = 0;
+    cJSON *kline;
+    cJSON_ArrayForEach(kline, json) {
+        out->open_times[rows] = (long long)field_number(kline, 0);
+        out->open[rows] = field_number(kline, 1);
+        out->high[rows] = field_number(kline, 2);
+        out->low[rows] = field_number(kline, 3);
+        out->close[rows] = field_number(kline, 4);
+        out->volume[rows] = field_number(kline, 5);
+        rows++;
+    }
+    out->count = rows;
+    cJSON_Delete(json);
+    return 0;
+}
+
+static void parser_for(KlineParser *parser, Klines *out) {
+    KlineColumns columns = {
+        .open_times = out->open_times, .open = out->open, .high = out->high,
+        .low = out->low, .close = out->close, .volume = out->volume, .capacity = KLINE_PAGE_LIMIT,
+    };
+    kline_parser_init(parser, &columns);
+}
+
+// Feed body in pieces of chunk bytes, with the first piece cut at split
+static int parse_streaming(const char *body, size_t length, size_t split, size_t chunk, Klines *out) {
+    KlineParser parser;
+    parser_for(&parser, out);
+    kline_parser_feed(&parser, body, split);
+    for (size_t offset = split; offset < length; offset += chunk) {
+        size_t n = length - offset < chunk ? length - offset : chunk;
+        kline_parser_feed(&parser, body + offset, n);
+    }
+    out->count = parser.row_count;
+    return kline_parser_finish(&parser);
+}
+
+static int same_klines(const Klines *a, const Klines *b) {
+    return a->count == b->count &&
+           memcmp(a->open_times, b->open_times, a->count * sizeof(long long)) == 0 &&
+           memcmp(a->open, b->open, a->count * sizeof(double)) == 0 &&
+           memcmp(a->high, b->high, a->count * sizeof(double)) == 0 &&
+           memcmp(a->low, b->low, a->count * sizeof(double)) == 0 &&
+           memcmp(a->close, b->close, a->count * sizeof(double)) == 0 &&
+           memcmp(a->volume, b->volume, a->count * sizeof(double)) == 0;
+}
+
+// Inputs the parser must reject, and short responses it must accept
+static int check_edge_cases(void) {
+    static const struct { const char *body; int status; size_t rows; } cases[] = {
+        {"[]", 0, 0},
+        {" [ ] ", 0, 0},
+        {"[[1,\"2\",\"3\",\"4\",\"5\",\"6\"]]", 0, 1},
+        {"[[1,\"2\",\"3\"],[1,\"2\",\"3\",\"4\",\"5\",\"6\",null,true]]", 0, 1},
+        {"[[1,\"2\",\"3\",\"4\",\"5\",\"-6.5e-3\",\"a\\\"b\"]]", 0, 1},
+        {"{\"code\":-1003,\"msg\":\"Too many requests\"}", -1, 0},
+        {"[[1,\"2\",\"x\",\"4\",\"5\",\"6\"]]", -1, 0},
+        {"[[1,\"2\",\"3\",\"4\",\"5\",\"6\"]", -1, 1},
+        {"[[1,\"2\",\"3\",\"4\",\"5\",\"6\"]] x", -1, 1},
+    };
+
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        Klines *out = (Klines *)calloc(1, sizeof(Klines));
+        int status = parse_streaming(cases[i].body, strlen(cases[i].body), 0, 1, out);
+        if (status != cases[i].status || (status == 0 && out->count != cases[i].rows)) {
+            printf("FAIL edge case %zu: status %d rows %zu\n", i, status, out->count);
+            failures++;
+        }
+        if (i == 4 && out->volume[0] != -6.5e-3) {
+            printf("FAIL exponent: %.17g\n", out->volume[0]);
+            failures++;
+        }
+        free(out);
+    }
+    return failures;
+}
+
+int main(void) {
+    size_t buffer_size = (size_t)KLINE_PAGE_LIMIT * 256;
+    char *body = (char *)malloc(buffer_size);
+    Klines *expected = (Klines *)calloc(1, sizeof(Klines));
+    Klines *actual = (Klines *)calloc(1, sizeof(Klines));
+    if (!body || !expected || !actual) {
+        return 1;
+    }
+    size_t length = build_response(body, buffer_size);
+
+    int failures = check_edge_cases();
+    if (parse_with_cjson(body, expected) != 0 || expected->count != KLINE_PAGE_LIMIT) {
+        printf("FAIL cJSON reference parse\n");
+        return 1;
+    }
+
+    // Every split point of the first 4 KB, then a spread of chunk sizes over the whole body
+    for (size_t split = 0; split <= 4096 && split <= length; split++) {
+        if (parse_streaming(body, length, split, length, actual) != 0 || !same_klines(expected, actual)) {
+            printf("FAIL split at %zu\n", split);
+            failures++;
+        }
+    }
+    for (size_t chunk = 1; chunk <= 1024; chunk = chunk < 16 ? chunk + 1 : chunk * 2 + 1) {
+        if (parse_streaming(body, length, 0, chunk, actual) != 0 || !same_klines(expected, actual)) {
+            printf("FAIL chunk size %zu\n", chunk);
+            failures++;
+        }
+    }
+
+    // Throughput on whole bodies, the way each path sees a completed response
+    double start = now_seconds();
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        parse_with_cjson(body, expected);
+    }
+    double cjson_seconds = now_seconds() - start;
+
+    start = now_seconds();
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        parse_streaming(body, length, length, length, actual);
+    }
+    double streaming_seconds = now_seconds() - start;
+
+    double megabytes = (double)length * BENCH_ROUNDS / 1e6;
+    printf("cJSON + atof:     %8.1f MB/s  %8.1f rows/us\n", megabytes / cjson_seconds, KLINE_PAGE_LIMIT * BENCH_ROUNDS / cjson_seconds / 1e6);
+    printf("streaming parser: %8.1f MB/s  %8.1f rows/us\n", megabytes / streaming_seconds, KLINE_PAGE_LIMIT * BENCH_ROUNDS / streaming_seconds / 1e6);
+
+    free(body);
+    free(expected);
+    free(actual);
+    if (failures) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
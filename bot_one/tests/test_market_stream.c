@@ -0,0 +1,102 @@
+// tests/test_market_stream.c
+// Streams tests/stream_capture.jsonl from tests/ws_stub_server.py into a LockFreeQueue and
+// checks every tick, then reports the receive-to-enqueue latency.
+//
+// Usage: ./bin/test_market_stream ws://127.0.0.1:18081/ws/btcusdt@trade REPEAT
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <curl/curl.h>
+#include "market_stream.h"
+#include "lock_free_queue.h"
+
+#define TEST_TIMEOUT_SECONDS 20
+
+// Ticks in one replay of tests/stream_capture.jsonl; the subscription reply and the
+// 24hrMiniTicker event are not ticks
+static const MarketData expected[] = {
+    {.price = 37150.12, .volume = 0.0125},
+    {.price = 37150.13, .volume = 0.0004},
+    {.price = 37149.99, .volume = 1.2},
+    {.price = 37149.99, .volume = 12.345},
+    {.price = 37151.00, .volume = 0.25},
+    {.price = 37151.01, .volume = 0.001},
+    {.price = 37151.01, .volume = 12.596},
+    {.price = 37152.50, .volume = 0.5},
+};
+#define EXPECTED_PER_REPLAY (sizeof(expected) / sizeof(expected[0]))
+
+static int running = 1;
+static size_t target_ticks;
+
+typedef struct {
+    LockFreeQueue *queue;
+    size_t received;
+} TickSink;
+
+static void enqueue_tick(MarketData *tick, void *userdata) {
+    TickSink *sink = (TickSink *)userdata;
+    lock_free_queue_enqueue(sink->queue, tick);
+    if (++sink->received == target_ticks) {
+        running = 0;
+    }
+}
+
+static void *watchdog(void *args) {
+    (void)args;
+    for (int i = 0; i < TEST_TIMEOUT_SECONDS * 10 && running; i++) {
+        struct timespec step = {0, 100 * 1000000L};
+        nanosleep(&step, NULL);
+    }
+    running = 0;
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    const char *url = argc > 1 ? argv[1] : "ws://127.0.0.1:18081/ws/btcusdt@trade";
+    size_t repeat = argc > 2 ? (size_t)atoi(argv[2]) : 1;
+    target_ticks = repeat * EXPECTED_PER_REPLAY;
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    TickSink sink = {lock_free_queue_init(), 0};
+    MarketStream stream = {
+        .url = url,
+        .on_tick = enqueue_tick,
+        .userdata = &sink,
+        .running = &running,
+    };
+
+    pthread_t watchdog_thread;
+    pthread_create(&watchdog_thread, NULL, watchdog, NULL);
+    market_stream_run(&stream);
+    pthread_join(watchdog_thread, NULL);
+
+    int failures = 0;
+    size_t index = 0;
+    MarketData *tick;
+    while ((tick = (MarketData *)lock_free_queue_dequeue(sink.queue)) != NULL) {
+        const MarketData *want = &expected[index % EXPECTED_PER_REPLAY];
+        if (tick->price != want->price || tick->volume != want->volume) {
+            if (failures++ < 5) {
+                printf("tick %zu: %.8f x %.8f, expected %.8f x %.8f\n", index, tick->price, tick->volume, want->price, want->volume);
+            }
+        }
+        free(tick);
+        index++;
+    }
+    lock_free_queue_destroy(sink.queue);
+
+    printf("%zu messages, %zu ticks\n", stream.messages, stream.ticks);
+    if (stream.ticks > 0) {
+        printf("receive-to-queue latency: mean %.2f us, max %.2f us\n",
+               stream.latency_ns_total / 1e3 / stream.ticks, stream.latency_ns_max / 1e3);
+    }
+    if (index != target_ticks || failures) {
+        printf("FAIL: %zu of %zu ticks, %d mismatches\n", index, target_ticks, failures);
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,207 @@
+// tests/test_rate_limiter.c
+// Backfills against tests/kline_stub_server.py started with a weight limit, while a live
+// poller keeps requesting the latest bar. With the limiter the server must never answer
+// 429/418, the backfill must sustain close to the limit, and every live poll must succeed;
+// how long live polls were held is printed. The same backfill without the limiter is run
+// last to show the server enforces the limit. A request heavier than the whole budget must be refused at
+// once, including one already waiting when the budget is lowered below it.
+//
+// Usage: ./bin/test_rate_limiter http://127.0.0.1:18080 WEIGHT_LIMIT WINDOW_MS
+// with the stub started as: python3 tests/kline_stub_server.py 18080 0 0 WEIGHT_LIMIT WINDOW_MS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "kline_backfill.h"
+
+#define FIRST_OPEN_MS 1609459200000LL
+#define PAGE_COUNT 240
+#define LIVE_POLL_MS 200
+#define LIVE_PATH "/api/v3/klines?symbol=BTCUSDT&interval=1m&startTime=1609459200000&limit=1"
+
+typedef struct {
+    FetcherContext *context;
+    volatile int running;
+    int polls;
+    int failures;
+    double max_round_trip_ms;
+} LivePoller;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void free_raw_data(RawData *raw_data) {
+    free(raw_data->open_times);
+    free(raw_data->prices);
+    free(raw_data->high_prices);
+    free(raw_data->low_prices);
+    free(raw_data->volumes);
+    memset(raw_data, 0, sizeof(*raw_data));
+}
+
+static void *live_poll(void *args) {
+    LivePoller *poller = (LivePoller *)args;
+    while (poller->running) {
+        double start = now_seconds();
+        FetcherConnection *connection = fetcher_acquire(poller->context);
+        if (fetcher_get(poller->context, connection, LIVE_PATH, REQUEST_PRIORITY_LIVE, KLINE_REQUEST_WEIGHT) != 0) {
+            poller->failures++;
+        }
+        fetcher_release(poller->context, connection);
+        double round_trip_ms = (now_seconds() - start) * 1e3;
+        if (round_trip_ms > poller->max_round_trip_ms) {
+            poller->max_round_trip_ms = round_trip_ms;
+        }
+        poller->polls++;
+        struct timespec step = {0, LIVE_POLL_MS * 1000000L};
+        nanosleep(&step, NULL);
+    }
+    return NULL;
+}
+
+static long stat_value(const char *body, const char *name) {
+    char key[64];
+    snprintf(key, sizeof(key), "\"%s\":", name);
+    const char *found = strstr(body, key);
+    return found ? strtol(found + strlen(key), NULL, 10) : -1;
+}
+
+// Read the stub's counters: klines requests, weight charged, 429s and 418s
+static int server_stats(FetcherContext *context, long *weight, long *rejected_429, long *rejected_418) {
+    FetcherConnection *connection = fetcher_acquire(context);
+    int status = fetcher_get(context, connection, "/stats", REQUEST_PRIORITY_LIVE, 0);
+    if (status == 0) {
+        *weight = stat_value(connection->body.memory, "weight");
+        *rejected_429 = stat_value(connection->body.memory, "rejected_429");
+        *rejected_418 = stat_value(connection->body.memory, "rejected_418");
+    }
+    fetcher_release(context, connection);
+    return status;
+}
+
+static void *acquire_heavy(void *args) {
+    RateLimiter *limiter = (RateLimiter *)args;
+    return (void *)(long)rate_limiter_acquire(limiter, REQUEST_PRIORITY_BACKFILL, 8);
+}
+
+// A weight the limit can never grant is refused rather than waited on forever
+static int check_oversized_weight(void) {
+    int failures = 0;
+    RateLimiter limiter;
+    rate_limiter_init(&limiter, 10, 1000);
+    long long window;
+    double start = now_seconds();
+    if (rate_limiter_acquire(&limiter, REQUEST_PRIORITY_LIVE, 11) != -1 ||
+        rate_limiter_try_acquire(&limiter, REQUEST_PRIORITY_BACKFILL, 11, &window) != -1) {
+        printf("FAIL weight 11 against a limit of 10 was not refused\n");
+        failures++;
+    }
+
+    // Spend the window so the next request waits, then lower the limit beneath it
+    rate_limiter_acquire(&limiter, REQUEST_PRIORITY_LIVE, 10);
+    pthread_t waiter;
+    pthread_create(&waiter, NULL, acquire_heavy, &limiter);
+    struct timespec step = {0, 50 * 1000000L};
+    nanosleep(&step, NULL);
+    rate_limiter_configure(&limiter, 4, 60000);
+    void *result;
+    pthread_join(waiter, &result);
+    if ((long)result != -1 || limiter.waiting[REQUEST_PRIORITY_BACKFILL] != 0) {
+        printf("FAIL a waiting request was not refused when the limit dropped below it\n");
+        failures++;
+    }
+    printf("oversized weights refused in %.3f s\n", now_seconds() - start);
+    rate_limiter_destroy(&limiter);
+    return failures;
+}
+
+static int backfill(FetcherContext *context, const ConfigParams *config) {
+    RawData raw_data;
+    memset(&raw_data, 0, sizeof(raw_data));
+    int status = backfill_klines(context, config, "BTCUSDT", FIRST_OPEN_MS,
+                                 FIRST_OPEN_MS + PAGE_COUNT * KLINE_PAGE_LIMIT * 60000LL - 1, &raw_data);
+    if (status == 0 && raw_data.price_count != (size_t)PAGE_COUNT * KLINE_PAGE_LIMIT) {
+        printf("expected %d bars, got %zu\n", PAGE_COUNT * KLINE_PAGE_LIMIT, raw_data.price_count);
+        status = -1;
+    }
+    free_raw_data(&raw_data);
+    return status;
+}
+
+int main(int argc, char *argv[]) {
+    const char *base_url = argc > 1 ? argv[1] : "http://127.0.0.1:18080";
+    int weight_limit = argc > 2 ? atoi(argv[2]) : 200;
+    long long window_ms = argc > 3 ? atoll(argv[3]) : 1000;
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    ConfigParams config;
+    memset(&config, 0, sizeof(config));
+    snprintf(config.interval, sizeof(config.interval), "1m");
+    config.backfill_concurrency = 8;
+
+    FetcherContext *context = fetcher_context_create(base_url, 9);
+    if (context == NULL) {
+        return 1;
+    }
+    rate_limiter_configure(&context->limiter, weight_limit, window_ms);
+
+    int failures = check_oversized_weight();
+    LivePoller poller = {.context = context, .running = 1};
+    pthread_t live_thread;
+    pthread_create(&live_thread, NULL, live_poll, &poller);
+
+    double start = now_seconds();
+    if (backfill(context, &config) != 0) {
+        printf("FAIL paced backfill\n");
+        failures++;
+    }
+    double elapsed = now_seconds() - start;
+    poller.running = 0;
+    pthread_join(live_thread, NULL);
+
+    long weight = 0, rejected_429 = 0, rejected_418 = 0;
+    if (server_stats(context, &weight, &rejected_429, &rejected_418) != 0) {
+        return 1;
+    }
+    double per_window = weight / elapsed * (window_ms / 1e3);
+    printf("paced: %d pages and %d live polls in %.2f s, %.0f weight per %lld ms window (limit %d), %ld 429s, %ld 418s\n",
+           PAGE_COUNT, poller.polls, elapsed, per_window, window_ms, weight_limit, rejected_429, rejected_418);
+    long long live_wait_ms = context->limiter.max_wait_ms[REQUEST_PRIORITY_LIVE];
+    printf("live polls: max %lld ms held by the limiter, max %.2f ms round trip\n", live_wait_ms, poller.max_round_trip_ms);
+    if (rejected_429 != 0 || rejected_418 != 0 || context->limiter.rejected != 0) {
+        printf("FAIL the limiter let the server reject requests\n");
+        failures++;
+    }
+    if (per_window < weight_limit * 0.75) {
+        printf("FAIL sustained %.0f weight per window, expected at least 75%% of %d\n", per_window, weight_limit);
+        failures++;
+    }
+    if (poller.failures || poller.polls == 0) {
+        printf("FAIL live polls: %d of %d failed\n", poller.failures, poller.polls);
+        failures++;
+    }
+
+    // Without the limiter the same backfill runs straight into the server's limit
+    rate_limiter_configure(&context->limiter, 0, window_ms);
+    int unpaced = backfill(context, &config);
+    long paced_429 = rejected_429, paced_418 = rejected_418;
+    server_stats(context, &weight, &rejected_429, &rejected_418);
+    printf("unpaced: backfill %s, %ld 429s, %ld 418s\n", unpaced == 0 ? "completed" : "failed",
+           rejected_429 - paced_429, rejected_418 - paced_418);
+    if (rejected_429 == paced_429) {
+        printf("FAIL the stub did not enforce its limit\n");
+        failures++;
+    }
+
+    fetcher_context_destroy(context);
+    if (failures) {
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
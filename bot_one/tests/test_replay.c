@@ -0,0 +1,165 @@
+// tests/test_replay.c
+// Replays recordings at 1x, 10x and full speed and checks that every tick arrives, in order.
+// How far each tick lands from its recorded offset divided by the speed, including across a
+// burst after a quiet gap, is printed rather than checked, since it depends on how busy the
+// machine is. Covers tests/stream_capture.jsonl, a generated capture and a generated kline
+// history.
+//
+// Usage: ./bin/test_replay tests/stream_capture.jsonl
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "replay.h"
+#include "ws_client.h"
+
+#define GENERATED_TRADES 500
+#define GENERATED_GAP_MS 200
+#define GENERATED_BARS 100
+#define FIRST_EVENT_MS 1700000000000LL
+
+static const double capture_prices[] = {37150.12, 37150.13, 37149.99, 37149.99, 37151.00, 37151.01, 37151.01, 37152.50};
+static const long long capture_offsets_ms[] = {0, 13, 119, 499, 729, 909, 40000, 40209};
+#define CAPTURE_TICKS (sizeof(capture_prices) / sizeof(capture_prices[0]))
+
+typedef struct {
+    size_t count;
+    size_t capacity;
+    double *prices;
+    long long *arrival_ns;
+} TickLog;
+
+static int running = 1;
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void record_tick(MarketData *tick, void *userdata) {
+    TickLog *log = (TickLog *)userdata;
+    if (log->count < log->capacity) {
+        log->prices[log->count] = tick->price;
+        log->arrival_ns[log->count] = ws_monotonic_ns();
+    }
+    log->count++;
+    free(tick);
+}
+
+// Replay path at speed and compare each tick with its expected price and recorded offset
+static int check_replay(const char *name, const char *path, double speed, const double *prices,
+                        const long long *offsets_ms, size_t tick_count) {
+    TickLog log = {0, tick_count, malloc(tick_count * sizeof(double)), malloc(tick_count * sizeof(long long))};
+    double *late_ms = (double *)calloc(tick_count, sizeof(double));
+    ReplaySource replay = {.path = path, .speed = speed, .on_tick = record_tick, .userdata = &log, .running = &running};
+    int failures = 0;
+    if (!log.prices || !log.arrival_ns || !late_ms || replay_run(&replay) != 0 || log.count != tick_count) {
+        printf("FAIL %s at %gx: %zu of %zu ticks\n", name, speed, log.count, tick_count);
+        failures++;
+        tick_count = log.count < tick_count ? log.count : tick_count;
+    }
+
+    double max_early_ms = 0.0;
+    for (size_t i = 0; i < tick_count; i++) {
+        if (log.prices[i] != prices[i]) {
+            if (failures++ < 5) {
+                printf("FAIL %s tick %zu: price %.2f, expected %.2f\n", name, i, log.prices[i], prices[i]);
+            }
+        }
+        if (speed > 0) {
+            double offset_ms = (log.arrival_ns[i] - log.arrival_ns[0]) / 1e6;
+            double due_ms = offsets_ms[i] / speed;
+            if (due_ms - offset_ms > max_early_ms) {
+                max_early_ms = due_ms - offset_ms;
+            }
+            late_ms[i] = offset_ms - due_ms;
+        }
+    }
+    qsort(late_ms, tick_count, sizeof(double), compare_doubles);
+    double median_late_ms = tick_count ? late_ms[tick_count / 2] : 0.0;
+    double max_late_ms = tick_count ? late_ms[tick_count - 1] : 0.0;
+
+    double elapsed_s = replay.elapsed_ns / 1e9;
+    printf("%-18s %6gx: %zu ticks, %lld ms recorded in %.3f s (%.0f ticks/s), lag mean %.1f us max %.1f us",
+           name, speed, replay.ticks, replay.recorded_ms, elapsed_s, elapsed_s > 0 ? replay.ticks / elapsed_s : 0.0,
+           replay.ticks ? replay.lag_ns_total / 1e3 / replay.ticks : 0.0, replay.lag_ns_max / 1e3);
+    if (speed > 0) {
+        printf(", max %.3f ms early, %.3f ms median and %.3f ms max late", max_early_ms, median_late_ms, max_late_ms);
+    }
+    printf("\n");
+    free(log.prices);
+    free(log.arrival_ns);
+    free(late_ms);
+    return failures;
+}
+
+// One trade per millisecond with a quiet gap halfway, so replay must reproduce the burst after it
+static int write_capture(const char *path, double *prices, long long *offsets_ms) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        return -1;
+    }
+    fprintf(file, "{\"result\":null,\"id\":1}\n");
+    for (int i = 0; i < GENERATED_TRADES; i++) {
+        long long offset = i + (i >= GENERATED_TRADES / 2 ? GENERATED_GAP_MS : 0);
+        prices[i] = 100 + i / 100.0;
+        offsets_ms[i] = offset;
+        fprintf(file, "{\"e\":\"trade\",\"E\":%lld,\"s\":\"BTCUSDT\",\"t\":%d,\"p\":\"%.2f\",\"q\":\"1.00000000\",\"T\":%lld,\"m\":true}\n",
+                FIRST_EVENT_MS + offset, i, prices[i], FIRST_EVENT_MS + offset - 1);
+    }
+    return fclose(file);
+}
+
+// Minute bars in the kline history layout
+static int write_history(const char *path, double *prices, long long *offsets_ms) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        return -1;
+    }
+    fprintf(file, "timestamp,open,high,low,close,volume,close_time,quote_asset_volume,number_of_trades,taker_buy_base_volume,taker_buy_quote_volume,ignore\n");
+    for (int i = 0; i < GENERATED_BARS; i++) {
+        long long open_time = FIRST_EVENT_MS + i * 60000LL;
+        prices[i] = 200 + i / 10.0;
+        offsets_ms[i] = i * 60000LL;
+        fprintf(file, "%lld,%.2f,%.2f,%.2f,%.2f,12.5,%lld,0,0,0,0,0\n",
+                open_time, prices[i], prices[i], prices[i], prices[i], open_time + 59999);
+    }
+    return fclose(file);
+}
+
+int main(int argc, char *argv[]) {
+    const char *capture = argc > 1 ? argv[1] : "tests/stream_capture.jsonl";
+    char generated[] = "/tmp/test_replay_XXXXXX";
+    if (mkdtemp(generated) == NULL) {
+        return 1;
+    }
+    char capture_path[64], history_path[64];
+    snprintf(capture_path, sizeof(capture_path), "%s/capture.jsonl", generated);
+    snprintf(history_path, sizeof(history_path), "%s/BTCUSDT_MinuteBars.csv", generated);
+
+    static double trade_prices[GENERATED_TRADES], bar_prices[GENERATED_BARS];
+    static long long trade_offsets_ms[GENERATED_TRADES], bar_offsets_ms[GENERATED_BARS];
+    if (write_capture(capture_path, trade_prices, trade_offsets_ms) != 0 ||
+        write_history(history_path, bar_prices, bar_offsets_ms) != 0) {
+        printf("Could not write the test recordings under %s\n", generated);
+        return 1;
+    }
+
+    int failures = 0;
+    failures += check_replay("stream_capture", capture, 1000, capture_prices, capture_offsets_ms, CAPTURE_TICKS);
+    failures += check_replay("stream_capture", capture, 0, capture_prices, capture_offsets_ms, CAPTURE_TICKS);
+    failures += check_replay("generated capture", capture_path, 1, trade_prices, trade_offsets_ms, GENERATED_TRADES);
+    failures += check_replay("generated capture", capture_path, 10, trade_prices, trade_offsets_ms, GENERATED_TRADES);
+    failures += check_replay("generated capture", capture_path, 0, trade_prices, trade_offsets_ms, GENERATED_TRADES);
+    failures += check_replay("kline history", history_path, 60000, bar_prices, bar_offsets_ms, GENERATED_BARS);
+    failures += check_replay("kline history", history_path, 0, bar_prices, bar_offsets_ms, GENERATED_BARS);
+
+    remove(capture_path);
+    remove(history_path);
+    remove(generated);
+    if (failures) {
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,219 @@
+// tests/test_response_cache.c
+// Backfills through the response cache against tests/kline_stub_server.py: a cold run fills
+// the cache, a warm run must succeed with the server unreachable, a range ending now must
+// leave its open final page uncached, and a small cap must evict the least recently used range.
+// The cache's running byte total must match the directory, and oversized keys are never cached.
+//
+// Usage: ./bin/test_response_cache http://127.0.0.1:18080
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "kline_backfill.h"
+#include "response_cache.h"
+
+#define FIRST_OPEN_MS 1609459200000LL
+#define BAR_COUNT 25500
+#define PAGE_COUNT ((BAR_COUNT + KLINE_PAGE_LIMIT - 1) / KLINE_PAGE_LIMIT)
+#define UNREACHABLE_URL "http://127.0.0.1:1"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void free_raw_data(RawData *raw_data) {
+    free(raw_data->open_times);
+    free(raw_data->prices);
+    free(raw_data->high_prices);
+    free(raw_data->low_prices);
+    free(raw_data->volumes);
+    memset(raw_data, 0, sizeof(*raw_data));
+}
+
+// Count the cache entries in dir and their total size
+static size_t scan_cache(const char *dir, size_t *bytes) {
+    size_t count = 0;
+    *bytes = 0;
+    DIR *handle = opendir(dir);
+    struct dirent *entry;
+    while (handle && (entry = readdir(handle)) != NULL) {
+        if (strstr(entry->d_name, RESPONSE_CACHE_SUFFIX) == NULL) {
+            continue;
+        }
+        char path[512];
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        if (stat(path, &st) == 0) {
+            *bytes += (size_t)st.st_size;
+            count++;
+        }
+    }
+    if (handle) {
+        closedir(handle);
+    }
+    return count;
+}
+
+static void clear_cache(const char *dir) {
+    DIR *handle = opendir(dir);
+    struct dirent *entry;
+    while (handle && (entry = readdir(handle)) != NULL) {
+        if (entry->d_name[0] != '.') {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+            unlink(path);
+        }
+    }
+    if (handle) {
+        closedir(handle);
+    }
+}
+
+static int check_history(const RawData *raw_data, long long first_open_ms) {
+    if (raw_data->price_count != BAR_COUNT) {
+        printf("expected %d bars, got %zu\n", BAR_COUNT, raw_data->price_count);
+        return 1;
+    }
+    for (size_t i = 0; i < raw_data->price_count; i++) {
+        long long open_ms = first_open_ms + (long long)i * 60000;
+        double close = 100 + (double)((open_ms / 60000) % 97) + 0.5;
+        if (raw_data->open_times[i] != open_ms || raw_data->prices[i] != close) {
+            printf("bar %zu: open %lld close %.2f, expected %lld %.2f\n", i, raw_data->open_times[i], raw_data->prices[i], open_ms, close);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Backfill BAR_COUNT bars from first_open_ms and check them
+static int backfill_history(FetcherContext *context, const ConfigParams *config, long long first_open_ms, double *seconds) {
+    RawData raw_data;
+    memset(&raw_data, 0, sizeof(raw_data));
+    double start = now_seconds();
+    int status = backfill_klines(context, config, "BTCUSDT", first_open_ms, first_open_ms + BAR_COUNT * 60000LL - 1, &raw_data);
+    *seconds = now_seconds() - start;
+    if (status == 0) {
+        status = check_history(&raw_data, first_open_ms);
+    }
+    free_raw_data(&raw_data);
+    return status;
+}
+
+int main(int argc, char *argv[]) {
+    const char *base_url = argc > 1 ? argv[1] : "http://127.0.0.1:18080";
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    char cache_dir[] = "/tmp/response_cache_XXXXXX";
+    if (mkdtemp(cache_dir) == NULL) {
+        return 1;
+    }
+
+    ConfigParams config;
+    memset(&config, 0, sizeof(config));
+    snprintf(config.interval, sizeof(config.interval), "1m");
+    snprintf(config.cache_dir, sizeof(config.cache_dir), "%s", cache_dir);
+    config.cache_max_mb = 64;
+    config.backfill_concurrency = 4;
+
+    FetcherContext *live = fetcher_context_create(base_url, 4);
+    FetcherContext *unreachable = fetcher_context_create(UNREACHABLE_URL, 4);
+    if (!live || !unreachable) {
+        return 1;
+    }
+
+    int failures = 0;
+    RawData raw_data;
+    memset(&raw_data, 0, sizeof(raw_data));
+    double cold_seconds, warm_seconds;
+    size_t bytes;
+
+    // Cold: every page of a closed range is fetched and stored
+    if (backfill_history(live, &config, FIRST_OPEN_MS, &cold_seconds) != 0 || scan_cache(cache_dir, &bytes) != PAGE_COUNT) {
+        printf("FAIL cold run: %zu cache entries\n", scan_cache(cache_dir, &bytes));
+        failures++;
+    }
+
+    // Warm: the same range needs neither the network nor the parser
+    if (backfill_history(unreachable, &config, FIRST_OPEN_MS, &warm_seconds) != 0) {
+        printf("FAIL warm run did not come from the cache\n");
+        failures++;
+    }
+    printf("cold %.3f s, warm %.4f s for %d bars\n", cold_seconds, warm_seconds, BAR_COUNT);
+
+    // A range ending now: the page holding the open bar is never stored, so it cannot be served
+    clear_cache(cache_dir);
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    long long now_ms = (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+    long long recent_start = (now_ms / 60000 - 1500) * 60000;
+    if (backfill_klines(live, &config, "BTCUSDT", recent_start, now_ms, &raw_data) != 0 ||
+        scan_cache(cache_dir, &bytes) != 1) {
+        printf("FAIL open range: expected only the closed page cached, found %zu\n", scan_cache(cache_dir, &bytes));
+        failures++;
+    }
+    free_raw_data(&raw_data);
+    if (backfill_klines(unreachable, &config, "BTCUSDT", recent_start, now_ms, &raw_data) == 0) {
+        printf("FAIL open range was served without the network\n");
+        failures++;
+    }
+    free_raw_data(&raw_data);
+
+    // A 1 MB cap holds one range; fetching a second evicts the first, least recently used
+    clear_cache(cache_dir);
+    config.cache_max_mb = 1;
+    long long second_open_ms = FIRST_OPEN_MS + BAR_COUNT * 60000LL;
+    if (backfill_history(live, &config, FIRST_OPEN_MS, &cold_seconds) != 0 ||
+        backfill_history(live, &config, second_open_ms, &cold_seconds) != 0) {
+        printf("FAIL capped runs\n");
+        failures++;
+    }
+    size_t entries = scan_cache(cache_dir, &bytes);
+    if (bytes > 1024 * 1024 || backfill_history(unreachable, &config, second_open_ms, &warm_seconds) != 0 ||
+        backfill_history(unreachable, &config, FIRST_OPEN_MS, &warm_seconds) == 0) {
+        printf("FAIL eviction: %zu entries, %zu bytes\n", entries, bytes);
+        failures++;
+    }
+    printf("1 MB cap keeps %zu of %d pages (%zu bytes)\n", entries, 2 * PAGE_COUNT, bytes);
+
+    // The running total starts from one scan and follows each store without rescanning
+    ResponseCache cache;
+    response_cache_init(&cache, cache_dir, 1);
+    long long open_times[2] = {FIRST_OPEN_MS, FIRST_OPEN_MS + 60000};
+    double values[2] = {1, 2};
+    KlineColumns columns = {.open_times = open_times, .close = values, .high = values, .low = values,
+                            .volume = values, .capacity = 2};
+    ResponseCacheKey key = {"/api/v3/klines", "ETHUSDT", "1m", FIRST_OPEN_MS, FIRST_OPEN_MS + 119999};
+    size_t scanned_total = cache.total_bytes;
+    if (scanned_total != bytes || response_cache_store(&cache, &key, &columns, 2) != 0 ||
+        scan_cache(cache_dir, &bytes) == 0 || cache.total_bytes != bytes || cache.total_bytes > cache.max_bytes) {
+        printf("FAIL running total: %zu at init, %zu after a store, %zu on disk\n", scanned_total, cache.total_bytes, bytes);
+        failures++;
+    }
+
+    // A key too long for the key text is neither stored nor served, so truncated keys cannot collide
+    char long_symbol[RESPONSE_CACHE_KEY_MAX + 16];
+    memset(long_symbol, 'X', sizeof(long_symbol) - 1);
+    long_symbol[sizeof(long_symbol) - 1] = '\0';
+    key.symbol = long_symbol;
+    entries = scan_cache(cache_dir, &bytes);
+    if (response_cache_store(&cache, &key, &columns, 2) != 0 || scan_cache(cache_dir, &bytes) != entries ||
+        response_cache_load(&cache, &key, &columns) != -1) {
+        printf("FAIL an oversized key was cached\n");
+        failures++;
+    }
+
+    clear_cache(cache_dir);
+    rmdir(cache_dir);
+    fetcher_context_destroy(live);
+    fetcher_context_destroy(unreachable);
+    if (failures) {
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,132 @@
+# Local stand-in for a Binance WebSocket stream used by the market stream tests.
+# Replays recorded messages (one JSON message per line) to each client, exercising the
+# framing the client must handle: 16-bit lengths, fragmented messages, frames split across
+# reads, pings that must be answered, and the closing handshake.
+#
+# Usage: python3 tests/ws_stub_server.py PORT CAPTURE [REPEAT]
+#   CAPTURE  file of recorded messages, e.g. tests/stream_capture.jsonl
+#   REPEAT   times the capture is replayed per connection (default 1)
+import base64
+import hashlib
+import socket
+import struct
+import sys
+import time
+
+GUID = '258EAFA5-E914-47DA-95CA-C5AB0DC85B11'
+TEXT, CONTINUATION, CLOSE, PING, PONG = 0x1, 0x0, 0x8, 0x9, 0xA
+
+
+def frame(opcode, payload, fin=True):
+    header = bytes([(0x80 if fin else 0) | opcode])
+    n = len(payload)
+    if n < 126:
+        header += bytes([n])
+    elif n < 65536:
+        header += bytes([126]) + struct.pack('!H', n)
+    else:
+        header += bytes([127]) + struct.pack('!Q', n)
+    return header + payload
+
+
+def read_exact(conn, n):
+    data = b''
+    while len(data) < n:
+        chunk = conn.recv(n - len(data))
+        if not chunk:
+            raise ConnectionError('client went away')
+        data += chunk
+    return data
+
+
+# Client frames must be masked; returns (opcode, unmasked payload)
+def read_frame(conn):
+    b0, b1 = read_exact(conn, 2)
+    n = b1 & 0x7F
+    if n == 126:
+        n = struct.unpack('!H', read_exact(conn, 2))[0]
+    elif n == 127:
+        n = struct.unpack('!Q', read_exact(conn, 8))[0]
+    if not b1 & 0x80:
+        raise ValueError('client frame is not masked')
+    mask = read_exact(conn, 4)
+    payload = bytes(b ^ mask[i % 4] for i, b in enumerate(read_exact(conn, n)))
+    return b0 & 0x0F, payload
+
+
+def handshake(conn):
+    request = b''
+    while b'\r\n\r\n' not in request:
+        chunk = conn.recv(4096)
+        if not chunk:
+            return False
+        request += chunk
+    headers = {}
+    for line in request.decode().split('\r\n')[1:]:
+        if ':' in line:
+            name, value = line.split(':', 1)
+            headers[name.strip().lower()] = value.strip()
+    key = headers.get('sec-websocket-key')
+    if headers.get('upgrade', '').lower() != 'websocket' or not key:
+        conn.sendall(b'HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n')
+        return False
+    accept = base64.b64encode(hashlib.sha1((key + GUID).encode()).digest()).decode()
+    conn.sendall(('HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n'
+                  'Connection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n' % accept).encode())
+    return True
+
+
+def replay(conn, messages, repeat):
+    sent = 0
+    for _ in range(repeat):
+        for i, message in enumerate(messages):
+            data = message.encode()
+            if i % 5 == 2:
+                # One message as three frames in a single write
+                conn.sendall(frame(TEXT, data[:10], False) + frame(CONTINUATION, data[10:30], False) +
+                             frame(CONTINUATION, data[30:]))
+            elif i % 5 == 4:
+                # One frame split across two writes
+                whole = frame(TEXT, data)
+                conn.sendall(whole[:3])
+                time.sleep(0.002)
+                conn.sendall(whole[3:])
+            else:
+                conn.sendall(frame(TEXT, data))
+            sent += 1
+            if sent % 7 == 3:
+                token = b'hb%d' % sent
+                conn.sendall(frame(PING, token))
+                opcode, payload = read_frame(conn)
+                if opcode != PONG or payload != token:
+                    print('bad pong %r' % payload, flush=True)
+                    conn.sendall(frame(CLOSE, struct.pack('!H', 1002)))
+                    return
+    conn.sendall(frame(CLOSE, struct.pack('!H', 1000)))
+    while True:
+        opcode, _ = read_frame(conn)
+        if opcode == CLOSE:
+            return
+
+
+if __name__ == '__main__':
+    port = int(sys.argv[1])
+    with open(sys.argv[2]) as capture:
+        messages = [line.strip() for line in capture if line.strip()]
+    repeat = int(sys.argv[3]) if len(sys.argv) > 3 else 1
+
+    server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(('127.0.0.1', port))
+    server.listen(4)
+    print(f'stream stub listening on {port}', flush=True)
+    while True:
+        conn, _ = server.accept()
+        conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        try:
+            if handshake(conn):
+                replay(conn, messages, repeat)
+        except (ConnectionError, ValueError) as error:
+            print('connection ended: %s' % error, flush=True)
+        finally:
+            conn.close()
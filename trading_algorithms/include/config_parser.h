@@ -1,6 +1,8 @@
 #ifndef CONFIG_PARSER_H
 #define CONFIG_PARSER_H
 
+#include "wait_strategy.h"
+
 typedef struct {
     int default_calculation_interval;
     int max_records_to_process;
@@ -8,6 +10,8 @@ typedef struct {
     double ema_alpha;
     int rsi_period;
     double bollinger_multiplier;
+    WaitMode input_wait;
+    WaitMode output_wait;
 } ConfigParams;
 
 int load_config(const char *config_file_path, ConfigParams *params);
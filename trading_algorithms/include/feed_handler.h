@@ -0,0 +1,82 @@
+// include/feed_handler.h
+#ifndef FEED_HANDLER_H
+#define FEED_HANDLER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "market_data.h"
+#include "ws_client.h"
+
+// Most ticks handed to the batch handler in one call
+#define FEED_MAX_BATCH 256
+// Ready sockets taken from epoll per wake-up
+#define FEED_EPOLL_EVENTS 64
+// How often the loop wakes to check the running flag when no data arrives
+#define FEED_POLL_MS 200
+// Pause before reconnecting a source whose connection dropped
+#define FEED_RECONNECT_MS 1000
+// Receive buffer for a tcp:// source
+#define FEED_TCP_BUFFER (64 * 1024)
+
+// Connection state of a source
+typedef enum {
+    FEED_SOURCE_DOWN,         // waiting for reconnect_at_ns
+    FEED_SOURCE_CONNECTING,   // connect or WebSocket upgrade in progress, until connect_deadline_ns
+    FEED_SOURCE_UP
+} FeedSourceState;
+
+typedef enum {
+    FEED_SOURCE_WEBSOCKET,  // ws:// or wss://, Binance stream messages in text frames
+    FEED_SOURCE_TCP         // tcp://host:port, the same messages one per line
+} FeedSourceType;
+
+// Receives the ticks decoded since the last call; ticks belong to the handler and must be
+// copied before returning
+typedef void (*FeedBatchHandler)(MarketData *ticks, size_t count, void *userdata);
+
+// One connection multiplexed by the feed handler
+typedef struct {
+    const char *url;
+    FeedSourceType type;
+    FeedSourceState state;
+    WsClient ws;
+    int fd;                   // tcp:// socket
+    char *buffer;             // tcp:// bytes not yet split into lines
+    size_t buffer_length;
+    long long reconnect_at_ns;
+    long long connect_deadline_ns;
+    size_t messages;
+} FeedSource;
+
+// Every source on one thread: sockets are registered with one epoll instance and only the
+// ready ones are read, so the thread count stays at one and the cost per message does not
+// grow with the number of sources. Decoded ticks are collected across all sources that
+// were ready together and handed over as one batch, so the pipeline is woken once per
+// batch rather than once per tick. Sources connect without blocking too: the TCP connect and
+// the WebSocket upgrade advance as epoll reports their socket ready, so a source that is slow
+// to answer, or never does, holds up nothing but itself.
+typedef struct {
+    int epoll_fd;
+    FeedSource *sources;
+    size_t source_count;
+    FeedBatchHandler on_batch;
+    void *userdata;
+    const int *running;       // the loop stops once this reads 0
+    MarketData batch[FEED_MAX_BATCH];
+    size_t batch_count;
+    size_t messages;          // messages received over all sources
+    size_t ticks;             // ticks handed to on_batch
+    size_t batches;
+} FeedHandler;
+
+// Function to set up a handler for urls (ws://, wss:// or tcp://); urls must outlive the handler
+int feed_handler_init(FeedHandler *handler, const char *const *urls, size_t url_count, FeedBatchHandler on_batch, void *userdata, const int *running);
+
+// Function to connect every source and deliver batches until *handler->running is 0,
+// reconnecting sources whose connection drops
+int feed_handler_run(FeedHandler *handler);
+
+// Function to close every source and release the handler
+void feed_handler_destroy(FeedHandler *handler);
+
+#endif // FEED_HANDLER_H
@@ -3,6 +3,7 @@
 
 #include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 typedef struct LockFreeQueueNode {
     void *data;
@@ -16,6 +17,8 @@ typedef struct {
 
 LockFreeQueue *lock_free_queue_init();
 void lock_free_queue_enqueue(LockFreeQueue *queue, void *data);
+// Function to append count items in order with a single exchange on the tail
+void lock_free_queue_enqueue_batch(LockFreeQueue *queue, void *const *items, size_t count);
 void *lock_free_queue_dequeue(LockFreeQueue *queue);
 void lock_free_queue_destroy(LockFreeQueue *queue);
 bool queue_is_empty(LockFreeQueue *queue);
@@ -2,12 +2,19 @@
 #define MARKET_DATA_POOL_H
 
 #include <stddef.h>
+#include <pthread.h>
 #include "market_data.h"
 
+// Fixed set of MarketData slots shared by the ingestion threads and the consumers. Slots are
+// handed out from the unused tail of buffer first and then from the stack of freed slots,
+// so a slot returned by a consumer is reused and the pool only runs dry while every slot is
+// still queued or being processed.
 typedef struct {
     MarketData *buffer;
     size_t size;
-    size_t next_free;
+    size_t next_free;           // slots from here on have never been handed out
+    MarketData **free_slots;    // slots returned by market_data_pool_free
+    size_t free_count;
     pthread_mutex_t mutex;
 } MarketDataPool;
 
@@ -0,0 +1,37 @@
+// include/market_stream.h
+#ifndef MARKET_STREAM_H
+#define MARKET_STREAM_H
+
+#include <stddef.h>
+#include "market_data.h"
+
+// How often the stream wakes to check the running flag when no data arrives
+#define MARKET_STREAM_POLL_MS 200
+// Pause before reconnecting after the connection drops
+#define MARKET_STREAM_RECONNECT_MS 1000
+
+// Receives each tick as soon as its message is decoded and takes ownership of it (malloc'd)
+typedef void (*MarketTickHandler)(MarketData *tick, void *userdata);
+
+// A Binance-style market stream: trade, aggTrade and kline events, raw (/ws/...) or combined
+// (/stream?streams=...), decoded into MarketData ticks
+typedef struct {
+    const char *url;
+    MarketTickHandler on_tick;
+    void *userdata;
+    const int *running;           // the stream stops once this reads 0
+    size_t messages;              // messages received
+    size_t ticks;                 // ticks handed to on_tick
+    long long latency_ns_total;   // time from bytes received to on_tick returning, summed over ticks
+    long long latency_ns_max;
+} MarketStream;
+
+// Function to decode one stream message; returns 1 for a tick, 0 for other messages
+// (subscription replies and unknown events), -1 if the message is malformed
+int market_stream_parse(const char *message, size_t length, MarketData *tick);
+
+// Function to connect to stream->url and deliver ticks until *stream->running is 0,
+// reconnecting whenever the connection drops
+int market_stream_run(MarketStream *stream);
+
+#endif // MARKET_STREAM_H
@@ -0,0 +1,53 @@
+// include/mpmc_queue.h
+#ifndef MPMC_QUEUE_H
+#define MPMC_QUEUE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Slots in a queue shared by the ingestion threads; rounded up to a power of two
+#define MPMC_QUEUE_DEFAULT_CAPACITY 65536
+
+typedef struct {
+    _Atomic size_t sequence;   // tells producers and consumers whose turn the cell is
+    void *data;
+} MpmcCell;
+
+// Bounded queue of pointers for any number of producer and consumer threads (Vyukov's
+// array queue). Each cell carries a sequence number: a producer may fill the cell at
+// position pos once its sequence equals pos, a consumer may empty it once it equals pos + 1,
+// and emptying sets it to pos + capacity for the producer one lap later. Claiming a position
+// is one compare-and-swap on the shared index, so threads never wait on each other's
+// half-finished operations on other cells, and nothing is allocated after init.
+typedef struct {
+    _Alignas(64) MpmcCell *cells;
+    size_t mask;                             // capacity - 1
+    _Alignas(64) _Atomic size_t enqueue_pos;
+    _Alignas(64) _Atomic size_t dequeue_pos;
+} MpmcQueue;
+
+// Function to create a queue holding at least capacity items; NULL if allocation fails
+MpmcQueue *mpmc_queue_init(size_t capacity);
+
+// Function to append an item from any thread; returns false when the queue is full
+bool mpmc_queue_enqueue(MpmcQueue *queue, void *item);
+
+// Function to take the oldest available item from any thread; returns NULL when the queue is empty
+void *mpmc_queue_dequeue(MpmcQueue *queue);
+
+// Function to append up to count items from any thread, claiming their positions with a single
+// compare-and-swap; returns how many were appended, fewer than count once the queue fills
+size_t mpmc_queue_enqueue_bulk(MpmcQueue *queue, void *const *items, size_t count);
+
+// Function to take up to max of the oldest available items from any thread, claiming them with
+// a single compare-and-swap; returns how many were taken, 0 when the queue is empty
+size_t mpmc_queue_dequeue_bulk(MpmcQueue *queue, void **items, size_t max);
+
+// Function to tell whether the oldest position holds no published item yet
+bool mpmc_queue_is_empty(MpmcQueue *queue);
+
+// Function to release the queue; items still queued are left to the caller
+void mpmc_queue_destroy(MpmcQueue *queue);
+
+#endif // MPMC_QUEUE_H
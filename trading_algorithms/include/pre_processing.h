@@ -4,6 +4,9 @@
 #include <stddef.h>
 #include "market_data.h"
 #include "lock_free_queue.h"
+#include "spsc_ring.h"
+#include "wait_strategy.h"
+#include "order_book.h"
 
 typedef struct {
     double *prices;
@@ -21,6 +24,7 @@ typedef struct {
 
 typedef struct {
     double minimum_liquidity;
+    double depth_bps;       // book depth within this many basis points of the touch counts as liquidity
 } LiquidityInfo;
 
 typedef struct {
@@ -41,11 +45,14 @@ typedef struct {
     TrendInfo trend_info;
     double *liquidity;
     size_t liquidity_count;
+    OrderBook *order_book;   // L2 book for the symbol, fed by the caller; NULL judges liquidity by the liquidity series
 } PreProcessedData;
 
 typedef struct {
-    LockFreeQueue *input_queue;
-    LockFreeQueue *output_queue;
+    SpscRing *input_queue;
+    SpscRing *output_queue;
+    WaitStrategy *input_wait;    // how this thread waits for input
+    WaitStrategy *output_wait;   // notified after each push to output_queue
 } PreProcessingArgs;
 
 PreProcessedData *pre_process_data(const RawData *raw_data, size_t rolling_volatility_window_size);
@@ -0,0 +1,49 @@
+// include/spsc_ring.h
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Slots in each pipeline hand-off; rounded up to a power of two
+#define SPSC_RING_DEFAULT_CAPACITY 65536
+
+// Fixed-capacity queue of pointers between exactly one producer thread and one consumer
+// thread. Slots are allocated once, so a hand-off is a store into the array and a release of
+// the index. Each index sits on its own cache line next to the owner's cached copy of the
+// other index, so the two threads only touch each other's line when the cached view says
+// the ring looks full (producer) or empty (consumer).
+typedef struct {
+    _Alignas(64) _Atomic size_t tail;   // next slot the producer fills
+    size_t cached_head;                 // producer's last view of head
+    _Alignas(64) _Atomic size_t head;   // next slot the consumer empties
+    size_t cached_tail;                 // consumer's last view of tail
+    _Alignas(64) size_t mask;           // capacity - 1
+    void **slots;
+} SpscRing;
+
+// Function to create a ring holding at least capacity items; NULL if allocation fails
+SpscRing *spsc_ring_init(size_t capacity);
+
+// Function to append an item from the producer thread; returns false when the ring is full
+bool spsc_ring_push(SpscRing *ring, void *item);
+
+// Function to take the oldest item from the consumer thread; returns NULL when the ring is empty
+void *spsc_ring_pop(SpscRing *ring);
+
+// Function to append up to count items from the producer thread with a single index update;
+// returns how many were appended, fewer than count once the ring fills
+size_t spsc_ring_push_bulk(SpscRing *ring, void *const *items, size_t count);
+
+// Function to take up to max of the oldest items from the consumer thread with a single index
+// update; returns how many were taken, 0 when the ring is empty
+size_t spsc_ring_pop_bulk(SpscRing *ring, void **items, size_t max);
+
+// Function to tell whether the ring holds no items
+bool spsc_ring_is_empty(SpscRing *ring);
+
+// Function to release the ring; items still queued are left to the caller
+void spsc_ring_destroy(SpscRing *ring);
+
+#endif // SPSC_RING_H
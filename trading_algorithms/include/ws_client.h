@@ -0,0 +1,98 @@
+// include/ws_client.h
+#ifndef WS_CLIENT_H
+#define WS_CLIENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <curl/curl.h>
+
+// Largest message the client will reassemble; Binance stream messages are well under 4 KB
+#define WS_MAX_MESSAGE (1 << 20)
+// Initial receive buffer, large enough for a burst of stream messages
+#define WS_BUFFER_RESERVE (64 * 1024)
+// How long the opening handshake may take
+#define WS_HANDSHAKE_TIMEOUT_MS 5000
+
+typedef enum {
+    WS_OPCODE_CONTINUATION = 0x0,
+    WS_OPCODE_TEXT = 0x1,
+    WS_OPCODE_BINARY = 0x2,
+    WS_OPCODE_CLOSE = 0x8,
+    WS_OPCODE_PING = 0x9,
+    WS_OPCODE_PONG = 0xA
+} WsOpcode;
+
+// Where a connection opened with ws_client_open has got to
+typedef enum {
+    WS_STATE_CONNECTING,        // TCP connect in progress on a non-blocking socket
+    WS_STATE_HANDSHAKE,         // upgrade request being sent or its response awaited
+    WS_STATE_OPEN
+} WsState;
+
+// Called once per complete data message; message points into the client's buffers and is
+// only valid for the duration of the call
+typedef void (*WsMessageHandler)(const char *message, size_t length, void *userdata);
+
+// RFC 6455 client over a libcurl CONNECT_ONLY connection, so ws:// and wss:// URLs share one
+// code path and TLS comes from the library already linked for the REST fetcher
+typedef struct {
+    CURL *easy;
+    curl_socket_t socket;
+    WsState state;
+    bool socket_in_curl;        // handed to libcurl, which closes it on cleanup
+    char request[1024];         // opening handshake, sent once the socket connects
+    size_t request_length;
+    size_t request_sent;
+    char expected_accept[32];   // Sec-WebSocket-Accept the server must answer with
+    char *buffer;               // received bytes not yet consumed as frames
+    size_t buffer_length;
+    size_t buffer_capacity;
+    char *message;              // fragments of a message split over continuation frames
+    size_t message_length;
+    size_t message_capacity;
+    bool in_fragmented_message;
+    bool closed;
+    uint32_t mask_state;        // xorshift state for client frame masks
+    long long received_ns;      // monotonic time the newest bytes arrived
+} WsClient;
+
+// Function to open url ("ws://host:port/path" or "wss://...") and complete the upgrade handshake,
+// blocking for at most WS_HANDSHAKE_TIMEOUT_MS;
+// main() must have called curl_global_init before any thread connects
+int ws_client_connect(WsClient *client, const char *url);
+
+// Function to start connecting to url without blocking on the network; client->socket is set
+// and ws_client_advance is called whenever it is ready for ws_client_wants_write's direction.
+// Only name resolution blocks, and for wss:// the TLS handshake, which libcurl runs inside
+// the first ws_client_advance once the TCP connect has completed
+int ws_client_open(WsClient *client, const char *url);
+
+// Function to move a connection started by ws_client_open forward as far as it can go without
+// waiting; returns 1 once the upgrade is complete, 0 if it needs the socket ready again, -1 on failure
+int ws_client_advance(WsClient *client);
+
+// Function to tell whether an opening connection waits to write (true) or to read (false)
+bool ws_client_wants_write(const WsClient *client);
+
+// Function to start a non-blocking TCP connect to host:port; returns the socket, or -1
+int ws_tcp_connect_start(const char *host, const char *port);
+
+// Function to check a connect started by ws_tcp_connect_start once its socket is writable;
+// returns 0 when connected, 1 if still in progress, -1 if it failed
+int ws_tcp_connect_finish(int fd);
+
+// Function to wait up to timeout_ms for data and deliver every complete message to handler;
+// returns the number of messages delivered (0 on timeout), or -1 once the connection is closed
+int ws_client_poll(WsClient *client, int timeout_ms, WsMessageHandler handler, void *userdata);
+
+// Function to send one masked frame
+int ws_client_send(WsClient *client, WsOpcode opcode, const char *payload, size_t length);
+
+// Function to send a close frame if still open and release the connection
+void ws_client_close(WsClient *client);
+
+// Function to get the current CLOCK_MONOTONIC time in nanoseconds
+long long ws_monotonic_ns(void);
+
+#endif // WS_CLIENT_H
@@ -7,7 +7,7 @@ static double calculate_position_size(double price_difference, const RiskManagem
 static double calculate_standard_deviation(const double *values, size_t count, size_t window_size);
 static double trend_strength(const PreProcessedData *data);
 static bool is_trade_profitable(double price_difference, double transaction_costs, double latency, const LiquidityInfo *liquidity_info, double liquidity);
-static double get_current_liquidity(const PreProcessedData *data);
+static double get_current_liquidity(const PreProcessedData *data, BookSide side, double *available_quantity);
 
 TradeSignal execute_algorithm(const PreProcessedData *data, TradingAlgorithm algorithm, const RiskManagementSettings *settings) {
     // Execute the specific trading algorithm to generate a trade signal
@@ -23,7 +23,9 @@ TradeSignal arbitrage_trading_strategy(const PreProcessedData *data) {
     const double base_threshold = 0.01;
     double dynamic_threshold = calculate_dynamic_threshold(data, base_threshold);
     double current_price_difference = data->price_differences[data->price_difference_count - 1];
-    double liquidity = get_current_liquidity(data);
+    // A buy takes liquidity from the asks, a sell from the bids
+    double available_quantity;
+    double liquidity = get_current_liquidity(data, current_price_difference > 0 ? BOOK_SIDE_ASK : BOOK_SIDE_BID, &available_quantity);
     bool trade_is_profitable = is_trade_profitable(
         current_price_difference,
         data->transaction_costs,
@@ -33,11 +35,11 @@ TradeSignal arbitrage_trading_strategy(const PreProcessedData *data) {
     );
 
     if (trade_is_profitable && current_price_difference > dynamic_threshold && trend_strength(data) > 0) {
-        double position_size = calculate_position_size(current_price_difference, &data->risk_management_params);
+        double position_size = fmin(calculate_position_size(current_price_difference, &data->risk_management_params), available_quantity);
         TradeSignal signal = {BUY, position_size};
         return signal;
     } else if (trade_is_profitable && current_price_difference < -dynamic_threshold && trend_strength(data) < 0) {
-        double position_size = calculate_position_size(-current_price_difference, &data->risk_management_params);
+        double position_size = fmin(calculate_position_size(-current_price_difference, &data->risk_management_params), available_quantity);
         TradeSignal signal = {SELL, position_size};
         return signal;
     }
@@ -96,8 +98,15 @@ static bool is_trade_profitable(double price_difference, double transaction_cost
     return (price_difference - transaction_costs - latency > 0) && (liquidity >= liquidity_info->minimum_liquidity);
 }
 
-static double get_current_liquidity(const PreProcessedData *data) {
-    // Placeholder implementation; replace with actual liquidity retrieval
+// Liquidity a trade on side can draw on: with an order book, the notional resting within
+// depth_bps of the touch, whose quantity also caps the position; otherwise the latest liquidity sample
+static double get_current_liquidity(const PreProcessedData *data, BookSide side, double *available_quantity) {
+    double notional;
+    if (data->order_book &&
+        order_book_depth(data->order_book, side, data->liquidity_info.depth_bps, available_quantity, &notional) == 0) {
+        return notional;
+    }
+    *available_quantity = HUGE_VAL;
     if (data->liquidity_count > 0) {
         return data->liquidity[data->liquidity_count - 1];
     }
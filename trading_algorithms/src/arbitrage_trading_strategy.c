@@ -72,24 +72,35 @@ bool is_trade_profitable(double price_difference, double transaction_costs, doub
 // Define the base_threshold
 const double base_threshold = 0.01;
 
-double get_current_liquidity(const PreProcessedData *data)
+// Liquidity a trade on side can draw on: with an order book, the notional resting within
+// depth_bps of the touch, whose quantity also caps the position; otherwise the latest liquidity sample
+double get_current_liquidity(const PreProcessedData *data, BookSide side, double *available_quantity)
 {
-    // Implement this function to return the current liquidity based on the PreProcessedData structure
-    // This is a placeholder implementation; replace with your own method of obtaining liquidity
-    (void)data;
-    return 100000;
+    double notional;
+    if (data->order_book && order_book_depth(data->order_book, side, data->liquidity_info.depth_bps, available_quantity, &notional) == 0)
+    {
+        return notional;
+    }
+    *available_quantity = HUGE_VAL;
+    if (data->liquidity_count > 0)
+    {
+        return data->liquidity[data->liquidity_count - 1];
+    }
+    return 0;
 }
 
 TradeSignal arbitrage_trading_strategy(const PreProcessedData *data)
 {
     double dynamic_threshold = calculate_dynamic_threshold(data, base_threshold);
     double current_price_difference = data->price_differences[data->price_difference_count - 1];
-    double liquidity = get_current_liquidity(data);
+    // A buy takes liquidity from the asks, a sell from the bids
+    double available_quantity;
+    double liquidity = get_current_liquidity(data, current_price_difference > 0 ? BOOK_SIDE_ASK : BOOK_SIDE_BID, &available_quantity);
     bool trade_is_profitable = is_trade_profitable(current_price_difference, data->transaction_costs, data->latency, &data->liquidity_info, liquidity);
 
     if (trade_is_profitable && current_price_difference > dynamic_threshold && trend_strength(data) > 0)
     {
-        double position_size = calculate_position_size(current_price_difference, &data->risk_management_params);
+        double position_size = fmin(calculate_position_size(current_price_difference, &data->risk_management_params), available_quantity);
         TradeSignal signal;
         signal.action = BUY;
         signal.position_size = position_size;
@@ -97,7 +108,7 @@ TradeSignal arbitrage_trading_strategy(const PreProcessedData *data)
     }
     else if (trade_is_profitable && current_price_difference < -dynamic_threshold && trend_strength(data) < 0)
     {
-        double position_size = calculate_position_size(-current_price_difference, &data->risk_management_params);
+        double position_size = fmin(calculate_position_size(-current_price_difference, &data->risk_management_params), available_quantity);
         TradeSignal signal;
         signal.action = SELL;
         signal.position_size = position_size;
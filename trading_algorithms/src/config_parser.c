@@ -11,5 +11,7 @@ int load_config(const char *config_file_path, ConfigParams *params) {
     params->ema_alpha = 0.1;
     params->rsi_period = 14;
     params->bollinger_multiplier = 2.0;
+    params->input_wait = WAIT_MODE_PARK;
+    params->output_wait = WAIT_MODE_PARK;
     return 0;
 }
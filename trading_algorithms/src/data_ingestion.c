@@ -2,17 +2,32 @@
 #include <stdio.h>
 #include <string.h>
 #include <pthread.h>
+#include <curl/curl.h>
 #include "market_data.h"
 #include "market_data_pool.h"
-#include "lock_free_queue.h"
+#include "mpmc_queue.h"
+#include "feed_handler.h"
+#include "wait_strategy.h"
 
-// Define a struct to hold the arguments for data ingestion threads
+// Define a struct to hold the arguments for the data ingestion thread
 typedef struct DataIngestionArgs {
-    LockFreeQueue *queue;
+    MpmcQueue *queue;            // shared by every ingestion thread
     MarketDataPool *pool;
-    // Other arguments such as data source information
+    WaitStrategy *consumer_wait; // notified after every publish
+    const char *const *sources;  // ws://, wss:// or tcp:// feeds of one exchange, all read by one thread
+    size_t source_count;
 } DataIngestionArgs;
 
+// Define a struct to hold the arguments for the thread that drains the shared queue
+typedef struct DataConsumerArgs {
+    MpmcQueue *queue;
+    MarketDataPool *pool;
+    WaitStrategy wait;
+    size_t consumed;
+} DataConsumerArgs;
+
+static int running = 1;
+
 // Replace this function with actual implementation using appropriate third-party libraries
 MarketData *fetch_market_data() {
     MarketData *data = (MarketData *)malloc(sizeof(MarketData));
@@ -23,10 +38,55 @@ MarketData *fetch_market_data() {
     return data;
 }
 
-void *nasdaq_data_ingestion_thread(void *args) {
+// Copy a batch of ticks into pool slots and publish them to the shared queue in one claim
+static void enqueue_pool_batch(MarketData *ticks, size_t count, void *userdata) {
+    DataIngestionArgs *ingestion_args = (DataIngestionArgs *)userdata;
+    void *slots[FEED_MAX_BATCH];
+    size_t filled = 0;
+    for (size_t i = 0; i < count && filled < FEED_MAX_BATCH; i++) {
+        MarketData *pool_data = market_data_pool_alloc(ingestion_args->pool);
+        if (pool_data == NULL) {
+            // No free slots in the memory pool; the tick is dropped
+            continue;
+        }
+        memcpy(pool_data, &ticks[i], sizeof(MarketData));
+        slots[filled++] = pool_data;
+    }
+    if (filled == 0) {
+        return;
+    }
+    // A full queue means the consumers are behind; the ticks that did not fit are dropped
+    // rather than stalling this exchange's sockets
+    size_t published = mpmc_queue_enqueue_bulk(ingestion_args->queue, slots, filled);
+    if (published > 0) {
+        wait_strategy_notify(ingestion_args->consumer_wait);
+    }
+    for (size_t i = published; i < filled; i++) {
+        market_data_pool_free(ingestion_args->pool, (MarketData *)slots[i]);
+    }
+}
+
+// Length of the scheme://host:port prefix that tells which exchange a source belongs to
+static size_t exchange_prefix_length(const char *source) {
+    const char *host = strstr(source, "://");
+    host = host ? host + 3 : source;
+    return (size_t)(host - source) + strcspn(host, "/");
+}
+
+void *data_ingestion_thread(void *args) {
     DataIngestionArgs *ingestion_args = (DataIngestionArgs *)args;
 
-    while (1) {
+    // One epoll loop serves every source, so adding symbols adds sockets, not threads
+    if (ingestion_args->source_count > 0) {
+        FeedHandler feed;
+        if (feed_handler_init(&feed, ingestion_args->sources, ingestion_args->source_count, enqueue_pool_batch, ingestion_args, &running) == 0) {
+            feed_handler_run(&feed);
+            feed_handler_destroy(&feed);
+        }
+        return NULL;
+    }
+
+    while (running) {
         MarketData *market_data = fetch_market_data();
         if (market_data == NULL) {
             // Handle error when fetching market data
@@ -41,29 +101,107 @@ void *nasdaq_data_ingestion_thread(void *args) {
         }
 
         memcpy(pool_data, market_data, sizeof(MarketData));
-        lock_free_queue_enqueue(ingestion_args->queue, pool_data);
+        if (mpmc_queue_enqueue(ingestion_args->queue, pool_data)) {
+            wait_strategy_notify(ingestion_args->consumer_wait);
+        } else {
+            // The queue is full; the slot goes back to the pool and the tick is dropped
+            market_data_pool_free(ingestion_args->pool, pool_data);
+        }
         free(market_data);
     }
 
     return NULL;
 }
 
-int main() {
-    // Initialize the lock-free queue and the market data pool
-    LockFreeQueue *queue = lock_free_queue_init();
+static bool queue_ready(void *arg) {
+    return !mpmc_queue_is_empty((MpmcQueue *)arg);
+}
+
+// Drain the shared queue in batches and return each tick's slot to the pool, so the pool
+// only runs dry while this thread is behind
+void *data_consumer_thread(void *args) {
+    DataConsumerArgs *consumer_args = (DataConsumerArgs *)args;
+    void *items[FEED_MAX_BATCH];
+    for (;;) {
+        size_t count = mpmc_queue_dequeue_bulk(consumer_args->queue, items, FEED_MAX_BATCH);
+        if (count == 0) {
+            if (!wait_strategy_wait(&consumer_args->wait, queue_ready, consumer_args->queue, &running)) {
+                break;
+            }
+            continue;
+        }
+        for (size_t i = 0; i < count; i++) {
+            market_data_pool_free(consumer_args->pool, (MarketData *)items[i]);
+        }
+        consumer_args->consumed += count;
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    // libcurl's global state is set up once, before the ingestion threads connect
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    // Initialize the queue every ingestion thread publishes to, and the market data pool
+    MpmcQueue *queue = mpmc_queue_init(MPMC_QUEUE_DEFAULT_CAPACITY);
     MarketDataPool *pool = market_data_pool_init(1000);
+    size_t source_count = argc > 1 ? (size_t)(argc - 1) : 0;
+    const char **sources = (const char **)malloc(sizeof(const char *) * (source_count + 1));
+    DataIngestionArgs *ingestion_args = (DataIngestionArgs *)malloc(sizeof(DataIngestionArgs) * (source_count + 1));
+    pthread_t *ingestion_threads = (pthread_t *)malloc(sizeof(pthread_t) * (source_count + 1));
+    DataConsumerArgs consumer_args = {.queue = queue, .pool = pool, .consumed = 0};
+    wait_strategy_init(&consumer_args.wait, WAIT_MODE_PARK);
+    if (!queue || !pool || !sources || !ingestion_args || !ingestion_threads) {
+        fprintf(stderr, "Failed to allocate the ingestion threads\n");
+        return 1;
+    }
 
-    // Create and start data ingestion threads
-    pthread_t nasdaq_thread;
-    DataIngestionArgs nasdaq_args = {queue, pool};
-    pthread_create(&nasdaq_thread, NULL, nasdaq_data_ingestion_thread, (void *)&nasdaq_args);
+    // Sources are grouped by exchange and each exchange gets its own ingestion thread, so one
+    // venue's slow or bursty connection does not hold up another's; without sources a single
+    // thread runs the placeholder feed
+    size_t thread_count = 0;
+    size_t grouped = 0;
+    bool *assigned = (bool *)calloc(source_count + 1, sizeof(bool));
+    for (size_t i = 0; i < source_count; i++) {
+        if (assigned[i]) {
+            continue;
+        }
+        const char *first = argv[i + 1];
+        size_t prefix = exchange_prefix_length(first);
+        DataIngestionArgs *group = &ingestion_args[thread_count++];
+        *group = (DataIngestionArgs){queue, pool, &consumer_args.wait, sources + grouped, 0};
+        for (size_t j = i; j < source_count; j++) {
+            if (!assigned[j] && exchange_prefix_length(argv[j + 1]) == prefix && strncmp(argv[j + 1], first, prefix) == 0) {
+                assigned[j] = true;
+                sources[grouped++] = argv[j + 1];
+                group->source_count++;
+            }
+        }
+    }
+    free(assigned);
+    if (thread_count == 0) {
+        ingestion_args[thread_count++] = (DataIngestionArgs){queue, pool, &consumer_args.wait, sources, 0};
+    }
+    pthread_t consumer_thread;
+    pthread_create(&consumer_thread, NULL, data_consumer_thread, (void *)&consumer_args);
+    for (size_t i = 0; i < thread_count; i++) {
+        pthread_create(&ingestion_threads[i], NULL, data_ingestion_thread, (void *)&ingestion_args[i]);
+    }
 
-    // Wait for the thread to finish (in this example, the thread runs indefinitely)
-    pthread_join(nasdaq_thread, NULL);
+    // Wait for the threads to finish (in this example, they run indefinitely)
+    for (size_t i = 0; i < thread_count; i++) {
+        pthread_join(ingestion_threads[i], NULL);
+    }
+    wait_strategy_wake_all(&consumer_args.wait);
+    pthread_join(consumer_thread, NULL);
 
     // Clean up resources
-    lock_free_queue_destroy(queue);
+    mpmc_queue_destroy(queue);
     market_data_pool_destroy(pool);
+    free(ingestion_threads);
+    free(ingestion_args);
+    free(sources);
+    curl_global_cleanup();
 
     return 0;
 }
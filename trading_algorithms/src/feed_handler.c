@@ -0,0 +1,288 @@
+// src/feed_handler.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include "feed_handler.h"
+#include "market_stream.h"
+
+int feed_handler_init(FeedHandler *handler, const char *const *urls, size_t url_count, FeedBatchHandler on_batch, void *userdata, const int *running) {
+    memset(handler, 0, sizeof(*handler));
+    handler->on_batch = on_batch;
+    handler->userdata = userdata;
+    handler->running = running;
+    handler->epoll_fd = epoll_create1(0);
+    handler->sources = (FeedSource *)calloc(url_count ? url_count : 1, sizeof(FeedSource));
+    if (handler->epoll_fd < 0 || !handler->sources) {
+        printf("Failed to initialize the feed handler\n");
+        feed_handler_destroy(handler);
+        return -1;
+    }
+    handler->source_count = url_count;
+
+    for (size_t i = 0; i < url_count; i++) {
+        FeedSource *source = &handler->sources[i];
+        source->url = urls[i];
+        source->fd = -1;
+        if (strncmp(urls[i], "tcp://", 6) == 0) {
+            source->type = FEED_SOURCE_TCP;
+            source->buffer = (char *)malloc(FEED_TCP_BUFFER);
+            if (!source->buffer) {
+                feed_handler_destroy(handler);
+                return -1;
+            }
+        } else if (strncmp(urls[i], "ws://", 5) == 0 || strncmp(urls[i], "wss://", 6) == 0) {
+            source->type = FEED_SOURCE_WEBSOCKET;
+        } else {
+            printf("Unsupported feed source %s\n", urls[i]);
+            feed_handler_destroy(handler);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Hand the collected ticks to the pipeline in one call
+static void flush_batch(FeedHandler *handler) {
+    if (handler->batch_count == 0) {
+        return;
+    }
+    handler->on_batch(handler->batch, handler->batch_count, handler->userdata);
+    handler->ticks += handler->batch_count;
+    handler->batches++;
+    handler->batch_count = 0;
+}
+
+// Decode one message into the next batch slot
+static void handle_message(const char *message, size_t length, void *userdata) {
+    FeedHandler *handler = (FeedHandler *)userdata;
+    handler->messages++;
+    int status = market_stream_parse(message, length, &handler->batch[handler->batch_count]);
+    if (status < 0) {
+        printf("Skipping malformed feed message: %.*s\n", length > 120 ? 120 : (int)length, message);
+    } else if (status > 0 && ++handler->batch_count == FEED_MAX_BATCH) {
+        flush_batch(handler);
+    }
+}
+
+// Start a non-blocking TCP connection to tcp://host:port
+static int connect_tcp(const char *url) {
+    char host[256];
+    char port[16];
+    if (sscanf(url, "tcp://%255[^:/]:%15[0-9]", host, port) != 2) {
+        printf("Feed source %s needs the form tcp://host:port\n", url);
+        return -1;
+    }
+    int fd = ws_tcp_connect_start(host, port);
+    if (fd < 0) {
+        printf("Feed connect to %s failed\n", url);
+    }
+    return fd;
+}
+
+static int source_socket(const FeedSource *source) {
+    return source->type == FEED_SOURCE_TCP ? source->fd : (int)source->ws.socket;
+}
+
+// Watch the source's socket for what it waits on next: writable while connecting, readable after
+static int watch_source(FeedHandler *handler, FeedSource *source, int operation) {
+    bool write = source->state == FEED_SOURCE_CONNECTING &&
+                 (source->type == FEED_SOURCE_TCP || ws_client_wants_write(&source->ws));
+    struct epoll_event event = {.events = (write ? EPOLLOUT : EPOLLIN) | EPOLLRDHUP, .data.ptr = source};
+    if (epoll_ctl(handler->epoll_fd, operation, source_socket(source), &event) != 0) {
+        printf("Could not watch feed source %s: %s\n", source->url, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static void close_source(FeedHandler *handler, FeedSource *source) {
+    if (source->state == FEED_SOURCE_DOWN) {
+        return;
+    }
+    epoll_ctl(handler->epoll_fd, EPOLL_CTL_DEL, source_socket(source), NULL);
+    if (source->type == FEED_SOURCE_TCP) {
+        close(source->fd);
+        source->fd = -1;
+    } else {
+        ws_client_close(&source->ws);
+    }
+    source->state = FEED_SOURCE_DOWN;
+}
+
+// Take a source down and schedule its reconnect
+static void drop_source(FeedHandler *handler, FeedSource *source) {
+    close_source(handler, source);
+    source->reconnect_at_ns = ws_monotonic_ns() + FEED_RECONNECT_MS * 1000000LL;
+}
+
+// Start connecting a source and register its socket; nothing here waits on the network
+static int open_source(FeedHandler *handler, FeedSource *source) {
+    if (source->type == FEED_SOURCE_TCP) {
+        source->fd = connect_tcp(source->url);
+        if (source->fd < 0) {
+            return -1;
+        }
+        source->buffer_length = 0;
+    } else if (ws_client_open(&source->ws, source->url) != 0) {
+        return -1;
+    }
+    source->state = FEED_SOURCE_CONNECTING;
+    source->connect_deadline_ns = ws_monotonic_ns() + WS_HANDSHAKE_TIMEOUT_MS * 1000000LL;
+    if (watch_source(handler, source, EPOLL_CTL_ADD) != 0) {
+        // Not registered yet, so only the socket is closed
+        if (source->type == FEED_SOURCE_TCP) {
+            close(source->fd);
+            source->fd = -1;
+        } else {
+            ws_client_close(&source->ws);
+        }
+        source->state = FEED_SOURCE_DOWN;
+        return -1;
+    }
+    return 0;
+}
+
+// Read everything a tcp:// source has ready and decode each complete line; -1 once it closed
+static int read_tcp(FeedHandler *handler, FeedSource *source) {
+    for (;;) {
+        ssize_t n = recv(source->fd, source->buffer + source->buffer_length, FEED_TCP_BUFFER - source->buffer_length, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return 0;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        source->buffer_length += (size_t)n;
+
+        char *line = source->buffer;
+        char *end = source->buffer + source->buffer_length;
+        char *newline;
+        while ((newline = memchr(line, '\n', (size_t)(end - line))) != NULL) {
+            if (newline > line) {
+                source->messages++;
+                handle_message(line, (size_t)(newline - line), handler);
+            }
+            line = newline + 1;
+        }
+        source->buffer_length = (size_t)(end - line);
+        memmove(source->buffer, line, source->buffer_length);
+        if (source->buffer_length == FEED_TCP_BUFFER) {
+            printf("Feed line from %s exceeds %d bytes\n", source->url, FEED_TCP_BUFFER);
+            return -1;
+        }
+    }
+}
+
+// Move a connecting source on now that its socket is ready; returns 1 once it is up
+static int advance_source(FeedHandler *handler, FeedSource *source) {
+    int status;
+    if (source->type == FEED_SOURCE_TCP) {
+        status = ws_tcp_connect_finish(source->fd);
+        status = status == 0 ? 1 : status > 0 ? 0 : -1;
+    } else {
+        status = ws_client_advance(&source->ws);
+    }
+    if (status < 0) {
+        printf("Feed connect to %s failed, retrying\n", source->url);
+        drop_source(handler, source);
+        return -1;
+    }
+    if (status > 0) {
+        source->state = FEED_SOURCE_UP;
+    }
+    if (watch_source(handler, source, EPOLL_CTL_MOD) != 0) {
+        drop_source(handler, source);
+        return -1;
+    }
+    return status;
+}
+
+static void read_source(FeedHandler *handler, FeedSource *source) {
+    int status;
+    if (source->type == FEED_SOURCE_TCP) {
+        status = read_tcp(handler, source);
+    } else {
+        // A zero timeout drains what is ready without another poll
+        size_t before = handler->messages;
+        status = ws_client_poll(&source->ws, 0, handle_message, handler);
+        source->messages += handler->messages - before;
+    }
+    if (status < 0) {
+        printf("Feed source %s disconnected, reconnecting\n", source->url);
+        drop_source(handler, source);
+    }
+}
+
+// Start connecting sources that are down and due, and give up on connects past their deadline;
+// returns the milliseconds until the next of those is due
+static int reconnect_sources(FeedHandler *handler) {
+    long long now = ws_monotonic_ns();
+    long long next = now + FEED_POLL_MS * 1000000LL;
+    for (size_t i = 0; i < handler->source_count && *handler->running; i++) {
+        FeedSource *source = &handler->sources[i];
+        if (source->state == FEED_SOURCE_CONNECTING && source->connect_deadline_ns <= now) {
+            printf("Feed connect to %s timed out, retrying\n", source->url);
+            drop_source(handler, source);
+        }
+        if (source->state == FEED_SOURCE_DOWN && source->reconnect_at_ns <= now && open_source(handler, source) != 0) {
+            source->reconnect_at_ns = now + FEED_RECONNECT_MS * 1000000LL;
+        }
+        long long due = source->state == FEED_SOURCE_CONNECTING ? source->connect_deadline_ns :
+                        source->state == FEED_SOURCE_DOWN ? source->reconnect_at_ns : next;
+        if (due < next) {
+            next = due;
+        }
+    }
+    long long wait_ms = (next - ws_monotonic_ns()) / 1000000;
+    return wait_ms < 0 ? 0 : (int)wait_ms;
+}
+
+int feed_handler_run(FeedHandler *handler) {
+    struct epoll_event events[FEED_EPOLL_EVENTS];
+    while (*handler->running) {
+        int timeout_ms = reconnect_sources(handler);
+        int ready = epoll_wait(handler->epoll_fd, events, FEED_EPOLL_EVENTS, timeout_ms);
+        if (ready < 0 && errno != EINTR) {
+            printf("Feed epoll_wait failed: %s\n", strerror(errno));
+            return -1;
+        }
+        for (int i = 0; i < ready; i++) {
+            FeedSource *source = (FeedSource *)events[i].data.ptr;
+            if (source->state == FEED_SOURCE_CONNECTING && advance_source(handler, source) <= 0) {
+                continue;
+            }
+            // Read straight after connecting too: frames can arrive with the upgrade response
+            if (source->state == FEED_SOURCE_UP) {
+                read_source(handler, source);
+            }
+        }
+        // Everything that arrived together goes out together
+        flush_batch(handler);
+    }
+    for (size_t i = 0; i < handler->source_count; i++) {
+        close_source(handler, &handler->sources[i]);
+    }
+    return 0;
+}
+
+void feed_handler_destroy(FeedHandler *handler) {
+    for (size_t i = 0; handler->sources && i < handler->source_count; i++) {
+        close_source(handler, &handler->sources[i]);
+        free(handler->sources[i].buffer);
+    }
+    free(handler->sources);
+    handler->sources = NULL;
+    handler->source_count = 0;
+    if (handler->epoll_fd >= 0) {
+        close(handler->epoll_fd);
+    }
+    handler->epoll_fd = -1;
+}
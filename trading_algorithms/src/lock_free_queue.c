@@ -21,6 +21,30 @@ void lock_free_queue_enqueue(LockFreeQueue *queue, void *data) {
     atomic_store(&prev_tail->next, node);
 }
 
+void lock_free_queue_enqueue_batch(LockFreeQueue *queue, void *const *items, size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    // The nodes are linked privately, then published to consumers as one chain
+    LockFreeQueueNode *first = NULL;
+    LockFreeQueueNode *last = NULL;
+    for (size_t i = 0; i < count; i++) {
+        LockFreeQueueNode *node = (LockFreeQueueNode *)malloc(sizeof(LockFreeQueueNode));
+        node->data = items[i];
+        node->next = NULL;
+        if (last) {
+            last->next = node;
+        } else {
+            first = node;
+        }
+        last = node;
+    }
+
+    LockFreeQueueNode *prev_tail = atomic_exchange(&queue->tail, last);
+    atomic_store(&prev_tail->next, first);
+}
+
 void *lock_free_queue_dequeue(LockFreeQueue *queue) {
     LockFreeQueueNode *head;
     void *data;
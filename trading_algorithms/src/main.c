@@ -2,19 +2,24 @@
 #include <stdlib.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#include <curl/curl.h>
 #include "market_data.h"
 #include "market_data_pool.h"
-#include "lock_free_queue.h"
+#include "spsc_ring.h"
+#include "wait_strategy.h"
 #include "pre_processing.h"
 #include "config_parser.h"
 #include "algorithm_execution.h"
 #include "risk_management.h"
+#include "feed_handler.h"
 
-// Global variables for synchronization
-pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
-pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
 int running = 1;
 
+// Ticks the pre-processing thread takes from its ring at once
+#define PRE_PROCESSING_BATCH 256
+
 // Placeholder function to fetch market data
 MarketData *fetch_market_data() {
     // Implement actual market data fetching logic
@@ -26,15 +31,92 @@ MarketData *fetch_market_data() {
     return data;
 }
 
+typedef struct {
+    SpscRing *queue;
+    WaitStrategy *wait;         // the pre-processing thread's wait on queue
+    const char *const *sources;
+    size_t source_count;
+} DataIngestionArgs;
+
+// Push onto a pipeline ring, yielding to the consumer while it is full; false if the
+// pipeline stopped first
+static bool push_waiting(SpscRing *queue, void *data) {
+    while (!spsc_ring_push(queue, data)) {
+        if (!running) {
+            return false;
+        }
+        sched_yield();
+    }
+    return true;
+}
+
+// Push a batch onto a pipeline ring, yielding to the consumer while it is full; returns how
+// many were pushed before the pipeline stopped
+static size_t push_bulk_waiting(SpscRing *queue, void *const *items, size_t count) {
+    size_t pushed = 0;
+    while ((pushed += spsc_ring_push_bulk(queue, items + pushed, count - pushed)) < count) {
+        if (!running) {
+            break;
+        }
+        sched_yield();
+    }
+    return pushed;
+}
+
+static bool ring_has_items(void *ring) {
+    return !spsc_ring_is_empty((SpscRing *)ring);
+}
+
+// Hand one tick to the pre-processing thread
+static void enqueue_tick(MarketData *data, void *userdata) {
+    DataIngestionArgs *ingestion_args = (DataIngestionArgs *)userdata;
+    if (!push_waiting(ingestion_args->queue, data)) {
+        free(data);
+        return;
+    }
+    wait_strategy_notify(ingestion_args->wait);
+}
+
+// Hand a batch of ticks to the pre-processing thread with one update of the ring's tail and
+// a single wake-up
+static void enqueue_batch(MarketData *ticks, size_t count, void *userdata) {
+    DataIngestionArgs *ingestion_args = (DataIngestionArgs *)userdata;
+    void *batch[FEED_MAX_BATCH];
+    size_t filled = 0;
+    for (size_t i = 0; i < count && filled < FEED_MAX_BATCH; i++) {
+        MarketData *data = (MarketData *)malloc(sizeof(MarketData));
+        if (data) {
+            *data = ticks[i];
+            batch[filled++] = data;
+        }
+    }
+    if (filled == 0) {
+        return;
+    }
+    size_t pushed = push_bulk_waiting(ingestion_args->queue, batch, filled);
+    for (size_t i = pushed; i < filled; i++) {
+        free(batch[i]);
+    }
+    wait_strategy_notify(ingestion_args->wait);
+}
+
 void *data_ingestion_thread(void *args) {
-    LockFreeQueue *queue = (LockFreeQueue *)args;
+    DataIngestionArgs *ingestion_args = (DataIngestionArgs *)args;
+
+    // Every source shares this one thread, however many symbols are streamed
+    if (ingestion_args->source_count > 0) {
+        FeedHandler feed;
+        if (feed_handler_init(&feed, ingestion_args->sources, ingestion_args->source_count, enqueue_batch, ingestion_args, &running) == 0) {
+            feed_handler_run(&feed);
+            feed_handler_destroy(&feed);
+        }
+        return NULL;
+    }
+
     while (running) {
-        MarketData *data = fetch_market_data();
-        pthread_mutex_lock(&mutex);
-        lock_free_queue_enqueue(queue, data);
-        pthread_cond_signal(&cond);
-        pthread_mutex_unlock(&mutex);
-        usleep(100000); // Simulate data fetching interval
+        enqueue_tick(fetch_market_data(), ingestion_args);
+        struct timespec interval = {0, 100 * 1000000L};
+        nanosleep(&interval, NULL); // Simulate data fetching interval
     }
     return NULL;
 }
@@ -49,64 +131,72 @@ void *pre_processing_thread(void *args) {
     size_t n = 0;
     double previous_price = 0;
 
+    void *batch[PRE_PROCESSING_BATCH];
     while (running) {
-        pthread_mutex_lock(&mutex);
-        while (queue_is_empty(pre_processing_args->input_queue)) {
-            pthread_cond_wait(&cond, &mutex);
-        }
-        pthread_mutex_unlock(&mutex);
-
-        MarketData *data = (MarketData *)lock_free_queue_dequeue(pre_processing_args->input_queue);
-        if (data == NULL) continue;
-
-        n++;
-        // Update moving average
-        window_price_sum += data->price;
-        if (n > pre_processing_args->window_size) {
-            window_price_sum -= data->price; // Placeholder for old price
-            data->moving_average = window_price_sum / pre_processing_args->window_size;
-        } else {
-            data->moving_average = window_price_sum / n;
+        if (!wait_strategy_wait(pre_processing_args->input_wait, ring_has_items, pre_processing_args->input_queue, &running)) {
+            continue;
         }
 
-        // Update EMA
-        if (prev_ema == 0) {
-            prev_ema = data->price;
-        }
-        data->ema = (1 - pre_processing_args->ema_alpha) * prev_ema + pre_processing_args->ema_alpha * data->price;
-        prev_ema = data->ema;
-
-        // Update Bollinger Bands
-        // Implement Welford's method
-        double delta = data->price - mean;
-        mean += delta / n;
-        double delta2 = data->price - mean;
-        M2 += delta * delta2;
-        if (n >= pre_processing_args->window_size) {
-            double variance = M2 / (n - 1);
-            double stddev = sqrt(variance);
-            data->bollinger_upper = mean + pre_processing_args->bollinger_multiplier * stddev;
-            data->bollinger_lower = mean - pre_processing_args->bollinger_multiplier * stddev;
-        }
+        // Take everything waiting, up to a batch, with one update of the ring's head
+        size_t count = spsc_ring_pop_bulk(pre_processing_args->input_queue, batch, PRE_PROCESSING_BATCH);
+        for (size_t b = 0; b < count; b++) {
+            MarketData *data = (MarketData *)batch[b];
 
-        // Update RSI
-        if (n > 1) {
-            double change = data->price - previous_price;
-            if (change > 0) {
-                avg_gain = (avg_gain * (pre_processing_args->rsi_period - 1) + change) / pre_processing_args->rsi_period;
-                avg_loss = (avg_loss * (pre_processing_args->rsi_period - 1)) / pre_processing_args->rsi_period;
+            n++;
+            // Update moving average
+            window_price_sum += data->price;
+            if (n > pre_processing_args->window_size) {
+                window_price_sum -= data->price; // Placeholder for old price
+                data->moving_average = window_price_sum / pre_processing_args->window_size;
             } else {
-                avg_gain = (avg_gain * (pre_processing_args->rsi_period - 1)) / pre_processing_args->rsi_period;
-                avg_loss = (avg_loss * (pre_processing_args->rsi_period - 1) - change) / pre_processing_args->rsi_period;
+                data->moving_average = window_price_sum / n;
+            }
+
+            // Update EMA
+            if (prev_ema == 0) {
+                prev_ema = data->price;
+            }
+            data->ema = (1 - pre_processing_args->ema_alpha) * prev_ema + pre_processing_args->ema_alpha * data->price;
+            prev_ema = data->ema;
+
+            // Update Bollinger Bands
+            // Implement Welford's method
+            double delta = data->price - mean;
+            mean += delta / n;
+            double delta2 = data->price - mean;
+            M2 += delta * delta2;
+            if (n >= pre_processing_args->window_size) {
+                double variance = M2 / (n - 1);
+                double stddev = sqrt(variance);
+                data->bollinger_upper = mean + pre_processing_args->bollinger_multiplier * stddev;
+                data->bollinger_lower = mean - pre_processing_args->bollinger_multiplier * stddev;
             }
-            double rs = avg_gain / avg_loss;
-            data->rsi = 100 - (100 / (1 + rs));
+
+            // Update RSI
+            if (n > 1) {
+                double change = data->price - previous_price;
+                if (change > 0) {
+                    avg_gain = (avg_gain * (pre_processing_args->rsi_period - 1) + change) / pre_processing_args->rsi_period;
+                    avg_loss = (avg_loss * (pre_processing_args->rsi_period - 1)) / pre_processing_args->rsi_period;
+                } else {
+                    avg_gain = (avg_gain * (pre_processing_args->rsi_period - 1)) / pre_processing_args->rsi_period;
+                    avg_loss = (avg_loss * (pre_processing_args->rsi_period - 1) - change) / pre_processing_args->rsi_period;
+                }
+                double rs = avg_gain / avg_loss;
+                data->rsi = 100 - (100 / (1 + rs));
+            }
+            previous_price = data->price;
         }
-        previous_price = data->price;
 
-        // Enqueue processed data
-        lock_free_queue_enqueue(pre_processing_args->output_queue, data);
-        records_processed++;
+        // Publish the batch with one update of the output ring's tail and at most one wake-up
+        size_t pushed = push_bulk_waiting(pre_processing_args->output_queue, batch, count);
+        for (size_t b = pushed; b < count; b++) {
+            free(batch[b]);
+        }
+        if (pushed > 0) {
+            wait_strategy_notify(pre_processing_args->output_wait);
+        }
+        records_processed += count;
     }
     return NULL;
 }
@@ -118,16 +208,39 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
-    LockFreeQueue *input_queue = lock_free_queue_init();
-    LockFreeQueue *output_queue = lock_free_queue_init();
+    // libcurl's global state is set up once, before the feed threads connect
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    // Each hand-off has one producer and one consumer thread
+    SpscRing *input_queue = spsc_ring_init(SPSC_RING_DEFAULT_CAPACITY);
+    SpscRing *output_queue = spsc_ring_init(SPSC_RING_DEFAULT_CAPACITY);
+    if (!input_queue || !output_queue) {
+        fprintf(stderr, "Failed to allocate the pipeline queues.\n");
+        return 1;
+    }
+
+    // Each queue's consumer waits in its own way, so a push only ever wakes that consumer
+    WaitStrategy input_wait, output_wait;
+    wait_strategy_init(&input_wait, params.input_wait);
+    wait_strategy_init(&output_wait, params.output_wait);
 
     pthread_t data_thread, pre_process_thread;
 
-    pthread_create(&data_thread, NULL, data_ingestion_thread, input_queue);
+    // trading_bot [SOURCE...], each a stream such as wss://stream.binance.com:9443/ws/btcusdt@trade
+    // or a tcp://host:port line feed; without sources the simulated feed is used
+    DataIngestionArgs ingestion_args = {
+        .queue = input_queue,
+        .wait = &input_wait,
+        .sources = (const char *const *)(argv + 1),
+        .source_count = argc > 1 ? (size_t)(argc - 1) : 0
+    };
+    pthread_create(&data_thread, NULL, data_ingestion_thread, &ingestion_args);
 
     PreProcessingArgs pre_processing_args = {
         .input_queue = input_queue,
         .output_queue = output_queue,
+        .input_wait = &input_wait,
+        .output_wait = &output_wait,
         .window_size = params.window_size,
         .ema_alpha = params.ema_alpha,
         .rsi_period = params.rsi_period,
@@ -138,13 +251,9 @@ int main(int argc, char *argv[]) {
     // Main loop
     size_t records_processed = 0;
     while (records_processed < params.max_records_to_process) {
-        pthread_mutex_lock(&mutex);
-        while (queue_is_empty(output_queue)) {
-            pthread_cond_wait(&cond, &mutex);
-        }
-        pthread_mutex_unlock(&mutex);
+        wait_strategy_wait(&output_wait, ring_has_items, output_queue, &running);
 
-        MarketData *data = (MarketData *)lock_free_queue_dequeue(output_queue);
+        MarketData *data = (MarketData *)spsc_ring_pop(output_queue);
         if (data) {
             // Implement trading algorithm execution and risk management
             // Placeholder: Print processed data
@@ -155,11 +264,13 @@ int main(int argc, char *argv[]) {
     }
 
     running = 0;
+    wait_strategy_wake_all(&input_wait);
     pthread_join(data_thread, NULL);
     pthread_join(pre_process_thread, NULL);
 
-    lock_free_queue_destroy(input_queue);
-    lock_free_queue_destroy(output_queue);
+    spsc_ring_destroy(input_queue);
+    spsc_ring_destroy(output_queue);
+    curl_global_cleanup();
 
     return 0;
 }
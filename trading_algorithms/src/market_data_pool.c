@@ -4,16 +4,31 @@
 
 MarketDataPool *market_data_pool_init(size_t size) {
     MarketDataPool *pool = (MarketDataPool *)malloc(sizeof(MarketDataPool));
+    if (pool == NULL) {
+        return NULL;
+    }
     pool->buffer = (MarketData *)malloc(sizeof(MarketData) * size);
+    pool->free_slots = (MarketData **)malloc(sizeof(MarketData *) * size);
+    if (pool->buffer == NULL || pool->free_slots == NULL) {
+        free(pool->buffer);
+        free(pool->free_slots);
+        free(pool);
+        return NULL;
+    }
     pool->size = size;
     pool->next_free = 0;
+    pool->free_count = 0;
     pthread_mutex_init(&pool->mutex, NULL);
     return pool;
 }
 
 MarketData *market_data_pool_alloc(MarketDataPool *pool) {
     pthread_mutex_lock(&pool->mutex);
-    if (pool->next_free < pool->size) {
+    if (pool->free_count > 0) {
+        MarketData *data = pool->free_slots[--pool->free_count];
+        pthread_mutex_unlock(&pool->mutex);
+        return data;
+    } else if (pool->next_free < pool->size) {
         MarketData *data = &pool->buffer[pool->next_free++];
         pthread_mutex_unlock(&pool->mutex);
         return data;
@@ -24,11 +39,14 @@ MarketData *market_data_pool_alloc(MarketDataPool *pool) {
 }
 
 void market_data_pool_free(MarketDataPool *pool, MarketData *data) {
-    // Implement if necessary
+    pthread_mutex_lock(&pool->mutex);
+    pool->free_slots[pool->free_count++] = data;
+    pthread_mutex_unlock(&pool->mutex);
 }
 
 void market_data_pool_destroy(MarketDataPool *pool) {
     pthread_mutex_destroy(&pool->mutex);
+    free(pool->free_slots);
     free(pool->buffer);
     free(pool);
 }
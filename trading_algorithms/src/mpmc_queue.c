@@ -0,0 +1,176 @@
+// src/mpmc_queue.c
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpmc_queue.h"
+
+MpmcQueue *mpmc_queue_init(size_t capacity) {
+    size_t cells = 2;
+    while (cells < capacity) {
+        cells <<= 1;
+    }
+
+    MpmcQueue *queue = (MpmcQueue *)aligned_alloc(_Alignof(MpmcQueue), sizeof(MpmcQueue));
+    if (queue == NULL) {
+        return NULL;
+    }
+    memset(queue, 0, sizeof(MpmcQueue));
+    queue->cells = (MpmcCell *)malloc(sizeof(MpmcCell) * cells);
+    if (queue->cells == NULL) {
+        free(queue);
+        return NULL;
+    }
+    for (size_t i = 0; i < cells; i++) {
+        atomic_init(&queue->cells[i].sequence, i);
+        queue->cells[i].data = NULL;
+    }
+    queue->mask = cells - 1;
+    atomic_init(&queue->enqueue_pos, 0);
+    atomic_init(&queue->dequeue_pos, 0);
+    return queue;
+}
+
+bool mpmc_queue_enqueue(MpmcQueue *queue, void *item) {
+    size_t pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+    MpmcCell *cell;
+    for (;;) {
+        cell = &queue->cells[pos & queue->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)pos;
+        if (difference == 0) {
+            // The cell is free for this lap; claim the position
+            if (atomic_compare_exchange_weak_explicit(&queue->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // The consumer of the previous lap has not emptied it yet: full
+            return false;
+        } else {
+            // Another producer took this position first
+            pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+        }
+    }
+    cell->data = item;
+    atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+    return true;
+}
+
+void *mpmc_queue_dequeue(MpmcQueue *queue) {
+    size_t pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+    MpmcCell *cell;
+    for (;;) {
+        cell = &queue->cells[pos & queue->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)(pos + 1);
+        if (difference == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // Nothing has been published at this position yet: empty
+            return NULL;
+        } else {
+            pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+        }
+    }
+    void *item = cell->data;
+    // Hand the cell to the producer one lap ahead
+    atomic_store_explicit(&cell->sequence, pos + queue->mask + 1, memory_order_release);
+    return item;
+}
+
+size_t mpmc_queue_enqueue_bulk(MpmcQueue *queue, void *const *items, size_t count) {
+    // An empty run claims nothing, which the loop below would read as a lost race forever
+    if (count == 0) {
+        return 0;
+    }
+    size_t pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+    size_t claimed;
+    for (;;) {
+        // Count the free cells from pos on; a cell stays free until its position is claimed,
+        // so the count still holds if the index has not moved by the time of the swap
+        claimed = 0;
+        while (claimed < count) {
+            size_t sequence = atomic_load_explicit(&queue->cells[(pos + claimed) & queue->mask].sequence,
+                                                   memory_order_acquire);
+            if (sequence != pos + claimed) {
+                break;
+            }
+            claimed++;
+        }
+        if (claimed == 0) {
+            size_t sequence = atomic_load_explicit(&queue->cells[pos & queue->mask].sequence, memory_order_acquire);
+            if ((intptr_t)sequence - (intptr_t)pos < 0) {
+                return 0;
+            }
+            pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+            continue;
+        }
+        if (atomic_compare_exchange_weak_explicit(&queue->enqueue_pos, &pos, pos + claimed,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            break;
+        }
+    }
+    for (size_t i = 0; i < claimed; i++) {
+        MpmcCell *cell = &queue->cells[(pos + i) & queue->mask];
+        cell->data = items[i];
+        atomic_store_explicit(&cell->sequence, pos + i + 1, memory_order_release);
+    }
+    return claimed;
+}
+
+size_t mpmc_queue_dequeue_bulk(MpmcQueue *queue, void **items, size_t max) {
+    if (max == 0) {
+        return 0;
+    }
+    size_t pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+    size_t claimed;
+    for (;;) {
+        // Count the published cells from pos on; producers fill claimed cells in any order,
+        // so the run stops at the first one still being written
+        claimed = 0;
+        while (claimed < max) {
+            size_t sequence = atomic_load_explicit(&queue->cells[(pos + claimed) & queue->mask].sequence,
+                                                   memory_order_acquire);
+            if (sequence != pos + claimed + 1) {
+                break;
+            }
+            claimed++;
+        }
+        if (claimed == 0) {
+            size_t sequence = atomic_load_explicit(&queue->cells[pos & queue->mask].sequence, memory_order_acquire);
+            if ((intptr_t)sequence - (intptr_t)(pos + 1) < 0) {
+                return 0;
+            }
+            pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+            continue;
+        }
+        if (atomic_compare_exchange_weak_explicit(&queue->dequeue_pos, &pos, pos + claimed,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            break;
+        }
+    }
+    for (size_t i = 0; i < claimed; i++) {
+        MpmcCell *cell = &queue->cells[(pos + i) & queue->mask];
+        items[i] = cell->data;
+        // Hand the cell to the producer one lap ahead
+        atomic_store_explicit(&cell->sequence, pos + i + queue->mask + 1, memory_order_release);
+    }
+    return claimed;
+}
+
+bool mpmc_queue_is_empty(MpmcQueue *queue) {
+    size_t pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+    size_t sequence = atomic_load_explicit(&queue->cells[pos & queue->mask].sequence, memory_order_acquire);
+    return sequence != pos + 1;
+}
+
+void mpmc_queue_destroy(MpmcQueue *queue) {
+    if (queue) {
+        free(queue->cells);
+        free(queue);
+    }
+}
@@ -43,6 +43,8 @@ PreProcessedData *pre_process_data(const RawData *raw_data, size_t rolling_volat
 
     // Initialize liquidity info
     data->liquidity_info.minimum_liquidity = 10000.0;
+    data->liquidity_info.depth_bps = 10.0;
+    data->order_book = NULL;
 
     // Initialize trend info
     data->trend_info.trend_strength = 1.0; // Placeholder
@@ -0,0 +1,85 @@
+# Local stand-in for many market data connections at once, used by the feed handler test.
+# Every connection streams MESSAGES trade events for its own symbol, as fast as the client
+# reads them, then stays open until the client disconnects:
+#   ws://127.0.0.1:PORT/ws/<symbol>@trade   one text frame per event, symbol from the path
+#   tcp://127.0.0.1:PORT+1                  one event per line, symbol T<n> for the nth connection
+# The price of a symbol's event number i is 100 + i / 100, so clients can check order.
+#
+# Usage: python3 tests/feed_stub_server.py PORT MESSAGES
+import asyncio
+import base64
+import hashlib
+import itertools
+import struct
+import sys
+
+GUID = '258EAFA5-E914-47DA-95CA-C5AB0DC85B11'
+CHUNK = 500
+
+
+def trade(symbol, i):
+    return ('{"e":"trade","E":%d,"s":"%s","t":%d,"p":"%.2f","q":"1.00000000","T":%d,"m":true}'
+            % (1700000000000 + i, symbol, i, 100 + i / 100, 1700000000000 + i)).encode()
+
+
+def text_frame(payload):
+    n = len(payload)
+    if n < 126:
+        return bytes([0x81, n]) + payload
+    return bytes([0x81, 126]) + struct.pack('!H', n) + payload
+
+
+async def stream(writer, symbol, messages, encode):
+    for start in range(0, messages, CHUNK):
+        end = min(start + CHUNK, messages)
+        writer.write(b''.join(encode(trade(symbol, i)) for i in range(start, end)))
+        await writer.drain()
+
+
+async def wait_for_close(reader, writer):
+    try:
+        while await reader.read(4096):
+            pass
+    except ConnectionError:
+        pass
+    writer.close()
+
+
+async def serve_ws(reader, writer, messages):
+    try:
+        head = await reader.readuntil(b'\r\n\r\n')
+    except (asyncio.IncompleteReadError, asyncio.LimitOverrunError):
+        writer.close()
+        return
+    lines = head.decode().split('\r\n')
+    path = lines[0].split(' ')[1]
+    headers = {}
+    for line in lines[1:]:
+        if ':' in line:
+            name, value = line.split(':', 1)
+            headers[name.strip().lower()] = value.strip()
+    accept = base64.b64encode(hashlib.sha1((headers['sec-websocket-key'] + GUID).encode()).digest()).decode()
+    writer.write(('HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n'
+                  'Connection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n' % accept).encode())
+    symbol = path.rsplit('/', 1)[-1].split('@')[0].upper()
+    await stream(writer, symbol, messages, text_frame)
+    await wait_for_close(reader, writer)
+
+
+async def serve_tcp(reader, writer, messages, counter):
+    symbol = 'T%d' % next(counter)
+    await stream(writer, symbol, messages, lambda payload: payload + b'\n')
+    await wait_for_close(reader, writer)
+
+
+async def main(port, messages):
+    counter = itertools.count()
+    ws = await asyncio.start_server(lambda r, w: serve_ws(r, w, messages), '127.0.0.1', port, backlog=1024)
+    tcp = await asyncio.start_server(lambda r, w: serve_tcp(r, w, messages, counter), '127.0.0.1', port + 1, backlog=1024)
+    print(f'feed stub listening on {port} (ws) and {port + 1} (tcp)', flush=True)
+    async with ws, tcp:
+        await asyncio.gather(ws.serve_forever(), tcp.serve_forever())
+
+
+if __name__ == '__main__':
+    asyncio.run(main(int(sys.argv[1]), int(sys.argv[2])))
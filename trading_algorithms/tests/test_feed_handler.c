@@ -0,0 +1,233 @@
+// tests/test_feed_handler.c
+// Streams from tests/feed_stub_server.py over a growing number of sources, half WebSocket
+// and half TCP, and checks that every symbol's ticks arrive complete and in order and that the
+// process runs the same number of threads whatever the source count. The feed thread's CPU
+// time per message is printed for each source count, not checked. Sources whose port never
+// accepts the connection, or accepts it but never answers the WebSocket upgrade, must not
+// hold up the others: every tick from the live sources has to arrive while they are still
+// connecting.
+//
+// Usage: ./bin/test_feed_handler PORT MESSAGES
+// with the stub started as: python3 tests/feed_stub_server.py PORT MESSAGES
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <curl/curl.h>
+#include "feed_handler.h"
+
+#define MAX_SOURCES 256
+#define TEST_TIMEOUT_SECONDS 60
+
+static const size_t source_counts[] = {4, 32, MAX_SOURCES};
+#define RUN_COUNT (sizeof(source_counts) / sizeof(source_counts[0]))
+
+typedef struct {
+    size_t next[2][MAX_SOURCES];  // next expected event per symbol, [0] for S<n>, [1] for T<n>
+    size_t ticks;
+    size_t mismatches;
+} FeedCheck;
+
+static int running;
+
+// Runs on the feed thread for every batch; checks each symbol's ticks are in order
+static void check_batch(MarketData *ticks, size_t count, void *userdata) {
+    FeedCheck *check = (FeedCheck *)userdata;
+    for (size_t i = 0; i < count; i++) {
+        int kind = ticks[i].symbol[0] == 'T';
+        size_t index = (size_t)atoi(ticks[i].symbol + 1);
+        if (index >= MAX_SOURCES) {
+            check->mismatches++;
+            continue;
+        }
+        size_t expected = check->next[kind][index]++;
+        if ((long long)(ticks[i].price * 100 + 0.5) != 10000 + (long long)expected) {
+            if (check->mismatches++ < 5) {
+                printf("%s: price %.2f, expected event %zu\n", ticks[i].symbol, ticks[i].price, expected);
+            }
+        }
+    }
+    check->ticks += count;
+}
+
+static void *feed_thread(void *args) {
+    feed_handler_run((FeedHandler *)args);
+    return NULL;
+}
+
+// Threads in this process, from /proc/self/status
+static int thread_count(void) {
+    FILE *status = fopen("/proc/self/status", "r");
+    char line[256];
+    int threads = -1;
+    while (status && fgets(line, sizeof(line), status)) {
+        if (sscanf(line, "Threads: %d", &threads) == 1) {
+            break;
+        }
+    }
+    if (status) {
+        fclose(status);
+    }
+    return threads;
+}
+
+static double cpu_seconds(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Listen on a free loopback port without ever accepting; with backlog 0 and the queue filled,
+// further connects are left unanswered. Returns the socket and sets *port
+static int stalled_listener(int backlog, int *port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    socklen_t length = sizeof(address);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, backlog) != 0 ||
+        getsockname(fd, (struct sockaddr *)&address, &length) != 0) {
+        return -1;
+    }
+    *port = ntohs(address.sin_port);
+    return fd;
+}
+
+static int check_stalled_sources(int port, size_t messages) {
+    int full_port, silent_port;
+    int full = stalled_listener(0, &full_port);
+    int silent = stalled_listener(16, &silent_port);
+    if (full < 0 || silent < 0) {
+        printf("FAIL could not set up the stalled listeners\n");
+        return 1;
+    }
+    // Fill the accept queue so later connects never complete
+    int fillers[4];
+    struct sockaddr_in full_address = {.sin_family = AF_INET, .sin_port = htons((uint16_t)full_port),
+                                       .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    for (int i = 0; i < 4; i++) {
+        fillers[i] = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        connect(fillers[i], (struct sockaddr *)&full_address, sizeof(full_address));
+    }
+
+    // Stalled sources come first, so a handler that connects in order would reach the live ones last
+    char urls_storage[5][64];
+    snprintf(urls_storage[0], sizeof(urls_storage[0]), "ws://127.0.0.1:%d/ws/s0@trade", full_port);
+    snprintf(urls_storage[1], sizeof(urls_storage[1]), "ws://127.0.0.1:%d/ws/s0@trade", silent_port);
+    snprintf(urls_storage[2], sizeof(urls_storage[2]), "tcp://127.0.0.1:%d", full_port);
+    snprintf(urls_storage[3], sizeof(urls_storage[3]), "ws://127.0.0.1:%d/ws/s0@trade", port);
+    snprintf(urls_storage[4], sizeof(urls_storage[4]), "tcp://127.0.0.1:%d", port + 1);
+    const char *urls[5] = {urls_storage[0], urls_storage[1], urls_storage[2], urls_storage[3], urls_storage[4]};
+
+    FeedCheck *check = (FeedCheck *)calloc(1, sizeof(FeedCheck));
+    FeedHandler handler;
+    running = 1;
+    if (!check || feed_handler_init(&handler, urls, 5, check_batch, check, &running) != 0) {
+        return 1;
+    }
+    pthread_t thread;
+    pthread_create(&thread, NULL, feed_thread, &handler);
+    size_t expected = 2 * messages;
+    double deadline = cpu_seconds(CLOCK_MONOTONIC) + TEST_TIMEOUT_SECONDS;
+    while (__atomic_load_n(&check->ticks, __ATOMIC_RELAXED) < expected && cpu_seconds(CLOCK_MONOTONIC) < deadline) {
+        struct timespec step = {0, 5 * 1000000L};
+        nanosleep(&step, NULL);
+    }
+    int stalled = 0;
+    for (int i = 0; i < 3; i++) {
+        stalled += __atomic_load_n(&handler.sources[i].state, __ATOMIC_RELAXED) == FEED_SOURCE_CONNECTING;
+    }
+    running = 0;
+    pthread_join(thread, NULL);
+
+    int failures = 0;
+    printf("stalled sources: %zu of %zu live ticks delivered while %d of 3 stalled sources were connecting\n",
+           check->ticks, expected, stalled);
+    if (check->ticks != expected || check->mismatches || stalled != 3) {
+        printf("FAIL stalled sources held up the live ones\n");
+        failures++;
+    }
+    feed_handler_destroy(&handler);
+    free(check);
+    for (int i = 0; i < 4; i++) {
+        close(fillers[i]);
+    }
+    close(full);
+    close(silent);
+    return failures;
+}
+
+int main(int argc, char *argv[]) {
+    int port = argc > 1 ? atoi(argv[1]) : 18090;
+    size_t messages = argc > 2 ? (size_t)atol(argv[2]) : 2000;
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    static char url_storage[MAX_SOURCES][64];
+    const char *urls[MAX_SOURCES];
+    int failures = 0;
+    int threads[RUN_COUNT];
+
+    for (size_t run = 0; run < RUN_COUNT; run++) {
+        size_t sources = source_counts[run];
+        for (size_t i = 0; i < sources; i++) {
+            if (i % 2 == 0) {
+                snprintf(url_storage[i], sizeof(url_storage[i]), "ws://127.0.0.1:%d/ws/s%zu@trade", port, i);
+            } else {
+                snprintf(url_storage[i], sizeof(url_storage[i]), "tcp://127.0.0.1:%d", port + 1);
+            }
+            urls[i] = url_storage[i];
+        }
+
+        FeedCheck *check = (FeedCheck *)calloc(1, sizeof(FeedCheck));
+        FeedHandler handler;
+        running = 1;
+        if (!check || feed_handler_init(&handler, urls, sources, check_batch, check, &running) != 0) {
+            return 1;
+        }
+
+        pthread_t thread;
+        clockid_t clock;
+        pthread_create(&thread, NULL, feed_thread, &handler);
+        pthread_getcpuclockid(thread, &clock);
+
+        // Wait for every tick; check->ticks is only advanced by the feed thread
+        size_t expected = sources * messages;
+        double deadline = cpu_seconds(CLOCK_MONOTONIC) + TEST_TIMEOUT_SECONDS;
+        while (__atomic_load_n(&check->ticks, __ATOMIC_RELAXED) < expected && cpu_seconds(CLOCK_MONOTONIC) < deadline) {
+            struct timespec step = {0, 5 * 1000000L};
+            nanosleep(&step, NULL);
+        }
+        double feed_cpu = cpu_seconds(clock);
+        threads[run] = thread_count();
+        running = 0;
+        pthread_join(thread, NULL);
+
+        double ns_per_message = feed_cpu * 1e9 / (double)(handler.messages ? handler.messages : 1);
+        printf("%3zu sources: %zu messages in %zu batches (%.1f per batch), %.0f ns feed CPU per message, %d threads\n",
+               sources, handler.messages, handler.batches, handler.batches ? (double)handler.ticks / handler.batches : 0.0,
+               ns_per_message, threads[run]);
+        if (check->ticks != expected || check->mismatches) {
+            printf("FAIL %zu sources: %zu of %zu ticks, %zu out of order\n", sources, check->ticks, expected, check->mismatches);
+            failures++;
+        }
+        feed_handler_destroy(&handler);
+        free(check);
+    }
+
+    failures += check_stalled_sources(port, messages);
+
+    for (size_t run = 1; run < RUN_COUNT; run++) {
+        if (threads[run] != threads[0]) {
+            printf("FAIL thread count changed from %d to %d\n", threads[0], threads[run]);
+            failures++;
+        }
+    }
+    if (failures) {
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,241 @@
+// tests/test_mpmc_queue.c
+// Runs producers and consumers against one MPMC queue and checks that every item arrives
+// exactly once and that each producer's items arrive in the order it sent them, then reports
+// throughput as the producer count grows, moving items one at a time and in bulk runs.
+// Throughput can only grow with producers while every thread has a CPU of its own, so the
+// online CPU count is printed first and rows with more threads than CPUs are marked shared.
+// Bulk calls for zero items must return at once, whether the queue is empty or not, and
+// mpmc_queue_is_empty must follow the queue through them.
+//
+// Usage: ./bin/test_mpmc_queue
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include "mpmc_queue.h"
+
+#define QUEUE_CAPACITY 4096
+#define ITEMS_PER_RUN 4000000
+#define CONSUMERS 2
+#define MAX_PRODUCERS 8
+#define BULK_BATCH 32
+
+// Items carry their producer in the high bits and a per-producer sequence number below it
+#define PRODUCER_SHIFT 40
+
+typedef struct {
+    MpmcQueue *queue;
+    uintptr_t producer;
+    size_t items;
+    bool bulk;
+} ProducerArgs;
+
+typedef struct {
+    MpmcQueue *queue;
+    atomic_size_t *remaining;           // items not yet taken by any consumer
+    size_t last_seen[MAX_PRODUCERS];    // highest sequence taken from each producer, plus one
+    size_t taken;
+    bool ordered;
+    bool bulk;
+} ConsumerArgs;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void *producer_thread(void *args) {
+    ProducerArgs *producer = (ProducerArgs *)args;
+    if (producer->bulk) {
+        void *batch[BULK_BATCH];
+        for (uintptr_t i = 1; i <= producer->items;) {
+            size_t count = 0;
+            while (count < BULK_BATCH && i + count <= producer->items) {
+                batch[count] = (void *)((producer->producer << PRODUCER_SHIFT) | (i + count));
+                count++;
+            }
+            size_t pushed = 0;
+            while ((pushed += mpmc_queue_enqueue_bulk(producer->queue, batch + pushed, count - pushed)) < count) {
+                sched_yield();
+            }
+            i += count;
+        }
+        return NULL;
+    }
+    for (uintptr_t i = 1; i <= producer->items; i++) {
+        while (!mpmc_queue_enqueue(producer->queue, (void *)((producer->producer << PRODUCER_SHIFT) | i))) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void *consumer_thread(void *args) {
+    ConsumerArgs *consumer = (ConsumerArgs *)args;
+    void *batch[BULK_BATCH];
+    while (atomic_load(consumer->remaining) > 0) {
+        size_t count;
+        if (consumer->bulk) {
+            count = mpmc_queue_dequeue_bulk(consumer->queue, batch, BULK_BATCH);
+        } else {
+            batch[0] = mpmc_queue_dequeue(consumer->queue);
+            count = batch[0] != NULL;
+        }
+        if (count == 0) {
+            sched_yield();
+            continue;
+        }
+        atomic_fetch_sub(consumer->remaining, count);
+        for (size_t i = 0; i < count; i++) {
+            uintptr_t value = (uintptr_t)batch[i];
+            size_t producer = value >> PRODUCER_SHIFT;
+            size_t sequence = value & (((uintptr_t)1 << PRODUCER_SHIFT) - 1);
+            // Items from one producer can be split between consumers, but each consumer
+            // must still see them in increasing order
+            if (producer >= MAX_PRODUCERS || sequence <= consumer->last_seen[producer]) {
+                consumer->ordered = false;
+            } else {
+                consumer->last_seen[producer] = sequence;
+            }
+        }
+        consumer->taken += count;
+    }
+    return NULL;
+}
+
+// Run producers against CONSUMERS consumers; returns ns per item, or -1 if items were lost,
+// duplicated or reordered
+static double run(size_t producers, bool bulk) {
+    MpmcQueue *queue = mpmc_queue_init(QUEUE_CAPACITY);
+    size_t per_producer = ITEMS_PER_RUN / producers;
+    atomic_size_t remaining = per_producer * producers;
+    ProducerArgs producer_args[MAX_PRODUCERS];
+    ConsumerArgs consumer_args[CONSUMERS];
+    pthread_t producer_threads[MAX_PRODUCERS], consumer_threads[CONSUMERS];
+
+    double start = now_ns();
+    for (size_t i = 0; i < CONSUMERS; i++) {
+        consumer_args[i] = (ConsumerArgs){.queue = queue, .remaining = &remaining, .ordered = true, .bulk = bulk};
+        pthread_create(&consumer_threads[i], NULL, consumer_thread, &consumer_args[i]);
+    }
+    for (size_t i = 0; i < producers; i++) {
+        producer_args[i] = (ProducerArgs){queue, i, per_producer, bulk};
+        pthread_create(&producer_threads[i], NULL, producer_thread, &producer_args[i]);
+    }
+    for (size_t i = 0; i < producers; i++) {
+        pthread_join(producer_threads[i], NULL);
+    }
+    for (size_t i = 0; i < CONSUMERS; i++) {
+        pthread_join(consumer_threads[i], NULL);
+    }
+    double ns_per_item = (now_ns() - start) / (per_producer * producers);
+
+    // Each producer's last item reached some consumer, and none are left over
+    size_t taken = 0;
+    bool ordered = true;
+    for (size_t i = 0; i < CONSUMERS; i++) {
+        taken += consumer_args[i].taken;
+        ordered &= consumer_args[i].ordered;
+    }
+    for (size_t p = 0; p < producers; p++) {
+        size_t highest = 0;
+        for (size_t i = 0; i < CONSUMERS; i++) {
+            highest = consumer_args[i].last_seen[p] > highest ? consumer_args[i].last_seen[p] : highest;
+        }
+        ordered &= highest == per_producer;
+    }
+    bool drained = mpmc_queue_dequeue(queue) == NULL;
+    mpmc_queue_destroy(queue);
+    if (!ordered || !drained || taken != per_producer * producers) {
+        printf("FAIL %zu producers%s: %zu of %zu items taken, %s, %s\n", producers, bulk ? " in bulk" : "", taken, per_producer * producers,
+               ordered ? "in order" : "out of order", drained ? "drained" : "items left behind");
+        return -1;
+    }
+    return ns_per_item;
+}
+
+int main(void) {
+    int failures = 0;
+
+    // Full and empty edges on one thread
+    MpmcQueue *queue = mpmc_queue_init(100);
+    size_t pushed = 0;
+    while (mpmc_queue_enqueue(queue, (void *)(uintptr_t)(pushed + 1))) {
+        pushed++;
+    }
+    uintptr_t expected = 1;
+    void *item;
+    while ((item = mpmc_queue_dequeue(queue)) != NULL && (uintptr_t)item == expected) {
+        expected++;
+    }
+    if (pushed != 128 || expected != 129) {
+        printf("FAIL capacity 100 held %zu items, %zu came back in order\n", pushed, (size_t)expected - 1);
+        failures++;
+    }
+    mpmc_queue_destroy(queue);
+
+    // Bulk runs stop at a full or empty queue and interleave with single items
+    queue = mpmc_queue_init(100);
+    void *in[200], *out[200];
+    for (size_t i = 0; i < 200; i++) {
+        in[i] = (void *)(uintptr_t)(i + 1);
+    }
+    size_t first = mpmc_queue_enqueue_bulk(queue, in, 50);
+    bool single = mpmc_queue_enqueue(queue, in[50]);
+    size_t rest = mpmc_queue_enqueue_bulk(queue, in + 51, 149);
+    size_t taken = mpmc_queue_dequeue_bulk(queue, out, 30);
+    taken += mpmc_queue_dequeue_bulk(queue, out + taken, 200);
+    bool in_order = true;
+    for (size_t i = 0; i < taken; i++) {
+        in_order &= out[i] == in[i];
+    }
+    if (first != 50 || !single || rest != 77 || taken != 128 || !in_order || mpmc_queue_dequeue_bulk(queue, out, 1) != 0) {
+        printf("FAIL bulk runs on capacity 100: %zu + %d + %zu in, %zu out %s\n", first, single, rest, taken,
+               in_order ? "in order" : "out of order");
+        failures++;
+    }
+    mpmc_queue_destroy(queue);
+
+    // Zero-item runs on an empty queue, then on one holding an item
+    queue = mpmc_queue_init(100);
+    size_t zero_in = mpmc_queue_enqueue_bulk(queue, in, 0);
+    size_t zero_out = mpmc_queue_dequeue_bulk(queue, out, 0);
+    bool empty_before = mpmc_queue_is_empty(queue);
+    mpmc_queue_enqueue(queue, in[0]);
+    zero_in += mpmc_queue_enqueue_bulk(queue, in, 0);
+    zero_out += mpmc_queue_dequeue_bulk(queue, out, 0);
+    bool empty_holding = mpmc_queue_is_empty(queue);
+    if (zero_in != 0 || zero_out != 0 || !empty_before || empty_holding || mpmc_queue_dequeue(queue) != in[0] ||
+        mpmc_queue_dequeue(queue) != NULL || !mpmc_queue_is_empty(queue)) {
+        printf("FAIL zero-item bulk runs moved %zu in and %zu out\n", zero_in, zero_out);
+        failures++;
+    }
+    mpmc_queue_destroy(queue);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("%ld online CPUs\n", cpus);
+    size_t counts[] = {1, 2, 4, 8};
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        double ns_per_item = run(counts[i], false);
+        double bulk_ns_per_item = run(counts[i], true);
+        if (ns_per_item < 0 || bulk_ns_per_item < 0) {
+            failures++;
+            continue;
+        }
+        printf("%zu producers, %d consumers: %.1f ns/item, %.1f M items/s; in runs of %d %.1f ns/item, %.1f M items/s%s\n",
+               counts[i], CONSUMERS, ns_per_item, 1e3 / ns_per_item, BULK_BATCH, bulk_ns_per_item, 1e3 / bulk_ns_per_item,
+               (long)(counts[i] + CONSUMERS) > cpus ? " (CPUs shared)" : "");
+    }
+
+    if (failures) {
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
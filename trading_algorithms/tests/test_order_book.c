@@ -0,0 +1,230 @@
+// tests/test_order_book.c
+// Checks the order book against Binance's diff-depth sync rules (buffering before the
+// snapshot, dropping diffs it covers, detecting gaps), compares best bid/ask and depth
+// queries with a brute-force book over random updates, checks that recentring the window
+// keeps the touch, and prints how long updates and queries take.
+//
+// Usage: ./bin/test_order_book
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "order_book.h"
+
+#define TICK 0.01
+#define LEVELS 16384
+#define RANDOM_UPDATES 200000
+#define REFERENCE_TICKS 200000
+#define START_TICK 100000          // price 1000.00
+#define DEPTH_BPS 50.0             // 500 ticks either side at the start price
+#define TIMED_QUERIES 1000000
+
+static int failures;
+
+#define CHECK(condition, ...)          \
+    do {                               \
+        if (!(condition)) {            \
+            printf("FAIL " __VA_ARGS__); \
+            printf("\n");              \
+            failures++;                \
+        }                              \
+    } while (0)
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static OrderBookStatus diff(OrderBook *book, long long first_id, long long final_id, const char *bids, const char *asks) {
+    char message[512];
+    int length = snprintf(message, sizeof(message),
+                          "{\"e\":\"depthUpdate\",\"E\":1700000000000,\"s\":\"BTCUSDT\",\"U\":%lld,\"u\":%lld,\"b\":[%s],\"a\":[%s]}",
+                          first_id, final_id, bids, asks);
+    return order_book_apply_diff(book, message, (size_t)length);
+}
+
+static int snapshot(OrderBook *book, long long last_update_id, const char *bids, const char *asks) {
+    char message[512];
+    int length = snprintf(message, sizeof(message), "{\"lastUpdateId\":%lld,\"bids\":[%s],\"asks\":[%s]}", last_update_id, bids, asks);
+    return order_book_apply_snapshot(book, message, (size_t)length);
+}
+
+static void test_sync(void) {
+    OrderBook book;
+    order_book_init(&book, "BTCUSDT", TICK, 4096);
+    double bid, bid_quantity, ask, ask_quantity;
+
+    // Diffs ahead of the snapshot wait for it
+    CHECK(diff(&book, 95, 99, "[\"100.00\",\"9\"]", "") == ORDER_BOOK_BUFFERED, "diff before the snapshot was not buffered");
+    CHECK(diff(&book, 100, 105, "[\"100.00\",\"3\"]", "[\"100.01\",\"0\"]") == ORDER_BOOK_BUFFERED, "second diff not buffered");
+    CHECK(order_book_top(&book, &bid, &bid_quantity, &ask, &ask_quantity) == -1, "an unsynced book has a top");
+    CHECK(order_book_needs_snapshot(&book), "buffered diffs did not ask for a snapshot");
+
+    // The snapshot covers 95-99; 100-105 straddles it and removes the 100.01 ask
+    CHECK(snapshot(&book, 101, "[\"100.00\",\"1\"],[\"99.99\",\"2\"]", "[\"100.01\",\"1.5\"],[\"100.02\",\"4\"]") == 0, "snapshot rejected");
+    CHECK(!order_book_needs_snapshot(&book), "book still wants a snapshot");
+    CHECK(order_book_top(&book, &bid, &bid_quantity, &ask, &ask_quantity) == 0 && fabs(bid - 100.00) < 1e-9 && bid_quantity == 3 &&
+              fabs(ask - 100.02) < 1e-9 && ask_quantity == 4,
+          "top after the snapshot is %.2f x %g / %.2f x %g", bid, bid_quantity, ask, ask_quantity);
+
+    CHECK(diff(&book, 106, 106, "[\"100.01\",\"5\"]", "") == ORDER_BOOK_APPLIED, "next diff not applied");
+    CHECK(diff(&book, 90, 104, "[\"90.00\",\"5\"]", "") == ORDER_BOOK_STALE, "old diff not dropped");
+    CHECK(order_book_apply_diff(&book, "{\"result\":null,\"id\":1}", 22) == ORDER_BOOK_STALE, "subscription reply not ignored");
+    CHECK(order_book_top(&book, &bid, &bid_quantity, &ask, &ask_quantity) == 0 && fabs(bid - 100.01) < 1e-9, "new best bid %.2f", bid);
+
+    // Skipping 107 is a gap: the book empties and waits for a new snapshot
+    CHECK(diff(&book, 108, 110, "[\"100.01\",\"1\"]", "") == ORDER_BOOK_GAP, "gap not detected");
+    CHECK(order_book_top(&book, &bid, &bid_quantity, &ask, &ask_quantity) == -1, "a book with a gap still has a top");
+    CHECK(order_book_needs_snapshot(&book) && book.resyncs == 1, "gap did not ask for a snapshot");
+    CHECK(snapshot(&book, 100, "[\"100.00\",\"1\"]", "[\"100.02\",\"1\"]") == -1, "a snapshot older than the buffered diffs was accepted");
+    CHECK(snapshot(&book, 109, "[\"100.00\",\"1\"]", "[\"100.02\",\"1\"]") == 0, "resync snapshot rejected");
+    CHECK(order_book_top(&book, &bid, &bid_quantity, &ask, &ask_quantity) == 0 && fabs(bid - 100.01) < 1e-9 && bid_quantity == 1,
+          "top after the resync is %.2f x %g", bid, bid_quantity);
+    order_book_destroy(&book);
+}
+
+// Depth on one side of the reference book, the slow way
+static void reference_depth(const double *levels, long long best, long long limit, int step, double *quantity, double *notional) {
+    *quantity = 0.0;
+    *notional = 0.0;
+    for (long long tick = best; step > 0 ? tick <= limit : tick >= limit; tick += step) {
+        *quantity += levels[tick];
+        *notional += levels[tick] * tick * TICK;
+    }
+}
+
+static void test_against_reference(void) {
+    OrderBook book;
+    order_book_init(&book, "BTCUSDT", TICK, LEVELS);
+    double *bids = (double *)calloc(REFERENCE_TICKS, sizeof(double));
+    double *asks = (double *)calloc(REFERENCE_TICKS, sizeof(double));
+    srand(7);
+
+    long long mid = START_TICK;
+    size_t mismatches = 0;
+    for (int i = 0; i < RANDOM_UPDATES; i++) {
+        // The mid wanders, and levels change within 1000 ticks of it without crossing
+        if (rand() % 100 == 0) {
+            mid += rand() % 41 - 20;
+            mid = mid < START_TICK - 3000 ? START_TICK - 3000 : mid > START_TICK + 3000 ? START_TICK + 3000 : mid;
+        }
+        long long offset = rand() % 1000 + 1;
+        double quantity = rand() % 4 == 0 ? 0.0 : (rand() % 1000 + 1) / 100.0;
+        if (rand() % 2) {
+            bids[mid - offset] = quantity;
+            order_book_set_level(&book, BOOK_SIDE_BID, (mid - offset) * TICK, quantity);
+        } else {
+            asks[mid + offset] = quantity;
+            order_book_set_level(&book, BOOK_SIDE_ASK, (mid + offset) * TICK, quantity);
+        }
+        // Resting levels the mid has since passed are removed, as the exchange would have matched them
+        bids[mid] = 0.0;
+        asks[mid] = 0.0;
+        order_book_set_level(&book, BOOK_SIDE_BID, mid * TICK, 0.0);
+        order_book_set_level(&book, BOOK_SIDE_ASK, mid * TICK, 0.0);
+
+        // Compare every 100 updates, once both sides have filled in
+        if (i % 100 != 0 || i < 10000) {
+            continue;
+        }
+        long long best_bid = REFERENCE_TICKS - 1, best_ask = 0;
+        while (best_bid > 0 && bids[best_bid] == 0.0) {
+            best_bid--;
+        }
+        while (best_ask < REFERENCE_TICKS - 1 && asks[best_ask] == 0.0) {
+            best_ask++;
+        }
+        double bid, bid_quantity, ask, ask_quantity;
+        if (order_book_top(&book, &bid, &bid_quantity, &ask, &ask_quantity) != 0 || llround(bid / TICK) != best_bid ||
+            llround(ask / TICK) != best_ask || bid_quantity != bids[best_bid] || ask_quantity != asks[best_ask]) {
+            if (mismatches++ < 5) {
+                printf("update %d: top %.2f / %.2f, expected %.2f / %.2f\n", i, bid, ask, best_bid * TICK, best_ask * TICK);
+            }
+            continue;
+        }
+
+        double quantity_bid, notional_bid, quantity_ask, notional_ask, want_quantity, want_notional;
+        order_book_depth(&book, BOOK_SIDE_BID, DEPTH_BPS, &quantity_bid, &notional_bid);
+        reference_depth(bids, best_bid, (long long)ceil(best_bid - best_bid * DEPTH_BPS / 10000.0 - 1e-9), -1, &want_quantity, &want_notional);
+        if (fabs(quantity_bid - want_quantity) > 1e-6 || fabs(notional_bid - want_notional) > 1e-3) {
+            if (mismatches++ < 5) {
+                printf("update %d: bid depth %.4f, expected %.4f\n", i, quantity_bid, want_quantity);
+            }
+        }
+        order_book_depth(&book, BOOK_SIDE_ASK, DEPTH_BPS, &quantity_ask, &notional_ask);
+        reference_depth(asks, best_ask, (long long)floor(best_ask + best_ask * DEPTH_BPS / 10000.0 + 1e-9), 1, &want_quantity, &want_notional);
+        if (fabs(quantity_ask - want_quantity) > 1e-6 || fabs(notional_ask - want_notional) > 1e-3) {
+            if (mismatches++ < 5) {
+                printf("update %d: ask depth %.4f, expected %.4f\n", i, quantity_ask, want_quantity);
+            }
+        }
+    }
+    CHECK(mismatches == 0, "%zu queries disagreed with the reference book", mismatches);
+
+    // Time the hot paths on the populated book
+    double start = now_ns();
+    for (int i = 0; i < TIMED_QUERIES; i++) {
+        long long offset = i % 1000 + 1;
+        order_book_set_level(&book, i % 2 ? BOOK_SIDE_BID : BOOK_SIDE_ASK, (i % 2 ? mid - offset : mid + offset) * TICK, (i % 7) + 1.0);
+    }
+    double update_ns = (now_ns() - start) / TIMED_QUERIES;
+    double bid, bid_quantity, ask, ask_quantity, sink = 0.0;
+    start = now_ns();
+    for (int i = 0; i < TIMED_QUERIES; i++) {
+        order_book_top(&book, &bid, &bid_quantity, &ask, &ask_quantity);
+        sink += bid;
+    }
+    double top_ns = (now_ns() - start) / TIMED_QUERIES;
+    double quantity, notional;
+    start = now_ns();
+    for (int i = 0; i < TIMED_QUERIES / 10; i++) {
+        order_book_depth(&book, i % 2 ? BOOK_SIDE_BID : BOOK_SIDE_ASK, 10.0, &quantity, &notional);
+        sink += quantity;
+    }
+    double depth_ns = (now_ns() - start) / (TIMED_QUERIES / 10);
+    printf("set level %.0f ns, best bid/ask %.0f ns, depth within 10 bps (100 levels) %.0f ns (%g)\n",
+           update_ns, top_ns, depth_ns, sink > 0 ? 1.0 : 0.0);
+
+    free(bids);
+    free(asks);
+    order_book_destroy(&book);
+}
+
+static void test_recenter(void) {
+    OrderBook book;
+    order_book_init(&book, "BTCUSDT", TICK, 1024);
+    double bid, bid_quantity, ask, ask_quantity;
+    order_book_set_level(&book, BOOK_SIDE_BID, 100.00, 1.0);
+    order_book_set_level(&book, BOOK_SIDE_ASK, 100.01, 1.0);
+    order_book_set_level(&book, BOOK_SIDE_ASK, 100.05, 2.0);
+    order_book_set_level(&book, BOOK_SIDE_ASK, 100.05, 0.0);
+
+    // Walk the market up by far more than the window; each step recentres around the new touch
+    for (int step = 1; step <= 40; step++) {
+        double price = 100.00 + step * 1.00;
+        order_book_set_level(&book, BOOK_SIDE_BID, price, 1.0);
+        order_book_set_level(&book, BOOK_SIDE_ASK, price + 0.01, 1.0);
+        order_book_set_level(&book, BOOK_SIDE_ASK, price - 0.99, 0.0);
+    }
+    CHECK(order_book_top(&book, &bid, &bid_quantity, &ask, &ask_quantity) == 0 && fabs(bid - 140.00) < 1e-9 && fabs(ask - 140.01) < 1e-9,
+          "after recentring the top is %.2f / %.2f", bid, ask);
+    // Bids more than half a window below the touch have been let go
+    double quantity, notional;
+    order_book_depth(&book, BOOK_SIDE_BID, 10000.0, &quantity, &notional);
+    CHECK(quantity > 0 && quantity < 40, "recentred book still holds %g bid quantity", quantity);
+    order_book_destroy(&book);
+}
+
+int main(void) {
+    test_sync();
+    test_against_reference();
+    test_recenter();
+    if (failures) {
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,278 @@
+// tests/test_spsc_ring.c
+// Checks the SPSC ring's full/empty edges and ordering across wrap-around, for single items
+// and bulk runs, streams items between two threads, and prints the cost of a hand-off next to
+// the linked lock-free queue it replaces in the pipelines and with bulk hand-offs.
+//
+// Usage: ./bin/test_spsc_ring
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "spsc_ring.h"
+#include "lock_free_queue.h"
+
+#define RING_CAPACITY 1024
+#define STREAM_ITEMS 5000000
+#define PAIR_ITEMS 10000000
+#define BULK_BATCH 64
+
+static int failures;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void test_edges(void) {
+    SpscRing *ring = spsc_ring_init(1000);
+    if (ring->mask + 1 != 1024) {
+        printf("FAIL capacity 1000 rounded to %zu\n", ring->mask + 1);
+        failures++;
+    }
+    if (spsc_ring_pop(ring) != NULL || !spsc_ring_is_empty(ring)) {
+        printf("FAIL new ring is not empty\n");
+        failures++;
+    }
+
+    // Fill and drain repeatedly so the indices wrap the slot array many times
+    uintptr_t next_in = 1, next_out = 1;
+    for (int round = 0; round < 100; round++) {
+        size_t pushed = 0;
+        while (spsc_ring_push(ring, (void *)next_in)) {
+            next_in++;
+            pushed++;
+        }
+        if (pushed != (round == 0 ? 1024 : 1024 - 7)) {
+            printf("FAIL round %d pushed %zu items\n", round, pushed);
+            failures++;
+            break;
+        }
+        // Leave a few behind so the next round starts part-way round the array
+        while (next_in - next_out > 7) {
+            if ((uintptr_t)spsc_ring_pop(ring) != next_out++) {
+                printf("FAIL items out of order in round %d\n", round);
+                failures++;
+                round = 100;
+                break;
+            }
+        }
+    }
+    spsc_ring_destroy(ring);
+}
+
+static void test_bulk_edges(void) {
+    SpscRing *ring = spsc_ring_init(64);
+    void *in[100], *out[100];
+    uintptr_t next_in = 1, next_out = 1;
+    // Runs of 37 never line up with the 64 slots, so most of them wrap at some point
+    for (int round = 0; round < 200; round++) {
+        for (size_t i = 0; i < 37; i++) {
+            in[i] = (void *)(next_in + i);
+        }
+        size_t pushed = spsc_ring_push_bulk(ring, in, 37);
+        size_t expected = 64 - (next_in - next_out) < 37 ? 64 - (next_in - next_out) : 37;
+        if (pushed != expected) {
+            printf("FAIL round %d bulk push took %zu of 37 items, expected %zu\n", round, pushed, expected);
+            failures++;
+            break;
+        }
+        next_in += pushed;
+        size_t popped = spsc_ring_pop_bulk(ring, out, round % 2 ? 100 : 29);
+        for (size_t i = 0; i < popped; i++) {
+            if ((uintptr_t)out[i] != next_out++) {
+                printf("FAIL bulk items out of order in round %d\n", round);
+                failures++;
+                round = 200;
+                break;
+            }
+        }
+    }
+    // Single and bulk operations share the indices
+    while (spsc_ring_pop(ring) != NULL) {
+    }
+    if (spsc_ring_pop_bulk(ring, out, 100) != 0 || !spsc_ring_push(ring, (void *)1) ||
+        spsc_ring_pop_bulk(ring, out, 100) != 1 || out[0] != (void *)1) {
+        printf("FAIL bulk pop disagrees with single push\n");
+        failures++;
+    }
+    spsc_ring_destroy(ring);
+}
+
+typedef struct {
+    SpscRing *ring;
+    LockFreeQueue *queue;
+    size_t items;
+} StreamArgs;
+
+static void *ring_producer(void *args) {
+    StreamArgs *stream = (StreamArgs *)args;
+    for (uintptr_t i = 1; i <= stream->items; i++) {
+        while (!spsc_ring_push(stream->ring, (void *)i)) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void *ring_bulk_producer(void *args) {
+    StreamArgs *stream = (StreamArgs *)args;
+    void *batch[BULK_BATCH];
+    for (uintptr_t i = 1; i <= stream->items;) {
+        size_t count = 0;
+        while (count < BULK_BATCH && i + count <= stream->items) {
+            batch[count] = (void *)(i + count);
+            count++;
+        }
+        size_t pushed = 0;
+        while ((pushed += spsc_ring_push_bulk(stream->ring, batch + pushed, count - pushed)) < count) {
+            sched_yield();
+        }
+        i += count;
+    }
+    return NULL;
+}
+
+static void *queue_producer(void *args) {
+    StreamArgs *stream = (StreamArgs *)args;
+    for (uintptr_t i = 1; i <= stream->items; i++) {
+        lock_free_queue_enqueue(stream->queue, (void *)i);
+    }
+    return NULL;
+}
+
+// Items per second from one producer thread to this one; false if any arrive out of order
+static bool stream_ring(size_t items, double *ns_per_item) {
+    StreamArgs args = {spsc_ring_init(RING_CAPACITY), NULL, items};
+    pthread_t producer;
+    double start = now_ns();
+    pthread_create(&producer, NULL, ring_producer, &args);
+    bool ordered = true;
+    for (uintptr_t expected = 1; expected <= items; expected++) {
+        void *item;
+        while ((item = spsc_ring_pop(args.ring)) == NULL) {
+            sched_yield();
+        }
+        ordered &= (uintptr_t)item == expected;
+    }
+    *ns_per_item = (now_ns() - start) / items;
+    pthread_join(producer, NULL);
+    spsc_ring_destroy(args.ring);
+    return ordered;
+}
+
+static bool stream_ring_bulk(size_t items, double *ns_per_item) {
+    StreamArgs args = {spsc_ring_init(RING_CAPACITY), NULL, items};
+    pthread_t producer;
+    double start = now_ns();
+    pthread_create(&producer, NULL, ring_bulk_producer, &args);
+    bool ordered = true;
+    void *batch[BULK_BATCH];
+    for (uintptr_t expected = 1; expected <= items;) {
+        size_t count = spsc_ring_pop_bulk(args.ring, batch, BULK_BATCH);
+        if (count == 0) {
+            sched_yield();
+        }
+        for (size_t i = 0; i < count; i++) {
+            ordered &= (uintptr_t)batch[i] == expected++;
+        }
+    }
+    *ns_per_item = (now_ns() - start) / items;
+    pthread_join(producer, NULL);
+    spsc_ring_destroy(args.ring);
+    return ordered;
+}
+
+static bool stream_queue(size_t items, double *ns_per_item) {
+    StreamArgs args = {NULL, lock_free_queue_init(), items};
+    pthread_t producer;
+    double start = now_ns();
+    pthread_create(&producer, NULL, queue_producer, &args);
+    bool ordered = true;
+    for (uintptr_t expected = 1; expected <= items; expected++) {
+        void *item;
+        while ((item = lock_free_queue_dequeue(args.queue)) == NULL) {
+            sched_yield();
+        }
+        ordered &= (uintptr_t)item == expected;
+    }
+    *ns_per_item = (now_ns() - start) / items;
+    pthread_join(producer, NULL);
+    lock_free_queue_destroy(args.queue);
+    return ordered;
+}
+
+int main(void) {
+    test_edges();
+    test_bulk_edges();
+
+    double ring_ns, bulk_ns, queue_ns;
+    if (!stream_ring(STREAM_ITEMS, &ring_ns)) {
+        printf("FAIL ring delivered items out of order between threads\n");
+        failures++;
+    }
+    if (!stream_ring_bulk(STREAM_ITEMS, &bulk_ns)) {
+        printf("FAIL ring delivered bulk runs out of order between threads\n");
+        failures++;
+    }
+    if (!stream_queue(STREAM_ITEMS, &queue_ns)) {
+        printf("FAIL linked queue delivered items out of order between threads\n");
+        failures++;
+    }
+    printf("two threads: ring %.1f ns/item, ring in runs of %d %.1f ns/item, linked queue %.1f ns/item\n",
+           ring_ns, BULK_BATCH, bulk_ns, queue_ns);
+
+    // One hand-off and its pickup back to back: the per-tick cost without scheduling noise
+    SpscRing *ring = spsc_ring_init(RING_CAPACITY);
+    LockFreeQueue *queue = lock_free_queue_init();
+    uintptr_t sink = 0;
+    double start = now_ns();
+    for (uintptr_t i = 1; i <= PAIR_ITEMS; i++) {
+        spsc_ring_push(ring, (void *)i);
+        sink += (uintptr_t)spsc_ring_pop(ring);
+    }
+    double ring_pair_ns = (now_ns() - start) / PAIR_ITEMS;
+    start = now_ns();
+    for (uintptr_t i = 1; i <= PAIR_ITEMS; i++) {
+        lock_free_queue_enqueue(queue, (void *)i);
+        sink += (uintptr_t)lock_free_queue_dequeue(queue);
+    }
+    double queue_pair_ns = (now_ns() - start) / PAIR_ITEMS;
+    printf("push + pop: ring %.1f ns, linked queue %.1f ns\n", ring_pair_ns, queue_pair_ns);
+    if (sink != (uintptr_t)PAIR_ITEMS * (PAIR_ITEMS + 1)) {
+        printf("FAIL push + pop lost or changed items\n");
+        failures++;
+    }
+
+    // The same items moved a run at a time
+    void *batch[BULK_BATCH];
+    sink = 0;
+    start = now_ns();
+    for (uintptr_t i = 1; i <= PAIR_ITEMS; i += BULK_BATCH) {
+        for (size_t j = 0; j < BULK_BATCH; j++) {
+            batch[j] = (void *)(i + j);
+        }
+        spsc_ring_push_bulk(ring, batch, BULK_BATCH);
+        size_t count = spsc_ring_pop_bulk(ring, batch, BULK_BATCH);
+        for (size_t j = 0; j < count; j++) {
+            sink += (uintptr_t)batch[j];
+        }
+    }
+    double bulk_pair_ns = (now_ns() - start) / PAIR_ITEMS;
+    printf("push + pop in runs of %d: ring %.1f ns per item\n", BULK_BATCH, bulk_pair_ns);
+    if (sink != (uintptr_t)PAIR_ITEMS * (PAIR_ITEMS + 1) / 2) {
+        printf("FAIL push + pop in runs lost or changed items\n");
+        failures++;
+    }
+    spsc_ring_destroy(ring);
+    lock_free_queue_destroy(queue);
+
+    if (failures) {
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
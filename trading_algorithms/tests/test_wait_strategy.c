@@ -0,0 +1,164 @@
+// tests/test_wait_strategy.c
+// Feeds a consumer through an SPSC ring under each wait strategy and under the old global
+// mutex/condvar scheme. Paced items measure how long a waiting consumer takes to see one and
+// how many context switches that costs; a burst checks that parking consumers are woken a
+// handful of times rather than once per item.
+//
+// Usage: ./bin/test_wait_strategy
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "spsc_ring.h"
+#include "wait_strategy.h"
+
+#define PACED_ITEMS 300
+#define PACE_US 1000
+#define BURST_ITEMS 200000
+#define RING_CAPACITY 4096
+// The condvar baseline stands in for the mutex/cond pair the pipelines used before
+#define MODE_CONDVAR -1
+
+typedef struct {
+    SpscRing *ring;
+    WaitStrategy wait;
+    int mode;
+    int running;
+    size_t items;
+    int64_t *sent_ns;          // per item, when the producer pushed it; NULL for the burst
+    double *latency_us;        // per item, push to pop
+    size_t received;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+} Pipe;
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static bool ring_has_items(void *ring) {
+    return !spsc_ring_is_empty((SpscRing *)ring);
+}
+
+static void *consumer_thread(void *args) {
+    Pipe *pipe = (Pipe *)args;
+    while (pipe->received < pipe->items) {
+        if (pipe->mode == MODE_CONDVAR) {
+            pthread_mutex_lock(&pipe->mutex);
+            while (spsc_ring_is_empty(pipe->ring)) {
+                pthread_cond_wait(&pipe->cond, &pipe->mutex);
+            }
+            pthread_mutex_unlock(&pipe->mutex);
+        } else if (!wait_strategy_wait(&pipe->wait, ring_has_items, pipe->ring, &pipe->running)) {
+            break;
+        }
+        uintptr_t item = (uintptr_t)spsc_ring_pop(pipe->ring);
+        if (item == 0) {
+            continue;
+        }
+        if (pipe->sent_ns) {
+            pipe->latency_us[item - 1] = (now_ns() - pipe->sent_ns[item - 1]) / 1e3;
+        }
+        pipe->received++;
+    }
+    return NULL;
+}
+
+static void push(Pipe *pipe, uintptr_t item) {
+    while (!spsc_ring_push(pipe->ring, (void *)item)) {
+        sched_yield();
+    }
+    if (pipe->mode == MODE_CONDVAR) {
+        pthread_mutex_lock(&pipe->mutex);
+        pthread_cond_signal(&pipe->cond);
+        pthread_mutex_unlock(&pipe->mutex);
+    } else {
+        wait_strategy_notify(&pipe->wait);
+    }
+}
+
+static long context_switches(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double left = *(const double *)a, right = *(const double *)b;
+    return (left > right) - (left < right);
+}
+
+// Run items through a consumer in the given mode; paced items are pushed PACE_US apart
+static bool run(int mode, size_t items, bool paced, Pipe *pipe) {
+    *pipe = (Pipe){.ring = spsc_ring_init(RING_CAPACITY), .mode = mode, .running = 1, .items = items};
+    pthread_mutex_init(&pipe->mutex, NULL);
+    pthread_cond_init(&pipe->cond, NULL);
+    wait_strategy_init(&pipe->wait, mode == MODE_CONDVAR ? WAIT_MODE_PARK : (WaitMode)mode);
+    if (paced) {
+        pipe->sent_ns = (int64_t *)calloc(items, sizeof(int64_t));
+        pipe->latency_us = (double *)calloc(items, sizeof(double));
+    }
+
+    pthread_t consumer;
+    pthread_create(&consumer, NULL, consumer_thread, pipe);
+    struct timespec pace = {0, PACE_US * 1000L};
+    for (uintptr_t i = 1; i <= items; i++) {
+        if (paced) {
+            nanosleep(&pace, NULL);
+            pipe->sent_ns[i - 1] = now_ns();
+        }
+        push(pipe, i);
+    }
+    pthread_join(consumer, NULL);
+    spsc_ring_destroy(pipe->ring);
+    pthread_mutex_destroy(&pipe->mutex);
+    pthread_cond_destroy(&pipe->cond);
+    free(pipe->sent_ns);
+    return pipe->received == items;
+}
+
+int main(void) {
+    int failures = 0;
+    const int modes[] = {MODE_CONDVAR, WAIT_MODE_SPIN, WAIT_MODE_YIELD, WAIT_MODE_PARK};
+    const char *names[] = {"mutex/condvar", "spin", "yield", "park"};
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        Pipe pipe;
+        long switches = context_switches();
+        if (!run(modes[m], PACED_ITEMS, true, &pipe)) {
+            printf("FAIL %s delivered %zu of %d paced items\n", names[m], pipe.received, PACED_ITEMS);
+            failures++;
+        }
+        switches = context_switches() - switches;
+        qsort(pipe.latency_us, PACED_ITEMS, sizeof(double), compare_doubles);
+        printf("%-14s paced: wake-up latency median %6.1f us, p99 %7.1f us, %ld context switches\n", names[m],
+               pipe.latency_us[PACED_ITEMS / 2], pipe.latency_us[PACED_ITEMS * 99 / 100], switches);
+        free(pipe.latency_us);
+    }
+
+    // A burst: a parking consumer should rarely need waking while items keep coming
+    Pipe pipe;
+    if (!run(WAIT_MODE_PARK, BURST_ITEMS, false, &pipe)) {
+        printf("FAIL park delivered %zu of %d burst items\n", pipe.received, BURST_ITEMS);
+        failures++;
+    }
+    size_t wakes = atomic_load(&pipe.wait.wakes);
+    printf("park burst: %d items, %zu parks, %zu wake-up calls (the condvar signals every item)\n",
+           BURST_ITEMS, pipe.wait.parks, wakes);
+    if (wakes > BURST_ITEMS / 100 || wakes > pipe.wait.parks) {
+        printf("FAIL producers made %zu wake-up calls for %zu parks\n", wakes, pipe.wait.parks);
+        failures++;
+    }
+
+    if (failures) {
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}